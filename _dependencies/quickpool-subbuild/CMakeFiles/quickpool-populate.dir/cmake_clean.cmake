@@ -0,0 +1,17 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/quickpool-populate"
+  "CMakeFiles/quickpool-populate-complete"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-build"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-configure"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-download"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-install"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-mkdir"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-patch"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-test"
+  "quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-update"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang )
+  include(CMakeFiles/quickpool-populate.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,73 @@
+# Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+# file Copyright.txt or https://cmake.org/licensing for details.
+
+cmake_minimum_required(VERSION 3.5)
+
+if(EXISTS "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitclone-lastrun.txt" AND EXISTS "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitinfo.txt" AND
+  "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitclone-lastrun.txt" IS_NEWER_THAN "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitinfo.txt")
+  message(STATUS
+    "Avoiding repeated git clone, stamp file is up to date: "
+    "'/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitclone-lastrun.txt'"
+  )
+  return()
+endif()
+
+execute_process(
+  COMMAND ${CMAKE_COMMAND} -E rm -rf "/root/repo/_dependencies/quickpool-src"
+  RESULT_VARIABLE error_code
+)
+if(error_code)
+  message(FATAL_ERROR "Failed to remove directory: '/root/repo/_dependencies/quickpool-src'")
+endif()
+
+# try the clone 3 times in case there is an odd git clone issue
+set(error_code 1)
+set(number_of_tries 0)
+while(error_code AND number_of_tries LESS 3)
+  execute_process(
+    COMMAND "/usr/bin/git" 
+            clone --no-checkout --depth 1 --no-single-branch --config "advice.detachedHead=false" "https://github.com/tnagler/quickpool.git" "quickpool-src"
+    WORKING_DIRECTORY "/root/repo/_dependencies"
+    RESULT_VARIABLE error_code
+  )
+  math(EXPR number_of_tries "${number_of_tries} + 1")
+endwhile()
+if(number_of_tries GREATER 1)
+  message(STATUS "Had to git clone more than once: ${number_of_tries} times.")
+endif()
+if(error_code)
+  message(FATAL_ERROR "Failed to clone repository: 'https://github.com/tnagler/quickpool.git'")
+endif()
+
+execute_process(
+  COMMAND "/usr/bin/git" 
+          checkout "ddc415bec1fc624e1c6b21c1b47063ca2eef84de" --
+  WORKING_DIRECTORY "/root/repo/_dependencies/quickpool-src"
+  RESULT_VARIABLE error_code
+)
+if(error_code)
+  message(FATAL_ERROR "Failed to checkout tag: 'ddc415bec1fc624e1c6b21c1b47063ca2eef84de'")
+endif()
+
+set(init_submodules TRUE)
+if(init_submodules)
+  execute_process(
+    COMMAND "/usr/bin/git" 
+            submodule update --recursive --init 
+    WORKING_DIRECTORY "/root/repo/_dependencies/quickpool-src"
+    RESULT_VARIABLE error_code
+  )
+endif()
+if(error_code)
+  message(FATAL_ERROR "Failed to update submodules in: '/root/repo/_dependencies/quickpool-src'")
+endif()
+
+# Complete success, update the script-last-run stamp file:
+#
+execute_process(
+  COMMAND ${CMAKE_COMMAND} -E copy "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitinfo.txt" "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitclone-lastrun.txt"
+  RESULT_VARIABLE error_code
+)
+if(error_code)
+  message(FATAL_ERROR "Failed to copy script-last-run stamp file: '/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/quickpool-populate-gitclone-lastrun.txt'")
+endif()
@@ -0,0 +1,22 @@
+# Distributed under the OSI-approved BSD 3-Clause License.  See accompanying
+# file Copyright.txt or https://cmake.org/licensing for details.
+
+cmake_minimum_required(VERSION 3.5)
+
+file(MAKE_DIRECTORY
+  "/root/repo/_dependencies/quickpool-src"
+  "/root/repo/_dependencies/quickpool-build"
+  "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix"
+  "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/tmp"
+  "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp"
+  "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src"
+  "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp"
+)
+
+set(configSubDirs )
+foreach(subDir IN LISTS configSubDirs)
+    file(MAKE_DIRECTORY "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp/${subDir}")
+endforeach()
+if(cfgdir)
+  file(MAKE_DIRECTORY "/root/repo/_dependencies/quickpool-subbuild/quickpool-populate-prefix/src/quickpool-populate-stamp${cfgdir}") # cfgdir has leading slash
+endif()
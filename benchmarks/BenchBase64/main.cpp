@@ -0,0 +1,156 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+#include "Data.hpp"
+
+#include "mumble/Base64.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <openssl/evp.h>
+
+// Large enough to make the per-call overhead irrelevant.
+static constexpr size_t bigSize = 8 * 1024 * 1024;
+// Size of the chunks fed to the streaming interfaces.
+static constexpr size_t chunkSize = 64 * 1024;
+
+using namespace mumble;
+
+static BufViewConst toView(const std::string_view str) {
+	return { reinterpret_cast< const std::byte * >(str.data()), str.size() };
+}
+
+static size_t evpEncode(const BufView out, const BufViewConst in) {
+	return static_cast< size_t >(EVP_EncodeBlock(reinterpret_cast< unsigned char * >(out.data()),
+												 reinterpret_cast< const unsigned char * >(in.data()),
+												 static_cast< int >(in.size())));
+}
+
+static size_t evpDecode(EVP_ENCODE_CTX *ctx, const BufView out, const BufViewConst in) {
+	EVP_DecodeInit(ctx);
+
+	size_t written = 0;
+
+	for (size_t offset = 0; offset < in.size(); offset += chunkSize) {
+		const auto chunk = in.subspan(offset, std::min(chunkSize, in.size() - offset));
+
+		int size = 0;
+		if (EVP_DecodeUpdate(ctx, reinterpret_cast< unsigned char * >(out.data() + written), &size,
+							 reinterpret_cast< const unsigned char * >(chunk.data()), static_cast< int >(chunk.size()))
+			< 0) {
+			return {};
+		}
+
+		written += static_cast< size_t >(size);
+	}
+
+	int size = 0;
+	if (EVP_DecodeFinal(ctx, reinterpret_cast< unsigned char * >(out.data() + written), &size) < 0) {
+		return {};
+	}
+
+	return written + static_cast< size_t >(size);
+}
+
+static size_t streamDecode(Base64 &base64, const BufView out, const BufViewConst in) {
+	size_t written = 0;
+
+	for (size_t offset = 0; offset < in.size(); offset += chunkSize) {
+		const auto chunk = in.subspan(offset, std::min(chunkSize, in.size() - offset));
+		written += base64.decodeUpdate(out.subspan(written), chunk);
+	}
+
+	return base64.decodeFinal() ? written : 0;
+}
+
+static size_t streamEncode(Base64 &base64, const BufView out, const BufViewConst in) {
+	size_t written = 0;
+
+	for (size_t offset = 0; offset < in.size(); offset += chunkSize) {
+		const auto chunk = in.subspan(offset, std::min(chunkSize, in.size() - offset));
+		written += base64.encodeUpdate(out.subspan(written), chunk);
+	}
+
+	return written + base64.encodeFinal(out.subspan(written));
+}
+
+static void benchmarkTable(const std::string &name, const Data::Table &table, EVP_ENCODE_CTX *ctx, Base64 &base64) {
+	Buf buf(1024);
+
+	Benchmark benchmark(name + " (" + std::to_string(table.size()) + " entries)");
+
+	benchmark.run("EVP encode", 100000, table.size(), [&]() {
+		for (const auto &entry : table) {
+			Benchmark::keep(evpEncode(buf, toView(entry.first)));
+		}
+	});
+
+	benchmark.run("Base64 encode", 100000, table.size(), [&]() {
+		for (const auto &entry : table) {
+			Benchmark::keep(Base64::encode(buf, toView(entry.first)));
+		}
+	});
+
+	benchmark.run("EVP decode", 100000, table.size(), [&]() {
+		for (const auto &entry : table) {
+			Benchmark::keep(evpDecode(ctx, buf, toView(entry.second)));
+		}
+	});
+
+	benchmark.run("Base64 decode", 100000, table.size(), [&]() {
+		for (const auto &entry : table) {
+			Benchmark::keep(base64.decode(buf, toView(entry.second)));
+		}
+	});
+}
+
+int32_t main() {
+	auto ctx = EVP_ENCODE_CTX_new();
+
+	Base64 base64;
+
+	benchmarkTable("ASCII", Data::ascii, ctx, base64);
+	benchmarkTable("Unicode", Data::unicode, ctx, base64);
+
+	std::random_device device;
+	std::mt19937 algorithm(device());
+	std::uniform_int_distribution< uint32_t > gen(0, UINT8_MAX);
+
+	Buf data(bigSize);
+	for (auto &byte : data) {
+		byte = static_cast< std::byte >(gen(algorithm));
+	}
+
+	// Both encoders write a NUL terminator, the decoders get the characters only.
+	Buf output(Base64::encode({}, data));
+	Buf encoded(output.size());
+	encoded.resize(Base64::encode(encoded, data) - 1);
+
+	Buf decoded(bigSize + chunkSize);
+
+	// The bytes processed by each iteration are reported as the number of operations.
+	Benchmark benchmark(std::to_string(bigSize / 1024 / 1024) + " MiB of random data");
+
+	benchmark.run("EVP encode", 10, bigSize, [&]() { Benchmark::keep(evpEncode(output, data)); });
+	benchmark.run("Base64 encode", 10, bigSize, [&]() { Benchmark::keep(Base64::encode(output, data)); });
+	benchmark.run("Base64 encode (streaming)", 10, bigSize,
+				  [&]() { Benchmark::keep(streamEncode(base64, output, data)); });
+	benchmark.run("EVP decode (streaming)", 10, bigSize,
+				  [&]() { Benchmark::keep(evpDecode(ctx, decoded, encoded)); });
+	benchmark.run("Base64 decode", 10, bigSize, [&]() { Benchmark::keep(base64.decode(decoded, encoded)); });
+	benchmark.run("Base64 decode (streaming)", 10, bigSize,
+				  [&]() { Benchmark::keep(streamDecode(base64, decoded, encoded)); });
+
+	EVP_ENCODE_CTX_free(ctx);
+
+	return 0;
+}
@@ -0,0 +1,135 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/Crypt.hpp"
+#include "mumble/CryptStateAEAD.hpp"
+#include "mumble/CryptStateOCB2.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static constexpr size_t iterations = 20000;
+
+using namespace mumble;
+
+static void run(Benchmark &benchmark, std::mt19937 &algorithm, const std::string_view cipher, const size_t size) {
+	std::uniform_int_distribution< uint32_t > gen(0, UINT8_MAX);
+
+	Crypt crypt;
+	crypt.setCipher(cipher);
+
+	const auto key = crypt.genKey();
+	crypt.setKey(key);
+	crypt.setNonce(crypt.genNonce());
+
+	Buf in(size), out(size), plain(size);
+	for (auto &byte : in) {
+		byte = static_cast< std::byte >(gen(algorithm));
+	}
+
+	FixedBuf< 16 > tag;
+
+	const auto suffix = " (" + std::to_string(size) + " bytes)";
+
+	benchmark.run("encrypt" + suffix, iterations, 1, [&]() { Benchmark::keep(crypt.encrypt(out, in, tag)); });
+
+	// A duplex stream: every call switches direction.
+	benchmark.run("encrypt + decrypt" + suffix, iterations, 2, [&]() {
+		Benchmark::keep(crypt.encrypt(out, in, tag));
+		Benchmark::keep(crypt.decrypt(plain, out, tag));
+	});
+
+	// What every direction switch used to cost: a full key schedule.
+	benchmark.run("encrypt + decrypt, re-keyed" + suffix, iterations, 2, [&]() {
+		crypt.setKey(key);
+		Benchmark::keep(crypt.encrypt(out, in, tag));
+		crypt.setKey(key);
+		Benchmark::keep(crypt.decrypt(plain, out, tag));
+	});
+}
+
+// Encrypts and decrypts typical voice packets, through a pair of connected states.
+template< typename T > static void runState(Benchmark &benchmark, const std::string &label, T &server, T &client) {
+	client.setKey(server.key(), server.encryptNonce(), server.decryptNonce());
+
+	constexpr size_t size = 80;
+
+	Buf in(size, std::byte(1)), packet(size + T::headerSize), out(size);
+
+	benchmark.run(label, iterations, 1, [&]() {
+		client.encrypt(packet, in);
+		Benchmark::keep(server.decrypt(out, packet));
+	});
+}
+
+static void runBatch(Benchmark &benchmark, CryptStateAEAD &server, CryptStateAEAD &client) {
+	client.setKey(server.key(), server.encryptNonce(), server.decryptNonce());
+
+	constexpr size_t size = 80, packets = 16;
+
+	const Buf in(size, std::byte(1));
+	std::vector< Buf > encrypted(packets, Buf(size + CryptStateAEAD::headerSize)), out(packets, Buf(size));
+
+	std::vector< CryptStateAEAD::Job > encryptJobs(packets), decryptJobs(packets);
+	for (size_t i = 0; i < packets; ++i) {
+		encryptJobs[i].out = encrypted[i];
+		encryptJobs[i].in  = in;
+		decryptJobs[i].out = out[i];
+		decryptJobs[i].in  = encrypted[i];
+	}
+
+	benchmark.run("AES-256-GCM, batches of " + std::to_string(packets), iterations / packets, packets, [&]() {
+		client.encryptBatch(encryptJobs);
+		Benchmark::keep(server.decryptBatch(decryptJobs));
+	});
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	for (const auto cipher : { "AES-256-GCM", "ChaCha20-Poly1305" }) {
+		Benchmark benchmark(cipher);
+
+		for (const size_t size : { 64, 256, 1024 }) {
+			run(benchmark, algorithm, cipher, size);
+		}
+	}
+
+	{
+		Benchmark benchmark("Voice packets (80 bytes, encrypt + decrypt)");
+
+		CryptStateOCB2 server, client;
+		server.gen();
+		runState(benchmark, "OCB2-AES128", server, client);
+
+		for (const auto mode : { CryptStateAEAD::Mode::AES256GCM, CryptStateAEAD::Mode::ChaCha20Poly1305 }) {
+			CryptStateAEAD serverAEAD(mode, true), clientAEAD(mode, false);
+			serverAEAD.gen();
+			runState(benchmark, mode == CryptStateAEAD::Mode::AES256GCM ? "AES-256-GCM" : "ChaCha20-Poly1305",
+					 serverAEAD, clientAEAD);
+
+			if (mode == CryptStateAEAD::Mode::AES256GCM) {
+				runBatch(benchmark, serverAEAD, clientAEAD);
+			}
+		}
+	}
+
+	{
+		Benchmark benchmark("Algorithm lookup");
+
+		Crypt crypt;
+		benchmark.run("setCipher", iterations, 1, [&]() { Benchmark::keep(crypt.setCipher("AES-256-GCM")); });
+	}
+
+	return 0;
+}
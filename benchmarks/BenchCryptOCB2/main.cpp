@@ -0,0 +1,85 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/CryptOCB2.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+static constexpr size_t listeners  = 64;
+static constexpr size_t iterations = 2000;
+
+using namespace mumble;
+
+// A voice packet forwarded to every listener, each with their own key.
+static void run(Benchmark &benchmark, std::mt19937 &algorithm, const size_t size) {
+	std::uniform_int_distribution< uint32_t > gen(0, UINT8_MAX);
+
+	std::vector< CryptOCB2 > crypts(listeners);
+	for (auto &crypt : crypts) {
+		crypt.setKey(crypt.genKey());
+		crypt.setNonce(crypt.genNonce());
+	}
+
+	Buf in(size);
+	for (auto &byte : in) {
+		byte = static_cast< std::byte >(gen(algorithm));
+	}
+
+	std::vector< Buf > outs(listeners, Buf(size));
+	std::vector< FixedBuf< 16 > > tags(listeners);
+
+	const auto suffix = " (" + std::to_string(size) + " bytes)";
+
+	benchmark.run("encrypt" + suffix, iterations, listeners, [&]() {
+		for (size_t i = 0; i < listeners; ++i) {
+			Benchmark::keep(crypts[i].encrypt(outs[i], in, tags[i]));
+		}
+	});
+
+	std::vector< CryptOCB2::EncryptJob > encryptJobs(listeners);
+	for (size_t i = 0; i < listeners; ++i) {
+		encryptJobs[i] = { &crypts[i], {}, outs[i], in, tags[i] };
+	}
+
+	benchmark.run("encryptBatch" + suffix, iterations, listeners,
+				  [&]() { Benchmark::keep(CryptOCB2::encryptBatch(encryptJobs)); });
+
+	// The tags match the ciphertexts as long as the nonces are not touched.
+	std::vector< Buf > plains(listeners, Buf(size));
+
+	benchmark.run("decrypt" + suffix, iterations, listeners, [&]() {
+		for (size_t i = 0; i < listeners; ++i) {
+			Benchmark::keep(crypts[i].decrypt(plains[i], outs[i], tags[i]));
+		}
+	});
+
+	std::vector< CryptOCB2::DecryptJob > decryptJobs(listeners);
+	for (size_t i = 0; i < listeners; ++i) {
+		decryptJobs[i] = { &crypts[i], {}, plains[i], outs[i], tags[i] };
+	}
+
+	benchmark.run("decryptBatch" + suffix, iterations, listeners,
+				  [&]() { Benchmark::keep(CryptOCB2::decryptBatch(decryptJobs)); });
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	Benchmark benchmark("OCB2-AES128, one packet per listener");
+
+	for (const size_t size : { 60, 200, 1000 }) {
+		run(benchmark, algorithm, size);
+	}
+
+	return 0;
+}
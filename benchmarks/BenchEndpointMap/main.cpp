@@ -0,0 +1,159 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/EndpointHash.hpp"
+#include "mumble/EndpointMap.hpp"
+#include "mumble/IP.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static constexpr size_t lookups = 100000;
+
+// Clients per IP, as many as behind a busy NAT.
+static constexpr uint16_t clientsPerIP = 50;
+
+using namespace mumble;
+
+// The hash the example server used before, kept as the baseline.
+struct SumHash {
+	size_t operator()(const Endpoint &endpoint) const {
+		size_t hash = endpoint.port;
+
+		for (const auto byte : endpoint.ip.v6()) {
+			hash += byte;
+		}
+
+		return std::hash< size_t >()(hash);
+	}
+};
+
+// IPv4 clients (IPv4-mapped), "clientsPerIP" of them share an address and get consecutive ports.
+static std::vector< Endpoint > endpoints(const size_t count, std::mt19937 &algorithm) {
+	std::uniform_int_distribution< uint32_t > genIP;
+	std::uniform_int_distribution< uint16_t > genPort(1024, UINT16_MAX - clientsPerIP);
+
+	std::vector< Endpoint > endpoints;
+	endpoints.reserve(count);
+
+	while (endpoints.size() < count) {
+		const auto ip = genIP(algorithm);
+
+		const IP::V4 v4 = { static_cast< uint8_t >(ip >> 24), static_cast< uint8_t >(ip >> 16),
+							static_cast< uint8_t >(ip >> 8), static_cast< uint8_t >(ip) };
+		const IP address(v4);
+
+		const auto port = genPort(algorithm);
+		for (uint16_t i = 0; i < clientsPerIP && endpoints.size() < count; ++i) {
+			endpoints.emplace_back(address, static_cast< uint16_t >(port + i));
+		}
+	}
+
+	return endpoints;
+}
+
+static std::vector< EndpointV > values(const std::vector< Endpoint > &endpoints) {
+	std::vector< EndpointV > values;
+	values.reserve(endpoints.size());
+	for (const auto &endpoint : endpoints) {
+		values.push_back(endpoint.value());
+	}
+
+	return values;
+}
+
+template< typename Map >
+static void runStd(Benchmark &benchmark, const std::string &label, const std::vector< Endpoint > &present,
+				   const std::vector< Endpoint > &hits, const std::vector< Endpoint > &misses) {
+	Map map;
+	map.reserve(present.size());
+	for (size_t i = 0; i < present.size(); ++i) {
+		map.emplace(present[i], i);
+	}
+
+	benchmark.run(label + ", hit", 10, hits.size(), [&]() {
+		size_t sum = 0;
+		for (const auto &endpoint : hits) {
+			sum += map.find(endpoint)->second;
+		}
+		Benchmark::keep(sum);
+	});
+
+	benchmark.run(label + ", miss", 10, misses.size(), [&]() {
+		size_t found = 0;
+		for (const auto &endpoint : misses) {
+			found += map.find(endpoint) != map.cend();
+		}
+		Benchmark::keep(found);
+	});
+}
+
+// Keyed by EndpointV, as stored in the packet metadata on the UDP path.
+static void runFlat(Benchmark &benchmark, const std::vector< Endpoint > &present, const std::vector< EndpointV > &hits,
+					const std::vector< EndpointV > &misses) {
+	EndpointMap< size_t > map;
+	map.reserve(present.size());
+	for (size_t i = 0; i < present.size(); ++i) {
+		map.insert(present[i], i);
+	}
+
+	benchmark.run("EndpointMap, hit", 10, hits.size(), [&]() {
+		size_t sum = 0;
+		for (const auto &endpoint : hits) {
+			sum += *map.find(endpoint);
+		}
+		Benchmark::keep(sum);
+	});
+
+	benchmark.run("EndpointMap, miss", 10, misses.size(), [&]() {
+		size_t found = 0;
+		for (const auto &endpoint : misses) {
+			found += map.find(endpoint) != nullptr;
+		}
+		Benchmark::keep(found);
+	});
+}
+
+static void run(const size_t count, std::mt19937 &algorithm) {
+	Benchmark benchmark("Endpoint lookups, " + std::to_string(count) + " entries");
+
+	auto all = endpoints(count * 2, algorithm);
+	std::shuffle(all.begin(), all.end(), algorithm);
+
+	const std::vector< Endpoint > present(all.cbegin(), all.cbegin() + count);
+	const std::vector< Endpoint > misses(all.cbegin() + count, all.cbegin() + count + std::min(count, lookups));
+
+	std::uniform_int_distribution< size_t > genIndex(0, count - 1);
+
+	std::vector< Endpoint > hits;
+	hits.reserve(lookups);
+	for (size_t i = 0; i < lookups; ++i) {
+		hits.push_back(present[genIndex(algorithm)]);
+	}
+
+	runStd< std::unordered_map< Endpoint, size_t, SumHash > >(benchmark, "unordered_map (byte sum)", present, hits,
+															   misses);
+	runStd< std::unordered_map< Endpoint, size_t, EndpointHash > >(benchmark, "unordered_map (EndpointHash)", present,
+																   hits, misses);
+	runFlat(benchmark, present, values(hits), values(misses));
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	run(10000, algorithm);
+	run(100000, algorithm);
+
+	return 0;
+}
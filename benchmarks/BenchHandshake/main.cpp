@@ -0,0 +1,160 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/Cert.hpp"
+#include "mumble/Connection.hpp"
+#include "mumble/IP.hpp"
+#include "mumble/Key.hpp"
+#include "mumble/Lib.hpp"
+#include "mumble/Peer.hpp"
+#include "mumble/Types.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+// Full handshakes (no session resumption) over loopback, both sides authenticate with a certificate.
+static constexpr uint16_t port = 64850;
+
+static constexpr size_t handshakes = 100;
+
+using namespace mumble;
+
+struct Identity {
+	Cert::Chain cert;
+	Key key;
+
+	Identity(const Key::Type type, const std::string_view name) : key(Key::generate(type)) {
+		using namespace std::chrono_literals;
+
+		cert = { Cert::selfSigned(key, { { "CN", std::string(name) } }, 24h) };
+	}
+};
+
+static Connection::Feedback connectionFeedback() {
+	Connection::Feedback feedback;
+
+	feedback.opened   = []() {};
+	feedback.closed   = []() {};
+	feedback.failed   = [](const Code) {};
+	feedback.timeout  = []() { return 1000; };
+	feedback.timeouts = []() { return 5; };
+
+	return feedback;
+}
+
+int32_t main() {
+#ifdef SIGPIPE
+	// The close_notify alert can be sent after the other side closed the socket.
+	std::signal(SIGPIPE, SIG_IGN);
+#endif
+	if (lib::init() != Code::Success) {
+		return 1;
+	}
+
+	using Type = Key::Type;
+
+	const std::pair< Type, std::string_view > types[] = { { Type::RSA2048, "RSA-2048" },
+														   { Type::P256, "ECDSA P-256" },
+														   { Type::Ed25519, "Ed25519" } };
+
+	{
+		Benchmark benchmark("Key generation");
+
+		for (const auto &type : types) {
+			benchmark.run(type.second, 5, 1,
+						  [&type]() { Benchmark::keep(static_cast< bool >(Key::generate(type.first))); });
+		}
+	}
+
+	Identity *server = nullptr;
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t accepted = 0;
+
+	Peer::FeedbackTCP peerFeedback;
+	peerFeedback.started = []() {};
+	peerFeedback.stopped = []() {};
+	peerFeedback.failed  = [](const Code) {};
+	peerFeedback.timeout = []() { return 100; };
+
+	peerFeedback.connection = [&](Endpoint &, const int32_t socketHandle) {
+		Connection connection(socketHandle, true);
+		if (!connection.setCert(server->cert, server->key) || connection(connectionFeedback()) != Code::Success) {
+			return true;
+		}
+
+		{
+			const std::lock_guard< std::mutex > lock(mutex);
+			++accepted;
+		}
+
+		cv.notify_one();
+
+		return true;
+	};
+
+	Peer peer;
+
+	Endpoint endpoint(IP("127.0.0.1"), port);
+	if (peer.bindTCP(endpoint) != Code::Success || peer.startTCP(peerFeedback, 1) != Code::Success) {
+		std::printf("Failed to listen on port %u!\n", port);
+		return 2;
+	}
+
+	Benchmark benchmark("Full TLS handshakes over loopback, " + std::to_string(handshakes) + " per round");
+
+	for (const auto &type : types) {
+		Identity serverIdentity(type.first, "Server");
+		Identity clientIdentity(type.first, "Client");
+
+		server = &serverIdentity;
+
+		bool ok = true;
+
+		const auto result = benchmark.run(type.second, handshakes, 1, [&]() {
+			const auto ret = Peer::connect(endpoint);
+			if (ret.first != Code::Success) {
+				ok = false;
+				return;
+			}
+
+			Connection connection(ret.second, false);
+			if (!connection.setCert(clientIdentity.cert, clientIdentity.key)
+				|| connection(connectionFeedback()) != Code::Success) {
+				ok = false;
+				return;
+			}
+
+			// The server completes the handshake after the client.
+			std::unique_lock< std::mutex > lock(mutex);
+			cv.wait(lock, [&accepted]() { return accepted > 0; });
+			--accepted;
+		});
+
+		if (!ok) {
+			std::printf("  Handshake failed!\n");
+			return 3;
+		}
+
+		std::printf("  %-40.*s %10.0f handshakes/s\n", static_cast< int >(type.second.size()), type.second.data(),
+					1e9 / result);
+	}
+
+	peer.stopTCP();
+
+	lib::deinit();
+
+	return 0;
+}
@@ -0,0 +1,59 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/Hash.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// About the size of a DER encoded certificate.
+static constexpr size_t inputSize = 1000;
+static constexpr size_t inputs    = 1000;
+
+using namespace mumble;
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+	std::uniform_int_distribution< uint32_t > gen(0, UINT8_MAX);
+
+	std::vector< Buf > data(inputs, Buf(inputSize));
+	for (auto &buf : data) {
+		for (auto &byte : buf) {
+			byte = static_cast< std::byte >(gen(algorithm));
+		}
+	}
+
+	const std::vector< BufViewConst > in(data.cbegin(), data.cend());
+
+	std::vector< Buf > digests(inputs, Buf(20));
+	const std::vector< BufView > out(digests.begin(), digests.end());
+
+	Benchmark benchmark("SHA1 of " + std::to_string(inputs) + " certificates");
+
+	benchmark.run("Hash per digest", 10, inputs, [&]() {
+		for (size_t i = 0; i < inputs; ++i) {
+			Hash hash;
+			hash.setType("SHA1");
+			Benchmark::keep(hash(out[i], in[i]));
+		}
+	});
+
+	benchmark.run("Hash::local()", 10, inputs, [&]() {
+		for (size_t i = 0; i < inputs; ++i) {
+			Benchmark::keep(Hash::local("SHA1")(out[i], in[i]));
+		}
+	});
+
+	benchmark.run("hashMany()", 10, inputs, [&]() { Benchmark::keep(Hash::local("SHA1").hashMany(out, in)); });
+
+	return 0;
+}
@@ -0,0 +1,95 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/JitterBuffer.hpp"
+#include "mumble/Mixer.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static constexpr uint8_t channels   = 1;
+static constexpr size_t iterations = 100;
+
+using namespace mumble;
+
+static constexpr uint64_t tickFrames = Mixer::tickDuration / JitterBuffer::frameDuration;
+
+// A 20 ms packet of a sine wave, so that the codec does some actual work.
+static std::vector< std::byte > encode() {
+	Opus::Encoder encoder(channels);
+	encoder.init(Mixer::sampleRate);
+
+	std::vector< float > in(Mixer::tickSamples * channels);
+	for (size_t i = 0; i < in.size(); ++i) {
+		in[i] = 0.3f * std::sin(static_cast< float >(i) * 0.05f);
+	}
+
+	std::vector< std::byte > out(JitterBuffer::packetSizeMax);
+	out.resize(encoder(out, in).size());
+
+	return out;
+}
+
+// Everybody talks at once, the worst case. "outputs" is 1 for a recording or the number of speakers for an N-1 mix
+// sent to each one of them. A single worker thread, so that the result is per core.
+static void benchmarkTick(const std::vector< std::byte > &packet, const uint32_t streams, const bool perSpeaker) {
+	const uint32_t outputs = perSpeaker ? streams : 1;
+
+	Mixer mixer(channels, streams, outputs, 1);
+
+	for (uint32_t id = 0; id < streams; ++id) {
+		mixer.addStream(id);
+	}
+
+	for (uint32_t id = 0; id < outputs; ++id) {
+		if (perSpeaker) {
+			mixer.addOutput(id, id);
+		} else {
+			mixer.addOutput(id);
+		}
+	}
+
+	const auto epoch = JitterBuffer::Clock::now();
+
+	uint64_t tick = 0;
+
+	const auto name = std::to_string(streams) + " streams, " + std::to_string(outputs) + " outputs";
+
+	Benchmark benchmark(name);
+
+	const auto ns = benchmark.run("Tick", iterations, streams, [&]() {
+		for (uint32_t id = 0; id < streams; ++id) {
+			mixer.push(id, tick * tickFrames, packet, false, epoch + Mixer::tickDuration * tick);
+		}
+
+		Benchmark::keep(mixer.tick());
+		++tick;
+	});
+
+	const auto tickNs = std::chrono::duration< double, std::nano >(Mixer::tickDuration).count();
+
+	// The time per operation is the time per stream.
+	std::printf("  %-40s %10.0f streams/core in real time\n", "Tick", tickNs / ns);
+}
+
+int32_t main() {
+	const auto packet = encode();
+
+	for (const uint32_t streams : { 16, 64 }) {
+		benchmarkTick(packet, streams, false);
+		benchmarkTick(packet, streams, true);
+	}
+
+	return 0;
+}
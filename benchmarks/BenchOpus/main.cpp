@@ -0,0 +1,59 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static constexpr uint8_t channels    = 1;
+static constexpr uint32_t sampleRate = 48000;
+static constexpr size_t speakers     = 100;
+
+using namespace mumble;
+
+// Speakers coming and going: a coder is created (or taken from a pool) for each one.
+static void benchmarkChurn() {
+	Opus::DecoderPool decoders(channels, sampleRate, speakers);
+	Opus::EncoderPool encoders(channels, sampleRate, speakers);
+
+	Benchmark benchmark(std::to_string(speakers) + " speakers joining and leaving");
+
+	benchmark.run("Decoder", 100, speakers, [&]() {
+		for (size_t i = 0; i < speakers; ++i) {
+			Opus::Decoder decoder(channels);
+			Benchmark::keep(static_cast< uint64_t >(decoder.init(sampleRate)));
+		}
+	});
+
+	benchmark.run("DecoderPool", 100, speakers, [&]() {
+		for (size_t i = 0; i < speakers; ++i) {
+			Benchmark::keep(decoders.acquire() != nullptr);
+		}
+	});
+
+	benchmark.run("Encoder", 100, speakers, [&]() {
+		for (size_t i = 0; i < speakers; ++i) {
+			Opus::Encoder encoder(channels);
+			Benchmark::keep(static_cast< uint64_t >(encoder.init(sampleRate)));
+		}
+	});
+
+	benchmark.run("EncoderPool", 100, speakers, [&]() {
+		for (size_t i = 0; i < speakers; ++i) {
+			Benchmark::keep(encoders.acquire() != nullptr);
+		}
+	});
+}
+
+int32_t main() {
+	benchmarkChurn();
+
+	return 0;
+}
@@ -0,0 +1,205 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/PCM.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// One second of stereo audio at 48 kHz.
+static constexpr uint32_t sampleRate = 48000;
+static constexpr uint8_t channels    = 2;
+static constexpr size_t frames       = sampleRate;
+static constexpr size_t samples      = frames * channels;
+
+static constexpr size_t iterations = 100;
+
+static constexpr double pi = 3.14159265358979323846;
+
+using namespace mumble;
+
+// The loops every application ends up writing, the baselines.
+namespace scalar {
+static void toFloat(std::vector< float > &out, const std::vector< int16_t > &in) {
+	for (size_t i = 0; i < in.size(); ++i) {
+		out[i] = static_cast< float >(in[i]) / 32768.f;
+	}
+}
+
+static void toInteger(std::vector< int16_t > &out, const std::vector< float > &in) {
+	for (size_t i = 0; i < in.size(); ++i) {
+		out[i] = static_cast< int16_t >(std::lrint(std::clamp(in[i] * 32768.f, -32768.f, 32767.f)));
+	}
+}
+
+static void applyGain(std::vector< int16_t > &out, const std::vector< int16_t > &in, const float gain) {
+	for (size_t i = 0; i < in.size(); ++i) {
+		out[i] = static_cast< int16_t >(std::lrint(std::clamp(in[i] * gain, -32768.f, 32767.f)));
+	}
+}
+
+static void toMono(std::vector< float > &out, const std::vector< float > &in) {
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = (in[i * 2] + in[i * 2 + 1]) * 0.5f;
+	}
+}
+
+// Same kind of filter as PCM::Resampler, applied directly on the interleaved samples.
+class Resampler {
+public:
+	static constexpr uint32_t taps = PCM::Resampler::taps;
+
+	Resampler(const uint32_t inRate, const uint32_t outRate)
+		: m_up(outRate / std::gcd(inRate, outRate)), m_down(inRate / std::gcd(inRate, outRate)),
+		  m_filter(m_up * taps), m_input((taps / 2 - 1) * channels), m_index(0), m_phase(0) {
+		const double bandwidth = 0.9 * std::min(1.0, static_cast< double >(m_up) / m_down);
+
+		for (uint32_t phase = 0; phase < m_up; ++phase) {
+			for (uint32_t tap = 0; tap < taps; ++tap) {
+				const double x = tap - (taps / 2 - 1) - static_cast< double >(phase) / m_up;
+				const double w = 0.42 + 0.5 * std::cos(pi * x / (taps / 2)) + 0.08 * std::cos(2 * pi * x / (taps / 2));
+
+				m_filter[phase * taps + tap] =
+					static_cast< float >(x != 0 ? w * std::sin(pi * bandwidth * x) / (pi * x) : w * bandwidth);
+			}
+		}
+	}
+
+	size_t operator()(std::vector< float > &out, const float *in, const size_t size) {
+		m_input.insert(m_input.end(), in, in + size);
+
+		size_t written = 0;
+
+		for (; (m_index + taps) * channels <= m_input.size(); ++written) {
+			for (uint8_t channel = 0; channel < channels; ++channel) {
+				float sum = 0;
+
+				for (uint32_t tap = 0; tap < taps; ++tap) {
+					sum += m_filter[m_phase * taps + tap] * m_input[(m_index + tap) * channels + channel];
+				}
+
+				out[written * channels + channel] = sum;
+			}
+
+			m_phase += m_down;
+			m_index += m_phase / m_up;
+			m_phase %= m_up;
+		}
+
+		const auto consumed = std::min(m_index, m_input.size() / channels);
+
+		m_input.erase(m_input.begin(), m_input.begin() + static_cast< std::ptrdiff_t >(consumed * channels));
+		m_index -= consumed;
+
+		return written;
+	}
+
+private:
+	uint32_t m_up;
+	uint32_t m_down;
+	std::vector< float > m_filter;
+	std::vector< float > m_input;
+	size_t m_index;
+	uint32_t m_phase;
+};
+} // namespace scalar
+
+static void benchmarkConversions(const std::vector< int16_t > &integer, const std::vector< float > &floating) {
+	std::vector< float > floatOut(samples);
+	std::vector< int16_t > integerOut(samples);
+	std::vector< float > mono(frames);
+
+	// The samples processed by each iteration are reported as the number of operations.
+	Benchmark benchmark("1 s of stereo audio at 48 kHz");
+
+	benchmark.run("Scalar int16 to float", iterations, samples, [&]() {
+		scalar::toFloat(floatOut, integer);
+		Benchmark::keep(static_cast< uint64_t >(floatOut[samples / 2] * 32768.f));
+	});
+
+	benchmark.run("PCM int16 to float", iterations, samples,
+				  [&]() { Benchmark::keep(PCM::toFloat(floatOut, integer)); });
+
+	benchmark.run("Scalar float to int16", iterations, samples, [&]() {
+		scalar::toInteger(integerOut, floating);
+		Benchmark::keep(static_cast< uint64_t >(integerOut[samples / 2]));
+	});
+
+	benchmark.run("PCM float to int16", iterations, samples,
+				  [&]() { Benchmark::keep(PCM::toInteger(integerOut, floating)); });
+
+	benchmark.run("Scalar int16 gain", iterations, samples, [&]() {
+		scalar::applyGain(integerOut, integer, 0.7f);
+		Benchmark::keep(static_cast< uint64_t >(integerOut[samples / 2]));
+	});
+
+	benchmark.run("PCM int16 gain", iterations, samples,
+				  [&]() { Benchmark::keep(PCM::applyGain(integerOut, integer, 0.7f)); });
+
+	benchmark.run("Scalar stereo to mono", iterations, samples, [&]() {
+		scalar::toMono(mono, floating);
+		Benchmark::keep(static_cast< uint64_t >(mono[frames / 2] * 32768.f));
+	});
+
+	benchmark.run("PCM stereo to mono", iterations, samples, [&]() { Benchmark::keep(PCM::toMono(mono, floating)); });
+}
+
+// Fed in 20 ms chunks, like the output of a decoder.
+static void benchmarkResampler(const uint32_t inRate, const uint32_t outRate) {
+	const size_t inFrames = inRate / 50;
+
+	std::vector< float > in(inFrames * channels);
+	for (size_t i = 0; i < inFrames; ++i) {
+		in[i * channels] = in[i * channels + 1] = static_cast< float >(0.5 * std::sin(2 * pi * 440 * i / inRate));
+	}
+
+	PCM::Resampler resampler(channels, inRate, outRate);
+	scalar::Resampler baseline(inRate, outRate);
+
+	std::vector< float > out(resampler.outputSize(in.size()));
+
+	Benchmark benchmark(std::to_string(inRate) + " Hz to " + std::to_string(outRate) + " Hz, stereo");
+
+	const auto baselineNs = benchmark.run("Scalar polyphase", iterations * 10, inFrames,
+										  [&]() { Benchmark::keep(baseline(out, in.data(), in.size())); });
+
+	const auto ns = benchmark.run("PCM::Resampler", iterations * 10, inFrames,
+								  [&]() { Benchmark::keep(resampler(out, in).size()); });
+
+	// The time per operation is the time per input frame.
+	const auto chunkNs = 1e9 / 50;
+
+	std::printf("  %-40s %10.0f streams/core in real time\n", "Scalar polyphase", chunkNs / (baselineNs * inFrames));
+	std::printf("  %-40s %10.0f streams/core in real time\n", "PCM::Resampler", chunkNs / (ns * inFrames));
+}
+
+int32_t main() {
+	std::vector< int16_t > integer(samples);
+	std::vector< float > floating(samples);
+
+	for (size_t i = 0; i < frames; ++i) {
+		const auto value = 0.5 * std::sin(2 * pi * 440 * i / sampleRate);
+
+		integer[i * channels] = integer[i * channels + 1] = static_cast< int16_t >(value * 32767);
+		floating[i * channels] = floating[i * channels + 1] = static_cast< float >(value);
+	}
+
+	benchmarkConversions(integer, floating);
+
+	for (const auto rate : { 16000, 44100 }) {
+		benchmarkResampler(rate, sampleRate);
+		benchmarkResampler(sampleRate, rate);
+	}
+
+	return 0;
+}
@@ -0,0 +1,258 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include "mumble/PacketDataStream.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+static constexpr size_t count      = 4096;
+static constexpr size_t iterations = 500;
+
+using namespace mumble;
+
+// The byte-wise codec PacketDataStream used before, kept as the baseline.
+class Reference {
+public:
+	Reference(const BufView buf) : m_ok(true), m_seek(buf) {}
+
+	BufView seek() const { return m_seek; }
+
+	Reference &operator<<(const uint64_t value) {
+		auto tmp = value;
+
+		if ((tmp & 0x8000000000000000LL) && (~tmp < 0x100000000LL)) {
+			tmp = ~tmp;
+			if (tmp <= 0x3) {
+				append(0xFC | tmp);
+				return *this;
+			} else {
+				append(0xF8);
+			}
+		}
+
+		if (tmp < 0x80) {
+			append(tmp);
+		} else if (tmp < 0x4000) {
+			append((tmp >> 8) | 0x80);
+			append(tmp & 0xFF);
+		} else if (tmp < 0x200000) {
+			append((tmp >> 16) | 0xC0);
+			append((tmp >> 8) & 0xFF);
+			append(tmp & 0xFF);
+		} else if (tmp < 0x10000000) {
+			append((tmp >> 24) | 0xE0);
+			append((tmp >> 16) & 0xFF);
+			append((tmp >> 8) & 0xFF);
+			append(tmp & 0xFF);
+		} else if (tmp < 0x100000000LL) {
+			append(0xF0);
+			append((tmp >> 24) & 0xFF);
+			append((tmp >> 16) & 0xFF);
+			append((tmp >> 8) & 0xFF);
+			append(tmp & 0xFF);
+		} else {
+			append(0xF4);
+			for (uint8_t shift = 56;; shift -= 8) {
+				append((tmp >> shift) & 0xFF);
+				if (!shift) {
+					break;
+				}
+			}
+		}
+
+		return *this;
+	}
+
+	Reference &operator>>(uint64_t &value) {
+		uint64_t tmp = next();
+
+		if ((tmp & 0x80) == 0x00) {
+			value = (tmp & 0x7F);
+		} else if ((tmp & 0xC0) == 0x80) {
+			value = (tmp & 0x3F) << 8 | next();
+		} else if ((tmp & 0xF0) == 0xF0) {
+			switch (tmp & 0xFC) {
+				case 0xF0:
+					value = next() << 24 | next() << 16 | next() << 8 | next();
+					break;
+				case 0xF4:
+					value = next() << 56 | next() << 48 | next() << 40 | next() << 32 | next() << 24 | next() << 16
+							| next() << 8 | next();
+					break;
+				case 0xF8:
+					*this >> value;
+					value = ~value;
+					break;
+				case 0xFC:
+					value = tmp & 0x03;
+					value = ~value;
+					break;
+				default:
+					m_ok  = false;
+					value = 0;
+					break;
+			}
+		} else if ((tmp & 0xF0) == 0xE0) {
+			value = (tmp & 0x0F) << 24 | next() << 16 | next() << 8 | next();
+		} else if ((tmp & 0xE0) == 0xC0) {
+			value = (tmp & 0x1F) << 16 | next() << 8 | next();
+		}
+
+		return *this;
+	}
+
+private:
+	void append(const uint64_t value) {
+		if (!m_seek.empty()) {
+			m_seek.front() = std::byte(value);
+			m_seek         = m_seek.subspan(1);
+		} else {
+			m_ok = false;
+		}
+	}
+
+	uint64_t next() {
+		if (!m_seek.empty()) {
+			const auto value = std::to_integer< uint64_t >(m_seek.front());
+			m_seek           = m_seek.subspan(1);
+			return value;
+		}
+
+		m_ok = false;
+
+		return 0;
+	}
+
+	bool m_ok;
+	BufView m_seek;
+};
+
+// Session, sequence and size/terminator, as found in legacy voice packet headers.
+static std::vector< uint64_t > voiceHeaders(std::mt19937 &algorithm) {
+	std::uniform_int_distribution< uint64_t > session(1, 2000);
+	std::uniform_int_distribution< uint64_t > size(20, 200);
+
+	std::vector< uint64_t > values;
+	for (uint64_t sequence = 100000; values.size() < count; ++sequence) {
+		values.push_back(session(algorithm));
+		values.push_back(sequence);
+		values.push_back(size(algorithm));
+	}
+
+	values.resize(count);
+
+	return values;
+}
+
+// Uniformly distributed encoded lengths.
+static std::vector< uint64_t > mixed(std::mt19937 &algorithm) {
+	std::uniform_int_distribution< uint32_t > bits(0, 63);
+	std::uniform_int_distribution< uint64_t > gen;
+
+	std::vector< uint64_t > values(count);
+	for (auto &value : values) {
+		value = gen(algorithm) >> bits(algorithm);
+	}
+
+	return values;
+}
+
+static void run(Benchmark &benchmark, const std::vector< uint64_t > &values) {
+	std::vector< uint64_t > decoded(values.size());
+	Buf buf(values.size() * 10);
+
+	benchmark.run("encode (byte-wise)", iterations, values.size(), [&]() {
+		Reference stream(buf);
+		for (const auto value : values) {
+			stream << value;
+		}
+		Benchmark::keep(stream.seek().size());
+	});
+
+	benchmark.run("encode", iterations, values.size(), [&]() {
+		PacketDataStream stream(buf);
+		stream.encode(values);
+		Benchmark::keep(stream.seek().size());
+	});
+
+	PacketDataStream stream(buf);
+	stream.encode(values);
+	const auto size = stream.data().size();
+
+	benchmark.run("decode (byte-wise)", iterations, values.size(), [&]() {
+		Reference stream({ buf.data(), size });
+		for (auto &value : decoded) {
+			stream >> value;
+		}
+		Benchmark::keep(decoded.back());
+	});
+
+	benchmark.run("decode", iterations, values.size(), [&]() {
+		PacketDataStream stream({ buf.data(), size });
+		for (auto &value : decoded) {
+			stream >> value;
+		}
+		Benchmark::keep(decoded.back());
+	});
+
+	benchmark.run("decode (bulk)", iterations, values.size(), [&]() {
+		PacketDataStream stream({ buf.data(), size });
+		Benchmark::keep(stream.decode(decoded));
+	});
+}
+
+static void extract(Benchmark &benchmark) {
+	FixedBuf< 64 > payload{};
+	Buf buf((payload.size() + 1) * count);
+
+	PacketDataStream stream(buf);
+	for (size_t i = 0; i < count; ++i) {
+		stream << payload;
+	}
+
+	benchmark.run("extract into Buf", iterations, count, [&]() {
+		PacketDataStream stream(buf);
+		for (size_t i = 0; i < count; ++i) {
+			Buf out;
+			stream >> out;
+			Benchmark::keep(out.size());
+		}
+	});
+
+	benchmark.run("extract into BufViewConst", iterations, count, [&]() {
+		PacketDataStream stream(buf);
+		for (size_t i = 0; i < count; ++i) {
+			BufViewConst out;
+			stream >> out;
+			Benchmark::keep(out.size());
+		}
+	});
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	{
+		Benchmark benchmark("Varint, voice packet headers");
+		run(benchmark, voiceHeaders(algorithm));
+	}
+	{
+		Benchmark benchmark("Varint, mixed lengths");
+		run(benchmark, mixed(algorithm));
+	}
+	{
+		Benchmark benchmark("Length-prefixed buffer");
+		extract(benchmark);
+	}
+
+	return 0;
+}
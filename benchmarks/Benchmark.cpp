@@ -0,0 +1,54 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr uint8_t rounds = 5;
+
+static volatile uint64_t sink;
+
+Benchmark::Benchmark(const std::string_view name) {
+	std::printf("%.*s\n", static_cast< int >(name.size()), name.data());
+}
+
+Benchmark::~Benchmark() {
+	std::printf("\n");
+}
+
+double Benchmark::run(const std::string_view label, const size_t iterations, const size_t ops, const Func &func) {
+	for (size_t i = 0; i < iterations / 10 + 1; ++i) {
+		func();
+	}
+
+	// The fastest round is the least disturbed by other processes.
+	double result = std::numeric_limits< double >::max();
+
+	for (uint8_t round = 0; round < rounds; ++round) {
+		const auto start = Clock::now();
+
+		for (size_t i = 0; i < iterations; ++i) {
+			func();
+		}
+
+		const std::chrono::duration< double, std::nano > elapsed = Clock::now() - start;
+
+		result = std::min(result, elapsed.count() / static_cast< double >(iterations * ops));
+	}
+
+	std::printf("  %-40.*s %10.2f ns/op\n", static_cast< int >(label.size()), label.data(), result);
+
+	return result;
+}
+
+void Benchmark::keep(const uint64_t value) {
+	sink = value;
+}
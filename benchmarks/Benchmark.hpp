@@ -0,0 +1,31 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_BENCHMARK_BENCHMARK_HPP
+#define MUMBLE_BENCHMARK_BENCHMARK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+class Benchmark {
+public:
+	using Func = std::function< void() >;
+
+	Benchmark(const std::string_view name);
+	~Benchmark();
+
+	// Calls "func" "iterations" times (after a short warm-up) and prints the average time per operation,
+	// taking the best out of several rounds.
+	// "ops" is the number of operations performed by a single call.
+	// Returns the average time in nanoseconds.
+	double run(const std::string_view label, const size_t iterations, const size_t ops, const Func &func);
+
+	// Prevents the compiler from optimizing away the computation of "value".
+	static void keep(const uint64_t value);
+};
+
+#endif
@@ -6,25 +6,13 @@
 #ifndef MUMBLE_EXAMPLESERVER_ENDPOINTS_HPP
 #define MUMBLE_EXAMPLESERVER_ENDPOINTS_HPP
 
+#include "mumble/EndpointHash.hpp"
 #include "mumble/Types.hpp"
 
 #include <unordered_set>
 
 using Endpoint  = mumble::Endpoint;
-using Endpoints = std::unordered_set< Endpoint >;
-
-namespace std {
-template<> struct hash< Endpoint > {
-	size_t operator()(const Endpoint &endpoint) const {
-		size_t hash = endpoint.port;
-
-		for (const auto byte : endpoint.ip.v6()) {
-			hash += byte;
-		}
-
-		return std::hash< size_t >()(hash);
-	}
-};
-} // namespace std
+using EndpointV = mumble::EndpointV;
+using Endpoints = std::unordered_set< EndpointV, mumble::EndpointHash >;
 
 #endif
@@ -12,9 +12,11 @@
 #include "mumble/Connection.hpp"
 #include "mumble/Endian.hpp"
 #include "mumble/IP.hpp"
+#include "mumble/Legacy.hpp"
 #include "mumble/Lib.hpp"
 #include "mumble/Message.hpp"
 #include "mumble/Pack.hpp"
+#include "mumble/SilenceGate.hpp"
 #include "mumble/Types.hpp"
 
 #include <algorithm>
@@ -105,10 +107,8 @@ bool Node::startTCP() {
 
 				printf("[#%u] Created!\n", user->id());
 
-				const auto certChain = user->connection()->peerCert();
-				if (certChain.size()) {
-					const auto attributes = certChain[0].subjectAttributes();
-					for (const auto &attribute : attributes) {
+				if (const auto &identity = user->connection()->peerIdentity()) {
+					for (const auto &attribute : identity->subjectAttributes) {
 						printf("[#%u] %s: %s\n", user->id(), attribute.first.data(), attribute.second.data());
 					}
 				} else {
@@ -182,9 +182,9 @@ bool Node::startTCP() {
 					printf("username: %s | password: %s\n", auth.username.c_str(), auth.password.c_str());
 
 					Message::CryptSetup crypt;
-					crypt.key.assign(user->key().begin(), user->key().end());
-					crypt.clientNonce.assign(user->decryptNonce().begin(), user->decryptNonce().end());
-					crypt.serverNonce.assign(user->encryptNonce().begin(), user->encryptNonce().end());
+					crypt.key         = user->key();
+					crypt.clientNonce = user->decryptNonce();
+					crypt.serverNonce = user->encryptNonce();
 					user->send(crypt);
 
 					Message::CodecVersion codec;
@@ -247,8 +247,37 @@ bool Node::startTCP() {
 					break;
 				case Type::QueryUsers:
 					break;
-				case Type::CryptSetup:
+				case Type::CryptSetup: {
+					Message::CryptSetup crypt;
+					if (!pack(crypt)) {
+						break;
+					}
+
+					if (!crypt.modes.empty() && user->setCryptMode(crypt.modes)) {
+						// The client offered modes other than OCB2, we picked one and send the new key and nonces.
+						Message::CryptSetup reply;
+						reply.mode        = user->cryptMode();
+						reply.key         = user->key();
+						reply.clientNonce = user->decryptNonce();
+						reply.serverNonce = user->encryptNonce();
+						user->send(reply);
+
+						break;
+					}
+
+					if (!crypt.clientNonce.empty()) {
+						// The client tells us its nonce, because our packets can't be decrypted anymore.
+						user->resync(crypt.clientNonce);
+						break;
+					}
+
+					// The client asks for our nonce, because it can't decrypt our packets anymore.
+					Message::CryptSetup reply;
+					reply.serverNonce = user->encryptNonce();
+					user->send(reply);
+
 					break;
+				}
 				case Type::ContextActionModify:
 					break;
 				case Type::ContextAction:
@@ -281,9 +310,7 @@ bool Node::startTCP() {
 						break;
 					}
 
-					stats.fromClient.good = target->good();
-					stats.fromClient.late = target->late();
-					stats.fromClient.lost = target->lost();
+					stats.fromClient = target->cryptStats();
 
 					stats.address      = target->connection()->peerEndpoint().ip;
 					stats.certificates = target->connection()->peerCert();
@@ -303,7 +330,7 @@ bool Node::startTCP() {
 			}
 		};
 
-		const auto code = user->connect(feedback, m_certChain, m_certKey);
+		const auto code = user->connect(feedback, m_certChain, m_certKey, m_trustStore);
 		if (code != Code::Success) {
 			return false;
 		}
@@ -329,13 +356,21 @@ bool Node::startUDP() {
 	Peer::FeedbackUDP feedbackUDP;
 
 	feedbackUDP.started = []() { printf("UDP started!\n"); };
-	feedbackUDP.stopped = []() { printf("UDP stopped!\n"); };
+	feedbackUDP.stopped = [this]() {
+		printf("UDP stopped!\n");
+
+		const auto stats = m_userManager->lookupStats();
+		for (size_t i = 0; i < stats.size(); ++i) {
+			printf("UDP lookups (%s): %lu\n", UserManager::text(static_cast< UserManager::Lookup >(i)).data(),
+				   static_cast< unsigned long >(stats[i]));
+		}
+	};
 
 	feedbackUDP.failed = [](const Code code) { printf("UDP failed with error \"%s\"!\n", text(code).data()); };
 
 	feedbackUDP.timeout = []() { return 10000; };
 
-	feedbackUDP.legacyPing = [this](Endpoint &endpoint, legacy::udp::Ping &ping) {
+	feedbackUDP.legacyPingV = [this](EndpointV &endpoint, legacy::udp::Ping &ping) {
 		ping.versionBlob  = Endian::toNetwork(lib::version().blob32());
 		ping.sessions     = Endian::toNetwork(m_userManager->num());
 		ping.maxSessions  = Endian::toNetwork(m_userManager->max());
@@ -344,72 +379,130 @@ bool Node::startUDP() {
 		m_server.sendUDP(endpoint, { reinterpret_cast< std::byte * >(&ping), sizeof(ping) });
 	};
 
-	feedbackUDP.ping = [this](Endpoint &endpoint, Message::Ping &ping) {
+	feedbackUDP.pingV = [this](EndpointV &endpoint, Message::Ping &ping) {
 		fillPing(ping);
 
 		m_server.sendUDP(endpoint, Pack(ping).buf());
 	};
 
-	feedbackUDP.encrypted = [this](Endpoint &endpoint, BufView buf) {
-		auto user = (*m_userManager)[endpoint];
+	feedbackUDP.encryptedV = [this](EndpointV &endpoint, BufView buf) {
+		// Everything on this path lives on the stack, no heap allocation takes place per packet.
+		if (buf.size() > User::maxPacketSize) {
+			return;
+		}
 
-		Buf decrypted(buf.size());
+		// Room is left for the session added when a voice packet is forwarded.
+		FixedBuf< User::maxForwardedSize > decrypted;
 
+		auto [user, size] = m_userManager->decrypt(BufView(decrypted).first(User::maxPacketSize), buf, endpoint);
 		if (!user) {
-			user = m_userManager->tryDecrypt(decrypted, buf, endpoint);
-			if (user) {
-				printf("[%s]:%u <-> #%u association added to cache!\n", endpoint.ip.text().data(), endpoint.port,
-					   user->id());
-			} else {
-				return;
-			}
-		}
-
-		auto size = user->decrypt(decrypted, buf);
-		if (!size) {
-			user->delEndpoint(endpoint);
 			return;
 		}
 
 		BufViewConst packet = { decrypted.data(), size };
 
-		if (legacy::udp::type(packet) == legacy::udp::Type::Ping) {
-			printf("[#%u] (UDP) Legacy ping received!\n", user->id());
+		switch (legacy::udp::type(packet)) {
+			case legacy::udp::Type::Ping:
+				printf("[#%u] (UDP) Legacy ping received!\n", user->id());
 
-			size = user->encrypt(buf, packet);
-			if (size) {
-				m_server.sendUDP(endpoint, buf.first(size));
-			}
+				size = user->encrypt(buf, packet);
+				if (size) {
+					m_server.sendUDP(endpoint, buf.first(size));
+				}
 
-			return;
-		}
+				return;
+			case legacy::udp::Type::VoiceOpus: {
+				legacy::udp::Voice voice;
+				if (!legacy::udp::decode(voice, packet, false)) {
+					return;
+				}
 
-		auto header = reinterpret_cast< const NetHeader * >(packet.data());
-		packet      = packet.subspan(sizeof(*header));
+				const auto verdict = user->gate(voice.sequence, voice.payload, voice.isTerminator);
+				if (verdict == SilenceGate::Verdict::Drop) {
+					return;
+				}
+
+				const auto target = voice.target;
+
+				if (verdict == SilenceGate::Verdict::Terminate && !voice.isTerminator) {
+					// The terminator flag is part of the size varint, the packet has to be written again.
+					voice.session      = user->id();
+					voice.target       = 0;
+					voice.isTerminator = true;
+
+					FixedBuf< User::maxForwardedSize > forwarded;
+
+					size = legacy::udp::encode(forwarded, voice);
+					if (size) {
+						forwardUDP(*user, { forwarded.data(), size }, target);
+					}
+
+					return;
+				}
+
+				// Turned into the packet the other clients expect, right where it is.
+				size = legacy::udp::reheader(decrypted, size, user->id(), 0);
+				if (size) {
+					forwardUDP(*user, { decrypted.data(), size }, target);
+				}
 
-		Pack pack(*header, packet.size());
+				return;
+			}
+			default:
+				break;
+		}
 
-		const auto type = Message::type(pack);
+		const auto type = static_cast< Type >(reinterpret_cast< const NetHeader * >(packet.data())->type);
 		if (type != Type::Audio) {
 			printf("[#%u] (UDP) %s received!\n", user->id(), Message::text(type).data());
 		}
 
 		switch (type) {
-			case Type::Audio:
+			case Type::Audio: {
+				legacy::udp::Voice voice;
+				if (!legacy::udp::fromPack(voice, packet)) {
+					break;
+				}
+
+				const auto verdict = user->gate(voice.sequence, voice.payload, voice.isTerminator);
+				if (verdict == SilenceGate::Verdict::Drop) {
+					break;
+				}
+
+				if (verdict == SilenceGate::Verdict::Terminate) {
+					voice.isTerminator = true;
+				}
+
+				const auto target = voice.target;
+
+				voice.session = user->id();
+				voice.target  = 0;
+
+				FixedBuf< User::maxForwardedSize > forwarded;
+
+				size = legacy::udp::toPack(forwarded, voice);
+				if (size) {
+					forwardUDP(*user, { forwarded.data(), size }, target);
+				}
+
 				break;
+			}
 			case Type::Ping: {
-				std::copy(packet.begin(), packet.end(), pack.data().begin());
-
 				Message::Ping ping;
-				if (!pack(ping)) {
+				if (!Pack::read(ping, packet)) {
 					break;
 				}
 
 				if (fillPing(ping)) {
-					pack = Pack(ping);
+					size = Pack::write(decrypted, ping);
+					if (!size) {
+						break;
+					}
+
+					packet = { decrypted.data(), size };
 				}
 
-				size = user->encrypt(buf, pack.buf());
+				size = user->encrypt(buf, packet);
 				if (size) {
 					m_server.sendUDP(endpoint, buf.first(size));
 				}
@@ -428,6 +521,28 @@ bool Node::startUDP() {
 	return true;
 }
 
+void Node::forwardUDP(User &sender, const BufViewConst packet, const uint8_t target) {
+	// Only talking to the current channel (0) and the server loopback (31) are implemented.
+	const bool loopback = target == 31;
+	if (target != 0 && !loopback) {
+		return;
+	}
+
+	FixedBuf< User::maxDatagramSize > encrypted;
+
+	m_userManager->forEach([&](const UserManager::UserPtr &user) {
+		// With loopback the packet only goes back to the sender, otherwise to everyone else.
+		if ((user.get() == &sender) != loopback || user->endpoints().empty()) {
+			return;
+		}
+
+		const auto size = user->encrypt(encrypted, packet);
+		if (size) {
+			m_server.sendUDP(*user->endpoints().cbegin(), { encrypted.data(), size });
+		}
+	});
+}
+
 bool Node::fillPing(udp::Message::Ping &ping) {
 	if (!ping.requestExtendedInformation) {
 		return false;
@@ -468,3 +583,19 @@ bool Node::setCert(const std::string_view certPath, const std::string_view keyPa
 
 	return true;
 }
+
+bool Node::setTrustStore(const std::string_view path) {
+	std::ifstream stream(path.data());
+	std::stringstream buffer;
+	buffer << stream.rdbuf();
+
+	auto trustStore = std::make_shared< TrustStore >();
+	if (!trustStore->addPEM(buffer.str())) {
+		printf("Node::setTrustStore(): Failed to load authorities!\n");
+		return false;
+	}
+
+	m_trustStore = std::move(trustStore);
+
+	return true;
+}
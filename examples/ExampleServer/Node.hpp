@@ -10,6 +10,8 @@
 #include "mumble/Key.hpp"
 #include "mumble/Message.hpp"
 #include "mumble/Peer.hpp"
+#include "mumble/TrustStore.hpp"
+#include "mumble/Types.hpp"
 
 #include <cstdint>
 #include <memory>
@@ -20,6 +22,7 @@ namespace mumble {
 class Session;
 }
 
+class User;
 class UserManager;
 
 class Node {
@@ -33,6 +36,7 @@ public:
 	bool start();
 
 	bool setCert(const std::string_view certPath, const std::string_view keyPath);
+	bool setTrustStore(const std::string_view path);
 
 private:
 	using SessionPtr = std::unique_ptr< mumble::Session >;
@@ -40,6 +44,8 @@ private:
 	bool startTCP();
 	bool startUDP();
 
+	void forwardUDP(User &sender, const mumble::BufViewConst packet, const uint8_t target);
+
 	bool fillPing(mumble::udp::Message::Ping &ping);
 
 	bool m_ok;
@@ -49,6 +55,7 @@ private:
 
 	std::vector< mumble::Cert > m_certChain;
 	mumble::Key m_certKey;
+	std::shared_ptr< mumble::TrustStore > m_trustStore;
 
 	mumble::Peer m_server;
 };
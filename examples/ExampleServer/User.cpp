@@ -10,29 +10,16 @@
 #include "mumble/Connection.hpp"
 #include "mumble/Pack.hpp"
 
-#include <algorithm>
 #include <cstdint>
-
-#include <gsl/byte>
-#include <gsl/span>
+#include <memory>
+#include <mutex>
 
 using namespace mumble;
 
 User::User(const int32_t socketHandle, const uint32_t id)
-	: m_id(id), m_cryptOK(false), m_good(0), m_late(0), m_lost(0), m_decryptHistory({}),
-	  m_connection(std::make_shared< Connection >(socketHandle, true)) {
-	const auto key = m_decrypt.genKey();
-	if (!m_decrypt.setKey(key) || !m_encrypt.setKey(key)) {
-		return;
-	}
-
-	m_decryptNonce = m_decrypt.genNonce();
-	m_encryptNonce = m_encrypt.genNonce();
-	if (!m_decrypt.setNonce(m_decryptNonce) || !m_encrypt.setNonce(m_encryptNonce)) {
-		return;
-	}
-
-	m_cryptOK = true;
+	: m_id(id), m_cryptOK(false), m_connection(std::make_shared< Connection >(socketHandle, true)) {
+	m_cryptOK      = m_crypt.gen();
+	m_peerEndpoint = m_connection->peerEndpoint();
 }
 
 User::~User() = default;
@@ -45,183 +32,118 @@ const std::shared_ptr< Connection > &User::connection() const {
 	return m_connection;
 }
 
+const Endpoint &User::peerEndpoint() const {
+	return m_peerEndpoint;
+}
+
 bool User::cryptOK() const {
 	return m_cryptOK;
 }
 
-uint32_t User::good() const {
-	return m_good;
-}
+User::CryptMode User::cryptMode() const {
+	std::unique_lock lock(m_cryptMutex);
 
-uint32_t User::late() const {
-	return m_late;
+	return m_cryptAEAD ? m_cryptAEAD->mode() : CryptMode::OCB2AES128;
 }
 
-uint32_t User::lost() const {
-	return m_lost;
-}
+bool User::setCryptMode(const std::vector< CryptMode > &modes) {
+	for (const auto mode : modes) {
+		auto crypt = std::make_unique< CryptStateAEAD >(mode, true);
+		if (!*crypt || !crypt->gen()) {
+			continue;
+		}
 
-BufViewConst User::key() const {
-	return m_decrypt.key();
-}
+		std::unique_lock lock(m_cryptMutex);
+
+		m_cryptAEAD = std::move(crypt);
 
-BufViewConst User::decryptNonce() const {
-	return m_decrypt.nonce();
+		return true;
+	}
+
+	return false;
 }
 
-BufViewConst User::encryptNonce() const {
-	return m_encrypt.nonce();
+CryptStateOCB2::Stats User::cryptStats() const {
+	std::unique_lock lock(m_cryptMutex);
+
+	return m_cryptAEAD ? m_cryptAEAD->stats() : m_crypt.stats();
 }
 
-size_t User::decrypt(const BufView out, const BufViewConst in) {
-	// The checksum header occupies 4 bytes.
-	if (in.size() < 4) {
-		return {};
-	}
+Buf User::key() const {
+	std::unique_lock lock(m_cryptMutex);
 
-	const auto nonceByte = static_cast< uint8_t >(in[0]);
-	const auto tag       = in.subspan(1, 3);
-	const auto encrypted = in.subspan(4);
-	const auto prevNonce = m_decryptNonce;
-
-	gsl::span< uint8_t > nonce(reinterpret_cast< uint8_t * >(m_decryptNonce.data()), m_decryptNonce.size());
-
-	bool restore = false;
-
-	int32_t lost = 0;
-	int32_t late = 0;
-
-	if (((nonce[0] + 1) & 0xFF) == nonceByte) {
-		// In order as expected.
-		if (nonceByte > nonce[0]) {
-			nonce[0] = nonceByte;
-		} else if (nonceByte < nonce[0]) {
-			nonce[0] = nonceByte;
-			for (uint32_t i = 1; i < nonce.size(); ++i)
-				if (++nonce[i])
-					break;
-		} else {
-			return {};
-		}
-	} else {
-		// This is either out of order or a repeat.
-
-		int32_t diff = nonceByte - nonce[0];
-		if (diff > 128)
-			diff = diff - 256;
-		else if (diff < -128)
-			diff = diff + 256;
-
-		if ((nonceByte < nonce[0]) && (diff > -30) && (diff < 0)) {
-			// Late packet, but no wraparound.
-			late     = 1;
-			lost     = -1;
-			nonce[0] = nonceByte;
-			restore  = true;
-		} else if ((nonceByte > nonce[0]) && (diff > -30) && (diff < 0)) {
-			// Last was 0x02, here comes 0xff from last round
-			late     = 1;
-			lost     = -1;
-			nonce[0] = nonceByte;
-			for (uint32_t i = 1; i < nonce.size(); ++i) {
-				if (nonce[i]--)
-					break;
-			}
-
-			restore = true;
-		} else if ((nonceByte > nonce[0]) && (diff > 0)) {
-			// Lost a few packets, but beyond that we're good.
-			lost     = nonceByte - nonce[0] - 1;
-			nonce[0] = nonceByte;
-		} else if ((nonceByte < nonce[0]) && (diff > 0)) {
-			// Lost a few packets, and wrapped around
-			lost     = 256 - nonce[0] + nonceByte - 1;
-			nonce[0] = nonceByte;
-			for (uint32_t i = 1; i < nonce.size(); ++i)
-				if (++nonce[i])
-					break;
-		} else {
-			return {};
-		}
+	const auto ret = m_cryptAEAD ? m_cryptAEAD->key() : m_crypt.key();
 
-		if (m_decryptHistory[nonce[0]] == nonce[1]) {
-			m_decryptNonce = prevNonce;
-			return {};
-		}
-	}
+	return { ret.begin(), ret.end() };
+}
 
-	if (!m_decrypt.setNonce(m_decryptNonce)) {
-		return {};
-	}
+Buf User::decryptNonce() const {
+	std::unique_lock lock(m_cryptMutex);
 
-	const auto written = m_decrypt.decrypt(out, encrypted, tag);
-	if (!written) {
-		m_decryptNonce = prevNonce;
-		return {};
-	}
+	const auto ret = m_cryptAEAD ? m_cryptAEAD->decryptNonce() : m_crypt.decryptNonce();
 
-	m_decryptHistory[nonce[0]] = nonce[1];
+	return { ret.begin(), ret.end() };
+}
 
-	if (restore) {
-		m_decryptNonce = prevNonce;
-	}
+Buf User::encryptNonce() const {
+	std::unique_lock lock(m_cryptMutex);
 
-	++m_good;
-	m_late += late;
-	m_lost += lost;
+	const auto ret = m_cryptAEAD ? m_cryptAEAD->encryptNonce() : m_crypt.encryptNonce();
 
-	return written;
+	return { ret.begin(), ret.end() };
 }
 
-size_t User::encrypt(const BufView out, const BufViewConst in) {
-	// The maximum packet size allowed in the Mumble protocol is 1024 bytes.
-	// 4 bytes are used for the checksum header, leaving 1020 bytes for the data.
-	if (out.size() < 4 || in.size() > 1020) {
-		return {};
-	}
+bool User::resync(const BufViewConst decryptNonce) {
+	std::unique_lock lock(m_cryptMutex);
 
-	for (auto &byte : m_encryptNonce) {
-		if (++*reinterpret_cast< uint8_t * >(&byte)) {
-			break;
-		}
-	}
+	return m_cryptAEAD ? m_cryptAEAD->setDecryptNonce(decryptNonce) : m_crypt.setDecryptNonce(decryptNonce);
+}
 
-	if (!m_encrypt.setNonce(m_encryptNonce)) {
-		return {};
+uint8_t User::nonceDistance(const BufViewConst in) const {
+	if (in.empty()) {
+		return UINT8_MAX;
 	}
 
-	const auto encrypted = out.subspan(4);
-	if (encrypted.empty()) {
-		return {};
-	}
+	std::unique_lock lock(m_cryptMutex);
+
+	// Both modes transmit the lowest byte of the nonce first.
+	const auto nonce = m_cryptAEAD ? m_cryptAEAD->decryptNonce() : m_crypt.decryptNonce();
+	const auto ahead = static_cast< uint8_t >(std::to_integer< uint8_t >(in[0]) - std::to_integer< uint8_t >(nonce[0]));
+
+	return ahead <= 128 ? ahead : static_cast< uint8_t >(-ahead);
+}
+
+size_t User::decrypt(const BufView out, const BufViewConst in) {
+	std::unique_lock lock(m_cryptMutex);
 
-	Buf tag(m_encrypt.blockSize());
+	return m_cryptAEAD ? m_cryptAEAD->decrypt(out, in) : m_crypt.decrypt(out, in);
+}
 
-	const auto written = m_encrypt.encrypt(encrypted, in, tag);
-	if (!written) {
+size_t User::encrypt(const BufView out, const BufViewConst in) {
+	if (in.size() > maxForwardedSize) {
 		return {};
 	}
 
-	out[0] = m_encryptNonce[0];
-	std::copy_n(tag.cbegin(), 3, out.begin() + 1);
+	std::unique_lock lock(m_cryptMutex);
 
-	return written + 4;
+	return m_cryptAEAD ? m_cryptAEAD->encrypt(out, in) : m_crypt.encrypt(out, in);
 }
 
 const Endpoints &User::endpoints() const {
 	return m_endpoints;
 }
 
-void User::addEndpoint(const Endpoint &endpoint) {
+void User::addEndpoint(const EndpointV &endpoint) {
 	m_endpoints.emplace(endpoint);
 }
 
-void User::delEndpoint(const Endpoint &endpoint) {
+void User::delEndpoint(const EndpointV &endpoint) {
 	m_endpoints.extract(endpoint);
 }
 
-Code User::connect(const Connection::Feedback &feedback, const Cert::Chain &cert, const Key &key) {
-	if (!m_connection->setCert(cert, key)) {
+Code User::connect(const Connection::Feedback &feedback, const Cert::Chain &cert, const Key &key,
+				   const std::shared_ptr< TrustStore > &trustStore) {
+	if (!m_connection->setCert(cert, key) || !m_connection->setTrustStore(trustStore)) {
 		return Code::Failure;
 	}
 
@@ -235,3 +157,9 @@ void User::send(const Message &message) {
 void User::send(const Pack &pack) {
 	m_connection->write(pack.buf());
 }
+
+User::SilenceGate::Verdict User::gate(const uint64_t number, const BufViewConst opusData, const bool terminator) {
+	const std::lock_guard lock(m_gateMutex);
+
+	return m_gate(number, opusData, terminator);
+}
@@ -10,13 +10,16 @@
 
 #include "mumble/Cert.hpp"
 #include "mumble/Connection.hpp"
-#include "mumble/CryptOCB2.hpp"
+#include "mumble/CryptStateAEAD.hpp"
+#include "mumble/CryptStateOCB2.hpp"
+#include "mumble/SilenceGate.hpp"
+#include "mumble/TrustStore.hpp"
 #include "mumble/Types.hpp"
 
-#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -31,15 +34,27 @@ namespace tcp {
 
 class User {
 public:
-	using BufView      = mumble::BufView;
-	using BufViewConst = mumble::BufViewConst;
-	using Cert         = mumble::Cert;
-	using Code         = mumble::Code;
-	using Connection   = mumble::Connection;
-	using CryptOCB2    = mumble::CryptOCB2;
-	using Key          = mumble::Key;
-	using Message      = mumble::tcp::Message;
-	using Pack         = mumble::tcp::Pack;
+	using Buf            = mumble::Buf;
+	using BufView        = mumble::BufView;
+	using BufViewConst   = mumble::BufViewConst;
+	using Cert           = mumble::Cert;
+	using Code           = mumble::Code;
+	using Connection     = mumble::Connection;
+	using CryptMode      = mumble::CryptStateAEAD::Mode;
+	using CryptStateAEAD = mumble::CryptStateAEAD;
+	using CryptStateOCB2 = mumble::CryptStateOCB2;
+	using Key            = mumble::Key;
+	using Message        = mumble::tcp::Message;
+	using Pack           = mumble::tcp::Pack;
+	using SilenceGate    = mumble::SilenceGate;
+	using TrustStore     = mumble::TrustStore;
+
+	// The maximum packet size allowed in the Mumble protocol.
+	static constexpr size_t maxPacketSize = 1024;
+	// A voice packet grows when it's forwarded, the sender's session is added: a varint of up to 5 bytes, plus the
+	// field tag in the protobuf format. Clients accept larger datagrams than the ones they send.
+	static constexpr size_t maxForwardedSize = maxPacketSize + 6;
+	static constexpr size_t maxDatagramSize  = maxForwardedSize + CryptStateAEAD::headerSize;
 
 	struct Packet {
 		mumble::Endpoint endpoint;
@@ -67,42 +82,59 @@ public:
 
 	const std::shared_ptr< Connection > &connection() const;
 
+	// The endpoint of the TCP connection, used as a hint to associate UDP packets.
+	const Endpoint &peerEndpoint() const;
+
 	bool cryptOK() const;
 
-	uint32_t good() const;
-	uint32_t late() const;
-	uint32_t lost() const;
+	CryptMode cryptMode() const;
+	// Switches to the first supported mode among the ones offered by the client, with a new key and nonces.
+	// Returns false (keeping the current mode) if none is supported.
+	bool setCryptMode(const std::vector< CryptMode > &modes);
+
+	CryptStateOCB2::Stats cryptStats() const;
+
+	// Copies, the state they come from can be replaced by setCryptMode() at any time.
+	Buf key() const;
 
-	BufViewConst key() const;
+	Buf decryptNonce() const;
+	Buf encryptNonce() const;
 
-	BufViewConst decryptNonce() const;
-	BufViewConst encryptNonce() const;
+	bool resync(const BufViewConst decryptNonce);
+
+	// How far the packet's nonce byte is from the one we expect next, the closest candidate is tried first.
+	uint8_t nonceDistance(const BufViewConst in) const;
 
 	size_t decrypt(const BufView out, const BufViewConst in);
 	size_t encrypt(const BufView out, const BufViewConst in);
 
 	const Endpoints &endpoints() const;
-	void addEndpoint(const Endpoint &endpoint);
-	void delEndpoint(const Endpoint &endpoint);
+	void addEndpoint(const EndpointV &endpoint);
+	void delEndpoint(const EndpointV &endpoint);
 
-	Code connect(const Connection::Feedback &feedback, const Cert::Chain &cert, const Key &key);
+	Code connect(const Connection::Feedback &feedback, const Cert::Chain &cert, const Key &key,
+				 const std::shared_ptr< TrustStore > &trustStore);
 
 	void send(const Message &message);
 	void send(const Pack &pack);
 
+	// Whether the voice packet is to be forwarded, silence is held back once the user stops talking.
+	SilenceGate::Verdict gate(const uint64_t number, const BufViewConst opusData, const bool terminator);
+
 private:
 	uint32_t m_id;
 	bool m_cryptOK;
-	uint32_t m_good;
-	uint32_t m_late;
-	uint32_t m_lost;
 	Endpoints m_endpoints;
-	CryptOCB2 m_decrypt;
-	CryptOCB2 m_encrypt;
-	std::vector< std::byte > m_decryptNonce;
-	std::vector< std::byte > m_encryptNonce;
-	std::array< uint8_t, UINT8_MAX + 1 > m_decryptHistory;
+	CryptStateOCB2 m_crypt;
+	// Used instead of "m_crypt" once the client switched to an AEAD mode.
+	std::unique_ptr< CryptStateAEAD > m_cryptAEAD;
+	// Packets are decrypted by the UDP threads and the scan workers, the TCP thread resets the nonce and changes the
+	// mode.
+	mutable std::mutex m_cryptMutex;
 	std::shared_ptr< Connection > m_connection;
+	Endpoint m_peerEndpoint;
+	SilenceGate m_gate;
+	std::mutex m_gateMutex;
 };
 
 #endif
@@ -8,35 +8,65 @@
 #include "Endpoints.hpp"
 #include "User.hpp"
 
+#include <algorithm>
 #include <mutex>
 #include <unordered_set>
 #include <utility>
 
+#ifndef MUMBLE_COMPILER_MSVC
+#	include <quickpool.hpp>
+#else
+#	pragma warning(push)
+#	pragma warning(disable : 4244)
+#	pragma warning(disable : 4324)
+#	include <quickpool.hpp>
+#	pragma warning(pop)
+#endif
+
 using namespace mumble;
 
-using UserPtr = UserManager::UserPtr;
+using Lookup      = UserManager::Lookup;
+using LookupStats = UserManager::LookupStats;
+using UserPtr     = UserManager::UserPtr;
+
+using Result = std::pair< UserPtr, size_t >;
+
+UserManager::UserManager(const uint32_t max, const uint32_t workers)
+	: m_minID(1), m_maxID(max), m_scanOffset(0), m_scanTokens(scanBurst), m_scanRefill(Clock::now()),
+	  m_pool(std::make_unique< quickpool::ThreadPool >(std::max(workers, 1u))) {
+	for (auto &lookup : m_lookups) {
+		lookup = 0;
+	}
 
-UserManager::UserManager(const uint32_t max) : m_minID(1), m_maxID(max) {
+	m_scanned.reserve(maxScanned);
 }
 
 UserManager::~UserManager() = default;
 
-UserPtr UserManager::operator[](const uint32_t id) {
-	std::shared_lock lock(m_mutex);
-
-	const auto iter = m_users.find(id);
-	if (iter != m_users.cend()) {
-		return iter->second;
+std::string_view UserManager::text(const Lookup lookup) {
+	switch (lookup) {
+		case Lookup::Cached:
+			return "Cached";
+		case Lookup::Hinted:
+			return "Hinted";
+		case Lookup::Scanned:
+			return "Scanned";
+		case Lookup::Rejected:
+			return "Rejected";
+		case Lookup::RateLimited:
+			return "RateLimited";
+		case Lookup::Unknown:
+			return "Unknown";
 	}
 
 	return {};
 }
 
-UserPtr UserManager::operator[](const Endpoint &endpoint) {
+UserPtr UserManager::operator[](const uint32_t id) {
 	std::shared_lock lock(m_mutex);
 
-	const auto iter = m_endpoints.find(endpoint);
-	if (iter != m_endpoints.cend()) {
+	const auto iter = m_users.find(id);
+	if (iter != m_users.cend()) {
 		return iter->second;
 	}
 
@@ -81,6 +111,7 @@ void UserManager::add(const UserPtr &user) {
 	std::unique_lock lock(m_mutex);
 
 	m_users[user->id()] = user;
+	m_hints.emplace(user->peerEndpoint().ip.value(), user);
 }
 
 void UserManager::del(const uint32_t id) {
@@ -94,32 +125,201 @@ void UserManager::del(const uint32_t id) {
 	for (const auto &endpoint : user->endpoints()) {
 		m_endpoints.erase(endpoint);
 	}
+
+	auto range = m_hints.equal_range(user->peerEndpoint().ip.value());
+	while (range.first != range.second) {
+		if (range.first->second == user) {
+			range.first = m_hints.erase(range.first);
+		} else {
+			++range.first;
+		}
+	}
+}
+
+Result UserManager::decrypt(const BufView out, const BufViewConst in, const EndpointV &endpoint) {
+	// The user associated to the endpoint is the only one that is tried: if it can't decrypt the packet
+	// (e.g. because it's a replay) nobody else can, and scanning would only amplify the cost of garbage.
+	{
+		std::shared_lock lock(m_mutex);
+
+		if (const auto cached = m_endpoints.find(endpoint)) {
+			const auto user = *cached;
+			lock.unlock();
+
+			const auto written = user->decrypt(out, in);
+			return count(written ? Lookup::Cached : Lookup::Rejected, { written ? user : nullptr, written });
+		}
+	}
+
+	auto result = tryHinted(out, in, endpoint);
+	if (result.first) {
+		associate(result.first, endpoint);
+		return count(Lookup::Hinted, result);
+	}
+
+	if (!takeScanToken()) {
+		return count(Lookup::RateLimited);
+	}
+
+	result = tryScan(out, in);
+	if (result.first) {
+		associate(result.first, endpoint);
+		return count(Lookup::Scanned, result);
+	}
+
+	return count(Lookup::Unknown);
 }
 
-UserPtr UserManager::tryDecrypt(const BufView out, const BufViewConst in, const Endpoint &endpoint) {
-	UserPtr user;
+LookupStats UserManager::lookupStats() const {
+	LookupStats stats;
+
+	for (size_t i = 0; i < stats.size(); ++i) {
+		stats[i] = m_lookups[i];
+	}
+
+	return stats;
+}
+
+Result UserManager::tryHinted(const BufView out, const BufViewConst in, const EndpointV &endpoint) {
+	// Narrows the candidates down to the users whose TCP connection comes from the same IP,
+	// then to the ones whose next expected nonce byte is closest to the packet's.
+	std::array< std::pair< uint8_t, UserPtr >, maxHinted > candidates;
+	uint8_t num = 0;
 
 	{
 		std::shared_lock lock(m_mutex);
 
-		for (auto &iter : m_users) {
-			if (iter.second && iter.second->decrypt(out, in)) {
-				user = iter.second;
+		const auto range = m_hints.equal_range(endpoint.ip);
+		for (auto iter = range.first; iter != range.second; ++iter) {
+			const auto distance = iter->second->nonceDistance(in);
+			if (!distance) {
+				// Replay of the newest packet, it would be rejected anyway.
+				continue;
+			}
+
+			if (num < candidates.size()) {
+				candidates[num++] = { distance, iter->second };
+				continue;
+			}
+
+			auto &farthest = *std::max_element(candidates.begin(), candidates.end(),
+											   [](const auto &a, const auto &b) { return a.first < b.first; });
+			if (distance < farthest.first) {
+				farthest = { distance, iter->second };
 			}
 		}
 	}
 
-	if (!user) {
+	std::sort(candidates.begin(), candidates.begin() + num,
+			  [](const auto &a, const auto &b) { return a.first < b.first; });
+
+	for (uint8_t i = 0; i < num; ++i) {
+		const auto &user = candidates[i].second;
+		if (const auto written = user->decrypt(out, in)) {
+			return { user, written };
+		}
+	}
+
+	return {};
+}
+
+Result UserManager::tryScan(const BufView out, const BufViewConst in) {
+	if (out.size() > User::maxPacketSize) {
 		return {};
 	}
 
+	std::unique_lock scanLock(m_scanMutex);
+
 	{
-		std::unique_lock lock(m_mutex);
+		std::shared_lock lock(m_mutex);
+
+		const auto users = static_cast< uint32_t >(m_users.size());
+		if (!users) {
+			return {};
+		}
+
+		// Rotating the starting point makes sure that all users are eventually tried when there are more than the
+		// bound.
+		const uint32_t start = m_scanOffset % users;
+		const uint32_t end   = start + std::min(users, maxScanned);
 
-		user->addEndpoint(endpoint);
+		m_scanOffset = end % users;
 
-		m_endpoints.insert_or_assign(endpoint, user);
+		uint32_t i = 0;
+		for (uint8_t pass = 0; pass < 2 && i < end; ++pass) {
+			for (const auto &iter : m_users) {
+				if (i >= end) {
+					break;
+				}
+
+				if (i++ >= start && iter.second) {
+					m_scanned.push_back(iter.second);
+				}
+			}
+		}
 	}
 
-	return user;
+	std::atomic_bool found(false);
+	Result result;
+
+	// Returns once every candidate was tried or skipped.
+	m_pool->parallel_for(0, static_cast< int >(m_scanned.size()), [&](const int i) {
+		if (found) {
+			return;
+		}
+
+		FixedBuf< User::maxPacketSize > buf;
+		const BufView decrypted = { buf.data(), out.size() };
+
+		const auto &user = m_scanned[static_cast< size_t >(i)];
+		if (const auto written = user->decrypt(decrypted, in)) {
+			// Only the user the packet belongs to can decrypt it, so this is a formality.
+			if (!found.exchange(true)) {
+				std::copy(decrypted.begin(), decrypted.begin() + written, out.begin());
+				result = { user, written };
+			}
+		}
+	});
+
+	m_scanned.clear();
+
+	return result;
+}
+
+bool UserManager::takeScanToken() {
+	std::unique_lock lock(m_scanMutex);
+
+	const auto now     = Clock::now();
+	const auto elapsed = std::chrono::duration< double >(now - m_scanRefill).count();
+
+	m_scanRefill = now;
+	m_scanTokens = std::min< double >(scanBurst, m_scanTokens + elapsed * scanRate);
+
+	if (m_scanTokens < 1) {
+		return false;
+	}
+
+	--m_scanTokens;
+
+	return true;
+}
+
+void UserManager::associate(const UserPtr &user, const EndpointV &endpoint) {
+	std::unique_lock lock(m_mutex);
+
+	// The user may have disconnected in the meantime.
+	const auto iter = m_users.find(user->id());
+	if (iter == m_users.cend() || iter->second != user) {
+		return;
+	}
+
+	user->addEndpoint(endpoint);
+
+	m_endpoints.insert(endpoint, user);
+}
+
+Result UserManager::count(const Lookup lookup, Result result) {
+	++m_lookups[static_cast< size_t >(lookup)];
+
+	return result;
 }
@@ -8,27 +8,56 @@
 
 #include "Endpoints.hpp"
 
+#include "mumble/EndpointHash.hpp"
+#include "mumble/EndpointMap.hpp"
+#include "mumble/IP.hpp"
 #include "mumble/Types.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <shared_mutex>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 class User;
 
+namespace quickpool {
+class ThreadPool;
+}
+
 class UserManager {
 public:
-	UserManager(const uint32_t max);
-	~UserManager();
+	// How the user a UDP packet belongs to was found, or why it wasn't.
+	enum class Lookup : uint8_t {
+		Cached,      // The endpoint was already associated.
+		Hinted,      // The IP matches the one of a TCP connection.
+		Scanned,     // Fallback scan.
+		Rejected,    // The associated user couldn't decrypt the packet.
+		RateLimited, // The fallback scan was skipped to keep up with legitimate traffic.
+		Unknown      // Nobody could decrypt the packet.
+	};
+
+	static constexpr size_t lookups = static_cast< size_t >(Lookup::Unknown) + 1;
 
 	using BufView      = mumble::BufView;
 	using BufViewConst = mumble::BufViewConst;
+	using LookupStats  = std::array< uint64_t, lookups >;
 	using UserPtr      = std::shared_ptr< User >;
 
+	UserManager(const uint32_t max, const uint32_t workers);
+	~UserManager();
+
+	static std::string_view text(const Lookup lookup);
+
 	UserPtr operator[](const uint32_t id);
-	UserPtr operator[](const Endpoint &endpoint);
 
 	bool full();
 
@@ -40,15 +69,58 @@ public:
 	void add(const UserPtr &user);
 	void del(const uint32_t id);
 
-	UserPtr tryDecrypt(const BufView out, const BufViewConst in, const Endpoint &endpoint);
+	// Finds the user the packet belongs to and decrypts it, associating the endpoint to the user on success.
+	// Returns the user and the number of bytes written into "out".
+	std::pair< UserPtr, size_t > decrypt(const BufView out, const BufViewConst in, const EndpointV &endpoint);
+
+	LookupStats lookupStats() const;
+
+	// Calls "func" for every user, with the lock held. A template so that no std::function has to be created.
+	template< typename Func > void forEach(const Func &func) {
+		std::shared_lock lock(m_mutex);
+
+		for (const auto &iter : m_users) {
+			if (iter.second) {
+				func(iter.second);
+			}
+		}
+	}
 
 private:
-	void thread();
+	using Clock = std::chrono::steady_clock;
+
+	// At most this many users sharing the packet's IP are tried, closest nonce first.
+	static constexpr uint8_t maxHinted = 2;
+	// The scan tries at most this many users per packet, starting where the previous one stopped.
+	static constexpr uint32_t maxScanned = 1024;
+	// Token bucket: scans per second and burst.
+	static constexpr uint32_t scanRate  = 50;
+	static constexpr uint32_t scanBurst = 10;
+
+	std::pair< UserPtr, size_t > tryHinted(const BufView out, const BufViewConst in, const EndpointV &endpoint);
+	std::pair< UserPtr, size_t > tryScan(const BufView out, const BufViewConst in);
+
+	bool takeScanToken();
+
+	void associate(const UserPtr &user, const EndpointV &endpoint);
+
+	std::pair< UserPtr, size_t > count(const Lookup lookup, std::pair< UserPtr, size_t > result = {});
 
 	uint32_t m_minID, m_maxID;
 	std::shared_mutex m_mutex;
 	std::unordered_map< uint32_t, UserPtr > m_users;
-	std::unordered_map< Endpoint, UserPtr > m_endpoints;
+	mumble::EndpointMap< UserPtr > m_endpoints;
+	std::unordered_multimap< mumble::IPValue, UserPtr, mumble::EndpointHash > m_hints;
+
+	std::array< std::atomic< uint64_t >, lookups > m_lookups;
+
+	// Only one scan at a time, the workers are shared.
+	std::mutex m_scanMutex;
+	uint32_t m_scanOffset;
+	double m_scanTokens;
+	Clock::time_point m_scanRefill;
+	std::vector< UserPtr > m_scanned;
+	std::unique_ptr< quickpool::ThreadPool > m_pool;
 };
 
 #endif
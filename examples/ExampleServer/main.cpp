@@ -14,6 +14,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -43,7 +44,8 @@ int32_t main(const int argc, const char **argv) {
 		return 2;
 	}
 
-	auto userManager = std::make_shared< UserManager >(toml::find< uint32_t >(conf, "maxUsers"));
+	auto userManager = std::make_shared< UserManager >(toml::find< uint32_t >(conf, "maxUsers"),
+													  std::thread::hardware_concurrency());
 
 	std::vector< std::unique_ptr< Node > > nodes;
 
@@ -53,6 +55,7 @@ int32_t main(const int argc, const char **argv) {
 		const auto &identity = toml::find(nodeConf.second, "identity");
 		const auto cert      = toml::find< std::string_view >(identity, "cert");
 		const auto key       = toml::find< std::string_view >(identity, "key");
+		const auto trust     = toml::find_or< std::string >(identity, "trust", {});
 
 		const auto &tcp    = toml::find(nodeConf.second, "tcp");
 		const auto tcpIP   = toml::find< std::string_view >(tcp, "ip");
@@ -71,6 +74,10 @@ int32_t main(const int argc, const char **argv) {
 			return 4;
 		}
 
+		if (!trust.empty() && !node->setTrustStore(trust)) {
+			return 4;
+		}
+
 		if (!node->start()) {
 			return 5;
 		}
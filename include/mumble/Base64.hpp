@@ -13,6 +13,10 @@
 #include <memory>
 
 namespace mumble {
+// Standard Base64 (RFC 4648) with padding, accelerated with SSSE3 or AVX2 when the CPU supports them.
+//
+// Decoding skips spaces, tabs, carriage returns and newlines anywhere in the input and stops at the first '-'.
+// Any other character outside of the alphabet, data after padding and incomplete groups of 4 are errors.
 class MUMBLE_EXPORT Base64 : NonCopyable {
 public:
 	class P;
@@ -23,8 +27,21 @@ public:
 	virtual explicit operator bool();
 
 	virtual size_t decode(const BufView out, const BufViewConst in);
+	// The output is NUL terminated if there's room for it, the terminator is always included in the returned size.
 	static size_t encode(const BufView out, const BufViewConst in);
 
+	// Streaming interface, for input that arrives in chunks or is too big to be kept in memory at once.
+	// The state is kept in this object, the update functions can be called any number of times before the final ones.
+	//
+	// decodeUpdate() returns the number of bytes written, "out" must be able to hold in.size() / 4 * 3 + 3 bytes.
+	// Errors are reported by decodeFinal(), which also resets the state.
+	virtual size_t decodeUpdate(const BufView out, const BufViewConst in);
+	virtual bool decodeFinal();
+	// encodeUpdate() returns the number of characters written, "out" must be able to hold in.size() / 3 * 4 + 4 bytes.
+	// encodeFinal() writes the last (up to 4) characters and resets the state. No NUL terminator is written.
+	virtual size_t encodeUpdate(const BufView out, const BufViewConst in);
+	virtual size_t encodeFinal(const BufView out);
+
 private:
 	std::unique_ptr< P > m_p;
 };
@@ -0,0 +1,84 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_BITRATELIMITER_HPP
+#define MUMBLE_BITRATELIMITER_HPP
+
+#include "Macros.hpp"
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mumble {
+// Enforces the maximum bitrate of each sender (ServerSync::maxBandwidth) before their voice packets are fanned out,
+// so that a client going over it doesn't cost that much more for every listener.
+//
+// Each session has a token bucket that fills up at the allowed bitrate and holds up to "burst" worth of it, a packet
+// takes its size from the bucket. A packet that doesn't fit is over budget: depending on the policy, it's either
+// flagged (the caller decides what to do, e.g. forward it to fewer listeners) or dropped. Either way it doesn't take
+// anything from the bucket.
+//
+// The size of a packet is up to the caller, typically the datagram plus the IP and UDP headers: that's what clients
+// account for when they compute the bitrate they can afford.
+//
+// A session that doesn't send anything for "idle" loses its bucket (and its stats), it starts over with a full one like
+// a new session. That's the case for those that are gone, so calling remove() when a session ends is not required; it
+// only frees the memory sooner. An idle duration of 0 disables the expiry, remove() is then the only way to free it.
+// Shorter than the burst, it's raised to the burst: an expired bucket would be full by then anyway.
+//
+// All functions are thread-safe.
+class MUMBLE_EXPORT BitrateLimiter : NonCopyable {
+public:
+	class P;
+
+	using Clock     = std::chrono::steady_clock;
+	using TimePoint = Clock::time_point;
+
+	enum class Policy : uint8_t { Flag, Drop };
+	enum class Verdict : uint8_t { Pass, Flag, Drop };
+
+	struct Stats {
+		uint64_t passed  = 0;
+		uint64_t flagged = 0;
+		uint64_t dropped = 0;
+		// Sum of the sizes of the packets that were let through, flagged ones included.
+		uint64_t bytes = 0;
+	};
+
+	// A bitrate of 0 means no limit.
+	BitrateLimiter(const uint32_t bitrate, const Policy policy = Policy::Drop,
+				   const std::chrono::milliseconds burst = std::chrono::seconds(1),
+				   const std::chrono::milliseconds idle  = std::chrono::minutes(1));
+	virtual ~BitrateLimiter();
+
+	virtual explicit operator bool() const;
+
+	virtual uint32_t bitrate() const;
+	// Applies to all sessions, their buckets keep the tokens they have.
+	virtual bool setBitrate(const uint32_t bitrate);
+
+	virtual Policy policy() const;
+
+	virtual Verdict operator()(const uint32_t session, const size_t size, const TimePoint now = Clock::now());
+	// Also validates the Opus packet (see Opus::inspect()): malformed ones, or longer than 120 ms, are dropped
+	// whatever the policy. An empty packet (terminator) is accepted.
+	virtual Verdict operator()(const uint32_t session, const BufViewConst opusPacket, const size_t size,
+							   const TimePoint now = Clock::now());
+
+	virtual Stats stats(const uint32_t session) const;
+
+	virtual size_t sessions() const;
+	virtual bool remove(const uint32_t session);
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
@@ -14,6 +14,7 @@
 #include <chrono>
 #include <map>
 #include <memory>
+#include <string_view>
 
 namespace mumble {
 class MUMBLE_EXPORT Cert {
@@ -27,6 +28,16 @@ public:
 	using DerViewConst = gsl::span< const std::byte >;
 	using TimePoint    = std::chrono::system_clock::time_point;
 
+	// What is usually needed to identify a peer, computed once per certificate.
+	struct Identity {
+		Der sha1;
+		Der sha256;
+		Attributes subjectAttributes;
+		Attributes issuerAttributes;
+	};
+
+	using IdentityPtr = std::shared_ptr< const Identity >;
+
 	Cert();
 	Cert(const Cert &cert);
 	Cert(Cert &&cert);
@@ -59,6 +70,17 @@ public:
 	virtual Attributes subjectAttributes() const;
 	virtual Attributes issuerAttributes() const;
 
+	// Digest of the DER encoding, "type" is the name of the hash algorithm.
+	virtual Der fingerprint(const std::string_view type = "SHA256") const;
+
+	// Shared by all instances of the same certificate: the result is kept in a process-wide LRU cache,
+	// indexed by the SHA-256 fingerprint, so that the certificate is only parsed the first time it's seen.
+	virtual IdentityPtr identity() const;
+
+	// Creates a certificate for "key", signed with the key itself, valid from now until "validity" has elapsed.
+	// "subject" is used for both the subject and the issuer, the keys are short names (e.g. "CN", "O").
+	static Cert selfSigned(const Key &key, const Attributes &subject, const std::chrono::seconds validity);
+
 private:
 	std::unique_ptr< P > m_p;
 };
@@ -12,8 +12,11 @@
 #include "NonCopyable.hpp"
 
 #include <functional>
+#include <memory>
 
 namespace mumble {
+class TrustStore;
+
 namespace tcp {
 	class Pack;
 }
@@ -51,9 +54,15 @@ public:
 	virtual Endpoint peerEndpoint() const;
 
 	virtual const Cert::Chain &cert() const;
-	virtual Cert::Chain peerCert() const;
+	// The peer's chain and the identity of its first certificate are retrieved once, when the connection is
+	// established. The identity is null if the peer didn't provide a certificate.
+	virtual const Cert::Chain &peerCert() const;
+	virtual const Cert::IdentityPtr &peerIdentity() const;
 
 	virtual bool setCert(const Cert::Chain &cert, const Key &key);
+	// The peer's certificate chain is verified against the store during the handshake, which fails if the chain is
+	// not trusted. A peer not providing a certificate is still accepted. By default, any certificate is accepted.
+	virtual bool setTrustStore(const std::shared_ptr< TrustStore > &store);
 
 	virtual Code process(
 		const bool wait = true, const std::function< bool() > halt = []() { return false; });
@@ -13,6 +13,15 @@
 #include <memory>
 
 namespace mumble {
+// Generic cipher, backed by OpenSSL's EVP interface.
+//
+// Cost model:
+// - setCipher(): the algorithm is fetched once per process and cached, later calls only initialize the contexts.
+// - setKey(): computes the key schedule, once for each direction. The expensive part, avoid calling it per packet.
+// - setNonce(): only stores the nonce, which is applied at the start of every encrypt()/decrypt() call.
+// - encrypt()/decrypt(): separate contexts are kept for each direction, alternating between them costs nothing extra.
+//
+// handle() returns the encryption context.
 class MUMBLE_EXPORT Crypt : NonCopyable {
 public:
 	class P;
@@ -36,10 +45,14 @@ public:
 
 	virtual BufViewConst key() const;
 	virtual Buf genKey() const;
+	// Fills "key", which must be exactly keySize() bytes big.
+	virtual bool genKey(const BufView key) const;
 	virtual bool setKey(const BufViewConst key);
 
 	virtual BufViewConst nonce() const;
 	virtual Buf genNonce() const;
+	// Fills "nonce", which must be exactly nonceSize() bytes big.
+	virtual bool genNonce(const BufView nonce) const;
 	virtual bool setNonce(const BufViewConst nonce);
 
 	virtual bool usesPadding() const;
@@ -47,11 +60,20 @@ public:
 
 	virtual bool reset();
 
+	// "out" can be the same buffer as "in" for in-place processing, partially overlapping buffers are not supported.
+	// "aad" is only authenticated, it's passed to the cipher as is.
 	virtual size_t decrypt(const BufView out, const BufViewConst in, const BufViewConst tag = {},
 						   const BufViewConst aad = {});
 	virtual size_t encrypt(const BufView out, const BufViewConst in, const BufView tag = {},
 						   const BufViewConst aad = {});
 
+	// Same as above, but "in" is made of parts (e.g. a header and a body) that don't have to be copied together first.
+	// The output is contiguous, a part can be processed in place if it's where its output goes in "out".
+	virtual size_t decrypt(const BufView out, const BufViewsConst in, const BufViewConst tag = {},
+						   const BufViewConst aad = {});
+	virtual size_t encrypt(const BufView out, const BufViewsConst in, const BufView tag = {},
+						   const BufViewConst aad = {});
+
 private:
 	std::unique_ptr< P > m_p;
 };
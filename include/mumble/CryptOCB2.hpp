@@ -12,11 +12,28 @@
 
 #include <memory>
 
+#include <gsl/span>
+
 namespace mumble {
 class MUMBLE_EXPORT CryptOCB2 : NonCopyable {
 public:
 	class P;
 
+	// A packet to process as part of a batch, see encryptBatch() and decryptBatch().
+	// "crypt" provides the key and, unless "nonce" is set, the nonce.
+	template< typename Tag > struct Job {
+		CryptOCB2 *crypt   = nullptr;
+		BufViewConst nonce = {};
+		BufView out        = {};
+		BufViewConst in    = {};
+		Tag tag            = {};
+		// Filled in by the batch function, same as the return value of encrypt()/decrypt().
+		size_t written = 0;
+	};
+
+	using DecryptJob = Job< BufViewConst >;
+	using EncryptJob = Job< BufView >;
+
 	CryptOCB2();
 	virtual ~CryptOCB2();
 
@@ -28,15 +45,25 @@ public:
 
 	virtual BufViewConst key() const;
 	virtual Buf genKey() const;
+	// Fills "key", which must be exactly keySize() bytes big.
+	virtual bool genKey(const BufView key) const;
 	virtual bool setKey(const BufViewConst key);
 
 	virtual BufViewConst nonce() const;
 	virtual Buf genNonce() const;
+	// Fills "nonce", which must be exactly nonceSize() bytes big.
+	virtual bool genNonce(const BufView nonce) const;
 	virtual bool setNonce(const BufViewConst nonce);
 
 	virtual size_t decrypt(BufView out, BufViewConst in, const BufViewConst tag = {});
 	virtual size_t encrypt(BufView out, BufViewConst in, const BufView tag = {});
 
+	// Process multiple packets (usually with different keys) at once.
+	// The AES rounds of the packets are interleaved, which is a lot faster than processing them one by one.
+	// Returns the number of successful jobs.
+	static size_t decryptBatch(const gsl::span< DecryptJob > jobs);
+	static size_t encryptBatch(const gsl::span< EncryptJob > jobs);
+
 private:
 	std::unique_ptr< P > m_p;
 };
@@ -0,0 +1,99 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_CRYPTSTATEAEAD_HPP
+#define MUMBLE_CRYPTSTATEAEAD_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <gsl/span>
+
+namespace mumble {
+// The encryption state of a UDP voice connection using an AEAD cipher, negotiated through CryptSetup as an alternative
+// to CryptStateOCB2. Each packet is processed in a single pass, which OpenSSL accelerates on most CPUs.
+//
+// The key exchanged through CryptSetup is not used as is: each direction gets its own, derived from it with HKDF-SHA256
+// and a label naming the direction. The counters of the two nonces can overlap, the keys make sure that a nonce is
+// never used twice with the same key (and that a packet can't be reflected back to its sender).
+//
+// The nonces are 12 bytes: a 64-bit little-endian packet counter, followed by 4 fixed bytes.
+// Every packet is prefixed with a 17 bytes header: the lowest byte of the counter and the full tag.
+// The counter is reconstructed from that byte, late, lost and replayed packets are handled like in CryptStateOCB2.
+//
+// The counters can be read from any thread, the other functions must not be called concurrently.
+class MUMBLE_EXPORT CryptStateAEAD : NonCopyable {
+public:
+	class P;
+
+	using Mode  = tcp::Message::CryptSetup::Mode;
+	using Stats = tcp::Message::UserStats::Stats;
+
+	// A packet to process as part of a batch, see decryptBatch() and encryptBatch().
+	struct Job {
+		BufView out     = {};
+		BufViewConst in = {};
+		// Filled in by the batch function, same as the return value of decrypt()/encrypt().
+		size_t written = 0;
+	};
+
+	static constexpr uint8_t nonceSize  = 12;
+	static constexpr uint8_t tagSize    = 16;
+	static constexpr uint8_t headerSize = 1 + tagSize;
+	// Packets that arrive up to this many packets late are still accepted.
+	static constexpr uint8_t maxLate = 30;
+
+	// The state is invalid unless "mode" is an AEAD one. "server" tells which side of the connection we are.
+	CryptStateAEAD(const Mode mode, const bool server);
+	virtual ~CryptStateAEAD();
+
+	virtual explicit operator bool() const;
+
+	virtual Mode mode() const;
+
+	// The key exchanged with the peer, not the ones derived from it.
+	virtual BufViewConst key() const;
+	virtual BufViewConst decryptNonce() const;
+	virtual BufViewConst encryptNonce() const;
+
+	// Generates a random key and nonces.
+	virtual bool gen();
+	virtual bool setKey(const BufViewConst key, const BufViewConst decryptNonce, const BufViewConst encryptNonce);
+	// Used when the peer asks for a resync, which is counted.
+	virtual bool setDecryptNonce(const BufViewConst nonce);
+
+	// "out" must be able to hold "in" minus the header.
+	virtual size_t decrypt(const BufView out, const BufViewConst in);
+	// "out" must be able to hold "in" plus the header.
+	virtual size_t encrypt(const BufView out, const BufViewConst in);
+	// Same as above, with the parts of "in" encrypted as a single packet.
+	virtual size_t encrypt(const BufView out, const BufViewsConst in);
+
+	// Same as calling decrypt()/encrypt() for each job in order, a failed job doesn't stop the batch. The context of
+	// the direction is reused for the whole batch, only the nonce changes between jobs.
+	// encryptBatch() reserves the counters for the whole batch at once, a failed job leaves a gap that the peer counts
+	// as a lost packet. Return the number of successful jobs.
+	virtual size_t decryptBatch(const gsl::span< Job > jobs);
+	virtual size_t encryptBatch(const gsl::span< Job > jobs);
+
+	virtual uint32_t good() const;
+	virtual uint32_t late() const;
+	virtual uint32_t lost() const;
+	virtual uint32_t resync() const;
+
+	virtual Stats stats() const;
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
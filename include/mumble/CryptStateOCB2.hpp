@@ -0,0 +1,68 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_CRYPTSTATEOCB2_HPP
+#define MUMBLE_CRYPTSTATEOCB2_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mumble {
+// The encryption state of a UDP voice connection, as negotiated through CryptSetup.
+//
+// Every packet is prefixed with a 4 bytes header: the lowest byte of the nonce and the first 3 bytes of the tag.
+// The full nonce is reconstructed from that byte, which allows packets to arrive late or to get lost.
+// A sliding window keeps track of the recently received nonces and rejects replayed packets.
+//
+// The counters can be read from any thread, the other functions must not be called concurrently.
+class MUMBLE_EXPORT CryptStateOCB2 : NonCopyable {
+public:
+	class P;
+
+	using Stats = tcp::Message::UserStats::Stats;
+
+	static constexpr uint8_t headerSize = 4;
+	// Packets that arrive up to this many packets late are still accepted.
+	static constexpr uint8_t maxLate = 30;
+
+	CryptStateOCB2();
+	virtual ~CryptStateOCB2();
+
+	virtual explicit operator bool() const;
+
+	virtual BufViewConst key() const;
+	virtual BufViewConst decryptNonce() const;
+	virtual BufViewConst encryptNonce() const;
+
+	// Generates a random key and nonces.
+	virtual bool gen();
+	virtual bool setKey(const BufViewConst key, const BufViewConst decryptNonce, const BufViewConst encryptNonce);
+	// Used when the peer asks for a resync, which is counted.
+	virtual bool setDecryptNonce(const BufViewConst nonce);
+
+	// "out" must be able to hold "in" minus the header.
+	virtual size_t decrypt(const BufView out, const BufViewConst in);
+	// "out" must be able to hold "in" plus the header.
+	virtual size_t encrypt(const BufView out, const BufViewConst in);
+
+	virtual uint32_t good() const;
+	virtual uint32_t late() const;
+	virtual uint32_t lost() const;
+	virtual uint32_t resync() const;
+
+	virtual Stats stats() const;
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,75 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_ENDPOINTHASH_HPP
+#define MUMBLE_ENDPOINTHASH_HPP
+
+#include "IP.hpp"
+#include "Macros.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mumble {
+// Keyed hash for endpoints and IPs, meant for hash tables. Built on the multiply-and-fold mixing of wyhash.
+//
+// Clients behind the same NAT only differ in port and IPv4-mapped addresses share 12 bytes, all of them are mixed in.
+// The key is secret, so that remote peers can't pick endpoints that collide on purpose.
+class MUMBLE_EXPORT EndpointHash {
+public:
+	using Key = std::array< uint64_t, 2 >;
+
+	// Uses a random key, generated once per process.
+	EndpointHash();
+	constexpr EndpointHash(const Key &key) : m_key(key) {}
+
+	constexpr const Key &key() const { return m_key; }
+
+	constexpr uint64_t hash(const EndpointV &endpoint) const {
+		return hash(endpoint.ip, uint64_t(sizeof(endpoint.ip) + sizeof(endpoint.port)) << 56 | endpoint.port);
+	}
+
+	constexpr uint64_t hash(const IPValue &ip) const { return hash(ip, uint64_t(sizeof(ip)) << 56); }
+
+	uint64_t hash(const Endpoint &endpoint) const { return hash(endpoint.value()); }
+	uint64_t hash(const IP &ip) const { return hash(ip.value()); }
+
+	template< typename T > size_t operator()(const T &value) const { return static_cast< size_t >(hash(value)); }
+
+private:
+	// Multiplies the two values and folds the 128 bits result.
+	static constexpr uint64_t mix(const uint64_t a, const uint64_t b) {
+#ifdef __SIZEOF_INT128__
+		__extension__ using Product = unsigned __int128;
+
+		const auto product = static_cast< Product >(a) * b;
+
+		return static_cast< uint64_t >(product) ^ static_cast< uint64_t >(product >> 64);
+#else
+		const uint64_t aLow = static_cast< uint32_t >(a), aHigh = a >> 32;
+		const uint64_t bLow = static_cast< uint32_t >(b), bHigh = b >> 32;
+
+		const uint64_t low = aLow * bLow, high = aHigh * bHigh;
+		const uint64_t middle1 = aHigh * bLow, middle2 = aLow * bHigh;
+
+		const uint64_t carry =
+			((low >> 32) + static_cast< uint32_t >(middle1) + static_cast< uint32_t >(middle2)) >> 32;
+
+		return (low + (middle1 << 32) + (middle2 << 32)) ^ (high + (middle1 >> 32) + (middle2 >> 32) + carry);
+#endif
+	}
+
+	// "tail" holds the port (if any) and the length of the input in the highest byte.
+	constexpr uint64_t hash(const IPValue &ip, const uint64_t tail) const {
+		return mix(mix(ip.word(0) ^ m_key[0], ip.word(1) ^ tail ^ m_key[1]) ^ m_key[1], tail ^ m_key[0]);
+	}
+
+	Key m_key;
+};
+} // namespace mumble
+
+#endif
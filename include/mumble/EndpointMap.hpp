@@ -0,0 +1,185 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_ENDPOINTMAP_HPP
+#define MUMBLE_ENDPOINTMAP_HPP
+
+#include "EndpointHash.hpp"
+#include "Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mumble {
+// Flat open-addressing hash map with endpoints as keys, for lookups on the UDP path.
+//
+// The slots are stored contiguously and probed linearly, a lookup usually touches a single cache line.
+// Deletion shifts the following slots back instead of leaving tombstones, so the table never degrades.
+template< typename T > class EndpointMap {
+public:
+	EndpointMap(const EndpointHash &hash = {}) : m_size(0), m_hash(hash) {}
+
+	size_t size() const { return m_size; }
+	bool empty() const { return !m_size; }
+
+	void clear() {
+		m_slots.clear();
+		m_size = 0;
+	}
+
+	// Makes room for "size" entries, so that inserting them doesn't cause a rehash.
+	void reserve(const size_t size) {
+		size_t capacity = minCapacity;
+		while (!fits(size, capacity)) {
+			capacity *= 2;
+		}
+
+		if (capacity > m_slots.size()) {
+			rehash(capacity);
+		}
+	}
+
+	T *find(const EndpointV &endpoint) {
+		const auto slot = lookup(endpoint, digest(endpoint));
+		return slot ? &slot->value : nullptr;
+	}
+
+	const T *find(const EndpointV &endpoint) const {
+		return const_cast< EndpointMap * >(this)->find(endpoint);
+	}
+
+	T *find(const Endpoint &endpoint) { return find(endpoint.value()); }
+	const T *find(const Endpoint &endpoint) const { return find(endpoint.value()); }
+
+	// Returns true if the endpoint was added, false if its value was replaced.
+	bool insert(const EndpointV &endpoint, T value) {
+		const auto hash = digest(endpoint);
+
+		if (const auto slot = lookup(endpoint, hash)) {
+			slot->value = std::move(value);
+			return false;
+		}
+
+		if (!fits(m_size + 1, m_slots.size())) {
+			rehash(std::max(m_slots.size() * 2, minCapacity));
+		}
+
+		auto &slot    = m_slots[probe(hash)];
+		slot.hash     = hash;
+		slot.endpoint = endpoint;
+		slot.value    = std::move(value);
+
+		++m_size;
+
+		return true;
+	}
+
+	bool insert(const Endpoint &endpoint, T value) { return insert(endpoint.value(), std::move(value)); }
+
+	bool erase(const EndpointV &endpoint) {
+		auto slot = lookup(endpoint, digest(endpoint));
+		if (!slot) {
+			return false;
+		}
+
+		const size_t mask = m_slots.size() - 1;
+
+		// Moves back the entries that would become unreachable, until an empty slot or one already at its home.
+		size_t hole = static_cast< size_t >(slot - m_slots.data());
+		for (size_t i = (hole + 1) & mask; m_slots[i].hash; i = (i + 1) & mask) {
+			const size_t home = m_slots[i].hash & mask;
+			if (((i - home) & mask) >= ((i - hole) & mask)) {
+				m_slots[hole] = std::move(m_slots[i]);
+				hole          = i;
+			}
+		}
+
+		m_slots[hole] = Slot();
+
+		--m_size;
+
+		return true;
+	}
+
+	bool erase(const Endpoint &endpoint) { return erase(endpoint.value()); }
+
+	// Calls "func" for every entry, in no particular order.
+	template< typename Func > void forEach(const Func &func) const {
+		for (const auto &slot : m_slots) {
+			if (slot.hash) {
+				func(slot.endpoint, slot.value);
+			}
+		}
+	}
+
+private:
+	static constexpr size_t minCapacity = 16;
+
+	struct Slot {
+		// 0 marks an empty slot.
+		uint64_t hash;
+		EndpointV endpoint;
+		T value;
+
+		Slot() : hash(0), endpoint() {}
+	};
+
+	// Keeps the load factor at or below 3/4.
+	static bool fits(const size_t size, const size_t capacity) { return size * 4 <= capacity * 3; }
+
+	uint64_t digest(const EndpointV &endpoint) const {
+		const auto hash = m_hash.hash(endpoint);
+		return hash ? hash : 1;
+	}
+
+	size_t probe(const uint64_t hash) const {
+		const size_t mask = m_slots.size() - 1;
+
+		size_t i = hash & mask;
+		while (m_slots[i].hash) {
+			i = (i + 1) & mask;
+		}
+
+		return i;
+	}
+
+	Slot *lookup(const EndpointV &endpoint, const uint64_t hash) {
+		if (m_slots.empty()) {
+			return nullptr;
+		}
+
+		const size_t mask = m_slots.size() - 1;
+
+		for (size_t i = hash & mask; m_slots[i].hash; i = (i + 1) & mask) {
+			auto &slot = m_slots[i];
+			if (slot.hash == hash && slot.endpoint == endpoint) {
+				return &slot;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void rehash(const size_t capacity) {
+		std::vector< Slot > slots(capacity);
+		std::swap(m_slots, slots);
+
+		for (auto &slot : slots) {
+			if (slot.hash) {
+				m_slots[probe(slot.hash)] = std::move(slot);
+			}
+		}
+	}
+
+	size_t m_size;
+	EndpointHash m_hash;
+	std::vector< Slot > m_slots;
+};
+} // namespace mumble
+
+#endif
@@ -11,6 +11,9 @@
 #include "Types.hpp"
 
 #include <memory>
+#include <string_view>
+
+#include <gsl/span>
 
 namespace mumble {
 class MUMBLE_EXPORT Hash : NonCopyable {
@@ -25,7 +28,20 @@ public:
 
 	virtual Hash &operator=(Hash &&crypt);
 
+	// Hashes "in" in one go, discarding the data passed to update() and not finalized yet.
 	virtual size_t operator()(const BufView out, const BufViewConst in);
+	// Same as above, with the parts of "in" hashed as if they were a single buffer.
+	virtual size_t operator()(const BufView out, const BufViewsConst in);
+
+	// Incremental hashing, for input that is not available all at once.
+	// update() can be called any number of times, final() writes the digest and gets the context ready for a new one.
+	// A failure of either discards the data passed so far, the next call starts a new digest.
+	virtual bool update(const BufViewConst in);
+	virtual size_t final(const BufView out);
+
+	// Hashes every input into the corresponding output, reusing the same context.
+	// Stops at the first failure, returns the number of digests written.
+	virtual size_t hashMany(const gsl::span< const BufView > out, const BufViewsConst in);
 
 	virtual void *handle() const;
 
@@ -36,6 +52,10 @@ public:
 
 	virtual bool reset();
 
+	// A Hash of the specified type owned by the calling thread, created on first use and reused afterwards.
+	// type() is empty if the type is not supported. Must not be passed to other threads.
+	static Hash &local(const std::string_view type);
+
 private:
 	std::unique_ptr< P > m_p;
 };
@@ -12,12 +12,43 @@
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <type_traits>
 
 #include <gsl/span>
 
 struct sockaddr_in6;
 
 namespace mumble {
+// Trivially copyable, standard-layout counterpart of IP: no vtable, can be copied with memcpy().
+// Meant for contiguous arrays of packet metadata and for hash tables.
+struct MUMBLE_EXPORT IPValue {
+	std::array< uint8_t, 16 > bytes;
+
+	static IPValue fromSockAddr(const sockaddr_in6 &sockaddr);
+	void toSockAddr(sockaddr_in6 &sockaddr) const;
+
+	constexpr bool isV4() const {
+		for (uint8_t i = 0; i < 10; ++i) {
+			if (bytes[i] != 0x00) {
+				return false;
+			}
+		}
+
+		return bytes[10] == 0xff && bytes[11] == 0xff;
+	}
+
+	// Little-endian, spelled out so that compilers turn it into a single load.
+	constexpr uint64_t word(const uint8_t index) const {
+		const auto byte = [this, index](const uint8_t i) { return uint64_t(bytes[index * 8 + i]) << (i * 8); };
+
+		return byte(0) | byte(1) | byte(2) | byte(3) | byte(4) | byte(5) | byte(6) | byte(7);
+	}
+
+	constexpr bool operator==(const IPValue &ip) const { return word(0) == ip.word(0) && word(1) == ip.word(1); }
+
+	constexpr bool operator!=(const IPValue &ip) const { return !(*this == ip); }
+};
+
 class MUMBLE_EXPORT IP {
 public:
 	class P;
@@ -35,11 +66,14 @@ public:
 	IP(const ViewConst view);
 	IP(const std::string_view string);
 	IP(const sockaddr_in6 &sockaddr);
+	IP(const IPValue &ip);
 	virtual ~IP();
 
 	virtual IP &operator=(const IP &ip);
 	virtual bool operator==(const IP &ip) const;
 
+	virtual IPValue value() const;
+
 	virtual ViewConst v6() const;
 	virtual ViewConst v4() const;
 
@@ -58,6 +92,9 @@ public:
 private:
 	std::array< uint8_t, v6Size > m_bytes;
 };
+
+static_assert(std::is_trivially_copyable_v< IPValue > && std::is_standard_layout_v< IPValue >);
+static_assert(sizeof(IPValue) == IP::v6Size);
 } // namespace mumble
 
 #endif
@@ -0,0 +1,114 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_JITTERBUFFER_HPP
+#define MUMBLE_JITTERBUFFER_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Opus.hpp"
+#include "Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mumble {
+// Reorders the audio packets of a single speaker and releases them at a steady pace.
+//
+// Packets are stored in a fixed-capacity ring, indexed by their frame number (one frame = 10 ms of audio).
+// The delay between reception and playback adapts to the jitter measured on arrival (RFC 3550 estimator):
+// it grows when a talk spurt starts after jitter went up and shrinks during a spurt when too much audio is queued.
+//
+// A missing packet is concealed through PLC, or recovered through FEC when its successor is already there.
+// No allocation takes place after construction.
+//
+// All functions are thread-safe, packets are usually pushed from the network thread and popped from the audio one.
+// decode() runs the decoder without holding the lock that push() needs.
+class MUMBLE_EXPORT JitterBuffer : NonCopyable {
+public:
+	class P;
+
+	using Clock     = std::chrono::steady_clock;
+	using TimePoint = Clock::time_point;
+
+	// Duration of a frame, as counted by the frame numbers.
+	static constexpr std::chrono::milliseconds frameDuration = std::chrono::milliseconds(10);
+	// Number of slots in the ring, packets more than this many frames ahead of the playback position restart it.
+	static constexpr uint8_t capacity = 64;
+	// Bigger packets are rejected.
+	static constexpr size_t packetSizeMax = 1024;
+
+	struct Frame {
+		enum class Type : uint8_t {
+			// Nothing to play: the speaker is silent or the buffer is filling up.
+			None,
+			// "packet" is to be decoded as usual.
+			Normal,
+			// "packet" is the successor of the missing one, to be decoded with FEC.
+			FEC,
+			// The packet is missing, PLC is to be used ("packet" is empty).
+			Loss
+		};
+
+		Type type = Type::None;
+		// Length in frames, 0 for Type::None.
+		uint8_t frames = 0;
+		// Set on the last packet of a talk spurt.
+		bool terminator = false;
+		uint64_t number = 0;
+		// Points to the storage of the buffer, valid until the next call to any function.
+		BufViewConst packet;
+	};
+
+	struct Stats {
+		// Played as received.
+		uint32_t good = 0;
+		// Arrived after their turn and were discarded.
+		uint32_t late = 0;
+		// Concealed through PLC.
+		uint32_t lost = 0;
+		// Recovered through FEC.
+		uint32_t recovered = 0;
+		// Discarded to reduce the delay.
+		uint32_t dropped = 0;
+	};
+
+	// "tick" is how much audio decode() returns per call, either 10 or 20 ms.
+	JitterBuffer(const std::chrono::milliseconds tick = std::chrono::milliseconds(20));
+	virtual ~JitterBuffer();
+
+	virtual explicit operator bool() const;
+
+	virtual bool push(const udp::Message::Audio &audio, const TimePoint arrival = Clock::now());
+	virtual bool push(const uint64_t number, const BufViewConst packet, const bool terminator,
+					  const TimePoint arrival = Clock::now());
+
+	// Returns the next packet to decode, for callers that drive the decoder themselves.
+	virtual Frame pop();
+	// Fills "out" with exactly one tick of audio, decoding as many packets as needed.
+	// Returns an empty view when there is nothing to play, the caller is expected to output silence.
+	virtual Opus::FloatView decode(const Opus::FloatView out, Opus::Decoder &decoder);
+
+	// Drops all packets and the decoded audio that was not returned yet. The jitter estimate is kept.
+	virtual void reset();
+
+	virtual bool playing() const;
+
+	virtual std::chrono::milliseconds tick() const;
+	// The amount of audio that is buffered before playback starts.
+	virtual std::chrono::milliseconds delay() const;
+	virtual std::chrono::microseconds jitter() const;
+
+	virtual Stats stats() const;
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "Macros.hpp"
 
+#include <cstdint>
 #include <memory>
 #include <string_view>
 
@@ -16,6 +17,10 @@ class MUMBLE_EXPORT Key {
 public:
 	class P;
 
+	// ECDSA P-256 and Ed25519 signatures are much cheaper to compute than RSA ones,
+	// which makes a big difference in the cost of a TLS handshake.
+	enum Type : uint8_t { RSA2048, P256, Ed25519 };
+
 	Key();
 	Key(const Key &key);
 	Key(Key &&key);
@@ -36,6 +41,9 @@ public:
 
 	virtual std::string pem() const;
 
+	// Generates a new private key.
+	static Key generate(const Type type);
+
 private:
 	std::unique_ptr< P > m_p;
 };
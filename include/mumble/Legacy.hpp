@@ -0,0 +1,76 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_LEGACY_HPP
+#define MUMBLE_LEGACY_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace mumble {
+namespace legacy {
+	namespace udp {
+		// Zero-copy view of a legacy voice packet:
+		//
+		// [header] [session]? [sequence] [size | terminator] [payload] [position]?
+		//
+		// The header byte holds the type in the upper 3 bits and the target (client to server)
+		// or context (server to client) in the lower 5 bits. The session is only present
+		// in packets sent by the server. All integers are PacketDataStream varints.
+		struct Voice {
+			using Position = std::array< float, 3 >;
+
+			static constexpr uint8_t targetMask      = 0x1F;
+			static constexpr uint16_t sizeMask       = 0x1FFF;
+			static constexpr uint16_t terminatorFlag = 0x2000;
+
+			Type type      = Type::VoiceOpus;
+			uint8_t target = 0;
+
+			std::optional< uint32_t > session = {};
+
+			uint64_t sequence    = 0;
+			BufViewConst payload = {};
+			bool isTerminator    = false;
+
+			std::optional< Position > position = {};
+		};
+
+		// Only Opus packets are supported, the other codecs use a different payload framing.
+		//
+		// The payload is a view into the packet, which has to outlive the Voice object.
+		MUMBLE_EXPORT bool decode(Voice &voice, const BufViewConst packet, const bool hasSession);
+		// Returns the required size when "out" is empty.
+		MUMBLE_EXPORT size_t encode(const BufView out, const Voice &voice);
+
+		// Turns a packet received from a client into one that can be forwarded to other clients,
+		// by inserting the sender's session after the header and replacing the target with the context.
+		//
+		// "buf" must have room for the (up to 5 bytes long) session varint past "size".
+		// Returns the new size of the packet, 0 on failure.
+		MUMBLE_EXPORT size_t reheader(const BufView buf, const size_t size, const uint32_t session,
+									  const uint8_t context);
+
+		// Conversion to/from the protobuf based format.
+		//
+		// toPack() and fromPack() work directly on the wire format of a udp::Pack (header included),
+		// skipping the protobuf message and the copy of the Opus data into udp::Message::Audio.
+		MUMBLE_EXPORT bool toAudio(mumble::udp::Message::Audio &audio, const Voice &voice);
+		MUMBLE_EXPORT bool fromAudio(Voice &voice, const mumble::udp::Message::Audio &audio);
+
+		// Returns the required size when "out" is empty.
+		MUMBLE_EXPORT size_t toPack(const BufView out, const Voice &voice);
+		MUMBLE_EXPORT bool fromPack(Voice &voice, const BufViewConst pack);
+	} // namespace udp
+} // namespace legacy
+} // namespace mumble
+
+#endif
@@ -539,9 +539,15 @@ namespace tcp {
 	};
 
 	MUMBLE_MESSAGE_DECL(CryptSetup) {
+		enum Mode : uint8_t { OCB2AES128, AES256GCM, ChaCha20Poly1305 };
+
 		std::vector< std::byte > key         = {};
 		std::vector< std::byte > clientNonce = {};
 		std::vector< std::byte > serverNonce = {};
+		// Offered by the client, in order of preference. Empty for peers that only support OCB2AES128.
+		std::vector< Mode > modes = {};
+		// The mode "key" and the nonces are meant for.
+		Mode mode = OCB2AES128;
 
 		MUMBLE_MESSAGE_COMMON(CryptSetup)
 	};
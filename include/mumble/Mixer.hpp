@@ -0,0 +1,83 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_MIXER_HPP
+#define MUMBLE_MIXER_HPP
+
+#include "JitterBuffer.hpp"
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Opus.hpp"
+#include "Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace mumble {
+// Mixes Opus streams into one or more outputs, for recording, for clients that can only receive a single stream
+// and for bridging to other systems.
+//
+// Every tick (20 ms), the incoming streams are decoded in parallel through their jitter buffer, summed once and
+// each output is derived from the sum: an output can leave out one of the streams (typically the voice of the user
+// it's sent to). A limiter keeps the result in range, with a smooth gain instead of hard clipping. The outputs are
+// then encoded in parallel.
+//
+// Decoders and encoders come from pools sized on construction, adding a stream or an output doesn't allocate them.
+//
+// push() can be called from any thread, concurrently with the other functions. Streams and outputs can be added and
+// removed at any time, but tick() must not be called concurrently with itself. tick() writes the results in place:
+// packet(), pcm() and the views they return must not be used while it runs, typically they are called by the thread
+// that calls tick(), right after it.
+class MUMBLE_EXPORT Mixer : NonCopyable {
+public:
+	class P;
+
+	static constexpr uint32_t sampleRate = 48000;
+	static constexpr std::chrono::milliseconds tickDuration = std::chrono::milliseconds(20);
+	// Per channel.
+	static constexpr uint32_t tickSamples = sampleRate / 1000 * tickDuration.count();
+
+	// "threads" is the size of the worker pool, 0 picks the number of CPU cores.
+	Mixer(const uint8_t channels = 1, const uint32_t streamsMax = 64, const uint32_t outputsMax = 8,
+		  const uint32_t threads = 0);
+	virtual ~Mixer();
+
+	virtual explicit operator bool() const;
+
+	virtual uint8_t channels() const;
+
+	// Fail if the ID is already taken or if the maximum is reached.
+	virtual bool addStream(const uint32_t id);
+	virtual bool removeStream(const uint32_t id);
+	virtual size_t streams() const;
+
+	virtual bool push(const uint32_t id, const udp::Message::Audio &audio,
+					  const JitterBuffer::TimePoint arrival = JitterBuffer::Clock::now());
+	virtual bool push(const uint32_t id, const uint64_t number, const BufViewConst packet, const bool terminator,
+					  const JitterBuffer::TimePoint arrival = JitterBuffer::Clock::now());
+
+	// "exclude" is a stream that is not part of the output. A bitrate of 0 lets the encoder decide.
+	virtual bool addOutput(const uint32_t id, const std::optional< uint32_t > exclude = {}, const uint32_t bitrate = 0);
+	virtual bool removeOutput(const uint32_t id);
+	virtual size_t outputs() const;
+
+	// Decodes, mixes and encodes one tick, to be called every 20 ms. Returns the number of streams that were heard.
+	virtual size_t tick();
+
+	// The result of the last tick for the output, valid until the next one starts: not to be called concurrently with
+	// tick(). Both are empty when none of the streams in the output were heard.
+	virtual BufViewConst packet(const uint32_t id) const;
+	virtual Opus::FloatViewConst pcm(const uint32_t id) const;
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
@@ -10,6 +10,10 @@
 #include "NonCopyable.hpp"
 #include "Types.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 namespace mumble {
@@ -17,12 +21,58 @@ class MUMBLE_EXPORT Opus : NonCopyable {
 public:
 	class Decoder;
 	class Encoder;
+	class DecoderPool;
+	class EncoderPool;
+	class Repacketizer;
 
 	using FloatView        = gsl::span< float >;
 	using FloatViewConst   = gsl::span< const float >;
 	using IntegerView      = gsl::span< int16_t >;
 	using IntegerViewConst = gsl::span< const int16_t >;
 
+	// Everything the header of a packet tells (RFC 6716, section 3), all sample counts are at 48 kHz.
+	struct PacketInfo {
+		enum class Mode : uint8_t { SILK, Hybrid, CELT };
+		enum class Bandwidth : uint8_t { Narrow, Medium, Wide, SuperWide, Full };
+
+		// Set when the packet follows all the rules in section 3.4 and is 120 ms long at most.
+		bool valid = false;
+
+		Mode mode           = Mode::SILK;
+		Bandwidth bandwidth = Bandwidth::Narrow;
+		// Index into the table of modes, bandwidths and frame sizes.
+		uint8_t config = 0;
+		// Frame count code: one frame, two of the same size, two of different sizes or an arbitrary number.
+		uint8_t code = 0;
+		bool stereo  = false;
+		// Whether the frames can have different sizes.
+		bool vbr = false;
+
+		uint8_t frames        = 0;
+		uint16_t frameSamples = 0;
+		uint32_t samples      = 0;
+
+		// Compressed data, without the header, the frame lengths and the padding.
+		uint32_t payload = 0;
+		uint32_t padding = 0;
+		// Sizes of the smallest and the largest frame. A frame of 0 or 1 byte carries no audio (DTX).
+		uint16_t smallestFrame = 0;
+		uint16_t largestFrame  = 0;
+
+		constexpr explicit operator bool() const { return valid; }
+
+		constexpr uint8_t channels() const { return stereo ? 2 : 1; }
+
+		constexpr std::chrono::microseconds duration() const {
+			return std::chrono::microseconds(samples * uint64_t(1000) / 48);
+		}
+	};
+
+	// Longest frame allowed.
+	static constexpr uint16_t frameSizeMax = 1275;
+	// Longest packet allowed, in samples at 48 kHz (120 ms).
+	static constexpr uint32_t packetSamplesMax = 5760;
+
 	virtual explicit operator bool() const = 0;
 
 	virtual uint8_t channels() const    = 0;
@@ -37,8 +87,207 @@ public:
 	static uint32_t packetFrames(const BufViewConst packet);
 	static uint32_t packetSamples(const BufViewConst packet, const uint32_t sampleRate);
 	static uint32_t packetSamplesPerFrame(const BufViewConst packet, const uint32_t sampleRate);
+
+	// Parses and validates the header in a single pass, without calling into the library.
+	static constexpr PacketInfo inspect(const BufViewConst packet);
+
+private:
+	// Reads a frame length (1 or 2 bytes), returns the number of bytes used or 0 if the packet is too short.
+	static constexpr uint8_t readSize(const std::byte *data, const size_t size, uint16_t &value);
+	static constexpr uint8_t toByte(const std::byte value) { return std::to_integer< uint8_t >(value); }
 };
 
+constexpr uint8_t Opus::readSize(const std::byte *data, const size_t size, uint16_t &value) {
+	if (size < 1) {
+		return 0;
+	}
+
+	if (toByte(data[0]) < 252) {
+		value = toByte(data[0]);
+		return 1;
+	}
+
+	if (size < 2) {
+		return 0;
+	}
+
+	value = static_cast< uint16_t >(4 * toByte(data[1]) + toByte(data[0]));
+	return 2;
+}
+
+constexpr Opus::PacketInfo Opus::inspect(const BufViewConst packet) {
+	using Bandwidth = PacketInfo::Bandwidth;
+	using Mode      = PacketInfo::Mode;
+
+	PacketInfo info;
+
+	const std::byte *data = packet.data();
+	size_t size           = packet.size();
+
+	if (!size) {
+		return info;
+	}
+
+	const auto toc = toByte(data[0]);
+
+	info.config = static_cast< uint8_t >(toc >> 3);
+	info.stereo = toc & 0x04;
+	info.code   = toc & 0x03;
+
+	// Frame sizes in 2.5 ms units (120 samples) and bandwidths of each group of configurations.
+	if (info.config < 12) {
+		constexpr uint8_t units[] = { 4, 8, 16, 24 };
+
+		info.mode         = Mode::SILK;
+		info.bandwidth    = static_cast< Bandwidth >(info.config / 4);
+		info.frameSamples = static_cast< uint16_t >(120 * units[info.config % 4]);
+	} else if (info.config < 16) {
+		info.mode         = Mode::Hybrid;
+		info.bandwidth    = info.config < 14 ? Bandwidth::SuperWide : Bandwidth::Full;
+		info.frameSamples = static_cast< uint16_t >(info.config % 2 ? 960 : 480);
+	} else {
+		constexpr Bandwidth bandwidths[] = { Bandwidth::Narrow, Bandwidth::Wide, Bandwidth::SuperWide,
+											 Bandwidth::Full };
+
+		info.mode         = Mode::CELT;
+		info.bandwidth    = bandwidths[(info.config - 16) / 4];
+		info.frameSamples = static_cast< uint16_t >(120 << (info.config % 4));
+	}
+
+	++data;
+	--size;
+
+	uint16_t sizes[2] = {};
+
+	switch (info.code) {
+		case 0:
+			info.frames = 1;
+			sizes[0]    = static_cast< uint16_t >(size);
+
+			if (size > frameSizeMax) {
+				return info;
+			}
+
+			break;
+		case 1:
+			info.frames = 2;
+			sizes[0] = sizes[1] = static_cast< uint16_t >(size / 2);
+
+			if (size % 2 || size / 2 > frameSizeMax) {
+				return info;
+			}
+
+			break;
+		case 2: {
+			info.frames = 2;
+			info.vbr    = true;
+
+			const auto used = readSize(data, size, sizes[0]);
+			if (!used || sizes[0] > size - used || size - used - sizes[0] > frameSizeMax) {
+				return info;
+			}
+
+			size -= used;
+			sizes[1] = static_cast< uint16_t >(size - sizes[0]);
+
+			break;
+		}
+		case 3: {
+			if (size < 1) {
+				return info;
+			}
+
+			const auto count = toByte(data[0]);
+			++data;
+			--size;
+
+			info.frames = count & 0x3F;
+			info.vbr    = count & 0x80;
+
+			if (!info.frames || uint32_t(info.frames) * info.frameSamples > packetSamplesMax) {
+				return info;
+			}
+
+			// Each padding length byte of 255 means 254 bytes of padding plus another length byte.
+			if (count & 0x40) {
+				uint8_t byte = 255;
+
+				while (byte == 255) {
+					if (size < 1) {
+						return info;
+					}
+
+					byte = toByte(data[0]);
+					++data;
+					--size;
+
+					info.padding += byte == 255 ? 254 : byte;
+				}
+			}
+
+			if (info.padding > size) {
+				return info;
+			}
+
+			size -= info.padding;
+
+			if (!info.vbr) {
+				if (size % info.frames || size / info.frames > frameSizeMax) {
+					return info;
+				}
+
+				info.smallestFrame = static_cast< uint16_t >(size / info.frames);
+				info.largestFrame  = info.smallestFrame;
+
+				break;
+			}
+
+			info.smallestFrame = frameSizeMax;
+
+			size_t total = 0;
+
+			// All lengths but the last one are explicit.
+			for (uint8_t i = 0; i + 1 < info.frames; ++i) {
+				uint16_t frameSize = 0;
+
+				const auto used = readSize(data, size, frameSize);
+				if (!used || frameSize > frameSizeMax) {
+					return info;
+				}
+
+				data += used;
+				size -= used;
+				total += frameSize;
+
+				info.smallestFrame = std::min(info.smallestFrame, frameSize);
+				info.largestFrame  = std::max(info.largestFrame, frameSize);
+			}
+
+			if (total > size || size - total > frameSizeMax) {
+				return info;
+			}
+
+			const auto last = static_cast< uint16_t >(size - total);
+
+			info.smallestFrame = std::min(info.smallestFrame, last);
+			info.largestFrame  = std::max(info.largestFrame, last);
+
+			break;
+		}
+	}
+
+	if (info.code < 3) {
+		info.smallestFrame = std::min(sizes[0], sizes[1 % info.frames]);
+		info.largestFrame  = std::max(sizes[0], sizes[1 % info.frames]);
+	}
+
+	info.samples = uint32_t(info.frames) * info.frameSamples;
+	info.payload = static_cast< uint32_t >(size);
+	info.valid   = info.samples <= packetSamplesMax;
+
+	return info;
+}
+
 class MUMBLE_EXPORT Opus::Decoder : public Opus {
 public:
 	class P;
@@ -66,6 +315,10 @@ public:
 	virtual uint32_t packetSamples(const BufViewConst packet);
 
 private:
+	friend DecoderPool;
+
+	Decoder(P *p);
+
 	std::unique_ptr< P > m_p;
 };
 
@@ -104,6 +357,119 @@ public:
 	virtual bool usesVBR() const;
 	virtual bool toggleVBR(const bool enable);
 
+	// In-band forward error correction, only used by SILK and when the packet loss is expected to be above 0.
+	virtual bool usesFEC() const;
+	virtual bool toggleFEC(const bool enable);
+
+	// Expected packet loss, in percent.
+	virtual uint8_t packetLoss() const;
+	virtual bool setPacketLoss(const uint8_t percent);
+
+private:
+	friend EncoderPool;
+
+	Encoder(P *p);
+
+	std::unique_ptr< P > m_p;
+};
+
+// Merges the frames of several packets into one and splits multi-frame packets, without decoding them.
+//
+// The packets are not copied: they must stay valid until reset() is called or the repacketizer is destroyed.
+// All packets must have the same configuration (mode, bandwidth, frame size and channels) and a packet can't be longer
+// than 120 ms, add() fails otherwise.
+class MUMBLE_EXPORT Opus::Repacketizer : NonCopyable {
+public:
+	class P;
+
+	Repacketizer(Repacketizer &&repacketizer);
+	Repacketizer();
+	virtual ~Repacketizer();
+
+	virtual explicit operator bool() const;
+
+	// Discards all frames.
+	virtual void reset();
+
+	virtual Code add(const BufViewConst packet);
+
+	virtual uint32_t frames() const;
+
+	// Writes the frames in [begin, end) as a single packet. Returns an empty view on failure.
+	virtual BufView operator()(const BufView out, const uint32_t begin, const uint32_t end);
+	// Writes all frames.
+	virtual BufView operator()(const BufView out);
+
+private:
+	std::unique_ptr< P > m_p;
+};
+
+// Fixed set of decoders for a given channel count and sample rate, for applications that see speakers come and go.
+//
+// The states of all decoders are allocated in a single block and initialized once, when the pool is created.
+// A decoder is reset when it's given back (by destroying the pointer), acquiring one doesn't allocate anything.
+//
+// The pool must outlive the decoders it hands out. acquire() can be called from any thread.
+class MUMBLE_EXPORT Opus::DecoderPool : NonCopyable {
+public:
+	class P;
+
+	struct Releaser {
+		P *pool;
+
+		void operator()(Decoder *decoder) const;
+	};
+
+	using Ptr = std::unique_ptr< Decoder, Releaser >;
+
+	DecoderPool(const uint8_t channels, const uint32_t sampleRate, const size_t size);
+	virtual ~DecoderPool();
+
+	virtual explicit operator bool() const;
+
+	// Returns null when all decoders are in use.
+	virtual Ptr acquire();
+
+	virtual uint8_t channels() const;
+	virtual uint32_t sampleRate() const;
+
+	virtual size_t size() const;
+	virtual size_t available() const;
+
+private:
+	std::unique_ptr< P > m_p;
+};
+
+// Same as DecoderPool, for encoders. The preset, bitrate, VBR, FEC, packet loss and phase inversion are restored on
+// release.
+class MUMBLE_EXPORT Opus::EncoderPool : NonCopyable {
+public:
+	class P;
+
+	struct Releaser {
+		P *pool;
+
+		void operator()(Encoder *encoder) const;
+	};
+
+	using Ptr = std::unique_ptr< Encoder, Releaser >;
+
+	EncoderPool(const uint8_t channels, const uint32_t sampleRate, const size_t size,
+				const Encoder::Preset preset = Encoder::Preset::VoIP);
+	virtual ~EncoderPool();
+
+	virtual explicit operator bool() const;
+
+	// Returns null when all encoders are in use.
+	virtual Ptr acquire();
+
+	virtual uint8_t channels() const;
+	virtual uint32_t sampleRate() const;
+	virtual Encoder::Preset preset() const;
+
+	virtual size_t size() const;
+	virtual size_t available() const;
+
 private:
 	std::unique_ptr< P > m_p;
 };
@@ -0,0 +1,88 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_PCM_HPP
+#define MUMBLE_PCM_HPP
+
+#include "Macros.hpp"
+#include "NonCopyable.hpp"
+#include "Opus.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace mumble {
+// Processing for the interleaved PCM taken and produced by Opus::Encoder and Opus::Decoder, accelerated with SSE2, AVX
+// or AVX2 when the CPU supports them.
+//
+// Float samples are in the [-1, 1] range, the results are clamped to it. Conversions to 16 bit round to the nearest
+// integer and saturate. The functions process as many samples as both views can take and return that number.
+class MUMBLE_EXPORT PCM : NonCopyable {
+public:
+	class Resampler;
+
+	using FloatView        = Opus::FloatView;
+	using FloatViewConst   = Opus::FloatViewConst;
+	using IntegerView      = Opus::IntegerView;
+	using IntegerViewConst = Opus::IntegerViewConst;
+
+	static size_t toFloat(const FloatView out, const IntegerViewConst in);
+	static size_t toInteger(const IntegerView out, const FloatViewConst in);
+
+	// "out" and "in" can be the same view.
+	static size_t applyGain(const FloatView out, const FloatViewConst in, const float gain);
+	static size_t applyGain(const IntegerView out, const IntegerViewConst in, const float gain);
+
+	// Gain for udp::Message::Audio::volumeAdjustment, where 0 means that the server didn't set it.
+	static constexpr float gain(const float volumeAdjustment) {
+		return volumeAdjustment > 0.f ? volumeAdjustment : 1.f;
+	}
+
+	// Return the number of frames (samples per channel), the views must not overlap.
+	// Stereo to mono takes the average of the channels, mono to stereo copies the channel to both sides.
+	static size_t toMono(const FloatView out, const FloatViewConst in);
+	static size_t toStereo(const FloatView out, const FloatViewConst in);
+};
+
+// Converts between sample rates, e.g. 44.1 or 16 kHz to and from the 48 kHz that Opus works best at.
+//
+// Polyphase FIR filter (windowed sinc), for any pair of rates whose ratio reduces to terms no bigger than phasesMax.
+// The state is kept between calls, so that a stream can be fed in chunks of any size: the output doesn't depend on how
+// the input is split. The last "taps / 2" frames of input are held back until more comes in.
+class MUMBLE_EXPORT PCM::Resampler : NonCopyable {
+public:
+	class P;
+
+	// Filter length, in frames of input.
+	static constexpr uint32_t taps = 32;
+	static constexpr uint32_t phasesMax = 1024;
+
+	Resampler(Resampler &&resampler);
+	Resampler(const uint8_t channels, const uint32_t inRate, const uint32_t outRate);
+	virtual ~Resampler();
+
+	virtual explicit operator bool() const;
+
+	virtual uint8_t channels() const;
+	virtual uint32_t inRate() const;
+	virtual uint32_t outRate() const;
+
+	// The most samples a call can write for "samples" samples of input.
+	virtual size_t outputSize(const size_t samples) const;
+
+	// Returns the samples written, or an empty view when "out" is smaller than outputSize(in.size()) or "in" doesn't
+	// hold whole frames. Nothing is consumed on failure.
+	virtual FloatView operator()(const FloatView out, const FloatViewConst in);
+
+	// Forgets the input held back, the next call starts from silence.
+	virtual void reset();
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
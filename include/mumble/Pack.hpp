@@ -83,6 +83,15 @@ namespace udp {
 		virtual ~Pack();
 
 		virtual bool operator()(Message &message, uint32_t dataSize = std::numeric_limits< uint32_t >::max()) const;
+
+		// Same as the Message constructor and operator(), but working on a caller-provided buffer
+		// that holds the whole packet (header included), instead of the one owned by a Pack.
+		//
+		// Pings don't require any heap allocation. For voice packets, see legacy::udp::toPack() and fromPack().
+		//
+		// write() returns the required size when "out" is empty.
+		static size_t write(const BufView out, const Message &message);
+		static bool read(Message &message, const BufViewConst buf);
 	};
 } // namespace udp
 } // namespace mumble
@@ -6,11 +6,16 @@
 #ifndef MUMBLE_PACKETDATASTREAM_HPP
 #define MUMBLE_PACKETDATASTREAM_HPP
 
+#include "Endian.hpp"
 #include "NonCopyable.hpp"
 #include "Types.hpp"
 
 #include <algorithm>
+#include <cstring>
 #include <string>
+#include <string_view>
+
+#include <gsl/span>
 
 namespace mumble {
 class PacketDataStream : NonCopyable {
@@ -41,7 +46,7 @@ public:
 		}
 	}
 
-	constexpr PacketDataStream &operator<<(const uint64_t value) {
+	PacketDataStream &operator<<(const uint64_t value) {
 		auto tmp = value;
 
 		if ((tmp & 0x8000000000000000LL) && (~tmp < 0x100000000LL)) {
@@ -61,87 +66,83 @@ public:
 			append(tmp);
 		} else if (tmp < 0x4000) {
 			// Need top two bits clear.
-			append((tmp >> 8) | 0x80);
-			append(tmp & 0xFF);
+			write< 2 >(tmp | 0x8000);
 		} else if (tmp < 0x200000) {
 			// Need top three bits clear.
-			append((tmp >> 16) | 0xC0);
-			append((tmp >> 8) & 0xFF);
-			append(tmp & 0xFF);
+			write< 3 >(tmp | 0xC00000);
 		} else if (tmp < 0x10000000) {
 			// Need top four bits clear.
-			append((tmp >> 24) | 0xE0);
-			append((tmp >> 16) & 0xFF);
-			append((tmp >> 8) & 0xFF);
-			append(tmp & 0xFF);
+			write< 4 >(tmp | 0xE0000000);
 		} else if (tmp < 0x100000000LL) {
 			// It's a full 32-bit integer.
-			append(0xF0);
-			append((tmp >> 24) & 0xFF);
-			append((tmp >> 16) & 0xFF);
-			append((tmp >> 8) & 0xFF);
-			append(tmp & 0xFF);
+			write< 5 >(tmp | 0xF000000000LL);
 		} else {
 			// It's a 64-bit value.
 			append(0xF4);
-			append((tmp >> 56) & 0xFF);
-			append((tmp >> 48) & 0xFF);
-			append((tmp >> 40) & 0xFF);
-			append((tmp >> 32) & 0xFF);
-			append((tmp >> 24) & 0xFF);
-			append((tmp >> 16) & 0xFF);
-			append((tmp >> 8) & 0xFF);
-			append(tmp & 0xFF);
+			write< 8 >(tmp);
 		}
 
 		return *this;
 	}
 
-	constexpr PacketDataStream &operator>>(uint64_t &value) {
-		uint64_t tmp = next();
+	PacketDataStream &operator>>(uint64_t &value) {
+		// Near the end of the buffer we fall back to reading byte by byte, to preserve the error semantics.
+		if (m_seek.size() >= s_maxLength) {
+			if (const auto length = decodeFast(m_seek.data(), value)) {
+				m_seek = m_seek.subspan(length);
+				return *this;
+			}
+		}
 
-		if ((tmp & 0x80) == 0x00) {
-			value = (tmp & 0x7F);
-		} else if ((tmp & 0xC0) == 0x80) {
-			value = (tmp & 0x3F) << 8 | next();
-		} else if ((tmp & 0xF0) == 0xF0) {
-			switch (tmp & 0xFC) {
-				case 0xF0:
-					value = next() << 24 | next() << 16 | next() << 8 | next();
-					break;
-				case 0xF4:
-					value = next() << 56 | next() << 48 | next() << 40 | next() << 32 | next() << 24 | next() << 16
-							| next() << 8 | next();
-					break;
-				case 0xF8:
-					*this >> value;
-					value = ~value;
-					break;
-				case 0xFC:
-					value = tmp & 0x03;
-					value = ~value;
-					break;
-				default:
-					m_ok  = false;
-					value = 0;
-					break;
+		return decodeSlow(value);
+	}
+
+	// Decodes consecutive values until either "values" is full or the stream is exhausted.
+	// Returns the number of decoded values.
+	size_t decode(const gsl::span< uint64_t > values) {
+		size_t count = 0;
+
+		// Work on a local cursor so that it stays in a register across iterations.
+		auto src  = m_seek.data();
+		auto size = m_seek.size();
+
+		for (; count < values.size() && size >= s_maxLength; ++count) {
+			const auto length = decodeFast(src, values[count]);
+			if (!length) {
+				break;
 			}
-		} else if ((tmp & 0xF0) == 0xE0) {
-			value = (tmp & 0x0F) << 24 | next() << 16 | next() << 8 | next();
-		} else if ((tmp & 0xE0) == 0xC0) {
-			value = (tmp & 0x1F) << 16 | next() << 8 | next();
+
+			src += length;
+			size -= length;
+		}
+
+		m_seek = m_seek.last(size);
+
+		for (; count < values.size() && m_ok && !m_seek.empty(); ++count) {
+			decodeSlow(values[count]);
+			if (!m_ok) {
+				break;
+			}
+		}
+
+		return count;
+	}
+
+	PacketDataStream &encode(const gsl::span< const uint64_t > values) {
+		for (const auto value : values) {
+			*this << value;
 		}
 
 		return *this;
 	}
 
-#define INTMAPOPERATOR(type)                                                                                     \
-	constexpr PacketDataStream &operator<<(const type value) { return *this << static_cast< uint64_t >(value); } \
-	constexpr PacketDataStream &operator>>(type &value) {                                                        \
-		uint64_t tmp = 0;                                                                                        \
-		*this >> tmp;                                                                                            \
-		value = static_cast< type >(tmp);                                                                        \
-		return *this;                                                                                            \
+#define INTMAPOPERATOR(type)                                                                           \
+	PacketDataStream &operator<<(const type value) { return *this << static_cast< uint64_t >(value); } \
+	PacketDataStream &operator>>(type &value) {                                                        \
+		uint64_t tmp = 0;                                                                              \
+		*this >> tmp;                                                                                  \
+		value = static_cast< type >(tmp);                                                              \
+		return *this;                                                                                  \
 	}
 
 	INTMAPOPERATOR(int32_t);
@@ -151,12 +152,12 @@ public:
 	INTMAPOPERATOR(int8_t);
 	INTMAPOPERATOR(uint8_t);
 
-	constexpr PacketDataStream &operator<<(const bool value) {
+	PacketDataStream &operator<<(const bool value) {
 		const uint32_t tmp = value ? 1 : 0;
 		return *this << tmp;
 	}
 
-	constexpr PacketDataStream &operator>>(bool &value) {
+	PacketDataStream &operator>>(bool &value) {
 		uint32_t tmp = 0;
 		*this >> tmp;
 		value = tmp ? true : false;
@@ -216,7 +217,8 @@ public:
 		return *this;
 	}
 
-	PacketDataStream &operator>>(Buf &buf) {
+	// Zero-copy, the view points into the stream's buffer.
+	PacketDataStream &operator>>(BufViewConst &buf) {
 		uint32_t size = 0;
 		*this >> size;
 
@@ -225,34 +227,164 @@ public:
 			m_ok = false;
 		}
 
-		buf    = { m_seek.begin(), m_seek.begin() + size };
+		buf    = m_seek.first(size);
 		m_seek = m_seek.subspan(size);
 
 		return *this;
 	}
 
+	PacketDataStream &operator>>(Buf &buf) {
+		BufViewConst view;
+		*this >> view;
+
+		buf.assign(view.begin(), view.end());
+
+		return *this;
+	}
+
 	PacketDataStream &operator<<(const std::string_view str) {
 		*this << static_cast< uint32_t >(str.size());
 		append({ reinterpret_cast< const std::byte * >(str.data()), str.size() });
 		return *this;
 	}
 
+	// Zero-copy, the view points into the stream's buffer.
+	PacketDataStream &operator>>(std::string_view &str) {
+		BufViewConst view;
+		*this >> view;
+
+		str = { reinterpret_cast< const char * >(view.data()), view.size() };
+
+		return *this;
+	}
+
 	PacketDataStream &operator>>(std::string &str) {
-		uint32_t size = 0;
-		*this >> size;
+		std::string_view view;
+		*this >> view;
 
-		if (size > m_seek.size()) {
-			size = static_cast< decltype(size) >(m_seek.size());
+		str = view;
+
+		return *this;
+	}
+
+	constexpr void append(const uint64_t value) {
+		if (!m_seek.empty()) {
+			m_seek.front() = std::byte(value);
+			m_seek         = m_seek.subspan(sizeof(std::byte));
+		} else {
 			m_ok = false;
+			++m_overshoot;
 		}
+	}
 
-		str    = { reinterpret_cast< const char * >(m_seek.data()), size };
+	void append(const BufViewConst buf) {
+		if (m_seek.size() >= buf.size()) {
+			std::copy(buf.begin(), buf.end(), m_seek.begin());
+			m_seek = m_seek.subspan(buf.size());
+		} else {
+			std::fill(m_seek.begin(), m_seek.end(), std::byte(0));
+			m_overshoot += static_cast< decltype(m_overshoot) >(buf.size() - m_seek.size());
+			m_seek = m_seek.last(0);
+			m_ok   = false;
+		}
+	}
+
+private:
+	// Total length of the encoded value, indexed by the upper 6 bits of the prefix byte.
+	// 0 means the prefix is handled by the slow path (negative numbers).
+	static constexpr uint8_t s_length[64] = {
+		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0xxxxxxx
+		2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,                                                 // 10xxxxxx
+		3, 3, 3, 3, 3, 3, 3, 3,                                                                         // 110xxxxx
+		4, 4, 4, 4,                                                                                     // 1110xxxx
+		5,                                                                                              // 111100xx
+		9,                                                                                              // 111101xx
+		0,                                                                                              // 111110xx
+		0                                                                                               // 111111xx
+	};
+
+	static constexpr uint8_t s_maxLength = 1 + sizeof(uint64_t);
+
+	// How to extract the value from the 8 bytes loaded at the prefix (or right after it for 64-bit values),
+	// indexed by length.
+	static constexpr uint8_t s_shift[s_maxLength + 1] = { 0, 56, 48, 40, 32, 24, 0, 0, 0, 0 };
+	static constexpr uint64_t s_mask[s_maxLength + 1] = {
+		0, 0x7F, 0x3FFF, 0x1FFFFF, 0xFFFFFFF, 0xFFFFFFFF, 0, 0, 0, 0xFFFFFFFFFFFFFFFF
+	};
+
+	static uint64_t load(const std::byte *src) {
+		uint64_t value;
+		std::memcpy(&value, src, sizeof(value));
+		return Endian::toHost(value);
+	}
+
+	// Writes the lower "size" bytes of "value" in network byte order.
+	template< uint8_t size > void write(const uint64_t value) {
+		static_assert(size > 0 && size <= sizeof(value));
+
+		if (m_seek.size() < size) {
+			for (auto i = size; i > 0; --i) {
+				append((value >> (8 * (i - 1))) & 0xFF);
+			}
+
+			return;
+		}
+
+		const auto tmp = Endian::toNetwork(value << (64 - 8 * size));
+		std::memcpy(m_seek.data(), &tmp, size);
 		m_seek = m_seek.subspan(size);
+	}
+
+	// The prefix byte tells us the length, the value is then extracted from a single load without branching.
+	// "src" must point to at least s_maxLength bytes. Returns 0 for prefixes that require the slow path.
+	static uint8_t decodeFast(const std::byte *src, uint64_t &value) {
+		const auto length = s_length[std::to_integer< uint8_t >(*src) >> 2];
+
+		// 64-bit values are the only ones whose bytes don't start right at the prefix.
+		value = (load(src + (length >> 3)) >> s_shift[length]) & s_mask[length];
+
+		return length;
+	}
+
+	// Byte by byte, handles all prefixes and truncated input.
+	PacketDataStream &decodeSlow(uint64_t &value) {
+		uint64_t tmp = next();
+
+		if ((tmp & 0x80) == 0x00) {
+			value = (tmp & 0x7F);
+		} else if ((tmp & 0xC0) == 0x80) {
+			value = (tmp & 0x3F) << 8 | next();
+		} else if ((tmp & 0xF0) == 0xF0) {
+			switch (tmp & 0xFC) {
+				case 0xF0:
+					value = next() << 24 | next() << 16 | next() << 8 | next();
+					break;
+				case 0xF4:
+					value = next() << 56 | next() << 48 | next() << 40 | next() << 32 | next() << 24 | next() << 16
+							| next() << 8 | next();
+					break;
+				case 0xF8:
+					*this >> value;
+					value = ~value;
+					break;
+				case 0xFC:
+					value = tmp & 0x03;
+					value = ~value;
+					break;
+				default:
+					m_ok  = false;
+					value = 0;
+					break;
+			}
+		} else if ((tmp & 0xF0) == 0xE0) {
+			value = (tmp & 0x0F) << 24 | next() << 16 | next() << 8 | next();
+		} else if ((tmp & 0xE0) == 0xC0) {
+			value = (tmp & 0x1F) << 16 | next() << 8 | next();
+		}
 
 		return *this;
 	}
 
-private:
 	constexpr uint64_t next() {
 		if (!m_seek.empty()) {
 			const auto value = std::to_integer< uint64_t >(m_seek.front());
@@ -277,28 +409,6 @@ private:
 		return 0;
 	}
 
-	constexpr void append(const uint64_t value) {
-		if (!m_seek.empty()) {
-			m_seek.front() = std::byte(value);
-			m_seek         = m_seek.subspan(sizeof(std::byte));
-		} else {
-			m_ok = false;
-			++m_overshoot;
-		}
-	}
-
-	void append(const BufViewConst buf) {
-		if (m_seek.size() >= buf.size()) {
-			std::copy(buf.begin(), buf.end(), m_seek.begin());
-			m_seek = m_seek.subspan(buf.size());
-		} else {
-			std::fill(m_seek.begin(), m_seek.end(), std::byte(0));
-			m_overshoot += static_cast< decltype(m_overshoot) >(buf.size() - m_seek.size());
-			m_seek = m_seek.last(0);
-			m_ok   = false;
-		}
-	}
-
 	bool m_ok;
 	BufView m_buf;
 	BufView m_seek;
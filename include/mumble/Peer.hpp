@@ -40,6 +40,11 @@ public:
 		std::function< void(Endpoint &endpoint, BufView buf) > encrypted;
 		std::function< void(Endpoint &endpoint, udp::Message::Ping &ping) > ping;
 		std::function< void(Endpoint &endpoint, legacy::udp::Ping &ping) > legacyPing;
+
+		// Same as above, without building an Endpoint for every packet. Called instead of the above when set.
+		std::function< void(EndpointV &endpoint, BufView buf) > encryptedV;
+		std::function< void(EndpointV &endpoint, udp::Message::Ping &ping) > pingV;
+		std::function< void(EndpointV &endpoint, legacy::udp::Ping &ping) > legacyPingV;
 	};
 
 	Peer();
@@ -68,6 +73,7 @@ public:
 	virtual Code delTCP(const SharedConnection &connection);
 
 	virtual Code sendUDP(const Endpoint &endpoint, const BufViewConst data);
+	virtual Code sendUDP(const EndpointV &endpoint, const BufViewConst data);
 
 private:
 	std::unique_ptr< P > m_p;
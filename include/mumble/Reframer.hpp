@@ -0,0 +1,64 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_REFRAMER_HPP
+#define MUMBLE_REFRAMER_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace mumble {
+// Changes the length of the audio packets of a single speaker, for recipients that want fewer packets per second
+// (frames are merged) or a lower latency (frames are split). The Opus data is neither decoded nor re-encoded.
+//
+// Each packet sent carries the frame number (one frame = 10 ms of audio) of its first frame, like the original ones.
+// Frames can be grouped but not cut: a packet made of a single 60 ms frame stays as is when asking for 20 ms.
+//
+// The frames being held are sent first when a packet can't be merged with them (the configuration changed or there
+// is a gap in the frame numbers), so that a lost packet never shifts the ones after it.
+// The other fields (session, target/context, positional data, volume) are taken from the latest message.
+//
+// Not thread-safe, an instance is meant for a single speaker and a single class of recipients.
+class MUMBLE_EXPORT Reframer : NonCopyable {
+public:
+	class P;
+
+	using Messages = gsl::span< const udp::Message::Audio >;
+
+	// Duration of a frame, as counted by the frame numbers.
+	static constexpr std::chrono::milliseconds frameDuration = std::chrono::milliseconds(10);
+	// Longest packet Opus allows.
+	static constexpr std::chrono::milliseconds durationMax = std::chrono::milliseconds(120);
+
+	// "duration" is the length of the packets sent, a multiple of 10 ms up to 120 ms.
+	Reframer(const std::chrono::milliseconds duration = std::chrono::milliseconds(20));
+	virtual ~Reframer();
+
+	virtual explicit operator bool() const;
+
+	virtual std::chrono::milliseconds duration() const;
+	// Number of frames being held.
+	virtual uint32_t pending() const;
+
+	// Returns the messages to send, which are valid until the next call to any function.
+	// Nothing is returned while frames are being held.
+	virtual Messages operator()(const udp::Message::Audio &audio);
+	// Sends the frames being held, e.g. when the speaker timed out without a terminator.
+	virtual Messages flush();
+	// Discards the frames being held.
+	virtual void reset();
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
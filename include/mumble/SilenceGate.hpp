@@ -0,0 +1,98 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SILENCEGATE_HPP
+#define MUMBLE_SILENCEGATE_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Opus.hpp"
+#include "Types.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace mumble {
+// Keeps the silence sent by a speaker from being fanned out, for clients with an open mic or a poor voice activity
+// detection that keep sending comfort noise and near-silent frames.
+//
+// Packets are classified from their header and size only (see classify()): the audio is not decoded.
+// Once a speaker has been quiet for the hangover time, their packets are dropped until they speak again. The packet
+// that closes the gate is flagged as terminator, so that the listeners' jitter buffers end the talk spurt instead of
+// concealing the missing audio. Optionally, a quiet packet is let through from time to time (as a spurt of its own)
+// so that the listeners keep hearing the background.
+//
+// Time is measured through the frame numbers (one frame = 10 ms of audio), not on arrival.
+//
+// Not thread-safe, an instance is meant for a single speaker. The configuration is usually the one of their channel.
+class MUMBLE_EXPORT SilenceGate : NonCopyable {
+public:
+	class P;
+
+	enum class Class : uint8_t {
+		Speech,
+		// Comfort noise or background: the frames are too small to carry speech.
+		Quiet,
+		// The frames carry no audio at all, like the ones an encoder sends in DTX (see Opus::inDTX()).
+		DTX
+	};
+
+	enum class Verdict : uint8_t {
+		Forward,
+		// To be forwarded flagged as terminator.
+		Terminate,
+		Drop
+	};
+
+	// Frames with fewer bytes per 10 ms of audio are quiet (4 kbit/s).
+	static constexpr uint8_t quietBytesDefault = 5;
+
+	struct Config {
+		bool enabled       = true;
+		uint8_t quietBytes = quietBytesDefault;
+		// How long a speaker has to stay quiet before the gate closes, so that the end of sentences goes through.
+		std::chrono::milliseconds hangover = std::chrono::milliseconds(300);
+		// How often a quiet packet is let through while the gate is closed, 0 to drop them all.
+		std::chrono::milliseconds keepAlive = std::chrono::milliseconds(0);
+	};
+
+	struct Stats {
+		uint32_t forwarded = 0;
+		uint32_t dropped   = 0;
+		// Sum of the sizes of the Opus data that was dropped.
+		uint64_t bytesSaved = 0;
+	};
+
+	SilenceGate();
+	SilenceGate(const Config &config);
+	virtual ~SilenceGate();
+
+	virtual explicit operator bool() const;
+
+	virtual Config config() const;
+	// Takes effect with the next packet, e.g. when the speaker moves to another channel.
+	virtual void setConfig(const Config &config);
+
+	// Whether the speaker's packets are currently forwarded.
+	virtual bool open() const;
+	virtual Stats stats() const;
+
+	virtual Verdict operator()(const udp::Message::Audio &audio);
+	virtual Verdict operator()(const uint64_t number, const BufViewConst packet, const bool terminator);
+
+	// The next packet starts from a closed gate.
+	virtual void reset();
+
+	// Malformed packets are considered speech: it's not up to this class to filter them out.
+	static Class classify(const Opus::PacketInfo &info, const uint8_t quietBytes = quietBytesDefault);
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,112 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_TRANSCODER_HPP
+#define MUMBLE_TRANSCODER_HPP
+
+#include "Macros.hpp"
+#include "Message.hpp"
+#include "NonCopyable.hpp"
+#include "Opus.hpp"
+#include "Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace mumble {
+// Produces lower bitrate variants of the speakers' streams, for listeners whose link can't take all of them at the
+// original bitrate (typically mobile clients in big channels).
+//
+// Each packet is decoded once and the audio is encoded again for every variant of the stream that has subscribers:
+// nothing is done for the variants nobody listens to. process() handles the streams in parallel on a worker pool and
+// measures the time spent on each of them, so that the cost of a speaker can be accounted for.
+//
+// Decoders and encoders come from pools sized on construction, adding a stream or subscribing doesn't allocate them.
+//
+// push() can be called from any thread, concurrently with the other functions. Streams and subscriptions can be
+// changed at any time, but process() must not be called concurrently with itself, output() or stats().
+class MUMBLE_EXPORT Transcoder : NonCopyable {
+public:
+	class P;
+
+	struct Variant {
+		uint32_t bitrate             = 16000;
+		Opus::Encoder::Preset preset = Opus::Encoder::Preset::VoIP;
+		bool fec                     = true;
+		// Expected packet loss in percent, the encoder only adds FEC data when it's above 0.
+		uint8_t packetLoss = 10;
+	};
+
+	struct Packet {
+		uint64_t number;
+		bool terminator;
+		BufViewConst data;
+	};
+
+	using Packets = gsl::span< const Packet >;
+
+	struct Stats {
+		uint32_t decoded = 0;
+		uint32_t encoded = 0;
+		// Packets that couldn't be decoded or encoded.
+		uint32_t failed = 0;
+		// Received Opus data and the duration of the audio it carries, to tell the original bitrate.
+		uint64_t bytes                     = 0;
+		std::chrono::microseconds duration = {};
+		// Time spent on the stream by the worker threads.
+		std::chrono::nanoseconds time = {};
+
+		constexpr uint32_t bitrate() const {
+			return duration.count() ? static_cast< uint32_t >(bytes * 8 * 1000000 / duration.count()) : 0;
+		}
+	};
+
+	// "threads" is the size of the worker pool, 0 picks the number of CPU cores.
+	Transcoder(const std::vector< Variant > &variants, const uint8_t channels = 1, const uint32_t streamsMax = 64,
+			   const uint32_t threads = 0);
+	virtual ~Transcoder();
+
+	virtual explicit operator bool() const;
+
+	virtual uint8_t channels() const;
+
+	virtual size_t variants() const;
+	virtual Variant variant(const size_t index) const;
+
+	// Returns the variant for a listener who can take "bandwidth" bits per second for the stream: none when the
+	// original ("bitrate") fits, otherwise the one with the highest bitrate that fits or the lowest one.
+	virtual std::optional< size_t > select(const uint32_t bandwidth, const uint32_t bitrate = 0) const;
+
+	// Fail if the ID is already taken or if the maximum is reached.
+	virtual bool addStream(const uint32_t id);
+	virtual bool removeStream(const uint32_t id);
+	virtual size_t streams() const;
+
+	// The variant is encoded as long as it has at least one subscriber.
+	virtual bool subscribe(const uint32_t id, const size_t variant);
+	virtual bool unsubscribe(const uint32_t id, const size_t variant);
+	virtual uint32_t subscribers(const uint32_t id, const size_t variant) const;
+
+	virtual bool push(const uint32_t id, const udp::Message::Audio &audio);
+	virtual bool push(const uint32_t id, const uint64_t number, const BufViewConst packet, const bool terminator);
+
+	// Transcodes the packets pushed since the last call. Returns the number of packets that were decoded.
+	virtual size_t process();
+
+	// The packets of the variant produced by the last process() call, valid until the next one.
+	virtual Packets output(const uint32_t id, const size_t variant) const;
+	// Totals since the stream was added.
+	virtual Stats stats(const uint32_t id) const;
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,62 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_TRUSTSTORE_HPP
+#define MUMBLE_TRUSTSTORE_HPP
+
+#include "Cert.hpp"
+#include "Macros.hpp"
+#include "NonCopyable.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace mumble {
+// Set of trusted authorities that peer certificate chains are verified against.
+//
+// Successful verifications are cached, keyed by the fingerprint of the leaf and a hash of the rest of the chain and of
+// the verification parameters, until the first certificate in the verified chain expires. A peer presenting the same
+// chain again (e.g. when reconnecting) doesn't go through the signature checks. Failures are not cached.
+//
+// Meant to be shared by all connections, all functions are thread-safe.
+class MUMBLE_EXPORT TrustStore : NonCopyable {
+public:
+	class P;
+
+	// What the leaf is checked to be meant for (extended key usage), the trust settings of the authorities too.
+	enum class Purpose : uint8_t { Any, Client, Server };
+
+	// Entries are evicted once this number is reached, starting from the expired ones.
+	static constexpr size_t cacheSizeMax = 1000;
+
+	TrustStore();
+	virtual ~TrustStore();
+
+	virtual explicit operator bool() const;
+
+	virtual void *handle() const;
+
+	// addPEM() accepts multiple certificates, addDefaultPaths() adds the system's authorities.
+	virtual bool add(const Cert &cert);
+	virtual bool addPEM(const std::string_view pem);
+	virtual bool addDefaultPaths();
+
+	// "chain" starts with the leaf, as sent by the peer.
+	// "params" is an optional X509_VERIFY_PARAM (e.g. the one of the TLS connection), applied on top of the purpose:
+	// host name to match, flags, depth and so on. A purpose set in it has to be the same as "purpose".
+	// Returns the verified chain, ending with the trusted authority, or an empty one if verification failed.
+	virtual Cert::Chain verify(const Cert::Chain &chain, const Purpose purpose = Purpose::Any,
+							   const void *params = nullptr);
+
+	virtual size_t cacheSize() const;
+	virtual void clearCache();
+
+private:
+	std::unique_ptr< P > m_p;
+};
+} // namespace mumble
+
+#endif
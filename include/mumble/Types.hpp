@@ -14,6 +14,7 @@ namespace mumble {}
 
 #include <algorithm>
 #include <limits>
+#include <type_traits>
 #include <vector>
 
 #include <gsl/span>
@@ -39,6 +40,18 @@ enum class Code : int8_t {
 	Disconnect
 };
 
+// Trivially copyable, standard-layout counterpart of Endpoint (18 bytes instead of 40).
+// Used on the UDP path, so that packet metadata can be stored in contiguous arrays.
+struct EndpointV {
+	IPValue ip;
+	uint16_t port;
+
+	constexpr bool operator==(const EndpointV &endpoint) const { return endpoint.ip == ip && endpoint.port == port; }
+	constexpr bool operator!=(const EndpointV &endpoint) const { return !(*this == endpoint); }
+};
+
+static_assert(std::is_trivially_copyable_v< EndpointV > && std::is_standard_layout_v< EndpointV >);
+
 struct Endpoint {
 	IP ip;
 	uint16_t port;
@@ -48,12 +61,15 @@ struct Endpoint {
 	Endpoint(const IP &ip) : ip(ip), port(0) {}
 	Endpoint(const uint16_t port) : port(port) {}
 	Endpoint(const IP &ip, const uint16_t port) : ip(ip), port(port) {}
+	Endpoint(const EndpointV &endpoint) : ip(endpoint.ip), port(endpoint.port) {}
 	virtual ~Endpoint() = default;
 
 	virtual Endpoint &operator=(const Endpoint &endpoint) = default;
 	virtual Endpoint &operator=(Endpoint &&endpoint) = default;
 
 	virtual bool operator==(const Endpoint &endpoint) const { return endpoint.ip == ip && endpoint.port == port; }
+
+	virtual EndpointV value() const { return { ip.value(), port }; }
 };
 
 struct Version {
@@ -109,6 +125,8 @@ struct Version {
 using Buf          = std::vector< std::byte >;
 using BufView      = gsl::span< std::byte >;
 using BufViewConst = gsl::span< const std::byte >;
+// Multiple buffers, processed in order as if they were a single contiguous one.
+using BufViewsConst = gsl::span< const BufViewConst >;
 
 template< size_t size > using FixedBuf = std::array< std::byte, size >;
 
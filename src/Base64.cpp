@@ -7,33 +7,73 @@
 
 #include "mumble/Types.hpp"
 
-#include <cassert>
-#include <cmath>
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string_view>
 
-#include <openssl/evp.h>
+// The semantics are the same as the ones of EVP_EncodeBlock() and EVP_DecodeUpdate() + EVP_DecodeFinal(),
+// which were used before:
+//
+// - Encoding adds padding when the input is not divisible by 3, no newlines are inserted.
+// - Decoding skips whitespace (spaces and tabs), carriage returns and newlines, wherever they are.
+// - Decoding stops at '-' (EOF character for OpenSSL), the rest of the input is ignored.
+// - Decoding fails on any other character outside of the alphabet, on more than 2 padding characters,
+//   on data after padding and if the number of characters (including padding) is not divisible by 4.
 
 #define CHECK      \
 	if (!*this) {  \
 		return {}; \
 	}
 
-#define CAST_BUF(var) (reinterpret_cast< unsigned char * >(var))
-#define CAST_BUF_CONST(var) (reinterpret_cast< const unsigned char * >(var))
-#define CAST_SIZE(var) (static_cast< int >(var))
-
 using namespace mumble;
 
 using P = Base64::P;
 
+static constexpr uint8_t invalid = 0xFF;
+static constexpr uint8_t skip    = 0xFE;
+static constexpr uint8_t pad     = 0xFD;
+static constexpr uint8_t stop    = 0xFC;
+
+static constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static constexpr std::array< uint8_t, 256 > decodeTable() {
+	std::array< uint8_t, 256 > table = {};
+	for (auto &value : table) {
+		value = invalid;
+	}
+
+	for (uint8_t i = 0; i < alphabet.size(); ++i) {
+		table[static_cast< uint8_t >(alphabet[i])] = i;
+	}
+
+	table[' ']  = skip;
+	table['\t'] = skip;
+	table['\r'] = skip;
+	table['\n'] = skip;
+	table['=']  = pad;
+	table['-']  = stop;
+
+	return table;
+}
+
+static constexpr auto values = decodeTable();
+
+static void encodeGroup(std::byte *out, const uint8_t a, const uint8_t b, const uint8_t c) {
+	out[0] = static_cast< std::byte >(alphabet[a >> 2]);
+	out[1] = static_cast< std::byte >(alphabet[(a & 0x03) << 4 | b >> 4]);
+	out[2] = static_cast< std::byte >(alphabet[(b & 0x0F) << 2 | c >> 6]);
+	out[3] = static_cast< std::byte >(alphabet[c & 0x3F]);
+}
+
 Base64::Base64() : m_p(new P) {
 }
 
 Base64::~Base64() = default;
 
 Base64::operator bool() {
-	return m_p && m_p->m_ctx;
+	return static_cast< bool >(m_p);
 }
 
 size_t Base64::decode(const BufView out, const BufViewConst in) {
@@ -41,58 +81,215 @@ size_t Base64::decode(const BufView out, const BufViewConst in) {
 
 	if (!out.size()) {
 		// 4 input bytes = max. 3 output bytes.
-		//
-		// EVP_DecodeUpdate() ignores:
-		// - Leading/trailing whitespace.
-		// - Trailing newlines, carriage returns or EOF characters.
-		//
-		// EVP_DecodeFinal() fails if the input is not divisible by 4.
 		return in.size() / 4 * 3;
 	}
 
-	// We don't use EVP_DecodeBlock() because it adds padding if the output is not divisible by 3.
-	EVP_DecodeInit(m_p->m_ctx);
-
-	int written_1;
-	if (EVP_DecodeUpdate(m_p->m_ctx, CAST_BUF(out.data()), &written_1, CAST_BUF_CONST(in.data()), CAST_SIZE(in.size()))
-		< 0) {
-		return {};
-	}
+	P::DecodeState state;
 
-	int written_2;
-	if (EVP_DecodeFinal(m_p->m_ctx, CAST_BUF(out.data()), &written_2) <= 0) {
-		return {};
-	}
+	const auto written = P::decode(state, out, in);
 
-	assert(written_1 >= 0);
-	assert(written_2 >= 0);
-	return static_cast< std::size_t >(written_1 + written_2);
+	return P::finish(state) ? written : 0;
 }
 
 size_t Base64::encode(const BufView out, const BufViewConst in) {
+	// 3 input bytes = 4 output bytes, the last group is padded.
+	const auto size = (in.size() + 2) / 3 * 4;
+
 	if (!out.size()) {
-		// 3 input bytes = 4 output bytes.
 		// +1 for the NUL terminator.
-		//
-		// EVP_EncodeBlock() adds padding when the input is not divisible by 3.
-		// Note: n + 2 / 3 == ceil(n / 3.0f)
-		return static_cast< size_t >(4 * (in.size() + 2) / 3 + 1);
+		return size + 1;
 	}
 
-	// EVP_EncodeBlock() returns the length of the string without the NUL terminator.
-	const auto written = EVP_EncodeBlock(CAST_BUF(out.data()), CAST_BUF_CONST(in.data()), CAST_SIZE(in.size()));
-	if (written < 0) {
+	if (out.size() < size) {
 		return {};
 	}
 
-	return static_cast< std::size_t >(written + 1);
+	P::EncodeState state;
+
+	auto written = P::encode(state, out, in);
+	written += P::encodeFinal(state, out.subspan(written));
+
+	// Callers writing into a std::string pass its size, the terminator is already there in that case.
+	if (written < out.size()) {
+		out[written] = std::byte(0);
+	}
+
+	return written + 1;
 }
 
-P::P() : m_ctx(EVP_ENCODE_CTX_new()) {
+size_t Base64::decodeUpdate(const BufView out, const BufViewConst in) {
+	CHECK
+
+	return P::decode(m_p->m_decode, out, in);
 }
 
-P::~P() {
-	if (m_ctx) {
-		EVP_ENCODE_CTX_free(m_ctx);
+bool Base64::decodeFinal() {
+	CHECK
+
+	const auto ok = P::finish(m_p->m_decode);
+
+	m_p->m_decode = {};
+
+	return ok;
+}
+
+size_t Base64::encodeUpdate(const BufView out, const BufViewConst in) {
+	CHECK
+
+	return P::encode(m_p->m_encode, out, in);
+}
+
+size_t Base64::encodeFinal(const BufView out) {
+	CHECK
+
+	return P::encodeFinal(m_p->m_encode, out);
+}
+
+P::Kernel P::kernel() {
+	static const auto kernel = detectKernel();
+	return kernel;
+}
+
+size_t P::decode(DecodeState &state, BufView out, BufViewConst in) {
+	const auto kernel = P::kernel();
+	const auto size   = out.size();
+
+	while (!in.empty() && !state.stopped && !state.failed) {
+		if (kernel != Kernel::Scalar && !state.count && !state.padding) {
+			nativeDecode(kernel, out, in);
+		}
+
+		// Processes the character the native implementation stopped at, then goes back to it as soon as a group is
+		// complete. Without native implementation or with a short input, everything is processed here.
+		bool special = false;
+
+		while (!in.empty() && !(special && !state.count)) {
+			auto value = values[std::to_integer< uint8_t >(in[0])];
+			in         = in.subspan(1);
+
+			switch (value) {
+				case skip:
+					special = true;
+					continue;
+				case stop:
+					state.stopped = true;
+					// OpenSSL rejects an incomplete group before the EOF character.
+					state.failed = state.count;
+					return size - out.size();
+				case invalid:
+					state.failed = true;
+					return size - out.size();
+				case pad:
+					special = true;
+					value   = 0;
+
+					if (++state.padding > 2) {
+						state.failed = true;
+						return size - out.size();
+					}
+
+					break;
+				default:
+					// Data after padding.
+					if (state.padding) {
+						state.failed = true;
+						return size - out.size();
+					}
+			}
+
+			state.group[state.count++] = value;
+			if (state.count < state.group.size()) {
+				continue;
+			}
+
+			state.count = 0;
+
+			const auto &group       = state.group;
+			const uint8_t decoded[] = { static_cast< uint8_t >(group[0] << 2 | group[1] >> 4),
+										static_cast< uint8_t >(group[1] << 4 | group[2] >> 2),
+										static_cast< uint8_t >(group[2] << 6 | group[3]) };
+
+			// The padding can only be in the last group, the bytes it stands for are dropped.
+			const uint8_t written = 3 - state.padding;
+			if (out.size() < written) {
+				state.failed = true;
+				return size - out.size();
+			}
+
+			for (uint8_t i = 0; i < written; ++i) {
+				out[i] = static_cast< std::byte >(decoded[i]);
+			}
+
+			out = out.subspan(written);
+		}
 	}
+
+	return size - out.size();
+}
+
+size_t P::encode(EncodeState &state, BufView out, BufViewConst in) {
+	if (out.size() < (state.count + in.size()) / 3 * 4) {
+		return {};
+	}
+
+	const auto size = out.size();
+
+	// Completes the group left over by the previous call.
+	if (state.count) {
+		const size_t missing = 3 - state.count;
+		if (in.size() < missing) {
+			for (const auto byte : in) {
+				state.pending[state.count++] = std::to_integer< uint8_t >(byte);
+			}
+
+			return {};
+		}
+
+		const auto second = state.count > 1 ? state.pending[1] : std::to_integer< uint8_t >(in[0]);
+		encodeGroup(out.data(), state.pending[0], second, std::to_integer< uint8_t >(in[missing - 1]));
+
+		in          = in.subspan(missing);
+		out         = out.subspan(4);
+		state.count = 0;
+	}
+
+	const auto kernel = P::kernel();
+	if (kernel != Kernel::Scalar) {
+		nativeEncode(kernel, out, in);
+	}
+
+	while (in.size() >= 3) {
+		encodeGroup(out.data(), std::to_integer< uint8_t >(in[0]), std::to_integer< uint8_t >(in[1]),
+					std::to_integer< uint8_t >(in[2]));
+
+		in  = in.subspan(3);
+		out = out.subspan(4);
+	}
+
+	for (const auto byte : in) {
+		state.pending[state.count++] = std::to_integer< uint8_t >(byte);
+	}
+
+	return size - out.size();
+}
+
+size_t P::encodeFinal(EncodeState &state, const BufView out) {
+	if (!state.count || out.size() < 4) {
+		return {};
+	}
+
+	encodeGroup(out.data(), state.pending[0], state.count > 1 ? state.pending[1] : 0, 0);
+
+	out[3] = std::byte('=');
+	if (state.count == 1) {
+		out[2] = std::byte('=');
+	}
+
+	state = {};
+
+	return 4;
+}
+
+bool P::finish(const DecodeState &state) {
+	return !state.failed && !state.count;
 }
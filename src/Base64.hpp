@@ -8,18 +8,56 @@
 
 #include "mumble/Base64.hpp"
 
-#include <openssl/ossl_typ.h>
+#include "mumble/Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
 
 namespace mumble {
 class Base64::P {
 	friend Base64;
 
 public:
-	P();
-	~P();
+	enum class Kernel : uint8_t { Scalar, SSSE3, AVX2 };
+
+	struct DecodeState {
+		// The values of the characters of the current group.
+		std::array< uint8_t, 4 > group = {};
+		uint8_t count                  = 0;
+		uint8_t padding                = 0;
+		// Set when '-' is found, the rest of the input is ignored.
+		bool stopped = false;
+		bool failed  = false;
+	};
+
+	struct EncodeState {
+		// The bytes that didn't make a full group of 3 yet.
+		std::array< uint8_t, 2 > pending = {};
+		uint8_t count                    = 0;
+	};
+
+	// Detected once, on first use.
+	static Kernel kernel();
+
+	// Return the number of bytes written.
+	static size_t decode(DecodeState &state, BufView out, BufViewConst in);
+	static size_t encode(EncodeState &state, BufView out, BufViewConst in);
+	static size_t encodeFinal(EncodeState &state, const BufView out);
+
+	static bool finish(const DecodeState &state);
 
 private:
-	EVP_ENCODE_CTX *m_ctx;
+	// Native implementations, see Base64Native.cpp.
+	// Process full blocks for as long as the input and output are big enough, advancing both views.
+	// Decoding stops at the first block that contains a character outside of the alphabet, including padding.
+	static Kernel detectKernel();
+
+	static void nativeDecode(const Kernel kernel, BufView &out, BufViewConst &in);
+	static void nativeEncode(const Kernel kernel, BufView &out, BufViewConst &in);
+
+	DecodeState m_decode;
+	EncodeState m_encode;
 };
 } // namespace mumble
 
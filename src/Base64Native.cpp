@@ -0,0 +1,244 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Base64.hpp"
+#include "CPU.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef MUMBLE_ARCH_X86
+#	include <immintrin.h>
+#endif
+
+// SSSE3 and AVX2 implementations of Base64, based on the algorithms described by Wojciech Muła and Daniel Lemire in
+// "Faster Base64 Encoding and Decoding Using AVX2 Instructions" (https://arxiv.org/abs/1704.00605).
+//
+// Encoding: 12 bytes per 128-bit lane are spread into 16 groups of 6 bits with a shuffle and two multiplications,
+// the characters are then computed by adding an offset that depends on the range each value belongs to.
+//
+// Decoding: a block is only processed if all of its characters are part of the alphabet, which is checked with two
+// lookups (one for each nibble). Blocks containing anything else (whitespace, padding, errors) are left to the scalar
+// implementation in Base64.cpp, which defines the semantics.
+
+using namespace mumble;
+
+using P = Base64::P;
+
+#ifdef MUMBLE_ARCH_X86
+
+#	define TARGET_SSSE3 MUMBLE_TARGET("sse2,ssse3")
+#	define TARGET_AVX2 MUMBLE_TARGET("sse2,ssse3,avx,avx2")
+
+TARGET_SSSE3 static inline __m128i load(const std::byte *src) {
+	return _mm_loadu_si128(reinterpret_cast< const __m128i * >(src));
+}
+
+TARGET_SSSE3 static inline void store(std::byte *dst, const __m128i value) {
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(dst), value);
+}
+
+TARGET_AVX2 static inline __m256i load2(const std::byte *low, const std::byte *high) {
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(load(low)), load(high), 1);
+}
+
+// Turns the first 12 bytes of the block into 16 values of 6 bits.
+TARGET_SSSE3 static inline __m128i split(__m128i in) {
+	in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+	const __m128i first  = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+	const __m128i second = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+
+	return _mm_or_si128(first, second);
+}
+
+TARGET_AVX2 static inline __m256i split(__m256i in) {
+	in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1, 10, 11, 9, 10, 7, 8,
+												 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+	const __m256i first =
+		_mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+	const __m256i second =
+		_mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+
+	return _mm256_or_si256(first, second);
+}
+
+// Maps the values to the ranges of the alphabet: 0-25 to 13, 26-51 to 0, 52-61 to 1-10, 62 to 11 and 63 to 12.
+// The offset for each range is then looked up and added to the value.
+TARGET_SSSE3 static inline __m128i toChars(const __m128i values) {
+	__m128i ranges = _mm_subs_epu8(values, _mm_set1_epi8(51));
+	ranges = _mm_or_si128(ranges, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), values), _mm_set1_epi8(13)));
+
+	const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+										  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+	return _mm_add_epi8(values, _mm_shuffle_epi8(offsets, ranges));
+}
+
+TARGET_AVX2 static inline __m256i toChars(const __m256i values) {
+	__m256i ranges = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+	ranges = _mm256_or_si256(ranges, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), values),
+													  _mm256_set1_epi8(13)));
+
+	const __m256i offsets =
+		_mm256_broadcastsi128_si256(_mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+												  '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+
+	return _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, ranges));
+}
+
+// Returns false if any of the characters is not part of the alphabet, otherwise "values" is filled.
+TARGET_SSSE3 static inline bool toValues(const __m128i chars, __m128i &values) {
+	const __m128i lowNibbles  = _mm_and_si128(chars, _mm_set1_epi8(0x0F));
+	const __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), _mm_set1_epi8(0x0F));
+
+	// A bit is set in both lookups only for characters outside of the alphabet, including all bytes >= 0x80.
+	const __m128i lowLUT  = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B,
+										  0x1B, 0x1B, 0x1A);
+	const __m128i highLUT = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10,
+										  0x10, 0x10, 0x10);
+
+	const __m128i invalid =
+		_mm_and_si128(_mm_shuffle_epi8(lowLUT, lowNibbles), _mm_shuffle_epi8(highLUT, highNibbles));
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF) {
+		return false;
+	}
+
+	// The offset only depends on the high nibble, except for '/' which shares it with '+'.
+	const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i slash   = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+
+	values = _mm_add_epi8(chars, _mm_shuffle_epi8(offsets, _mm_add_epi8(slash, highNibbles)));
+
+	return true;
+}
+
+TARGET_AVX2 static inline bool toValues(const __m256i chars, __m256i &values) {
+	const __m256i lowNibbles  = _mm256_and_si256(chars, _mm256_set1_epi8(0x0F));
+	const __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi32(chars, 4), _mm256_set1_epi8(0x0F));
+
+	const __m256i lowLUT  = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+																	   0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A));
+	const __m256i highLUT = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+																	   0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+
+	if (!_mm256_testz_si256(_mm256_shuffle_epi8(lowLUT, lowNibbles), _mm256_shuffle_epi8(highLUT, highNibbles))) {
+		return false;
+	}
+
+	const __m256i offsets =
+		_mm256_broadcastsi128_si256(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+	const __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+
+	values = _mm256_add_epi8(chars, _mm256_shuffle_epi8(offsets, _mm256_add_epi8(slash, highNibbles)));
+
+	return true;
+}
+
+// Packs 16 values of 6 bits into the first 12 bytes of the block.
+TARGET_SSSE3 static inline __m128i merge(const __m128i values) {
+	const __m128i pairs   = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+	const __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+	return _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+// Packs 32 values of 6 bits into the first 24 bytes of the block.
+TARGET_AVX2 static inline __m256i merge(const __m256i values) {
+	const __m256i pairs   = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+	const __m256i triples = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+
+	const __m256i packed = _mm256_shuffle_epi8(triples, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+																		 -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+																		 -1, -1, -1, -1));
+
+	return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+}
+
+TARGET_SSSE3 static void decodeSSSE3(BufView &out, BufViewConst &in) {
+	__m128i values;
+
+	// The whole block is stored, only the first 12 bytes are meaningful.
+	while (in.size() >= 16 && out.size() >= 16 && toValues(load(in.data()), values)) {
+		store(out.data(), merge(values));
+
+		in  = in.subspan(16);
+		out = out.subspan(12);
+	}
+}
+
+TARGET_AVX2 static void decodeAVX2(BufView &out, BufViewConst &in) {
+	__m256i values;
+
+	while (in.size() >= 32 && out.size() >= 32
+		   && toValues(_mm256_loadu_si256(reinterpret_cast< const __m256i * >(in.data())), values)) {
+		_mm256_storeu_si256(reinterpret_cast< __m256i * >(out.data()), merge(values));
+
+		in  = in.subspan(32);
+		out = out.subspan(24);
+	}
+}
+
+TARGET_SSSE3 static void encodeSSSE3(BufView &out, BufViewConst &in) {
+	// The whole block is loaded, only the first 12 bytes are consumed.
+	while (in.size() >= 16 && out.size() >= 16) {
+		store(out.data(), toChars(split(load(in.data()))));
+
+		in  = in.subspan(12);
+		out = out.subspan(16);
+	}
+}
+
+TARGET_AVX2 static void encodeAVX2(BufView &out, BufViewConst &in) {
+	// Each lane loads 16 bytes and consumes 12.
+	while (in.size() >= 28 && out.size() >= 32) {
+		const __m256i chars = toChars(split(load2(in.data(), in.data() + 12)));
+		_mm256_storeu_si256(reinterpret_cast< __m256i * >(out.data()), chars);
+
+		in  = in.subspan(24);
+		out = out.subspan(32);
+	}
+}
+
+P::Kernel P::detectKernel() {
+	const auto &features = CPU::features();
+
+	if (features.avx2) {
+		return Kernel::AVX2;
+	}
+
+	return features.ssse3 ? Kernel::SSSE3 : Kernel::Scalar;
+}
+
+void P::nativeDecode(const Kernel kernel, BufView &out, BufViewConst &in) {
+	if (kernel == Kernel::AVX2) {
+		decodeAVX2(out, in);
+	}
+
+	decodeSSSE3(out, in);
+}
+
+void P::nativeEncode(const Kernel kernel, BufView &out, BufViewConst &in) {
+	if (kernel == Kernel::AVX2) {
+		encodeAVX2(out, in);
+	}
+
+	encodeSSSE3(out, in);
+}
+
+#else
+
+P::Kernel P::detectKernel() {
+	return Kernel::Scalar;
+}
+
+void P::nativeDecode(const Kernel, BufView &, BufViewConst &) {
+}
+
+void P::nativeEncode(const Kernel, BufView &, BufViewConst &) {
+}
+
+#endif
@@ -0,0 +1,204 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "BitrateLimiter.hpp"
+
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using namespace std::chrono;
+
+using P = BitrateLimiter::P;
+
+using Policy    = BitrateLimiter::Policy;
+using Stats     = BitrateLimiter::Stats;
+using TimePoint = BitrateLimiter::TimePoint;
+using Verdict   = BitrateLimiter::Verdict;
+
+BitrateLimiter::BitrateLimiter(const uint32_t bitrate, const Policy policy, const milliseconds burst,
+							   const milliseconds idle)
+	: m_p(new P(bitrate, policy, burst, idle)) {
+}
+
+BitrateLimiter::~BitrateLimiter() = default;
+
+BitrateLimiter::operator bool() const {
+	return m_p && m_p->m_burst > 0ms;
+}
+
+uint32_t BitrateLimiter::bitrate() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_bitrate;
+}
+
+bool BitrateLimiter::setBitrate(const uint32_t bitrate) {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	const bool wasUnlimited = !m_p->m_bitrate;
+
+	m_p->m_bitrate = bitrate;
+
+	const auto capacity = m_p->capacity();
+
+	// The buckets were empty without a limit, they start full like new ones.
+	for (auto &iter : m_p->m_buckets) {
+		iter.second.tokens = wasUnlimited ? capacity : std::min(iter.second.tokens, capacity);
+	}
+
+	return true;
+}
+
+Policy BitrateLimiter::policy() const {
+	if (!*this) {
+		return Policy::Drop;
+	}
+
+	return m_p->m_policy;
+}
+
+Verdict BitrateLimiter::operator()(const uint32_t session, const size_t size, const TimePoint now) {
+	if (!*this) {
+		return Verdict::Drop;
+	}
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->take(session, size, now);
+}
+
+Verdict BitrateLimiter::operator()(const uint32_t session, const BufViewConst opusPacket, const size_t size,
+								   const TimePoint now) {
+	if (!*this) {
+		return Verdict::Drop;
+	}
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	if (!opusPacket.empty() && !Opus::inspect(opusPacket)) {
+		++m_p->bucket(session, now).stats.dropped;
+		return Verdict::Drop;
+	}
+
+	return m_p->take(session, size, now);
+}
+
+Stats BitrateLimiter::stats(const uint32_t session) const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_buckets.find(session);
+	if (iter == m_p->m_buckets.cend()) {
+		return {};
+	}
+
+	return iter->second.stats;
+}
+
+size_t BitrateLimiter::sessions() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_buckets.size();
+}
+
+bool BitrateLimiter::remove(const uint32_t session) {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_buckets.erase(session);
+}
+
+P::P(const uint32_t bitrate, const Policy policy, const milliseconds burst, const milliseconds idle)
+	: m_bitrate(bitrate), m_policy(policy), m_burst(burst), m_idle(idle > 0ms ? std::max(idle, burst) : idle) {
+}
+
+P::Bucket &P::bucket(const uint32_t session, const TimePoint now) {
+	expire(now);
+
+	// A new session starts with a full bucket.
+	auto &bucket = m_buckets.try_emplace(session, Bucket{ capacity(), now, now, {} }).first->second;
+	bucket.used  = std::max(bucket.used, now);
+
+	return bucket;
+}
+
+void P::expire(const TimePoint now) {
+	if (m_idle <= 0ms || now - m_expired < m_idle) {
+		return;
+	}
+
+	m_expired = now;
+
+	for (auto iter = m_buckets.begin(); iter != m_buckets.end();) {
+		if (now - iter->second.used >= m_idle) {
+			iter = m_buckets.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+}
+
+Verdict P::take(const uint32_t session, const size_t size, const TimePoint now) {
+	auto &bucket = this->bucket(session, now);
+
+	if (!m_bitrate) {
+		++bucket.stats.passed;
+		bucket.stats.bytes += size;
+		return Verdict::Pass;
+	}
+
+	// Packets handled by different threads can come slightly out of order.
+	if (now > bucket.refilled) {
+		const auto elapsed = duration< double >(now - bucket.refilled).count();
+
+		bucket.tokens   = std::min(bucket.tokens + elapsed * rate(), capacity());
+		bucket.refilled = now;
+	}
+
+	if (static_cast< double >(size) <= bucket.tokens) {
+		bucket.tokens -= static_cast< double >(size);
+		++bucket.stats.passed;
+		bucket.stats.bytes += size;
+		return Verdict::Pass;
+	}
+
+	if (m_policy == Policy::Flag) {
+		++bucket.stats.flagged;
+		bucket.stats.bytes += size;
+		return Verdict::Flag;
+	}
+
+	++bucket.stats.dropped;
+	return Verdict::Drop;
+}
+
+double P::rate() const {
+	return m_bitrate / 8.0;
+}
+
+double P::capacity() const {
+	return rate() * duration< double >(m_burst).count();
+}
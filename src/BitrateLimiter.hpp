@@ -0,0 +1,55 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_BITRATELIMITER_HPP
+#define MUMBLE_SRC_BITRATELIMITER_HPP
+
+#include "mumble/BitrateLimiter.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace mumble {
+class BitrateLimiter::P {
+	friend BitrateLimiter;
+
+public:
+	struct Bucket {
+		// In bytes.
+		double tokens;
+		TimePoint refilled;
+		TimePoint used;
+		Stats stats;
+	};
+
+	P(const uint32_t bitrate, const Policy policy, const std::chrono::milliseconds burst,
+	  const std::chrono::milliseconds idle);
+	~P() = default;
+
+	Bucket &bucket(const uint32_t session, const TimePoint now);
+	Verdict take(const uint32_t session, const size_t size, const TimePoint now);
+	// Removes the buckets that weren't used for "idle". Walks all of them, but at most once per idle period.
+	void expire(const TimePoint now);
+
+private:
+	// Bytes per second.
+	double rate() const;
+	double capacity() const;
+
+	uint32_t m_bitrate;
+	Policy m_policy;
+	std::chrono::milliseconds m_burst;
+	std::chrono::milliseconds m_idle;
+	TimePoint m_expired;
+
+	mutable std::mutex m_mutex;
+	std::unordered_map< uint32_t, Bucket > m_buckets;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,93 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "CPU.hpp"
+
+#include <array>
+#include <cstdint>
+
+#ifdef MUMBLE_ARCH_X86
+#	ifdef MUMBLE_COMPILER_MSVC
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+using namespace mumble;
+
+#ifdef MUMBLE_ARCH_X86
+using Registers = std::array< uint32_t, 4 >;
+
+static Registers cpuid(const uint32_t leaf, const uint32_t subLeaf = 0) {
+	Registers regs{};
+#	ifdef MUMBLE_COMPILER_MSVC
+	int tmp[4];
+	__cpuidex(tmp, static_cast< int >(leaf), static_cast< int >(subLeaf));
+	for (uint8_t i = 0; i < regs.size(); ++i) {
+		regs[i] = static_cast< uint32_t >(tmp[i]);
+	}
+#	else
+	if (!__get_cpuid_count(leaf, subLeaf, &regs[0], &regs[1], &regs[2], &regs[3])) {
+		return {};
+	}
+#	endif
+	return regs;
+}
+
+// Whether the OS saves the XMM and YMM registers on context switch.
+static bool osSupportsAVX() {
+#	ifdef MUMBLE_COMPILER_MSVC
+	const auto xcr0 = _xgetbv(0);
+#	else
+	uint32_t eax, edx;
+	__asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	const uint64_t xcr0 = (static_cast< uint64_t >(edx) << 32) | eax;
+#	endif
+	return (xcr0 & 0x6) == 0x6;
+}
+
+static CPU::Features detect() {
+	CPU::Features features;
+
+	enum Reg : uint8_t { EAX, EBX, ECX, EDX };
+
+	const auto max = cpuid(0)[EAX];
+	if (max < 1) {
+		return features;
+	}
+
+	const auto leaf1 = cpuid(1);
+
+	features.sse2   = leaf1[EDX] & (1 << 26);
+	features.ssse3  = leaf1[ECX] & (1 << 9);
+	features.sse41  = leaf1[ECX] & (1 << 19);
+	features.aes    = leaf1[ECX] & (1 << 25);
+	features.pclmul = leaf1[ECX] & (1 << 1);
+
+	const bool osxsave = leaf1[ECX] & (1 << 27);
+	features.avx       = osxsave && (leaf1[ECX] & (1 << 28)) && osSupportsAVX();
+
+	if (max < 7 || !features.avx) {
+		return features;
+	}
+
+	const auto leaf7 = cpuid(7);
+
+	features.avx2 = leaf7[EBX] & (1 << 5);
+	features.vaes = leaf7[ECX] & (1 << 9);
+
+	return features;
+}
+#else
+static CPU::Features detect() {
+	return {};
+}
+#endif
+
+const CPU::Features &CPU::features() {
+	static const Features features = detect();
+	return features;
+}
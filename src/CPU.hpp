@@ -0,0 +1,43 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_CPU_HPP
+#define MUMBLE_SRC_CPU_HPP
+
+#include "mumble/Macros.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#	define MUMBLE_ARCH_X86
+#endif
+
+// Allows a function to use instructions that are not enabled for the whole build.
+// The caller is responsible for checking that the CPU supports them, see CPU::features().
+// MSVC doesn't need this, all intrinsics are always available.
+#ifdef MUMBLE_COMPILER_MSVC
+#	define MUMBLE_TARGET(features)
+#else
+#	define MUMBLE_TARGET(features) __attribute__((target(features)))
+#endif
+
+namespace mumble {
+class CPU {
+public:
+	struct Features {
+		bool sse2   = false;
+		bool ssse3  = false;
+		bool sse41  = false;
+		bool aes    = false;
+		bool pclmul = false;
+		bool avx    = false;
+		bool avx2   = false;
+		bool vaes   = false;
+	};
+
+	// Detected once, on first use.
+	static const Features &features();
+};
+} // namespace mumble
+
+#endif
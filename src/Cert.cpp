@@ -5,23 +5,29 @@
 
 #include "Cert.hpp"
 
+#include "EVP.hpp"
+
 #include "mumble/Key.hpp"
 #include "mumble/Types.hpp"
 
 #include <cstring>
 #include <ctime>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <utility>
 
-#include <gsl/span>
-
 #include <openssl/asn1.h>
 #include <openssl/bio.h>
 #include <openssl/buffer.h>
 #include <openssl/crypto.h>
+#include <openssl/evp.h>
 #include <openssl/obj_mac.h>
 #include <openssl/objects.h>
 #include <openssl/pem.h>
+#include <openssl/rand.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 
@@ -34,15 +40,17 @@
 
 using namespace mumble;
 
-using Attributes = Cert::Attributes;
-using Der        = Cert::Der;
-using P          = Cert::P;
-using TimePoint  = Cert::TimePoint;
+using Attributes  = Cert::Attributes;
+using Der         = Cert::Der;
+using IdentityPtr = Cert::IdentityPtr;
+using P           = Cert::P;
+using TimePoint   = Cert::TimePoint;
 
 Cert::Cert() : m_p(new P(X509_new())) {
 }
 
-Cert::Cert(const Cert &cert) : m_p(new P(X509_dup(cert.m_p->m_x509))) {
+// The certificate is never modified, copies share it.
+Cert::Cert(const Cert &cert) : m_p(new P(cert ? P::ref(cert.m_p->m_x509) : nullptr)) {
 }
 
 Cert::Cert(Cert &&cert) : m_p(std::exchange(cert.m_p, nullptr)) {
@@ -64,7 +72,7 @@ Cert::operator bool() const {
 }
 
 Cert &Cert::operator=(const Cert &cert) {
-	m_p = std::make_unique< P >(cert ? X509_dup(cert.m_p->m_x509) : nullptr);
+	m_p = std::make_unique< P >(cert ? P::ref(cert.m_p->m_x509) : nullptr);
 	return *this;
 }
 
@@ -178,12 +186,50 @@ Attributes Cert::issuerAttributes() const {
 	return P::parseX509Name(X509_get_issuer_name(m_p->m_x509));
 }
 
+Der Cert::fingerprint(const std::string_view type) const {
+	CHECK
+
+	const auto md = EVP::md(type);
+	if (!md) {
+		return {};
+	}
+
+	Der fingerprint(EVP_MAX_MD_SIZE);
+
+	unsigned int size;
+	if (X509_digest(m_p->m_x509, md, reinterpret_cast< unsigned char * >(fingerprint.data()), &size) <= 0) {
+		return {};
+	}
+
+	fingerprint.resize(size);
+
+	return fingerprint;
+}
+
+IdentityPtr Cert::identity() const {
+	CHECK
+
+	auto sha256 = fingerprint("SHA256");
+	if (sha256.empty()) {
+		return {};
+	}
+
+	return P::cachedIdentity(*this, std::move(sha256));
+}
+
+Cert Cert::selfSigned(const Key &key, const Attributes &subject, const std::chrono::seconds validity) {
+	// The private key is needed for the signature.
+	const auto pkey = key.isPrivate() ? static_cast< EVP_PKEY * >(key.handle()) : nullptr;
+
+	return P::selfSigned(pkey, subject, validity);
+}
+
 P::P(X509 *x509) : m_x509(x509) {
 }
 
-P::P(const DerViewConst der) {
-	auto bytes = gsl::as_bytes(der);
-	d2i_X509(&m_x509, reinterpret_cast< const unsigned char ** >(&bytes), static_cast< long >(bytes.size()));
+P::P(const DerViewConst der) : m_x509(nullptr) {
+	auto bytes = reinterpret_cast< const unsigned char * >(der.data());
+	d2i_X509(&m_x509, &bytes, static_cast< long >(der.size()));
 }
 
 P::P(const std::string_view pem, std::string_view password) : m_x509(nullptr) {
@@ -203,6 +249,125 @@ P::~P() {
 	}
 }
 
+X509 *P::ref(X509 *x509) {
+	return X509_up_ref(x509) ? x509 : nullptr;
+}
+
+IdentityPtr P::cachedIdentity(const Cert &cert, Der &&sha256) {
+	// Most recently used first, indexed by fingerprint. Nodes don't move, the iterators stay valid.
+	using Entries = std::list< std::pair< Der, IdentityPtr > >;
+
+	static std::mutex mutex;
+	static Entries entries;
+	static std::map< Der, Entries::iterator > index;
+
+	{
+		const std::lock_guard< std::mutex > lock(mutex);
+
+		const auto iter = index.find(sha256);
+		if (iter != index.cend()) {
+			entries.splice(entries.begin(), entries, iter->second);
+			return iter->second->second;
+		}
+	}
+
+	// Parsed without holding the lock, another thread may have done the same in the meantime.
+	auto identity               = std::make_shared< Identity >();
+	identity->sha1              = cert.fingerprint("SHA1");
+	identity->sha256            = sha256;
+	identity->subjectAttributes = cert.subjectAttributes();
+	identity->issuerAttributes  = cert.issuerAttributes();
+
+	const std::lock_guard< std::mutex > lock(mutex);
+
+	const auto iter = index.find(sha256);
+	if (iter != index.cend()) {
+		return iter->second->second;
+	}
+
+	if (entries.size() >= identityCacheSize) {
+		index.erase(entries.back().first);
+		entries.pop_back();
+	}
+
+	entries.emplace_front(sha256, std::move(identity));
+	index.emplace(std::move(sha256), entries.begin());
+
+	return entries.front().second;
+}
+
+X509 *P::selfSigned(EVP_PKEY *pkey, const Attributes &subject, const std::chrono::seconds validity) {
+	if (!pkey) {
+		return nullptr;
+	}
+
+	auto x509 = X509_new();
+	if (!x509) {
+		return nullptr;
+	}
+
+	// Random serial number, so that certificates generated for the same subject can be told apart.
+	uint64_t serial;
+	bool ok = RAND_bytes(reinterpret_cast< unsigned char * >(&serial), sizeof(serial)) > 0;
+	// Must be positive.
+	serial >>= 1;
+
+	ok = ok && X509_set_version(x509, 2) > 0;
+	ok = ok && ASN1_INTEGER_set_uint64(X509_get_serialNumber(x509), serial) > 0;
+	ok = ok && X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+	ok = ok && X509_gmtime_adj(X509_getm_notAfter(x509), static_cast< long >(validity.count()));
+	ok = ok && setPublicKey(x509, pkey);
+
+	const auto name = X509_get_subject_name(x509);
+
+	for (const auto &attribute : subject) {
+		if (!ok) {
+			break;
+		}
+
+		ok = X509_NAME_add_entry_by_txt(name, std::string(attribute.first).data(), MBSTRING_UTF8,
+										reinterpret_cast< const unsigned char * >(attribute.second.data()),
+										CAST_SIZE(attribute.second.size()), -1, 0)
+			 > 0;
+	}
+
+	ok = ok && X509_set_issuer_name(x509, name) > 0;
+
+	// Ed25519 signs the whole message, without a separate digest.
+	const auto md = EVP_PKEY_id(pkey) == EVP_PKEY_ED25519 ? nullptr : EVP_sha256();
+
+	if (!ok || X509_sign(x509, pkey, md) <= 0) {
+		X509_free(x509);
+		return nullptr;
+	}
+
+	return x509;
+}
+
+bool P::setPublicKey(X509 *x509, EVP_PKEY *pkey) {
+	// The key is kept by the certificate, only its public part must be there.
+	unsigned char *der = nullptr;
+	const int size     = i2d_PUBKEY(pkey, &der);
+	if (size <= 0) {
+		return false;
+	}
+
+	const unsigned char *bytes = der;
+	auto publicKey            = d2i_PUBKEY(nullptr, &bytes, size);
+
+	OPENSSL_free(der);
+
+	if (!publicKey) {
+		return false;
+	}
+
+	const bool ok = X509_set_pubkey(x509, publicKey) > 0;
+
+	EVP_PKEY_free(publicKey);
+
+	return ok;
+}
+
 std::string P::parseASN1String(const ASN1_STRING *string) {
 	if (!string) {
 		return {};
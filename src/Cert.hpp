@@ -8,6 +8,8 @@
 
 #include "mumble/Cert.hpp"
 
+#include <chrono>
+#include <cstddef>
 #include <string>
 #include <string_view>
 
@@ -24,6 +26,16 @@ public:
 	~P();
 
 private:
+	// The least recently used entry is dropped when this size is reached, instances in use are not affected.
+	static constexpr size_t identityCacheSize = 1000;
+
+	static X509 *ref(X509 *x509);
+
+	static IdentityPtr cachedIdentity(const Cert &cert, Der &&sha256);
+
+	static bool setPublicKey(X509 *x509, EVP_PKEY *pkey);
+	static X509 *selfSigned(EVP_PKEY *pkey, const Attributes &subject, const std::chrono::seconds validity);
+
 	static std::string parseASN1String(const ASN1_STRING *string);
 	static TimePoint parseASN1Time(const ASN1_TIME *time);
 	static Attributes parseX509Name(const X509_NAME *name);
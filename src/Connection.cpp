@@ -47,6 +47,11 @@ Code Connection::operator()(const Feedback &feedback, const std::function< bool(
 		const auto code = m_p->handleCode(m_p->isServer() ? m_p->accept() : m_p->connect(), true);
 		switch (code) {
 			case Code::Success:
+				m_p->m_peerCert = m_p->peerCert();
+				if (!m_p->m_peerCert.empty()) {
+					m_p->m_peerIdentity = m_p->m_peerCert[0].identity();
+				}
+
 				m_p->m_closed.clear();
 				m_p->m_feedback.opened();
 				[[fallthrough]];
@@ -84,8 +89,12 @@ const Cert::Chain &Connection::cert() const {
 	return m_p->m_cert;
 }
 
-Cert::Chain Connection::peerCert() const {
-	return m_p->peerCert();
+const Cert::Chain &Connection::peerCert() const {
+	return m_p->m_peerCert;
+}
+
+const Cert::IdentityPtr &Connection::peerIdentity() const {
+	return m_p->m_peerIdentity;
 }
 
 bool Connection::setCert(const Cert::Chain &cert, const Key &key) {
@@ -94,6 +103,12 @@ bool Connection::setCert(const Cert::Chain &cert, const Key &key) {
 	return m_p->setCert(cert, key);
 }
 
+bool Connection::setTrustStore(const std::shared_ptr< TrustStore > &store) {
+	const auto guard = m_p->lock();
+
+	return m_p->setTrustStore(store);
+}
+
 Code Connection::process(const bool wait, const std::function< bool() > halt) {
 	using NetHeader = tcp::NetHeader;
 	using Pack      = tcp::Pack;
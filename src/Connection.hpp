@@ -52,6 +52,8 @@ private:
 	Monitor m_monitorOut;
 
 	Cert::Chain m_cert;
+	Cert::Chain m_peerCert;
+	Cert::IdentityPtr m_peerIdentity;
 	uint32_t m_timeouts;
 	std::atomic_flag m_closed;
 	std::recursive_mutex m_mutex;
@@ -5,6 +5,8 @@
 
 #include "Crypt.hpp"
 
+#include "EVP.hpp"
+
 #include <cassert>
 #include <cstddef>
 #include <memory>
@@ -46,7 +48,7 @@ Crypt &Crypt::operator=(Crypt &&crypt) {
 void *Crypt::handle() const {
 	CHECK
 
-	return m_p->m_ctx;
+	return m_p->m_encrypt;
 }
 
 std::string_view Crypt::cipher() const {
@@ -92,27 +94,25 @@ Buf Crypt::genKey() const {
 	}
 
 	Buf key(size);
-	if (EVP_CIPHER_CTX_rand_key(m_p->m_ctx, CAST_BUF(key.data())) <= 0) {
+	if (!genKey(key)) {
 		return {};
 	}
 
 	return key;
 }
 
-bool Crypt::setKey(const BufViewConst key) {
-	CHECK
-
-	if (m_p->m_key.size() != key.size()) {
-		if (EVP_CIPHER_CTX_set_key_length(m_p->m_ctx, CAST_SIZE(key.size())) <= 0) {
-			return false;
-		}
-
-		m_p->m_key.resize(key.size());
+bool Crypt::genKey(const BufView key) const {
+	if (!key.size() || key.size() != keySize()) {
+		return false;
 	}
 
-	m_p->m_key.assign(key.begin(), key.end());
+	return EVP_CIPHER_CTX_rand_key(m_p->m_encrypt, CAST_BUF(key.data())) > 0;
+}
+
+bool Crypt::setKey(const BufViewConst key) {
+	CHECK
 
-	return EVP_CipherInit_ex(m_p->m_ctx, nullptr, nullptr, CAST_BUF_CONST(key.data()), nullptr, -1) > 0;
+	return m_p->setKey(key);
 }
 
 BufViewConst Crypt::nonce() const {
@@ -128,27 +128,25 @@ Buf Crypt::genNonce() const {
 	}
 
 	Buf nonce(size);
-	if (RAND_priv_bytes(CAST_BUF(nonce.data()), CAST_SIZE(nonce.size())) <= 0) {
+	if (!genNonce(nonce)) {
 		return {};
 	}
 
 	return nonce;
 }
 
-bool Crypt::setNonce(const BufViewConst nonce) {
-	CHECK
-
-	if (m_p->m_nonce.size() != nonce.size()) {
-		if (EVP_CIPHER_CTX_ctrl(m_p->m_ctx, EVP_CTRL_AEAD_SET_IVLEN, CAST_SIZE(nonce.size()), nullptr) <= 0) {
-			return false;
-		}
-
-		m_p->m_nonce.resize(nonce.size());
+bool Crypt::genNonce(const BufView nonce) const {
+	if (!nonce.size() || nonce.size() != nonceSize()) {
+		return false;
 	}
 
-	m_p->m_nonce.assign(nonce.begin(), nonce.end());
+	return RAND_priv_bytes(CAST_BUF(nonce.data()), CAST_SIZE(nonce.size())) > 0;
+}
+
+bool Crypt::setNonce(const BufViewConst nonce) {
+	CHECK
 
-	return EVP_CipherInit_ex(m_p->m_ctx, nullptr, nullptr, nullptr, CAST_BUF_CONST(nonce.data()), -1) > 0;
+	return m_p->setNonce(nonce);
 }
 
 bool Crypt::usesPadding() const {
@@ -166,44 +164,60 @@ bool Crypt::togglePadding(const bool enable) {
 bool Crypt::reset() {
 	CHECK
 
-	return EVP_CIPHER_CTX_reset(m_p->m_ctx) > 0;
+	return m_p->reset();
 }
 
 size_t Crypt::decrypt(const BufView out, const BufViewConst in, const BufViewConst tag, const BufViewConst aad) {
 	CHECK
 
-	return m_p->process(false, out, in, { const_cast< std::byte * >(tag.data()), tag.size() }, aad);
+	return m_p->process(false, out, { &in, 1 }, { const_cast< std::byte * >(tag.data()), tag.size() }, aad);
 }
 
 size_t Crypt::encrypt(const BufView out, const BufViewConst in, const BufView tag, const BufViewConst aad) {
 	CHECK
 
+	return m_p->process(true, out, { &in, 1 }, tag, aad);
+}
+
+size_t Crypt::decrypt(const BufView out, const BufViewsConst in, const BufViewConst tag, const BufViewConst aad) {
+	CHECK
+
+	return m_p->process(false, out, in, { const_cast< std::byte * >(tag.data()), tag.size() }, aad);
+}
+
+size_t Crypt::encrypt(const BufView out, const BufViewsConst in, const BufView tag, const BufViewConst aad) {
+	CHECK
+
 	return m_p->process(true, out, in, tag, aad);
 }
 
-P::P() : m_padding(true), m_ctx(EVP_CIPHER_CTX_new()) {
-	if (m_ctx) {
+P::P() : m_padding(true), m_encrypt(EVP_CIPHER_CTX_new()), m_decrypt(EVP_CIPHER_CTX_new()) {
+	if (m_encrypt && m_decrypt) {
 		setCipher();
 	}
 }
 
 P::~P() {
-	if (m_ctx) {
-		EVP_CIPHER_CTX_free(m_ctx);
+	if (m_encrypt) {
+		EVP_CIPHER_CTX_free(m_encrypt);
+	}
+
+	if (m_decrypt) {
+		EVP_CIPHER_CTX_free(m_decrypt);
 	}
 }
 
 P::operator bool() {
-	return m_ctx && EVP_CIPHER_CTX_cipher(m_ctx);
+	return m_encrypt && m_decrypt && EVP_CIPHER_CTX_cipher(m_encrypt) && EVP_CIPHER_CTX_cipher(m_decrypt);
 }
 
 uint32_t P::blockSize() const {
-	const int size = EVP_CIPHER_CTX_block_size(m_ctx);
+	const int size = EVP_CIPHER_CTX_block_size(m_encrypt);
 	return size >= 0 ? static_cast< uint32_t >(size) : 0;
 }
 
 std::string_view P::cipher() {
-	const auto cipher = EVP_CIPHER_CTX_cipher(m_ctx);
+	const auto cipher = EVP_CIPHER_CTX_cipher(m_encrypt);
 	if (cipher == EVP_enc_null()) {
 		return {};
 	}
@@ -212,85 +226,137 @@ std::string_view P::cipher() {
 }
 
 bool P::setCipher(const std::string_view name) {
-	const auto cipher = name.empty() ? EVP_enc_null() : EVP_get_cipherbyname(name.data());
+	const auto cipher = name.empty() ? EVP_enc_null() : EVP::cipher(name);
 	if (!cipher) {
 		return false;
 	}
 
-	if (EVP_CipherInit_ex(m_ctx, cipher, nullptr, nullptr, nullptr, -1) <= 0) {
+	if (EVP_CipherInit_ex(m_encrypt, cipher, nullptr, nullptr, nullptr, 1) <= 0
+		|| EVP_CipherInit_ex(m_decrypt, cipher, nullptr, nullptr, nullptr, 0) <= 0) {
 		return false;
 	}
 
-	m_key.resize(static_cast< std::size_t >(EVP_CIPHER_CTX_key_length(m_ctx)));
-	m_nonce.resize(static_cast< std::size_t >(EVP_CIPHER_CTX_iv_length(m_ctx)));
+	m_key.assign(static_cast< std::size_t >(EVP_CIPHER_CTX_key_length(m_encrypt)), {});
+	m_nonce.assign(static_cast< std::size_t >(EVP_CIPHER_CTX_iv_length(m_encrypt)), {});
 
-	m_key   = {};
-	m_nonce = {};
+	return true;
+}
+
+bool P::setKey(const BufViewConst key) {
+	for (const auto ctx : { m_encrypt, m_decrypt }) {
+		if (m_key.size() != key.size()) {
+			if (EVP_CIPHER_CTX_set_key_length(ctx, CAST_SIZE(key.size())) <= 0) {
+				return false;
+			}
+		}
+
+		// The expensive part: the key schedule is computed here, once per direction.
+		if (EVP_CipherInit_ex(ctx, nullptr, nullptr, CAST_BUF_CONST(key.data()), nullptr, -1) <= 0) {
+			return false;
+		}
+	}
+
+	m_key.assign(key.begin(), key.end());
+
+	return true;
+}
+
+bool P::setNonce(const BufViewConst nonce) {
+	if (m_nonce.size() != nonce.size()) {
+		for (const auto ctx : { m_encrypt, m_decrypt }) {
+			if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, CAST_SIZE(nonce.size()), nullptr) <= 0) {
+				return false;
+			}
+		}
+	}
+
+	// Applied to the context right before processing, so that every call starts from it.
+	m_nonce.assign(nonce.begin(), nonce.end());
 
 	return true;
 }
 
-size_t P::process(const bool encrypt, const BufView out, const BufViewConst in, const BufView tag,
+bool P::reset() {
+	return EVP_CIPHER_CTX_reset(m_encrypt) > 0 && EVP_CIPHER_CTX_reset(m_decrypt) > 0;
+}
+
+size_t P::process(const bool encrypt, const BufView out, const BufViewsConst in, const BufView tag,
 				  const BufViewConst aad) {
+	size_t size = 0;
+	for (const auto part : in) {
+		size += part.size();
+	}
+
+	// With padding, encryption may add up to an extra block.
+	const auto blockSize = this->blockSize();
+	const auto maxSize   = m_padding && blockSize > 1 ? size + blockSize : size;
+
 	if (!out.size()) {
-		if (m_padding) {
-			const auto size = blockSize();
-			return size > 1 ? in.size() + size : in.size();
-		} else {
-			return in.size();
-		}
+		return maxSize;
 	}
 
-	if (static_cast< bool >(EVP_CIPHER_CTX_encrypting(m_ctx)) == encrypt) {
-		if (EVP_CipherInit_ex(m_ctx, nullptr, nullptr, nullptr, nullptr, encrypt) <= 0) {
-			return {};
-		}
-	} else {
-		// Certain cipher implementations require resetting the key, nonce or both when switching operation mode.
-		// Not doing so doesn't cause any apparent failure, until you realize the output is messed up.
-		if (EVP_CipherInit_ex(m_ctx, nullptr, nullptr, CAST_BUF_CONST(m_key.data()), CAST_BUF_CONST(m_nonce.data()),
-							  encrypt)
-			<= 0) {
-			return {};
-		}
+	// Decryption only ever removes the padding, the output is never larger than the input.
+	if (out.size() < (encrypt ? maxSize : size)) {
+		return {};
+	}
+
+	const auto ctx = encrypt ? m_encrypt : m_decrypt;
+
+	// Only the nonce is set, the key schedule computed by setKey() is kept.
+	if (EVP_CipherInit_ex(ctx, nullptr, nullptr, nullptr, m_nonce.empty() ? nullptr : CAST_BUF_CONST(m_nonce.data()),
+						  -1)
+		<= 0) {
+		return {};
 	}
 
-	if (EVP_CIPHER_CTX_set_padding(m_ctx, m_padding) <= 0) {
+	if (EVP_CIPHER_CTX_set_padding(ctx, m_padding) <= 0) {
 		return {};
 	}
 
 	if (!encrypt && !tag.empty()) {
-		if (EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_AEAD_SET_TAG, CAST_SIZE(tag.size()), tag.data()) <= 0) {
+		if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, CAST_SIZE(tag.size()), tag.data()) <= 0) {
 			return {};
 		}
 	}
 
-	int written1;
+	int written;
 
 	if (!aad.empty()) {
-		if (EVP_CipherUpdate(m_ctx, nullptr, &written1, CAST_BUF_CONST(aad.data()), CAST_SIZE(aad.size())) <= 0) {
+		if (EVP_CipherUpdate(ctx, nullptr, &written, CAST_BUF_CONST(aad.data()), CAST_SIZE(aad.size())) <= 0) {
 			return {};
 		}
 	}
 
-	if (EVP_CipherUpdate(m_ctx, CAST_BUF(out.data()), &written1, CAST_BUF_CONST(in.data()), CAST_SIZE(in.size()))
-		<= 0) {
-		return {};
-	}
+	size_t total = 0;
 
-	int written2;
+	// Each part is written right after the output of the previous ones, no intermediate copy is made.
+	for (const auto part : in) {
+		if (part.empty()) {
+			continue;
+		}
 
-	if (EVP_CipherFinal_ex(m_ctx, CAST_BUF(out.data() + written1), &written2) <= 0) {
+		if (EVP_CipherUpdate(ctx, CAST_BUF(out.data() + total), &written, CAST_BUF_CONST(part.data()),
+							 CAST_SIZE(part.size()))
+			<= 0) {
+			return {};
+		}
+
+		assert(written >= 0);
+		total += static_cast< size_t >(written);
+	}
+
+	if (EVP_CipherFinal_ex(ctx, CAST_BUF(out.data() + total), &written) <= 0) {
 		return {};
 	}
 
+	assert(written >= 0);
+	total += static_cast< size_t >(written);
+
 	if (encrypt && !tag.empty()) {
-		if (EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_AEAD_GET_TAG, CAST_SIZE(tag.size()), tag.data()) <= 0) {
+		if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, CAST_SIZE(tag.size()), tag.data()) <= 0) {
 			return {};
 		}
 	}
 
-	assert(written1 >= 0);
-	assert(written2 >= 0);
-	return static_cast< std::size_t >(written1 + written2);
+	return total;
 }
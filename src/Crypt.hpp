@@ -31,14 +31,21 @@ public:
 	std::string_view cipher();
 	bool setCipher(const std::string_view name = {});
 
-	size_t process(const bool encrypt, const BufView out, const BufViewConst in, const BufView tag,
+	bool setKey(const BufViewConst key);
+	bool setNonce(const BufViewConst nonce);
+
+	bool reset();
+
+	size_t process(const bool encrypt, const BufView out, const BufViewsConst in, const BufView tag,
 				   const BufViewConst aad);
 
 private:
 	Buf m_key;
 	Buf m_nonce;
 	bool m_padding;
-	EVP_CIPHER_CTX *m_ctx;
+	// One context per direction, each keeps its own key schedule.
+	EVP_CIPHER_CTX *m_encrypt;
+	EVP_CIPHER_CTX *m_decrypt;
 };
 } // namespace mumble
 
@@ -5,11 +5,15 @@
 
 #include "CryptOCB2.hpp"
 
+#include "EVP.hpp"
+
 #include "mumble/Endian.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <memory>
+#include <type_traits>
 
 #include <gsl/span>
 
@@ -71,13 +75,23 @@ Buf CryptOCB2::genKey() const {
 	CHECK
 
 	Buf key(P::keySize);
-	if (EVP_CIPHER_CTX_rand_key(m_p->m_ctx, CAST_BUF(key.data())) <= 0) {
+	if (!genKey(key)) {
 		return {};
 	}
 
 	return key;
 }
 
+bool CryptOCB2::genKey(const BufView key) const {
+	CHECK
+
+	if (key.size() != P::keySize) {
+		return false;
+	}
+
+	return EVP_CIPHER_CTX_rand_key(m_p->m_ctx, CAST_BUF(key.data())) > 0;
+}
+
 bool CryptOCB2::setKey(const BufViewConst key) {
 	CHECK
 
@@ -87,6 +101,10 @@ bool CryptOCB2::setKey(const BufViewConst key) {
 
 	std::copy(key.begin(), key.end(), m_p->m_key.begin());
 
+	if (m_p->m_kernel != P::Kernel::EVP) {
+		m_p->expandKey();
+	}
+
 	return EVP_CipherInit_ex(m_p->m_ctx, nullptr, nullptr, CAST_BUF_CONST(key.data()), nullptr, -1) > 0;
 }
 
@@ -100,13 +118,23 @@ Buf CryptOCB2::genNonce() const {
 	CHECK
 
 	Buf nonce(P::nonceSize);
-	if (RAND_priv_bytes(CAST_BUF(nonce.data()), CAST_SIZE(nonce.size())) <= 0) {
+	if (!genNonce(nonce)) {
 		return {};
 	}
 
 	return nonce;
 }
 
+bool CryptOCB2::genNonce(const BufView nonce) const {
+	CHECK
+
+	if (nonce.size() != P::nonceSize) {
+		return false;
+	}
+
+	return RAND_priv_bytes(CAST_BUF(nonce.data()), CAST_SIZE(nonce.size())) > 0;
+}
+
 bool CryptOCB2::setNonce(const BufViewConst nonce) {
 	CHECK
 
@@ -126,6 +154,10 @@ size_t CryptOCB2::decrypt(BufView out, BufViewConst in, const BufViewConst tag)
 		return in.size();
 	}
 
+	if (m_p->m_kernel != P::Kernel::EVP) {
+		return m_p->nativeDecrypt(out, in, tag);
+	}
+
 	KeyBlock delta;
 	const auto deltaBytes = gsl::as_writable_bytes(KeyBlockView(delta));
 
@@ -192,7 +224,7 @@ size_t CryptOCB2::decrypt(BufView out, BufViewConst in, const BufViewConst tag)
 	P::s3(delta);
 	P::xorBlock(tmp, delta, checksum);
 
-	Buf retrievedTag(P::blockSize);
+	FixedBuf< P::blockSize > retrievedTag;
 	if (!m_p->process(true, retrievedTag, tmpBytes)) {
 		return {};
 	}
@@ -215,6 +247,10 @@ size_t CryptOCB2::encrypt(BufView out, BufViewConst in, const BufView tag) {
 		return {};
 	}
 
+	if (m_p->m_kernel != P::Kernel::EVP) {
+		return m_p->nativeEncrypt(out, in, tag);
+	}
+
 	KeyBlock delta;
 	if (!m_p->process(true, gsl::as_writable_bytes(KeyBlockView(delta)), m_p->m_nonce)) {
 		return {};
@@ -307,12 +343,22 @@ size_t CryptOCB2::encrypt(BufView out, BufViewConst in, const BufView tag) {
 	return written;
 }
 
-P::P() : m_ok(false), m_key(), m_nonce(), m_ctx(EVP_CIPHER_CTX_new()) {
+size_t CryptOCB2::decryptBatch(const gsl::span< DecryptJob > jobs) {
+	return P::batch(jobs);
+}
+
+size_t CryptOCB2::encryptBatch(const gsl::span< EncryptJob > jobs) {
+	return P::batch(jobs);
+}
+
+P::P()
+	: m_ok(false), m_kernel(detectKernel()), m_key(), m_nonce(), m_encKeys(), m_decKeys(), m_ctx(EVP_CIPHER_CTX_new()) {
 	if (!m_ctx) {
 		return;
 	}
 
-	if (EVP_CipherInit_ex(m_ctx, EVP_aes_128_ecb(), nullptr, nullptr, nullptr, -1) <= 0) {
+	const auto cipher = EVP::cipher("AES-128-ECB");
+	if (!cipher || EVP_CipherInit_ex(m_ctx, cipher, nullptr, nullptr, nullptr, -1) <= 0) {
 		return;
 	}
 
@@ -320,6 +366,10 @@ P::P() : m_ok(false), m_key(), m_nonce(), m_ctx(EVP_CIPHER_CTX_new()) {
 		return;
 	}
 
+	if (m_kernel != Kernel::EVP) {
+		expandKey();
+	}
+
 	m_ok = true;
 }
 
@@ -364,6 +414,65 @@ size_t P::process(const bool encrypt, const BufView out, const BufViewConst in)
 	return static_cast< std::size_t >(written1 + written2);
 }
 
+template< typename T > size_t P::batch(const gsl::span< T > jobs) {
+	constexpr bool encrypt = std::is_same_v< T, EncryptJob >;
+
+	std::array< T *, maxLanes > lanes;
+	uint8_t numLanes = 0;
+
+	const auto flush = [&lanes, &numLanes]() {
+		if (!numLanes) {
+			return;
+		}
+
+		if constexpr (encrypt) {
+			nativeEncryptLanes({ lanes.data(), numLanes });
+		} else {
+			nativeDecryptLanes({ lanes.data(), numLanes });
+		}
+
+		numLanes = 0;
+	};
+
+	for (auto &job : jobs) {
+		job.written = 0;
+
+		if (!job.crypt || !*job.crypt || (!job.nonce.empty() && job.nonce.size() != nonceSize)) {
+			continue;
+		}
+
+		auto &p = *job.crypt->m_p;
+
+		if (p.m_kernel != Kernel::EVP && !job.out.empty() && (job.tag.empty() || job.tag.size() == blockSize)) {
+			lanes[numLanes++] = &job;
+			if (numLanes == lanes.size()) {
+				flush();
+			}
+
+			continue;
+		}
+
+		// Not suitable for interleaving, process on its own.
+		const auto nonce = p.m_nonce;
+		if (!job.nonce.empty()) {
+			std::copy(job.nonce.begin(), job.nonce.end(), p.m_nonce.begin());
+		}
+
+		if constexpr (encrypt) {
+			job.written = job.crypt->encrypt(job.out, job.in, job.tag);
+		} else {
+			job.written = job.crypt->decrypt(job.out, job.in, job.tag);
+		}
+
+		p.m_nonce = nonce;
+	}
+
+	flush();
+
+	return static_cast< size_t >(
+		std::count_if(jobs.begin(), jobs.end(), [](const T &job) { return job.written != 0; }));
+}
+
 void P::xorBlock(const KeyBlockView dst, const KeyBlockViewConst a, const KeyBlockViewConst b) {
 	for (uint8_t i = 0; i < subBlocks; ++i) {
 		dst[i] = a[i] ^ b[i];
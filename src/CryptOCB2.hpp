@@ -41,6 +41,12 @@ public:
 	static constexpr uint8_t blockSize = 128 / 8;
 	static constexpr uint8_t keySize   = 128 / 8;
 	static constexpr uint8_t nonceSize = 128 / 8;
+	static constexpr uint8_t rounds    = 10;
+	static constexpr uint8_t maxLanes  = 8;
+
+	using RoundKeys = std::array< FixedBuf< blockSize >, rounds + 1 >;
+
+	enum class Kernel : uint8_t { EVP, AESNI, VAES };
 
 	P();
 	~P();
@@ -48,6 +54,21 @@ public:
 private:
 	size_t process(const bool encrypt, const BufView out, const BufViewConst in);
 
+	template< typename T > static size_t batch(const gsl::span< T > jobs);
+
+	// Native implementation, see CryptOCB2Native.cpp.
+	// Used instead of the EVP cipher when the CPU supports AES-NI.
+	static Kernel detectKernel();
+
+	void expandKey();
+
+	size_t nativeDecrypt(const BufView out, const BufViewConst in, const BufViewConst tag) const;
+	size_t nativeEncrypt(const BufView out, const BufViewConst in, const BufView tag) const;
+
+	// Interleaved processing of up to maxLanes jobs, all of them using the native kernel.
+	static void nativeDecryptLanes(const gsl::span< DecryptJob *const > jobs);
+	static void nativeEncryptLanes(const gsl::span< EncryptJob *const > jobs);
+
 	static void xorBlock(const KeyBlockView dst, const KeyBlockViewConst a, const KeyBlockViewConst b);
 
 	static void s2(const KeyBlockView block);
@@ -57,8 +78,11 @@ private:
 	static KeyBlockViewConst toBlockView(const BufViewConst buf);
 
 	bool m_ok;
+	Kernel m_kernel;
 	FixedBuf< keySize > m_key;
 	FixedBuf< nonceSize > m_nonce;
+	alignas(16) RoundKeys m_encKeys;
+	alignas(16) RoundKeys m_decKeys;
 	EVP_CIPHER_CTX *m_ctx;
 };
 } // namespace mumble
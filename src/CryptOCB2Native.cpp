@@ -0,0 +1,665 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "CPU.hpp"
+#include "CryptOCB2.hpp"
+
+#include "mumble/Endian.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef MUMBLE_ARCH_X86
+#	include <immintrin.h>
+#endif
+
+// AES-NI implementation of OCB2-AES128.
+//
+// The key schedule is computed once in setKey(). Full blocks are processed in groups of up to 8,
+// so that the AES rounds of independent blocks are interleaved and the pipeline stays busy.
+// With VAES, groups of 8 blocks are encrypted two at a time in 256-bit registers.
+//
+// Batches of packets are processed in lanes instead, each with its own key.
+//
+// The output must match the EVP based implementation in CryptOCB2.cpp bit for bit,
+// including the counter-cryptanalysis described in section 9 of https://eprint.iacr.org/2019/311.
+
+using namespace mumble;
+
+using P = CryptOCB2::P;
+
+#ifdef MUMBLE_ARCH_X86
+
+#	define TARGET_AESNI MUMBLE_TARGET("sse2,ssse3,aes")
+#	define TARGET_VAES MUMBLE_TARGET("sse2,ssse3,aes,avx,avx2,vaes")
+
+static constexpr uint8_t maxBlocks = 8;
+
+using Keys = const __m128i *;
+
+TARGET_AESNI static inline __m128i load(const std::byte *src) {
+	return _mm_loadu_si128(reinterpret_cast< const __m128i * >(src));
+}
+
+TARGET_AESNI static inline void store(std::byte *dst, const __m128i block) {
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(dst), block);
+}
+
+// Converts between the byte order of a block and a little-endian 128-bit integer.
+TARGET_AESNI static inline __m128i swap(const __m128i block) {
+	return _mm_shuffle_epi8(block, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// Multiplication by x in GF(2^128), the value is expected as little-endian integer (see swap()).
+TARGET_AESNI static inline __m128i times2(const __m128i value) {
+	// Bit 63 of each lane, moved to the other lane.
+	const __m128i carry = _mm_shuffle_epi32(_mm_srli_epi64(value, 63), _MM_SHUFFLE(1, 0, 3, 2));
+	// The carry out of the high lane wraps around as the reduction polynomial.
+	const __m128i mask = _mm_sub_epi64(_mm_setzero_si128(), carry);
+
+	return _mm_xor_si128(_mm_slli_epi64(value, 1), _mm_and_si128(mask, _mm_set_epi64x(1, 0x87)));
+}
+
+TARGET_AESNI static inline __m128i expandStep(__m128i key, __m128i assist) {
+	assist = _mm_shuffle_epi32(assist, _MM_SHUFFLE(3, 3, 3, 3));
+	key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key    = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+
+	return _mm_xor_si128(key, assist);
+}
+
+template< uint8_t count > TARGET_AESNI static inline void encryptBlocks(const Keys keys, __m128i *blocks) {
+	for (uint8_t i = 0; i < count; ++i) {
+		blocks[i] = _mm_xor_si128(blocks[i], keys[0]);
+	}
+
+	for (uint8_t round = 1; round < P::rounds; ++round) {
+		for (uint8_t i = 0; i < count; ++i) {
+			blocks[i] = _mm_aesenc_si128(blocks[i], keys[round]);
+		}
+	}
+
+	for (uint8_t i = 0; i < count; ++i) {
+		blocks[i] = _mm_aesenclast_si128(blocks[i], keys[P::rounds]);
+	}
+}
+
+template< uint8_t count > TARGET_AESNI static inline void decryptBlocks(const Keys keys, __m128i *blocks) {
+	for (uint8_t i = 0; i < count; ++i) {
+		blocks[i] = _mm_xor_si128(blocks[i], keys[0]);
+	}
+
+	for (uint8_t round = 1; round < P::rounds; ++round) {
+		for (uint8_t i = 0; i < count; ++i) {
+			blocks[i] = _mm_aesdec_si128(blocks[i], keys[round]);
+		}
+	}
+
+	for (uint8_t i = 0; i < count; ++i) {
+		blocks[i] = _mm_aesdeclast_si128(blocks[i], keys[P::rounds]);
+	}
+}
+
+TARGET_VAES static void encryptBlocksVAES(const Keys keys, __m128i *blocks) {
+	__m256i pairs[maxBlocks / 2];
+
+	for (uint8_t i = 0; i < maxBlocks / 2; ++i) {
+		pairs[i] = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(blocks + i * 2));
+		pairs[i] = _mm256_xor_si256(pairs[i], _mm256_broadcastsi128_si256(keys[0]));
+	}
+
+	for (uint8_t round = 1; round < P::rounds; ++round) {
+		const __m256i key = _mm256_broadcastsi128_si256(keys[round]);
+
+		for (auto &pair : pairs) {
+			pair = _mm256_aesenc_epi128(pair, key);
+		}
+	}
+
+	const __m256i key = _mm256_broadcastsi128_si256(keys[P::rounds]);
+
+	for (uint8_t i = 0; i < maxBlocks / 2; ++i) {
+		pairs[i] = _mm256_aesenclast_epi128(pairs[i], key);
+		_mm256_storeu_si256(reinterpret_cast< __m256i * >(blocks + i * 2), pairs[i]);
+	}
+}
+
+TARGET_VAES static void decryptBlocksVAES(const Keys keys, __m128i *blocks) {
+	__m256i pairs[maxBlocks / 2];
+
+	for (uint8_t i = 0; i < maxBlocks / 2; ++i) {
+		pairs[i] = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(blocks + i * 2));
+		pairs[i] = _mm256_xor_si256(pairs[i], _mm256_broadcastsi128_si256(keys[0]));
+	}
+
+	for (uint8_t round = 1; round < P::rounds; ++round) {
+		const __m256i key = _mm256_broadcastsi128_si256(keys[round]);
+
+		for (auto &pair : pairs) {
+			pair = _mm256_aesdec_epi128(pair, key);
+		}
+	}
+
+	const __m256i key = _mm256_broadcastsi128_si256(keys[P::rounds]);
+
+	for (uint8_t i = 0; i < maxBlocks / 2; ++i) {
+		pairs[i] = _mm256_aesdeclast_epi128(pairs[i], key);
+		_mm256_storeu_si256(reinterpret_cast< __m256i * >(blocks + i * 2), pairs[i]);
+	}
+}
+
+// Processes "count" blocks, which must be one of 1, 2, 4 or maxBlocks.
+TARGET_AESNI static void cryptBlocks(const bool encrypt, const bool vaes, const Keys keys, __m128i *blocks,
+									 const uint8_t count) {
+	switch (count) {
+		case 1:
+			return encrypt ? encryptBlocks< 1 >(keys, blocks) : decryptBlocks< 1 >(keys, blocks);
+		case 2:
+			return encrypt ? encryptBlocks< 2 >(keys, blocks) : decryptBlocks< 2 >(keys, blocks);
+		case 4:
+			return encrypt ? encryptBlocks< 4 >(keys, blocks) : decryptBlocks< 4 >(keys, blocks);
+		case maxBlocks:
+			if (vaes) {
+				return encrypt ? encryptBlocksVAES(keys, blocks) : decryptBlocksVAES(keys, blocks);
+			}
+
+			return encrypt ? encryptBlocks< maxBlocks >(keys, blocks) : decryptBlocks< maxBlocks >(keys, blocks);
+	}
+}
+
+static uint8_t groupSize(const size_t blocks) {
+	if (blocks >= maxBlocks) {
+		return maxBlocks;
+	}
+
+	return blocks >= 4 ? 4 : blocks >= 2 ? 2 : 1;
+}
+
+// Same as encryptBlocks()/decryptBlocks(), but every block has its own key.
+// The blocks and key pointers are copied to locals, otherwise the compiler has to assume that the blocks alias the
+// key schedules and goes through memory after every round.
+template< uint8_t count, bool encrypt >
+TARGET_AESNI static inline void cryptLanes(const Keys *keys, __m128i *blocks) {
+	Keys lanes[count];
+	__m128i state[count];
+
+	for (uint8_t i = 0; i < count; ++i) {
+		lanes[i] = keys[i];
+		state[i] = _mm_xor_si128(blocks[i], lanes[i][0]);
+	}
+
+	for (uint8_t round = 1; round < P::rounds; ++round) {
+		for (uint8_t i = 0; i < count; ++i) {
+			state[i] =
+				encrypt ? _mm_aesenc_si128(state[i], lanes[i][round]) : _mm_aesdec_si128(state[i], lanes[i][round]);
+		}
+	}
+
+	for (uint8_t i = 0; i < count; ++i) {
+		blocks[i] = encrypt ? _mm_aesenclast_si128(state[i], lanes[i][P::rounds])
+							: _mm_aesdeclast_si128(state[i], lanes[i][P::rounds]);
+	}
+}
+
+template< bool encrypt >
+TARGET_AESNI static void cryptLanes(const Keys *keys, __m128i *blocks, const uint8_t count) {
+	switch (count) {
+		case 1:
+			return cryptLanes< 1, encrypt >(keys, blocks);
+		case 2:
+			return cryptLanes< 2, encrypt >(keys, blocks);
+		case 3:
+			return cryptLanes< 3, encrypt >(keys, blocks);
+		case 4:
+			return cryptLanes< 4, encrypt >(keys, blocks);
+		case 5:
+			return cryptLanes< 5, encrypt >(keys, blocks);
+		case 6:
+			return cryptLanes< 6, encrypt >(keys, blocks);
+		case 7:
+			return cryptLanes< 7, encrypt >(keys, blocks);
+		case P::maxLanes:
+			return cryptLanes< P::maxLanes, encrypt >(keys, blocks);
+	}
+}
+
+static size_t fullBlocks(const size_t size) {
+	// The last block is always handled like a partial one, even if it's full.
+	return size > P::blockSize ? (size - 1) / P::blockSize : 0;
+}
+
+// The block encrypted to produce the pad for the final (partial) block.
+TARGET_AESNI static inline __m128i lengthBlock(const size_t size) {
+	return _mm_set_epi64x(static_cast< int64_t >(Endian::toNetwork(static_cast< uint64_t >(size * 8))), 0);
+}
+
+P::Kernel P::detectKernel() {
+	const auto &features = CPU::features();
+
+	if (!features.aes || !features.ssse3) {
+		return Kernel::EVP;
+	}
+
+	return features.vaes && features.avx2 ? Kernel::VAES : Kernel::AESNI;
+}
+
+TARGET_AESNI void P::expandKey() {
+	const auto enc = reinterpret_cast< __m128i * >(m_encKeys.data());
+	const auto dec = reinterpret_cast< __m128i * >(m_decKeys.data());
+
+	enc[0]  = load(m_key.data());
+	enc[1]  = expandStep(enc[0], _mm_aeskeygenassist_si128(enc[0], 0x01));
+	enc[2]  = expandStep(enc[1], _mm_aeskeygenassist_si128(enc[1], 0x02));
+	enc[3]  = expandStep(enc[2], _mm_aeskeygenassist_si128(enc[2], 0x04));
+	enc[4]  = expandStep(enc[3], _mm_aeskeygenassist_si128(enc[3], 0x08));
+	enc[5]  = expandStep(enc[4], _mm_aeskeygenassist_si128(enc[4], 0x10));
+	enc[6]  = expandStep(enc[5], _mm_aeskeygenassist_si128(enc[5], 0x20));
+	enc[7]  = expandStep(enc[6], _mm_aeskeygenassist_si128(enc[6], 0x40));
+	enc[8]  = expandStep(enc[7], _mm_aeskeygenassist_si128(enc[7], 0x80));
+	enc[9]  = expandStep(enc[8], _mm_aeskeygenassist_si128(enc[8], 0x1B));
+	enc[10] = expandStep(enc[9], _mm_aeskeygenassist_si128(enc[9], 0x36));
+
+	// Equivalent inverse cipher.
+	dec[0] = enc[rounds];
+	for (uint8_t i = 1; i < rounds; ++i) {
+		dec[i] = _mm_aesimc_si128(enc[rounds - i]);
+	}
+	dec[rounds] = enc[0];
+}
+
+TARGET_AESNI size_t P::nativeDecrypt(const BufView out, const BufViewConst in, const BufViewConst tag) const {
+	const auto encKeys = reinterpret_cast< Keys >(m_encKeys.data());
+	const auto decKeys = reinterpret_cast< Keys >(m_decKeys.data());
+	const bool vaes    = m_kernel == Kernel::VAES;
+
+	__m128i delta = load(m_nonce.data());
+	encryptBlocks< 1 >(encKeys, &delta);
+	// Kept as integer for the doubling.
+	delta = swap(delta);
+
+	__m128i checksum = _mm_setzero_si128();
+
+	auto src  = in.data();
+	auto dst  = out.data();
+	auto left = in.size();
+
+	for (auto blocks = fullBlocks(left); blocks;) {
+		const auto count = groupSize(blocks);
+
+		__m128i deltas[maxBlocks], tmp[maxBlocks];
+
+		for (uint8_t i = 0; i < count; ++i) {
+			delta     = times2(delta);
+			deltas[i] = swap(delta);
+			tmp[i]    = _mm_xor_si128(load(src + i * blockSize), deltas[i]);
+		}
+
+		cryptBlocks(false, vaes, decKeys, tmp, count);
+
+		for (uint8_t i = 0; i < count; ++i) {
+			const __m128i plain = _mm_xor_si128(tmp[i], deltas[i]);
+			checksum            = _mm_xor_si128(checksum, plain);
+			store(dst + i * blockSize, plain);
+		}
+
+		src += count * blockSize;
+		dst += count * blockSize;
+		left -= count * blockSize;
+		blocks -= count;
+	}
+
+	delta = times2(delta);
+
+	const __m128i finalDelta = swap(delta);
+
+	__m128i pad = _mm_xor_si128(lengthBlock(left), finalDelta);
+	encryptBlocks< 1 >(encKeys, &pad);
+
+	alignas(16) FixedBuf< blockSize > last{};
+	std::memcpy(last.data(), src, left);
+
+	const __m128i plain = _mm_xor_si128(load(last.data()), pad);
+	checksum            = _mm_xor_si128(checksum, plain);
+
+	// Counter-cryptanalysis described in section 9 of https://eprint.iacr.org/2019/311
+	// In an attack, the decrypted last block would need to equal `delta ^ len(128)`.
+	// See CryptOCB2::decrypt() for details.
+	if (_mm_movemask_epi8(_mm_cmpeq_epi8(plain, finalDelta)) == 0xFFFF) {
+		return {};
+	}
+
+	store(last.data(), plain);
+	std::memcpy(dst, last.data(), left);
+
+	const auto written = in.size();
+
+	if (tag.empty()) {
+		return written;
+	}
+
+	if (tag.size() > blockSize) {
+		return {};
+	}
+
+	__m128i retrievedTag = _mm_xor_si128(swap(_mm_xor_si128(delta, times2(delta))), checksum);
+	encryptBlocks< 1 >(encKeys, &retrievedTag);
+	store(last.data(), retrievedTag);
+
+	if (!std::equal(tag.begin(), tag.end(), last.cbegin())) {
+		return {};
+	}
+
+	return written;
+}
+
+TARGET_AESNI size_t P::nativeEncrypt(const BufView out, const BufViewConst in, const BufView tag) const {
+	const auto keys = reinterpret_cast< Keys >(m_encKeys.data());
+	const bool vaes = m_kernel == Kernel::VAES;
+
+	__m128i delta = load(m_nonce.data());
+	encryptBlocks< 1 >(keys, &delta);
+	// Kept as integer for the doubling.
+	delta = swap(delta);
+
+	__m128i checksum = _mm_setzero_si128();
+
+	auto src  = in.data();
+	auto dst  = out.data();
+	auto left = in.size();
+
+	for (auto blocks = fullBlocks(left); blocks;) {
+		const auto count = groupSize(blocks);
+
+		__m128i deltas[maxBlocks], tmp[maxBlocks];
+
+		for (uint8_t i = 0; i < count; ++i) {
+			__m128i plain = load(src + i * blockSize);
+
+			if (count == blocks && i == count - 1) {
+				// Counter-cryptanalysis described in section 9 of https://eprint.iacr.org/2019/311
+				// The second to last block must not be all 0 except for the last byte.
+				// See CryptOCB2::encrypt() for details.
+				if ((_mm_movemask_epi8(_mm_cmpeq_epi8(plain, _mm_setzero_si128())) & 0x7FFF) == 0x7FFF) {
+					plain = _mm_xor_si128(plain, _mm_cvtsi32_si128(1));
+				}
+			}
+
+			delta     = times2(delta);
+			deltas[i] = swap(delta);
+			checksum  = _mm_xor_si128(checksum, plain);
+			tmp[i]    = _mm_xor_si128(plain, deltas[i]);
+		}
+
+		cryptBlocks(true, vaes, keys, tmp, count);
+
+		for (uint8_t i = 0; i < count; ++i) {
+			store(dst + i * blockSize, _mm_xor_si128(tmp[i], deltas[i]));
+		}
+
+		src += count * blockSize;
+		dst += count * blockSize;
+		left -= count * blockSize;
+		blocks -= count;
+	}
+
+	delta = times2(delta);
+
+	__m128i pad = _mm_xor_si128(lengthBlock(left), swap(delta));
+	encryptBlocks< 1 >(keys, &pad);
+
+	// The plaintext, padded with the pad itself.
+	alignas(16) FixedBuf< blockSize > last;
+	store(last.data(), pad);
+	std::memcpy(last.data(), src, left);
+
+	const __m128i plain = load(last.data());
+	checksum            = _mm_xor_si128(checksum, plain);
+
+	store(last.data(), _mm_xor_si128(plain, pad));
+	std::memcpy(dst, last.data(), left);
+
+	const auto written = in.size();
+
+	if (tag.empty()) {
+		return written;
+	}
+
+	__m128i block = _mm_xor_si128(swap(_mm_xor_si128(delta, times2(delta))), checksum);
+	encryptBlocks< 1 >(keys, &block);
+	store(tag.data(), block);
+
+	return written;
+}
+
+// The packets are processed in lockstep, one block of each per step. Packets with fewer blocks simply sit out
+// the remaining steps. When forwarding, all packets have the same size and no lane is wasted.
+
+TARGET_AESNI void P::nativeDecryptLanes(const gsl::span< DecryptJob *const > jobs) {
+	const auto count = static_cast< uint8_t >(jobs.size());
+
+	Keys encKeys[maxLanes] = {}, decKeys[maxLanes] = {};
+	__m128i delta[maxLanes], checksum[maxLanes], deltas[maxLanes], tmp[maxLanes];
+	size_t blocks[maxLanes];
+	size_t steps = 0;
+
+	for (uint8_t i = 0; i < count; ++i) {
+		const auto &job = *jobs[i];
+		const auto &p   = *job.crypt->m_p;
+
+		encKeys[i]  = reinterpret_cast< Keys >(p.m_encKeys.data());
+		decKeys[i]  = reinterpret_cast< Keys >(p.m_decKeys.data());
+		tmp[i]      = load(job.nonce.empty() ? p.m_nonce.data() : job.nonce.data());
+		checksum[i] = _mm_setzero_si128();
+		blocks[i]   = fullBlocks(job.in.size());
+		steps       = std::max(steps, blocks[i]);
+	}
+
+	cryptLanes< true >(encKeys, tmp, count);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		delta[i] = swap(tmp[i]);
+	}
+
+	for (size_t step = 0; step < steps; ++step) {
+		const auto offset = step * blockSize;
+
+		for (uint8_t i = 0; i < count; ++i) {
+			if (step < blocks[i]) {
+				delta[i]  = times2(delta[i]);
+				deltas[i] = swap(delta[i]);
+				tmp[i]    = _mm_xor_si128(load(jobs[i]->in.data() + offset), deltas[i]);
+			}
+		}
+
+		cryptLanes< false >(decKeys, tmp, count);
+
+		for (uint8_t i = 0; i < count; ++i) {
+			if (step < blocks[i]) {
+				const __m128i plain = _mm_xor_si128(tmp[i], deltas[i]);
+				checksum[i]         = _mm_xor_si128(checksum[i], plain);
+				store(jobs[i]->out.data() + offset, plain);
+			}
+		}
+	}
+
+	for (uint8_t i = 0; i < count; ++i) {
+		delta[i]  = times2(delta[i]);
+		deltas[i] = swap(delta[i]);
+		tmp[i]    = _mm_xor_si128(lengthBlock(jobs[i]->in.size() - blocks[i] * blockSize), deltas[i]);
+	}
+
+	cryptLanes< true >(encKeys, tmp, count);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		auto &job         = *jobs[i];
+		const auto offset = blocks[i] * blockSize;
+		const auto left   = job.in.size() - offset;
+
+		alignas(16) FixedBuf< blockSize > last{};
+		std::memcpy(last.data(), job.in.data() + offset, left);
+
+		const __m128i plain = _mm_xor_si128(load(last.data()), tmp[i]);
+		checksum[i]         = _mm_xor_si128(checksum[i], plain);
+
+		// Counter-cryptanalysis described in section 9 of https://eprint.iacr.org/2019/311
+		// See CryptOCB2::decrypt() for details.
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(plain, deltas[i])) == 0xFFFF) {
+			// Marks the job as failed, the tag is not checked.
+			blocks[i] = SIZE_MAX;
+			continue;
+		}
+
+		store(last.data(), plain);
+		std::memcpy(job.out.data() + offset, last.data(), left);
+
+		tmp[i] = _mm_xor_si128(swap(_mm_xor_si128(delta[i], times2(delta[i]))), checksum[i]);
+	}
+
+	cryptLanes< true >(encKeys, tmp, count);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		auto &job = *jobs[i];
+
+		if (blocks[i] == SIZE_MAX) {
+			continue;
+		}
+
+		if (!job.tag.empty()) {
+			alignas(16) FixedBuf< blockSize > tag;
+			store(tag.data(), tmp[i]);
+
+			if (!std::equal(job.tag.begin(), job.tag.end(), tag.cbegin())) {
+				continue;
+			}
+		}
+
+		job.written = job.in.size();
+	}
+}
+
+TARGET_AESNI void P::nativeEncryptLanes(const gsl::span< EncryptJob *const > jobs) {
+	const auto count = static_cast< uint8_t >(jobs.size());
+
+	Keys keys[maxLanes] = {};
+	__m128i delta[maxLanes], checksum[maxLanes], deltas[maxLanes], tmp[maxLanes];
+	size_t blocks[maxLanes];
+	size_t steps = 0;
+
+	for (uint8_t i = 0; i < count; ++i) {
+		const auto &job = *jobs[i];
+		const auto &p   = *job.crypt->m_p;
+
+		keys[i]     = reinterpret_cast< Keys >(p.m_encKeys.data());
+		tmp[i]      = load(job.nonce.empty() ? p.m_nonce.data() : job.nonce.data());
+		checksum[i] = _mm_setzero_si128();
+		blocks[i]   = fullBlocks(job.in.size());
+		steps       = std::max(steps, blocks[i]);
+	}
+
+	cryptLanes< true >(keys, tmp, count);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		delta[i] = swap(tmp[i]);
+	}
+
+	for (size_t step = 0; step < steps; ++step) {
+		const auto offset = step * blockSize;
+
+		for (uint8_t i = 0; i < count; ++i) {
+			if (step >= blocks[i]) {
+				continue;
+			}
+
+			__m128i plain = load(jobs[i]->in.data() + offset);
+
+			if (step == blocks[i] - 1) {
+				// Counter-cryptanalysis described in section 9 of https://eprint.iacr.org/2019/311
+				// See CryptOCB2::encrypt() for details.
+				if ((_mm_movemask_epi8(_mm_cmpeq_epi8(plain, _mm_setzero_si128())) & 0x7FFF) == 0x7FFF) {
+					plain = _mm_xor_si128(plain, _mm_cvtsi32_si128(1));
+				}
+			}
+
+			delta[i]    = times2(delta[i]);
+			deltas[i]   = swap(delta[i]);
+			checksum[i] = _mm_xor_si128(checksum[i], plain);
+			tmp[i]      = _mm_xor_si128(plain, deltas[i]);
+		}
+
+		cryptLanes< true >(keys, tmp, count);
+
+		for (uint8_t i = 0; i < count; ++i) {
+			if (step < blocks[i]) {
+				store(jobs[i]->out.data() + offset, _mm_xor_si128(tmp[i], deltas[i]));
+			}
+		}
+	}
+
+	for (uint8_t i = 0; i < count; ++i) {
+		delta[i] = times2(delta[i]);
+		tmp[i]   = _mm_xor_si128(lengthBlock(jobs[i]->in.size() - blocks[i] * blockSize), swap(delta[i]));
+	}
+
+	cryptLanes< true >(keys, tmp, count);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		auto &job         = *jobs[i];
+		const auto offset = blocks[i] * blockSize;
+		const auto left   = job.in.size() - offset;
+
+		// The plaintext, padded with the pad itself.
+		alignas(16) FixedBuf< blockSize > last;
+		store(last.data(), tmp[i]);
+		std::memcpy(last.data(), job.in.data() + offset, left);
+
+		const __m128i plain = load(last.data());
+		checksum[i]         = _mm_xor_si128(checksum[i], plain);
+
+		store(last.data(), _mm_xor_si128(plain, tmp[i]));
+		std::memcpy(job.out.data() + offset, last.data(), left);
+
+		tmp[i] = _mm_xor_si128(swap(_mm_xor_si128(delta[i], times2(delta[i]))), checksum[i]);
+	}
+
+	cryptLanes< true >(keys, tmp, count);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		auto &job = *jobs[i];
+
+		if (!job.tag.empty()) {
+			store(job.tag.data(), tmp[i]);
+		}
+
+		job.written = job.in.size();
+	}
+}
+
+#else
+
+P::Kernel P::detectKernel() {
+	return Kernel::EVP;
+}
+
+void P::expandKey() {
+}
+
+size_t P::nativeDecrypt(const BufView, const BufViewConst, const BufViewConst) const {
+	return {};
+}
+
+size_t P::nativeEncrypt(const BufView, const BufViewConst, const BufView) const {
+	return {};
+}
+
+void P::nativeDecryptLanes(const gsl::span< DecryptJob *const >) {
+}
+
+void P::nativeEncryptLanes(const gsl::span< EncryptJob *const >) {
+}
+
+#endif
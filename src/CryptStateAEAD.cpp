@@ -0,0 +1,358 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "CryptStateAEAD.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+#define CAST_BUF(var) (reinterpret_cast< unsigned char * >(var))
+#define CAST_BUF_CONST(var) (reinterpret_cast< const unsigned char * >(var))
+#define CAST_SIZE(var) (static_cast< int >(var))
+
+using namespace mumble;
+
+using P = CryptStateAEAD::P;
+
+static constexpr std::string_view clientLabel = "mumble udp client to server";
+static constexpr std::string_view serverLabel = "mumble udp server to client";
+
+CryptStateAEAD::CryptStateAEAD(const Mode mode, const bool server) : m_p(new P(mode, server)) {
+}
+
+CryptStateAEAD::~CryptStateAEAD() = default;
+
+CryptStateAEAD::operator bool() const {
+	// Without a cipher name the contexts are left with the null cipher, which is valid for Crypt.
+	return m_p && !P::cipher(m_p->m_mode).empty() && m_p->m_decrypt && m_p->m_encrypt;
+}
+
+CryptStateAEAD::Mode CryptStateAEAD::mode() const {
+	return m_p->m_mode;
+}
+
+BufViewConst CryptStateAEAD::key() const {
+	CHECK
+
+	return m_p->m_key;
+}
+
+BufViewConst CryptStateAEAD::decryptNonce() const {
+	CHECK
+
+	return m_p->m_decryptNonce;
+}
+
+BufViewConst CryptStateAEAD::encryptNonce() const {
+	CHECK
+
+	return m_p->m_encryptNonce;
+}
+
+bool CryptStateAEAD::gen() {
+	CHECK
+
+	const auto key = m_p->m_decrypt.genKey();
+
+	P::Nonce decryptNonce, encryptNonce;
+
+	if (key.empty() || !m_p->m_decrypt.genNonce(decryptNonce) || !m_p->m_encrypt.genNonce(encryptNonce)) {
+		return false;
+	}
+
+	return setKey(key, decryptNonce, encryptNonce);
+}
+
+bool CryptStateAEAD::setKey(const BufViewConst key, const BufViewConst decryptNonce, const BufViewConst encryptNonce) {
+	CHECK
+
+	if (decryptNonce.size() != m_p->m_decryptNonce.size() || encryptNonce.size() != m_p->m_encryptNonce.size()) {
+		return false;
+	}
+
+	if (key.size() != m_p->m_decrypt.keySize()) {
+		return false;
+	}
+
+	const auto &decryptLabel = m_p->m_server ? clientLabel : serverLabel;
+	const auto &encryptLabel = m_p->m_server ? serverLabel : clientLabel;
+
+	Buf decryptKey(key.size()), encryptKey(key.size());
+
+	if (!P::deriveKey(decryptKey, key, decryptLabel) || !P::deriveKey(encryptKey, key, encryptLabel)) {
+		return false;
+	}
+
+	if (!m_p->m_decrypt.setKey(decryptKey) || !m_p->m_encrypt.setKey(encryptKey)) {
+		return false;
+	}
+
+	m_p->m_key.assign(key.begin(), key.end());
+
+	std::copy(decryptNonce.begin(), decryptNonce.end(), m_p->m_decryptNonce.begin());
+	std::copy(encryptNonce.begin(), encryptNonce.end(), m_p->m_encryptNonce.begin());
+
+	m_p->m_decryptCounter = P::counter(m_p->m_decryptNonce);
+	m_p->m_encryptCounter = P::counter(m_p->m_encryptNonce);
+
+	m_p->reset();
+
+	return true;
+}
+
+bool CryptStateAEAD::setDecryptNonce(const BufViewConst nonce) {
+	CHECK
+
+	if (nonce.size() != m_p->m_decryptNonce.size()) {
+		return false;
+	}
+
+	std::copy(nonce.begin(), nonce.end(), m_p->m_decryptNonce.begin());
+	m_p->m_decryptCounter = P::counter(m_p->m_decryptNonce);
+
+	m_p->reset();
+	++m_p->m_resync;
+
+	return true;
+}
+
+size_t CryptStateAEAD::decrypt(const BufView out, const BufViewConst in) {
+	CHECK
+
+	return m_p->decrypt(out, in);
+}
+
+size_t CryptStateAEAD::encrypt(const BufView out, const BufViewConst in) {
+	CHECK
+
+	return m_p->encrypt(out, { &in, 1 }, ++m_p->m_encryptCounter);
+}
+
+size_t CryptStateAEAD::encrypt(const BufView out, const BufViewsConst in) {
+	CHECK
+
+	return m_p->encrypt(out, in, ++m_p->m_encryptCounter);
+}
+
+size_t CryptStateAEAD::decryptBatch(const gsl::span< Job > jobs) {
+	CHECK
+
+	size_t done = 0;
+
+	for (auto &job : jobs) {
+		job.written = m_p->decrypt(job.out, job.in);
+		if (job.written) {
+			++done;
+		}
+	}
+
+	return done;
+}
+
+size_t CryptStateAEAD::encryptBatch(const gsl::span< Job > jobs) {
+	CHECK
+
+	const auto first = m_p->m_encryptCounter + 1;
+	m_p->m_encryptCounter += jobs.size();
+
+	size_t done = 0;
+
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		auto &job   = jobs[i];
+		job.written = m_p->encrypt(job.out, { &job.in, 1 }, first + i);
+		if (job.written) {
+			++done;
+		}
+	}
+
+	return done;
+}
+
+uint32_t CryptStateAEAD::good() const {
+	return m_p->m_good;
+}
+
+uint32_t CryptStateAEAD::late() const {
+	return m_p->m_late;
+}
+
+uint32_t CryptStateAEAD::lost() const {
+	return m_p->m_lost;
+}
+
+uint32_t CryptStateAEAD::resync() const {
+	return m_p->m_resync;
+}
+
+CryptStateAEAD::Stats CryptStateAEAD::stats() const {
+	Stats stats;
+	stats.good   = good();
+	stats.late   = late();
+	stats.lost   = lost();
+	stats.resync = resync();
+
+	return stats;
+}
+
+P::P(const Mode mode, const bool server)
+	: m_mode(mode), m_server(server), m_decryptNonce(), m_encryptNonce(), m_decryptCounter(0), m_encryptCounter(0),
+	  m_window(1), m_good(0), m_late(0), m_lost(0), m_resync(0) {
+	const auto name = cipher(mode);
+	if (!name.empty()) {
+		m_decrypt.setCipher(name);
+		m_encrypt.setCipher(name);
+	}
+}
+
+P::~P() = default;
+
+std::string_view P::cipher(const Mode mode) {
+	switch (mode) {
+		case Mode::AES256GCM:
+			return "AES-256-GCM";
+		case Mode::ChaCha20Poly1305:
+			return "ChaCha20-Poly1305";
+		default:
+			return {};
+	}
+}
+
+bool P::deriveKey(const BufView out, const BufViewConst key, const std::string_view label) {
+	auto ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr);
+	if (!ctx) {
+		return false;
+	}
+
+	size_t size = out.size();
+
+	// No salt: the key is already uniformly random.
+	const bool ok = EVP_PKEY_derive_init(ctx) > 0 && EVP_PKEY_CTX_set_hkdf_md(ctx, EVP_sha256()) > 0
+					&& EVP_PKEY_CTX_set1_hkdf_key(ctx, CAST_BUF_CONST(key.data()), CAST_SIZE(key.size())) > 0
+					&& EVP_PKEY_CTX_add1_hkdf_info(ctx, CAST_BUF_CONST(label.data()), CAST_SIZE(label.size())) > 0
+					&& EVP_PKEY_derive(ctx, CAST_BUF(out.data()), &size) > 0
+					&& size == out.size();
+
+	EVP_PKEY_CTX_free(ctx);
+
+	return ok;
+}
+
+uint64_t P::counter(const Nonce &nonce) {
+	uint64_t counter = 0;
+
+	for (uint8_t i = 0; i < sizeof(counter); ++i) {
+		counter |= uint64_t(std::to_integer< uint8_t >(nonce[i])) << (i * 8);
+	}
+
+	return counter;
+}
+
+void P::setCounter(Nonce &nonce, const uint64_t counter) {
+	for (uint8_t i = 0; i < sizeof(counter); ++i) {
+		nonce[i] = static_cast< std::byte >(counter >> (i * 8));
+	}
+}
+
+void P::reset() {
+	// The nonce we start from is never used for a packet, the peer increments it first.
+	m_window = 1;
+}
+
+size_t P::decrypt(const BufView out, const BufViewConst in) {
+	if (in.size() <= headerSize || out.size() < in.size() - headerSize) {
+		return {};
+	}
+
+	// Only the lowest byte of the counter is transmitted. Up to 128 packets ahead of the newest one
+	// means that the ones in between got lost (or are late), anything else is a late packet.
+	const auto ahead =
+		static_cast< uint8_t >(std::to_integer< uint8_t >(in[0]) - static_cast< uint8_t >(m_decryptCounter));
+	if (!ahead) {
+		return {};
+	}
+
+	uint64_t counter = m_decryptCounter;
+
+	uint8_t behind = 0;
+
+	if (ahead <= 128) {
+		counter += ahead;
+	} else {
+		behind = static_cast< uint8_t >(-ahead);
+		if (behind >= maxLate || m_window & (uint64_t(1) << behind)) {
+			return {};
+		}
+
+		counter -= behind;
+	}
+
+	auto nonce = m_decryptNonce;
+	setCounter(nonce, counter);
+
+	if (!m_decrypt.setNonce(nonce)) {
+		return {};
+	}
+
+	const auto written = m_decrypt.decrypt(out, in.subspan(headerSize), in.subspan(1, tagSize));
+	if (!written) {
+		return {};
+	}
+
+	if (behind) {
+		m_window |= uint64_t(1) << behind;
+
+		++m_late;
+		// The packet was counted as lost when the ones after it arrived.
+		if (m_lost) {
+			--m_lost;
+		}
+	} else {
+		m_window         = ahead < 64 ? m_window << ahead | 1 : 1;
+		m_decryptNonce   = nonce;
+		m_decryptCounter = counter;
+
+		m_lost += ahead - 1u;
+	}
+
+	++m_good;
+
+	return written;
+}
+
+size_t P::encrypt(const BufView out, const BufViewsConst in, const uint64_t counter) {
+	// Even if the packet is not sent, so that the nonce always matches the counter.
+	setCounter(m_encryptNonce, counter);
+
+	size_t size = 0;
+	for (const auto part : in) {
+		size += part.size();
+	}
+
+	if (!size || out.size() < size + headerSize) {
+		return {};
+	}
+
+	if (!m_encrypt.setNonce(m_encryptNonce)) {
+		return {};
+	}
+
+	const auto written = m_encrypt.encrypt(out.subspan(headerSize), in, out.subspan(1, tagSize));
+	if (!written) {
+		return {};
+	}
+
+	out[0] = static_cast< std::byte >(counter);
+
+	return written + headerSize;
+}
@@ -0,0 +1,64 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_CRYPTSTATEAEAD_HPP
+#define MUMBLE_SRC_CRYPTSTATEAEAD_HPP
+
+#include "mumble/CryptStateAEAD.hpp"
+
+#include "mumble/Crypt.hpp"
+#include "mumble/Types.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+namespace mumble {
+class CryptStateAEAD::P {
+	friend CryptStateAEAD;
+
+public:
+	using Nonce = FixedBuf< nonceSize >;
+
+	P(const Mode mode, const bool server);
+	~P();
+
+private:
+	static std::string_view cipher(const Mode mode);
+
+	// Derives the key used in the direction "label" from the exchanged one, the output is as big as the input.
+	static bool deriveKey(const BufView out, const BufViewConst key, const std::string_view label);
+
+	static uint64_t counter(const Nonce &nonce);
+	static void setCounter(Nonce &nonce, const uint64_t counter);
+
+	void reset();
+
+	size_t decrypt(const BufView out, const BufViewConst in);
+	size_t encrypt(const BufView out, const BufViewsConst in, const uint64_t counter);
+
+	Mode m_mode;
+	bool m_server;
+	// The exchanged key, "m_decrypt" and "m_encrypt" use the ones derived from it.
+	Buf m_key;
+	Crypt m_decrypt;
+	Crypt m_encrypt;
+	// The nonce of the newest packet received.
+	Nonce m_decryptNonce;
+	// The nonce of the last packet sent.
+	Nonce m_encryptNonce;
+	// The counters contained in the nonces above.
+	uint64_t m_decryptCounter;
+	uint64_t m_encryptCounter;
+	// Bit N is set when the packet N packets older than the newest one was received.
+	uint64_t m_window;
+	std::atomic< uint32_t > m_good;
+	std::atomic< uint32_t > m_late;
+	std::atomic< uint32_t > m_lost;
+	std::atomic< uint32_t > m_resync;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,244 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "CryptStateOCB2.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using P = CryptStateOCB2::P;
+
+CryptStateOCB2::CryptStateOCB2() : m_p(new P) {
+}
+
+CryptStateOCB2::~CryptStateOCB2() = default;
+
+CryptStateOCB2::operator bool() const {
+	return m_p && m_p->m_decrypt && m_p->m_encrypt;
+}
+
+BufViewConst CryptStateOCB2::key() const {
+	CHECK
+
+	return m_p->m_decrypt.key();
+}
+
+BufViewConst CryptStateOCB2::decryptNonce() const {
+	CHECK
+
+	return m_p->m_decryptNonce;
+}
+
+BufViewConst CryptStateOCB2::encryptNonce() const {
+	CHECK
+
+	return m_p->m_encryptNonce;
+}
+
+bool CryptStateOCB2::gen() {
+	CHECK
+
+	FixedBuf< 16 > key;
+	P::Nonce decryptNonce, encryptNonce;
+
+	if (!m_p->m_decrypt.genKey(key) || !m_p->m_decrypt.genNonce(decryptNonce)
+		|| !m_p->m_encrypt.genNonce(encryptNonce)) {
+		return false;
+	}
+
+	return setKey(key, decryptNonce, encryptNonce);
+}
+
+bool CryptStateOCB2::setKey(const BufViewConst key, const BufViewConst decryptNonce, const BufViewConst encryptNonce) {
+	CHECK
+
+	if (decryptNonce.size() != m_p->m_decryptNonce.size() || encryptNonce.size() != m_p->m_encryptNonce.size()) {
+		return false;
+	}
+
+	if (!m_p->m_decrypt.setKey(key) || !m_p->m_encrypt.setKey(key)) {
+		return false;
+	}
+
+	std::copy(decryptNonce.begin(), decryptNonce.end(), m_p->m_decryptNonce.begin());
+	std::copy(encryptNonce.begin(), encryptNonce.end(), m_p->m_encryptNonce.begin());
+
+	m_p->reset();
+
+	return true;
+}
+
+bool CryptStateOCB2::setDecryptNonce(const BufViewConst nonce) {
+	CHECK
+
+	if (nonce.size() != m_p->m_decryptNonce.size()) {
+		return false;
+	}
+
+	std::copy(nonce.begin(), nonce.end(), m_p->m_decryptNonce.begin());
+
+	m_p->reset();
+	++m_p->m_resync;
+
+	return true;
+}
+
+size_t CryptStateOCB2::decrypt(const BufView out, const BufViewConst in) {
+	CHECK
+
+	// An empty "out" would make the cipher return the size without checking the tag.
+	if (in.size() <= headerSize || out.size() < in.size() - headerSize) {
+		return {};
+	}
+
+	// Only the lowest byte of the nonce is transmitted. Up to 128 packets ahead of the newest one
+	// means that the ones in between got lost (or are late), anything else is a late packet.
+	const auto ahead =
+		static_cast< uint8_t >(std::to_integer< uint8_t >(in[0]) - std::to_integer< uint8_t >(m_p->m_decryptNonce[0]));
+	if (!ahead) {
+		return {};
+	}
+
+	auto nonce = m_p->m_decryptNonce;
+
+	uint8_t behind = 0;
+
+	if (ahead <= 128) {
+		P::add(nonce, ahead);
+	} else {
+		behind = static_cast< uint8_t >(-ahead);
+		if (behind >= maxLate || m_p->m_window & (uint64_t(1) << behind)) {
+			return {};
+		}
+
+		P::sub(nonce, behind);
+	}
+
+	if (!m_p->m_decrypt.setNonce(nonce)) {
+		return {};
+	}
+
+	const auto written = m_p->m_decrypt.decrypt(out, in.subspan(headerSize), in.subspan(1, 3));
+	if (!written) {
+		return {};
+	}
+
+	if (behind) {
+		m_p->m_window |= uint64_t(1) << behind;
+
+		++m_p->m_late;
+		// The packet was counted as lost when the ones after it arrived.
+		if (m_p->m_lost) {
+			--m_p->m_lost;
+		}
+	} else {
+		m_p->m_window       = ahead < 64 ? m_p->m_window << ahead | 1 : 1;
+		m_p->m_decryptNonce = nonce;
+
+		m_p->m_lost += ahead - 1u;
+	}
+
+	++m_p->m_good;
+
+	return written;
+}
+
+size_t CryptStateOCB2::encrypt(const BufView out, const BufViewConst in) {
+	CHECK
+
+	if (in.empty() || out.size() < in.size() + headerSize) {
+		return {};
+	}
+
+	P::add(m_p->m_encryptNonce, 1);
+
+	if (!m_p->m_encrypt.setNonce(m_p->m_encryptNonce)) {
+		return {};
+	}
+
+	FixedBuf< 16 > tag;
+
+	const auto written = m_p->m_encrypt.encrypt(out.subspan(headerSize), in, tag);
+	if (!written) {
+		return {};
+	}
+
+	out[0] = m_p->m_encryptNonce[0];
+	std::copy_n(tag.cbegin(), headerSize - 1, out.begin() + 1);
+
+	return written + headerSize;
+}
+
+uint32_t CryptStateOCB2::good() const {
+	return m_p->m_good;
+}
+
+uint32_t CryptStateOCB2::late() const {
+	return m_p->m_late;
+}
+
+uint32_t CryptStateOCB2::lost() const {
+	return m_p->m_lost;
+}
+
+uint32_t CryptStateOCB2::resync() const {
+	return m_p->m_resync;
+}
+
+CryptStateOCB2::Stats CryptStateOCB2::stats() const {
+	Stats stats;
+	stats.good   = good();
+	stats.late   = late();
+	stats.lost   = lost();
+	stats.resync = resync();
+
+	return stats;
+}
+
+P::P() : m_decryptNonce(), m_encryptNonce(), m_window(1), m_good(0), m_late(0), m_lost(0), m_resync(0) {
+}
+
+P::~P() = default;
+
+void P::add(Nonce &nonce, const uint8_t value) {
+	// The nonce is a little-endian 128-bit integer.
+	uint16_t carry = value;
+
+	for (auto &byte : nonce) {
+		if (!carry) {
+			break;
+		}
+
+		carry += std::to_integer< uint8_t >(byte);
+		byte = static_cast< std::byte >(carry);
+		carry >>= 8;
+	}
+}
+
+void P::sub(Nonce &nonce, const uint8_t value) {
+	uint8_t borrow = value;
+
+	for (auto &byte : nonce) {
+		if (!borrow) {
+			break;
+		}
+
+		const auto current = std::to_integer< uint8_t >(byte);
+		byte               = static_cast< std::byte >(current - borrow);
+		borrow             = current < borrow;
+	}
+}
+
+void P::reset() {
+	// The nonce we start from is never used for a packet, the peer increments it first.
+	m_window = 1;
+}
@@ -0,0 +1,48 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_CRYPTSTATEOCB2_HPP
+#define MUMBLE_SRC_CRYPTSTATEOCB2_HPP
+
+#include "mumble/CryptStateOCB2.hpp"
+
+#include "mumble/CryptOCB2.hpp"
+#include "mumble/Types.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace mumble {
+class CryptStateOCB2::P {
+	friend CryptStateOCB2;
+
+public:
+	using Nonce = FixedBuf< 16 >;
+
+	P();
+	~P();
+
+private:
+	static void add(Nonce &nonce, uint8_t value);
+	static void sub(Nonce &nonce, uint8_t value);
+
+	void reset();
+
+	CryptOCB2 m_decrypt;
+	CryptOCB2 m_encrypt;
+	// The nonce of the newest packet received.
+	Nonce m_decryptNonce;
+	// The nonce of the last packet sent.
+	Nonce m_encryptNonce;
+	// Bit N is set when the packet N packets older than the newest one was received.
+	uint64_t m_window;
+	std::atomic< uint32_t > m_good;
+	std::atomic< uint32_t > m_late;
+	std::atomic< uint32_t > m_lost;
+	std::atomic< uint32_t > m_resync;
+};
+} // namespace mumble
+
+#endif
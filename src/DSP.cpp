@@ -0,0 +1,165 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "DSP.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+using namespace mumble;
+
+using FloatView        = DSP::FloatView;
+using FloatViewConst   = DSP::FloatViewConst;
+using IntegerView      = DSP::IntegerView;
+using IntegerViewConst = DSP::IntegerViewConst;
+
+// Same rounding (to nearest, ties to even) and saturation as the native implementations.
+static int16_t toSample(const float value) {
+	return static_cast< int16_t >(std::lrint(std::clamp(value, -32768.f, 32767.f)));
+}
+
+DSP::Kernel DSP::kernel() {
+	static const auto kernel = detectKernel();
+	return kernel;
+}
+
+void DSP::add(FloatView out, FloatViewConst in) {
+	const auto size = std::min(out.size(), in.size());
+
+	out = out.first(size);
+	in  = in.first(size);
+
+	nativeAdd(kernel(), out, in);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] += in[i];
+	}
+}
+
+void DSP::subtract(FloatView out, FloatViewConst a, FloatViewConst b) {
+	const auto size = std::min({ out.size(), a.size(), b.size() });
+
+	out = out.first(size);
+	a   = a.first(size);
+	b   = b.first(size);
+
+	nativeSubtract(kernel(), out, a, b);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = a[i] - b[i];
+	}
+}
+
+float DSP::peak(FloatViewConst in) {
+	auto peak = nativePeak(kernel(), in);
+
+	for (const auto sample : in) {
+		peak = std::max(peak, std::abs(sample));
+	}
+
+	return peak;
+}
+
+void DSP::ramp(FloatView out, FloatViewConst in, const float from, const float to) {
+	const auto size = std::min(out.size(), in.size());
+	if (!size) {
+		return;
+	}
+
+	out = out.first(size);
+	in  = in.first(size);
+
+	float gain       = from;
+	const float step = (to - from) / static_cast< float >(size);
+
+	nativeRamp(kernel(), out, in, gain, step);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = std::clamp(in[i] * gain, -1.f, 1.f);
+		gain += step;
+	}
+}
+
+float DSP::dot(FloatViewConst a, FloatViewConst b) {
+	const auto size = std::min(a.size(), b.size());
+
+	a = a.first(size);
+	b = b.first(size);
+
+	auto sum = nativeDot(kernel(), a, b);
+
+	for (size_t i = 0; i < a.size(); ++i) {
+		sum += a[i] * b[i];
+	}
+
+	return sum;
+}
+
+void DSP::toFloat(FloatView out, IntegerViewConst in) {
+	const auto size = std::min(out.size(), in.size());
+
+	out = out.first(size);
+	in  = in.first(size);
+
+	nativeToFloat(kernel(), out, in);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = static_cast< float >(in[i]) * (1.f / 32768.f);
+	}
+}
+
+void DSP::toInteger(IntegerView out, FloatViewConst in) {
+	const auto size = std::min(out.size(), in.size());
+
+	out = out.first(size);
+	in  = in.first(size);
+
+	nativeToInteger(kernel(), out, in);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = toSample(in[i] * 32768.f);
+	}
+}
+
+void DSP::scale(IntegerView out, IntegerViewConst in, const float gain) {
+	const auto size = std::min(out.size(), in.size());
+
+	out = out.first(size);
+	in  = in.first(size);
+
+	nativeScale(kernel(), out, in, gain);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = toSample(static_cast< float >(in[i]) * gain);
+	}
+}
+
+void DSP::downmix(FloatView out, FloatViewConst in) {
+	const auto frames = std::min(out.size(), in.size() / 2);
+
+	out = out.first(frames);
+	in  = in.first(frames * 2);
+
+	nativeDownmix(kernel(), out, in);
+
+	for (size_t i = 0; i < out.size(); ++i) {
+		out[i] = (in[i * 2] + in[i * 2 + 1]) * 0.5f;
+	}
+}
+
+void DSP::upmix(FloatView out, FloatViewConst in) {
+	const auto frames = std::min(out.size() / 2, in.size());
+
+	out = out.first(frames * 2);
+	in  = in.first(frames);
+
+	nativeUpmix(kernel(), out, in);
+
+	for (size_t i = 0; i < in.size(); ++i) {
+		out[i * 2] = out[i * 2 + 1] = in[i];
+	}
+}
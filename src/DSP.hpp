@@ -0,0 +1,72 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_DSP_HPP
+#define MUMBLE_SRC_DSP_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gsl/span>
+
+namespace mumble {
+// Kernels for processing PCM, the native implementations are picked at runtime (see DSPNative.cpp).
+// Float samples are expected to be in the [-1, 1] range, all functions process min(out.size(), in.size()) samples.
+// Conversions to 16 bit round to the nearest integer and saturate.
+class DSP {
+public:
+	// AVX2 is only used by the kernels that work on integers, the others use AVX.
+	enum class Kernel : uint8_t { Scalar, SSE2, AVX, AVX2 };
+
+	using FloatView        = gsl::span< float >;
+	using FloatViewConst   = gsl::span< const float >;
+	using IntegerView      = gsl::span< int16_t >;
+	using IntegerViewConst = gsl::span< const int16_t >;
+
+	// Detected once, on first use.
+	static Kernel kernel();
+
+	// out += in
+	static void add(FloatView out, FloatViewConst in);
+	// out = a - b
+	static void subtract(FloatView out, FloatViewConst a, FloatViewConst b);
+	// Highest absolute value.
+	static float peak(FloatViewConst in);
+	// out = in * gain, clamped to [-1, 1]. The gain goes linearly from "from" to "to" over the whole view.
+	static void ramp(FloatView out, FloatViewConst in, const float from, const float to);
+	// Sum of the products.
+	static float dot(FloatViewConst a, FloatViewConst b);
+
+	// out = in / 32768
+	static void toFloat(FloatView out, IntegerViewConst in);
+	// out = in * 32768
+	static void toInteger(IntegerView out, FloatViewConst in);
+	// out = in * gain
+	static void scale(IntegerView out, IntegerViewConst in, const float gain);
+
+	// Average of the two channels, "out" holds the frames. min(out.size(), in.size() / 2) frames are processed.
+	static void downmix(FloatView out, FloatViewConst in);
+	// The channel is copied to both sides. min(out.size() / 2, in.size()) frames are processed.
+	static void upmix(FloatView out, FloatViewConst in);
+
+private:
+	// Process full blocks, advancing the views.
+	static Kernel detectKernel();
+
+	static void nativeAdd(const Kernel kernel, FloatView &out, FloatViewConst &in);
+	static void nativeSubtract(const Kernel kernel, FloatView &out, FloatViewConst &a, FloatViewConst &b);
+	static float nativePeak(const Kernel kernel, FloatViewConst &in);
+	// "gain" is updated to the value for the first sample that is left.
+	static void nativeRamp(const Kernel kernel, FloatView &out, FloatViewConst &in, float &gain, const float step);
+	static float nativeDot(const Kernel kernel, FloatViewConst &a, FloatViewConst &b);
+	static void nativeToFloat(const Kernel kernel, FloatView &out, IntegerViewConst &in);
+	static void nativeToInteger(const Kernel kernel, IntegerView &out, FloatViewConst &in);
+	static void nativeScale(const Kernel kernel, IntegerView &out, IntegerViewConst &in, const float gain);
+	static void nativeDownmix(const Kernel kernel, FloatView &out, FloatViewConst &in);
+	static void nativeUpmix(const Kernel kernel, FloatView &out, FloatViewConst &in);
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,608 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "CPU.hpp"
+#include "DSP.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef MUMBLE_ARCH_X86
+#	include <immintrin.h>
+#endif
+
+// SSE2 and AVX implementations of the DSP kernels, 4 and 8 samples at a time respectively.
+// The kernels that work on 16 bit samples use SSE2 and AVX2 instead, 8 and 16 samples at a time respectively.
+// The samples that don't make a full block are left to the scalar implementation in DSP.cpp.
+
+using namespace mumble;
+
+using FloatView        = DSP::FloatView;
+using FloatViewConst   = DSP::FloatViewConst;
+using IntegerView      = DSP::IntegerView;
+using IntegerViewConst = DSP::IntegerViewConst;
+
+#ifdef MUMBLE_ARCH_X86
+
+#	define TARGET_SSE2 MUMBLE_TARGET("sse2")
+#	define TARGET_AVX MUMBLE_TARGET("sse2,avx")
+#	define TARGET_AVX2 MUMBLE_TARGET("sse2,avx,avx2")
+
+static constexpr size_t blockSSE2 = 4;
+static constexpr size_t blockAVX  = 8;
+
+static constexpr size_t blockIntegerSSE2 = 8;
+static constexpr size_t blockIntegerAVX2 = 16;
+
+// Clears the sign bit.
+TARGET_SSE2 static inline __m128 abs(const __m128 value) {
+	return _mm_andnot_ps(_mm_set1_ps(-0.f), value);
+}
+
+TARGET_AVX static inline __m256 abs(const __m256 value) {
+	return _mm256_andnot_ps(_mm256_set1_ps(-0.f), value);
+}
+
+TARGET_SSE2 static inline __m128 clamp(const __m128 value) {
+	return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+}
+
+TARGET_AVX static inline __m256 clamp(const __m256 value) {
+	return _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-1.f)), _mm256_set1_ps(1.f));
+}
+
+TARGET_SSE2 static inline float max(const __m128 value) {
+	__m128 ret = _mm_max_ps(value, _mm_movehl_ps(value, value));
+	ret        = _mm_max_ss(ret, _mm_shuffle_ps(ret, ret, 1));
+
+	return _mm_cvtss_f32(ret);
+}
+
+TARGET_SSE2 static inline float sum(const __m128 value) {
+	__m128 ret = _mm_add_ps(value, _mm_movehl_ps(value, value));
+	ret        = _mm_add_ss(ret, _mm_shuffle_ps(ret, ret, 1));
+
+	return _mm_cvtss_f32(ret);
+}
+
+// Same range as the scalar implementation, converting values outside of the int32 range would not saturate.
+TARGET_SSE2 static inline __m128 clampInteger(const __m128 value) {
+	return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-32768.f)), _mm_set1_ps(32767.f));
+}
+
+TARGET_AVX static inline __m256 clampInteger(const __m256 value) {
+	return _mm256_min_ps(_mm256_max_ps(value, _mm256_set1_ps(-32768.f)), _mm256_set1_ps(32767.f));
+}
+
+// Sign extends 8 samples, SSE2 has no instruction for it.
+TARGET_SSE2 static inline void widen(const int16_t *in, __m128 &lo, __m128 &hi) {
+	const __m128i value = _mm_loadu_si128(reinterpret_cast< const __m128i * >(in));
+
+	lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16));
+	hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16));
+}
+
+TARGET_AVX2 static inline void widen(const int16_t *in, __m256 &lo, __m256 &hi) {
+	const __m256i value = _mm256_loadu_si256(reinterpret_cast< const __m256i * >(in));
+
+	lo = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(value)));
+	hi = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(value, 1)));
+}
+
+TARGET_SSE2 static inline void narrow(int16_t *out, const __m128 lo, const __m128 hi) {
+	const __m128i value = _mm_packs_epi32(_mm_cvtps_epi32(clampInteger(lo)), _mm_cvtps_epi32(clampInteger(hi)));
+
+	_mm_storeu_si128(reinterpret_cast< __m128i * >(out), value);
+}
+
+// The pack instruction works within each 128 bit lane, the 64 bit blocks have to be put back in order.
+TARGET_AVX2 static inline void narrow(int16_t *out, const __m256 lo, const __m256 hi) {
+	const __m256i value =
+		_mm256_packs_epi32(_mm256_cvtps_epi32(clampInteger(lo)), _mm256_cvtps_epi32(clampInteger(hi)));
+
+	_mm256_storeu_si256(reinterpret_cast< __m256i * >(out), _mm256_permute4x64_epi64(value, 0xD8));
+}
+
+TARGET_SSE2 static void addSSE2(FloatView &out, FloatViewConst &in) {
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= out.size(); i += blockSSE2) {
+		_mm_storeu_ps(out.data() + i, _mm_add_ps(_mm_loadu_ps(out.data() + i), _mm_loadu_ps(in.data() + i)));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_AVX static void addAVX(FloatView &out, FloatViewConst &in) {
+	size_t i = 0;
+
+	for (; i + blockAVX <= out.size(); i += blockAVX) {
+		_mm256_storeu_ps(out.data() + i,
+						 _mm256_add_ps(_mm256_loadu_ps(out.data() + i), _mm256_loadu_ps(in.data() + i)));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_SSE2 static void subtractSSE2(FloatView &out, FloatViewConst &a, FloatViewConst &b) {
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= out.size(); i += blockSSE2) {
+		_mm_storeu_ps(out.data() + i, _mm_sub_ps(_mm_loadu_ps(a.data() + i), _mm_loadu_ps(b.data() + i)));
+	}
+
+	out = out.subspan(i);
+	a   = a.subspan(i);
+	b   = b.subspan(i);
+}
+
+TARGET_AVX static void subtractAVX(FloatView &out, FloatViewConst &a, FloatViewConst &b) {
+	size_t i = 0;
+
+	for (; i + blockAVX <= out.size(); i += blockAVX) {
+		_mm256_storeu_ps(out.data() + i,
+						 _mm256_sub_ps(_mm256_loadu_ps(a.data() + i), _mm256_loadu_ps(b.data() + i)));
+	}
+
+	out = out.subspan(i);
+	a   = a.subspan(i);
+	b   = b.subspan(i);
+}
+
+TARGET_SSE2 static float peakSSE2(FloatViewConst &in) {
+	__m128 peak = _mm_setzero_ps();
+
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= in.size(); i += blockSSE2) {
+		peak = _mm_max_ps(peak, abs(_mm_loadu_ps(in.data() + i)));
+	}
+
+	in = in.subspan(i);
+
+	return max(peak);
+}
+
+TARGET_AVX static float peakAVX(FloatViewConst &in) {
+	__m256 peak = _mm256_setzero_ps();
+
+	size_t i = 0;
+
+	for (; i + blockAVX <= in.size(); i += blockAVX) {
+		peak = _mm256_max_ps(peak, abs(_mm256_loadu_ps(in.data() + i)));
+	}
+
+	in = in.subspan(i);
+
+	return max(_mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1)));
+}
+
+TARGET_SSE2 static void rampSSE2(FloatView &out, FloatViewConst &in, float &gain, const float step) {
+	__m128 gains       = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0, 1, 2, 3)));
+	const __m128 steps = _mm_set1_ps(step * blockSSE2);
+
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= out.size(); i += blockSSE2) {
+		_mm_storeu_ps(out.data() + i, clamp(_mm_mul_ps(_mm_loadu_ps(in.data() + i), gains)));
+		gains = _mm_add_ps(gains, steps);
+	}
+
+	gain = _mm_cvtss_f32(gains);
+	out  = out.subspan(i);
+	in   = in.subspan(i);
+}
+
+TARGET_AVX static void rampAVX(FloatView &out, FloatViewConst &in, float &gain, const float step) {
+	__m256 gains = _mm256_add_ps(_mm256_set1_ps(gain),
+								 _mm256_mul_ps(_mm256_set1_ps(step), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)));
+	const __m256 steps = _mm256_set1_ps(step * blockAVX);
+
+	size_t i = 0;
+
+	for (; i + blockAVX <= out.size(); i += blockAVX) {
+		_mm256_storeu_ps(out.data() + i, clamp(_mm256_mul_ps(_mm256_loadu_ps(in.data() + i), gains)));
+		gains = _mm256_add_ps(gains, steps);
+	}
+
+	gain = _mm_cvtss_f32(_mm256_castps256_ps128(gains));
+	out  = out.subspan(i);
+	in   = in.subspan(i);
+}
+
+TARGET_SSE2 static float dotSSE2(FloatViewConst &a, FloatViewConst &b) {
+	__m128 ret = _mm_setzero_ps();
+
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= a.size(); i += blockSSE2) {
+		ret = _mm_add_ps(ret, _mm_mul_ps(_mm_loadu_ps(a.data() + i), _mm_loadu_ps(b.data() + i)));
+	}
+
+	a = a.subspan(i);
+	b = b.subspan(i);
+
+	return sum(ret);
+}
+
+TARGET_AVX static float dotAVX(FloatViewConst &a, FloatViewConst &b) {
+	__m256 ret = _mm256_setzero_ps();
+
+	size_t i = 0;
+
+	for (; i + blockAVX <= a.size(); i += blockAVX) {
+		ret = _mm256_add_ps(ret, _mm256_mul_ps(_mm256_loadu_ps(a.data() + i), _mm256_loadu_ps(b.data() + i)));
+	}
+
+	a = a.subspan(i);
+	b = b.subspan(i);
+
+	return sum(_mm_add_ps(_mm256_castps256_ps128(ret), _mm256_extractf128_ps(ret, 1)));
+}
+
+TARGET_SSE2 static void toFloatSSE2(FloatView &out, IntegerViewConst &in) {
+	const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+
+	size_t i = 0;
+
+	for (; i + blockIntegerSSE2 <= out.size(); i += blockIntegerSSE2) {
+		__m128 lo, hi;
+		widen(in.data() + i, lo, hi);
+
+		_mm_storeu_ps(out.data() + i, _mm_mul_ps(lo, scale));
+		_mm_storeu_ps(out.data() + i + blockSSE2, _mm_mul_ps(hi, scale));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_AVX2 static void toFloatAVX2(FloatView &out, IntegerViewConst &in) {
+	const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+
+	size_t i = 0;
+
+	for (; i + blockIntegerAVX2 <= out.size(); i += blockIntegerAVX2) {
+		__m256 lo, hi;
+		widen(in.data() + i, lo, hi);
+
+		_mm256_storeu_ps(out.data() + i, _mm256_mul_ps(lo, scale));
+		_mm256_storeu_ps(out.data() + i + blockAVX, _mm256_mul_ps(hi, scale));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_SSE2 static void toIntegerSSE2(IntegerView &out, FloatViewConst &in) {
+	const __m128 scale = _mm_set1_ps(32768.f);
+
+	size_t i = 0;
+
+	for (; i + blockIntegerSSE2 <= out.size(); i += blockIntegerSSE2) {
+		narrow(out.data() + i, _mm_mul_ps(_mm_loadu_ps(in.data() + i), scale),
+			   _mm_mul_ps(_mm_loadu_ps(in.data() + i + blockSSE2), scale));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_AVX2 static void toIntegerAVX2(IntegerView &out, FloatViewConst &in) {
+	const __m256 scale = _mm256_set1_ps(32768.f);
+
+	size_t i = 0;
+
+	for (; i + blockIntegerAVX2 <= out.size(); i += blockIntegerAVX2) {
+		narrow(out.data() + i, _mm256_mul_ps(_mm256_loadu_ps(in.data() + i), scale),
+			   _mm256_mul_ps(_mm256_loadu_ps(in.data() + i + blockAVX), scale));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_SSE2 static void scaleSSE2(IntegerView &out, IntegerViewConst &in, const float gain) {
+	const __m128 gains = _mm_set1_ps(gain);
+
+	size_t i = 0;
+
+	for (; i + blockIntegerSSE2 <= out.size(); i += blockIntegerSSE2) {
+		__m128 lo, hi;
+		widen(in.data() + i, lo, hi);
+
+		narrow(out.data() + i, _mm_mul_ps(lo, gains), _mm_mul_ps(hi, gains));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+TARGET_AVX2 static void scaleAVX2(IntegerView &out, IntegerViewConst &in, const float gain) {
+	const __m256 gains = _mm256_set1_ps(gain);
+
+	size_t i = 0;
+
+	for (; i + blockIntegerAVX2 <= out.size(); i += blockIntegerAVX2) {
+		__m256 lo, hi;
+		widen(in.data() + i, lo, hi);
+
+		narrow(out.data() + i, _mm256_mul_ps(lo, gains), _mm256_mul_ps(hi, gains));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i);
+}
+
+// The even (left) and odd (right) samples are gathered into separate registers.
+TARGET_SSE2 static void downmixSSE2(FloatView &out, FloatViewConst &in) {
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= out.size(); i += blockSSE2) {
+		const __m128 a = _mm_loadu_ps(in.data() + i * 2);
+		const __m128 b = _mm_loadu_ps(in.data() + i * 2 + blockSSE2);
+
+		const __m128 left  = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+		_mm_storeu_ps(out.data() + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i * 2);
+}
+
+// The shuffle instruction works within each 128 bit lane, the lanes are swapped first so that the frames come out in
+// order.
+TARGET_AVX static void downmixAVX(FloatView &out, FloatViewConst &in) {
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	size_t i = 0;
+
+	for (; i + blockAVX <= out.size(); i += blockAVX) {
+		const __m256 a = _mm256_loadu_ps(in.data() + i * 2);
+		const __m256 b = _mm256_loadu_ps(in.data() + i * 2 + blockAVX);
+
+		const __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+		const __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+
+		const __m256 left  = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m256 right = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+
+		_mm256_storeu_ps(out.data() + i, _mm256_mul_ps(_mm256_add_ps(left, right), half));
+	}
+
+	out = out.subspan(i);
+	in  = in.subspan(i * 2);
+}
+
+TARGET_SSE2 static void upmixSSE2(FloatView &out, FloatViewConst &in) {
+	size_t i = 0;
+
+	for (; i + blockSSE2 <= in.size(); i += blockSSE2) {
+		const __m128 value = _mm_loadu_ps(in.data() + i);
+
+		_mm_storeu_ps(out.data() + i * 2, _mm_unpacklo_ps(value, value));
+		_mm_storeu_ps(out.data() + i * 2 + blockSSE2, _mm_unpackhi_ps(value, value));
+	}
+
+	out = out.subspan(i * 2);
+	in  = in.subspan(i);
+}
+
+TARGET_AVX static void upmixAVX(FloatView &out, FloatViewConst &in) {
+	size_t i = 0;
+
+	for (; i + blockAVX <= in.size(); i += blockAVX) {
+		const __m256 value = _mm256_loadu_ps(in.data() + i);
+
+		const __m256 lo = _mm256_unpacklo_ps(value, value);
+		const __m256 hi = _mm256_unpackhi_ps(value, value);
+
+		_mm256_storeu_ps(out.data() + i * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(out.data() + i * 2 + blockAVX, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+
+	out = out.subspan(i * 2);
+	in  = in.subspan(i);
+}
+
+DSP::Kernel DSP::detectKernel() {
+	const auto &features = CPU::features();
+
+	if (features.avx2) {
+		return Kernel::AVX2;
+	}
+
+	if (features.avx) {
+		return Kernel::AVX;
+	}
+
+	return features.sse2 ? Kernel::SSE2 : Kernel::Scalar;
+}
+
+void DSP::nativeAdd(const Kernel kernel, FloatView &out, FloatViewConst &in) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			addAVX(out, in);
+			break;
+		case Kernel::SSE2:
+			addSSE2(out, in);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+void DSP::nativeSubtract(const Kernel kernel, FloatView &out, FloatViewConst &a, FloatViewConst &b) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			subtractAVX(out, a, b);
+			break;
+		case Kernel::SSE2:
+			subtractSSE2(out, a, b);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+float DSP::nativePeak(const Kernel kernel, FloatViewConst &in) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			return peakAVX(in);
+		case Kernel::SSE2:
+			return peakSSE2(in);
+		case Kernel::Scalar:
+			break;
+	}
+
+	return 0.f;
+}
+
+void DSP::nativeRamp(const Kernel kernel, FloatView &out, FloatViewConst &in, float &gain, const float step) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			rampAVX(out, in, gain, step);
+			break;
+		case Kernel::SSE2:
+			rampSSE2(out, in, gain, step);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+float DSP::nativeDot(const Kernel kernel, FloatViewConst &a, FloatViewConst &b) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			return dotAVX(a, b);
+		case Kernel::SSE2:
+			return dotSSE2(a, b);
+		case Kernel::Scalar:
+			break;
+	}
+
+	return 0.f;
+}
+
+void DSP::nativeToFloat(const Kernel kernel, FloatView &out, IntegerViewConst &in) {
+	switch (kernel) {
+		case Kernel::AVX2:
+			toFloatAVX2(out, in);
+			break;
+		case Kernel::AVX:
+		case Kernel::SSE2:
+			toFloatSSE2(out, in);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+void DSP::nativeToInteger(const Kernel kernel, IntegerView &out, FloatViewConst &in) {
+	switch (kernel) {
+		case Kernel::AVX2:
+			toIntegerAVX2(out, in);
+			break;
+		case Kernel::AVX:
+		case Kernel::SSE2:
+			toIntegerSSE2(out, in);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+void DSP::nativeScale(const Kernel kernel, IntegerView &out, IntegerViewConst &in, const float gain) {
+	switch (kernel) {
+		case Kernel::AVX2:
+			scaleAVX2(out, in, gain);
+			break;
+		case Kernel::AVX:
+		case Kernel::SSE2:
+			scaleSSE2(out, in, gain);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+void DSP::nativeDownmix(const Kernel kernel, FloatView &out, FloatViewConst &in) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			downmixAVX(out, in);
+			break;
+		case Kernel::SSE2:
+			downmixSSE2(out, in);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+void DSP::nativeUpmix(const Kernel kernel, FloatView &out, FloatViewConst &in) {
+	switch (kernel) {
+		case Kernel::AVX2:
+		case Kernel::AVX:
+			upmixAVX(out, in);
+			break;
+		case Kernel::SSE2:
+			upmixSSE2(out, in);
+			break;
+		case Kernel::Scalar:
+			break;
+	}
+}
+
+#else
+
+DSP::Kernel DSP::detectKernel() {
+	return Kernel::Scalar;
+}
+
+void DSP::nativeAdd(const Kernel, FloatView &, FloatViewConst &) {
+}
+
+void DSP::nativeSubtract(const Kernel, FloatView &, FloatViewConst &, FloatViewConst &) {
+}
+
+float DSP::nativePeak(const Kernel, FloatViewConst &) {
+	return 0.f;
+}
+
+void DSP::nativeRamp(const Kernel, FloatView &, FloatViewConst &, float &, const float) {
+}
+
+float DSP::nativeDot(const Kernel, FloatViewConst &, FloatViewConst &) {
+	return 0.f;
+}
+
+void DSP::nativeToFloat(const Kernel, FloatView &, IntegerViewConst &) {
+}
+
+void DSP::nativeToInteger(const Kernel, IntegerView &, FloatViewConst &) {
+}
+
+void DSP::nativeScale(const Kernel, IntegerView &, IntegerViewConst &, const float) {
+}
+
+void DSP::nativeDownmix(const Kernel, FloatView &, FloatViewConst &) {
+}
+
+void DSP::nativeUpmix(const Kernel, FloatView &, FloatViewConst &) {
+}
+
+#endif
@@ -0,0 +1,76 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "EVP.hpp"
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include <openssl/evp.h>
+#include <openssl/opensslv.h>
+
+using namespace mumble;
+
+// The algorithms are never freed: a static destructor could run after OpenSSL's own cleanup at exit.
+template< typename T > using Cache = std::unordered_map< std::string, const T * >;
+
+template< typename T, typename Fetch >
+static const T *get(Cache< T > &cache, std::shared_mutex &mutex, const std::string_view name, const Fetch &fetch) {
+	std::string key(name);
+
+	{
+		std::shared_lock lock(mutex);
+
+		const auto iter = cache.find(key);
+		if (iter != cache.cend()) {
+			return iter->second;
+		}
+	}
+
+	std::unique_lock lock(mutex);
+
+	// Another thread may have fetched it in the meantime.
+	const auto iter = cache.find(key);
+	if (iter != cache.cend()) {
+		return iter->second;
+	}
+
+	const T *algorithm = fetch(key.c_str());
+	if (!algorithm) {
+		return nullptr;
+	}
+
+	cache.emplace(std::move(key), algorithm);
+
+	return algorithm;
+}
+
+const EVP_CIPHER *EVP::cipher(const std::string_view name) {
+	static Cache< EVP_CIPHER > cache;
+	static std::shared_mutex mutex;
+
+	return get(cache, mutex, name, [](const char *name) {
+#if OPENSSL_VERSION_MAJOR >= 3
+		return EVP_CIPHER_fetch(nullptr, name, nullptr);
+#else
+		return EVP_get_cipherbyname(name);
+#endif
+	});
+}
+
+const EVP_MD *EVP::md(const std::string_view name) {
+	static Cache< EVP_MD > cache;
+	static std::shared_mutex mutex;
+
+	return get(cache, mutex, name, [](const char *name) {
+#if OPENSSL_VERSION_MAJOR >= 3
+		return EVP_MD_fetch(nullptr, name, nullptr);
+#else
+		return EVP_get_digestbyname(name);
+#endif
+	});
+}
@@ -0,0 +1,27 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_EVP_HPP
+#define MUMBLE_SRC_EVP_HPP
+
+#include <string_view>
+
+#include <openssl/ossl_typ.h>
+
+namespace mumble {
+// Process-wide cache of the algorithms provided by OpenSSL.
+//
+// With OpenSSL 3, looking up an algorithm by name (or passing a legacy EVP_aes_*() object to an init function)
+// goes through the provider machinery every time, which takes global locks and allocates.
+// Here every algorithm is fetched once and shared by all contexts, for the lifetime of the process.
+class EVP {
+public:
+	// Returns nullptr if the algorithm is not available.
+	static const EVP_CIPHER *cipher(const std::string_view name);
+	static const EVP_MD *md(const std::string_view name);
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,35 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/EndpointHash.hpp"
+
+#include <random>
+
+#include <openssl/rand.h>
+
+using namespace mumble;
+
+using Key = EndpointHash::Key;
+
+static Key genKey() {
+	Key key;
+	if (RAND_priv_bytes(reinterpret_cast< unsigned char * >(key.data()), sizeof(key)) > 0) {
+		return key;
+	}
+
+	std::random_device device;
+	for (auto &word : key) {
+		word = static_cast< uint64_t >(device()) << 32 | device();
+	}
+
+	return key;
+}
+
+EndpointHash::EndpointHash() {
+	static const Key key = genKey();
+
+	m_key = key;
+}
+
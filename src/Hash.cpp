@@ -5,12 +5,16 @@
 
 #include "Hash.hpp"
 
+#include "EVP.hpp"
+
 #include "mumble/Types.hpp"
 
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <memory>
+#include <string>
 #include <utility>
 
 #include <openssl/evp.h>
@@ -47,26 +51,60 @@ Hash &Hash::operator=(Hash &&crypt) {
 size_t Hash::operator()(const BufView out, const BufViewConst in) {
 	CHECK
 
+	return (*this)(out, BufViewsConst(&in, 1));
+}
+
+size_t Hash::operator()(const BufView out, const BufViewsConst in) {
+	CHECK
+
 	if (!out.size()) {
-		int size = EVP_MD_CTX_size(m_p->m_ctx);
-		assert(size >= 0);
-		return static_cast< std::size_t >(size);
+		return m_p->size();
 	}
 
-	if (EVP_DigestInit_ex(m_p->m_ctx, nullptr, nullptr) <= 0) {
-		return {};
+	// Starts over, even if update() was called before.
+	m_p->m_pending = false;
+
+	for (const auto part : in) {
+		if (!m_p->update(part)) {
+			return {};
+		}
 	}
 
-	if (EVP_DigestUpdate(m_p->m_ctx, in.data(), in.size()) <= 0) {
-		return {};
+	return m_p->final(out);
+}
+
+bool Hash::update(const BufViewConst in) {
+	CHECK
+
+	return m_p->update(in);
+}
+
+size_t Hash::final(const BufView out) {
+	CHECK
+
+	if (!out.size()) {
+		return m_p->size();
 	}
 
-	uint32_t written;
-	if (EVP_DigestFinal_ex(m_p->m_ctx, CAST_BUF(out.data()), &written) <= 0) {
+	return m_p->final(out);
+}
+
+size_t Hash::hashMany(const gsl::span< const BufView > out, const BufViewsConst in) {
+	CHECK
+
+	if (out.size() != in.size()) {
 		return {};
 	}
 
-	return written;
+	m_p->m_pending = false;
+
+	for (size_t i = 0; i < in.size(); ++i) {
+		if (!m_p->update(in[i]) || !m_p->final(out[i])) {
+			return i;
+		}
+	}
+
+	return in.size();
 }
 
 void *Hash::handle() const {
@@ -98,10 +136,28 @@ uint32_t Hash::blockSize() const {
 bool Hash::reset() {
 	CHECK
 
+	m_p->m_pending = false;
+
 	return EVP_MD_CTX_reset(m_p->m_ctx) > 0;
 }
 
-P::P() : m_ctx(EVP_MD_CTX_new()) {
+Hash &Hash::local(const std::string_view type) {
+	// Looked up by name, a thread only ever uses a handful of types. A deque doesn't move the elements when growing.
+	thread_local std::deque< std::pair< std::string, Hash > > hashes;
+
+	for (auto &iter : hashes) {
+		if (iter.first == type) {
+			return iter.second;
+		}
+	}
+
+	auto &hash = hashes.emplace_back(type, Hash()).second;
+	hash.setType(type);
+
+	return hash;
+}
+
+P::P() : m_ctx(EVP_MD_CTX_new()), m_pending(false) {
 	if (m_ctx) {
 		setType();
 	}
@@ -135,10 +191,56 @@ std::string_view P::type() {
 }
 
 bool P::setType(const std::string_view name) {
-	const auto type = name.empty() ? EVP_md_null() : EVP_get_digestbyname(name.data());
+	const auto type = name.empty() ? EVP_md_null() : EVP::md(name);
 	if (!type) {
 		return false;
 	}
 
 	return EVP_DigestInit_ex(m_ctx, type, nullptr) > 0;
 }
+
+size_t P::size() {
+	const int size = EVP_MD_CTX_size(m_ctx);
+	assert(size >= 0);
+	return static_cast< std::size_t >(size);
+}
+
+bool P::update(const BufViewConst in) {
+	if (!m_pending) {
+		if (EVP_DigestInit_ex(m_ctx, nullptr, nullptr) <= 0) {
+			return false;
+		}
+
+		m_pending = true;
+	}
+
+	if (EVP_DigestUpdate(m_ctx, in.data(), in.size()) <= 0) {
+		// The digest is incomplete, the next call starts a new one (initializing the context again).
+		m_pending = false;
+		return false;
+	}
+
+	return true;
+}
+
+size_t P::final(const BufView out) {
+	// Discarded as well, like any failure.
+	if (out.size() < size()) {
+		m_pending = false;
+		return {};
+	}
+
+	// Nothing was passed to update(), the digest of empty input.
+	if (!m_pending && !update({})) {
+		return {};
+	}
+
+	m_pending = false;
+
+	uint32_t written;
+	if (EVP_DigestFinal_ex(m_ctx, CAST_BUF(out.data()), &written) <= 0) {
+		return {};
+	}
+
+	return written;
+}
@@ -25,8 +25,15 @@ public:
 	std::string_view type();
 	bool setType(const std::string_view name = {});
 
+	size_t size();
+
+	bool update(const BufViewConst in);
+	size_t final(const BufView out);
+
 private:
 	EVP_MD_CTX *m_ctx;
+	// Set once update() initialized the context for a digest that wasn't finalized yet.
+	bool m_pending;
 };
 } // namespace mumble
 
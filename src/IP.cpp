@@ -61,6 +61,9 @@ IP::IP(const sockaddr_in6 &sockaddr) {
 	std::memcpy(m_bytes.data(), &sockaddr.sin6_addr, m_bytes.size());
 }
 
+IP::IP(const IPValue &ip) : m_bytes(ip.bytes) {
+}
+
 IP::~IP() = default;
 
 IP &IP::operator=(const IP &ip) {
@@ -72,6 +75,10 @@ bool IP::operator==(const IP &ip) const {
 	return m_bytes == ip.m_bytes;
 }
 
+IPValue IP::value() const {
+	return { m_bytes };
+}
+
 ViewConst IP::v6() const {
 	return m_bytes;
 }
@@ -131,3 +138,15 @@ void IP::toSockAddr(sockaddr_in6 &sockaddr) const {
 	sockaddr.sin6_family = AF_INET6;
 	std::memcpy(&sockaddr.sin6_addr, m_bytes.data(), sizeof(sockaddr.sin6_addr));
 }
+
+IPValue IPValue::fromSockAddr(const sockaddr_in6 &sockaddr) {
+	IPValue ip;
+	std::memcpy(ip.bytes.data(), &sockaddr.sin6_addr, ip.bytes.size());
+
+	return ip;
+}
+
+void IPValue::toSockAddr(sockaddr_in6 &sockaddr) const {
+	sockaddr.sin6_family = AF_INET6;
+	std::memcpy(&sockaddr.sin6_addr, bytes.data(), sizeof(sockaddr.sin6_addr));
+}
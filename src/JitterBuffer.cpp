@@ -0,0 +1,431 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "JitterBuffer.hpp"
+
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using namespace std::chrono;
+
+using P = JitterBuffer::P;
+
+using Frame     = JitterBuffer::Frame;
+using FloatView = Opus::FloatView;
+
+static constexpr uint32_t frameSamples = 48000 * JitterBuffer::frameDuration.count() / 1000;
+
+static constexpr uint8_t toFrames(const milliseconds duration) {
+	if (duration != JitterBuffer::frameDuration && duration != JitterBuffer::frameDuration * 2) {
+		return 0;
+	}
+
+	return static_cast< uint8_t >(duration / JitterBuffer::frameDuration);
+}
+
+JitterBuffer::JitterBuffer(const milliseconds tick) : m_p(new P(toFrames(tick))) {
+}
+
+JitterBuffer::~JitterBuffer() = default;
+
+JitterBuffer::operator bool() const {
+	return m_p && m_p->m_tickFrames;
+}
+
+bool JitterBuffer::push(const udp::Message::Audio &audio, const TimePoint arrival) {
+	return push(audio.frameNumber, audio.opusData, audio.isTerminator, arrival);
+}
+
+bool JitterBuffer::push(const uint64_t number, const BufViewConst packet, const bool terminator,
+						const TimePoint arrival) {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->push(number, packet, terminator, arrival);
+}
+
+Frame JitterBuffer::pop() {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->pop();
+}
+
+FloatView JitterBuffer::decode(const FloatView out, Opus::Decoder &decoder) {
+	CHECK
+
+	const size_t samples = decoder.sampleRate() / 100 * decoder.channels();
+	const size_t needed  = samples * m_p->m_tickFrames;
+	if (!samples || out.size() < needed || samples * P::packetFramesMax > m_p->m_pcm.size()) {
+		return {};
+	}
+
+	const std::lock_guard< std::mutex > lock(m_p->m_decodeMutex);
+
+	auto &pcm = m_p->m_pcm;
+
+	size_t written = 0;
+
+	for (;;) {
+		const auto size = std::min(needed - written, m_p->m_pcmSize - m_p->m_pcmOffset);
+		std::copy_n(pcm.data() + m_p->m_pcmOffset, size, out.data() + written);
+
+		written += size;
+		m_p->m_pcmOffset += size;
+
+		if (written == needed) {
+			break;
+		}
+
+		Frame frame;
+
+		{
+			const std::lock_guard< std::mutex > popLock(m_p->m_mutex);
+
+			frame = m_p->pop();
+
+			const auto packet = BufView(m_p->m_packet).first(frame.packet.size());
+			std::copy(frame.packet.begin(), frame.packet.end(), packet.begin());
+			frame.packet = packet;
+		}
+
+		if (frame.type == Frame::Type::None) {
+			break;
+		}
+
+		const FloatView view(pcm.data(), samples * frame.frames);
+
+		FloatView decoded;
+
+		switch (frame.type) {
+			case Frame::Type::None:
+				break;
+			case Frame::Type::Normal:
+				decoded = decoder(view, frame.packet);
+				break;
+			case Frame::Type::FEC:
+				decoded = decoder(view, frame.packet, true);
+				break;
+			case Frame::Type::Loss:
+				decoded = decoder(view, {});
+				break;
+		}
+
+		// A packet that fails to decode is played as silence, so that the timing is preserved.
+		if (decoded.empty()) {
+			std::fill(view.begin(), view.end(), 0.f);
+			decoded = view;
+		}
+
+		m_p->m_pcmOffset = 0;
+		m_p->m_pcmSize   = decoded.size();
+	}
+
+	if (!written) {
+		return {};
+	}
+
+	std::fill_n(out.data() + written, needed - written, 0.f);
+
+	return out.first(needed);
+}
+
+void JitterBuffer::reset() {
+	if (!*this) {
+		return;
+	}
+
+	const std::lock_guard< std::mutex > decodeLock(m_p->m_decodeMutex);
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	m_p->reset();
+}
+
+bool JitterBuffer::playing() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_playing;
+}
+
+milliseconds JitterBuffer::tick() const {
+	CHECK
+
+	return frameDuration * m_p->m_tickFrames;
+}
+
+milliseconds JitterBuffer::delay() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return frameDuration * m_p->m_target;
+}
+
+microseconds JitterBuffer::jitter() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return microseconds(static_cast< microseconds::rep >(m_p->m_jitter));
+}
+
+JitterBuffer::Stats JitterBuffer::stats() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_stats;
+}
+
+P::P(const uint8_t tickFrames)
+	: m_tickFrames(tickFrames), m_idle(true), m_playing(false), m_playout(0), m_newest(0), m_newestFrames(0),
+	  m_packetFrames(tickFrames), m_end(std::numeric_limits< uint64_t >::max()), m_waited(0), m_concealed(0),
+	  m_jitter(0), m_transit(0), m_hasTransit(false), m_target(tickFrames),
+	  m_pcm(frameSamples * packetFramesMax * 2), m_pcmOffset(0), m_pcmSize(0) {
+}
+
+bool P::push(const uint64_t number, const BufViewConst packet, const bool terminator, const TimePoint arrival) {
+	if (packet.size() > packetSizeMax) {
+		return false;
+	}
+
+	// An empty packet can only mark the end of a talk spurt.
+	if (packet.empty()) {
+		if (!terminator || m_idle) {
+			return false;
+		}
+
+		m_end = std::min(m_end, number);
+
+		return true;
+	}
+
+	if (m_idle) {
+		// Leftovers of the talk spurt that was just played.
+		if (number < m_playout && m_playout - number < capacity) {
+			++m_stats.late;
+			return false;
+		}
+
+		restart(number);
+	} else if (number >= m_playout + capacity) {
+		// Too far ahead to fit: the sender restarted its counter or we missed the end of the previous spurt.
+		m_stats.dropped += static_cast< uint32_t >(std::count_if(m_slots.cbegin(), m_slots.cend(),
+																  [](const Slot &slot) { return slot.used; }));
+		restart(number);
+	} else if (number < m_playout) {
+		// Packets that arrive out of order before playback starts are still in time.
+		if (m_playing || m_newest - number >= targetMax) {
+			++m_stats.late;
+			return false;
+		}
+
+		m_playout = number;
+	}
+
+	auto &slot = m_slots[number % capacity];
+	if (slot.used && slot.number == number) {
+		// Duplicate.
+		return false;
+	}
+
+	slot.number     = number;
+	slot.size       = static_cast< uint16_t >(packet.size());
+	slot.frames     = packetFrames(packet);
+	slot.terminator = terminator;
+	slot.used       = true;
+	std::copy(packet.begin(), packet.end(), slot.data.begin());
+
+	if (number >= m_newest) {
+		m_newest       = number;
+		m_newestFrames = slot.frames;
+		m_packetFrames = slot.frames;
+	}
+
+	if (terminator) {
+		m_end = std::min(m_end, number + slot.frames);
+	}
+
+	updateJitter(number, arrival);
+	updateTarget();
+
+	return true;
+}
+
+Frame P::pop() {
+	if (m_idle) {
+		return {};
+	}
+
+	if (!m_playing) {
+		// Playback starts once enough audio is buffered, when the spurt is complete or when we waited long enough
+		// (in case the sender stopped without sending a terminator).
+		m_waited = static_cast< uint8_t >(std::min< uint32_t >(m_waited + m_tickFrames, targetMax));
+
+		if (span() < m_target && m_waited < m_target && m_end == std::numeric_limits< uint64_t >::max()) {
+			return {};
+		}
+
+		m_playing = true;
+	}
+
+	auto slot = find(m_playout);
+
+	// Too much audio queued up, typically because the jitter went down: skip a packet (only when the following
+	// one is there, so that no gap is created).
+	const uint32_t margin = 2 * std::max(m_tickFrames, m_packetFrames);
+	if (slot && span() > m_target + margin) {
+		if (const auto next = find(m_playout + slot->frames)) {
+			++m_stats.dropped;
+
+			slot->used = false;
+			m_playout += slot->frames;
+			slot = next;
+		}
+	}
+
+	if (m_playout >= m_end) {
+		finish();
+		return {};
+	}
+
+	Frame frame;
+
+	if (slot) {
+		slot->used = false;
+
+		frame.type       = Frame::Type::Normal;
+		frame.frames     = slot->frames;
+		frame.terminator = slot->terminator;
+		frame.number     = slot->number;
+		frame.packet     = BufViewConst(slot->data.data(), slot->size);
+
+		++m_stats.good;
+
+		m_playout += slot->frames;
+		m_concealed = 0;
+
+		if (m_playout >= m_end) {
+			finish();
+		}
+
+		return frame;
+	}
+
+	// Nothing newer was received: the speaker may be gone, conceal a few frames only.
+	if (m_newest + m_newestFrames <= m_playout && m_concealed >= concealFramesMax) {
+		finish();
+		return {};
+	}
+
+	frame.frames = m_packetFrames;
+	frame.number = m_playout;
+
+	// The FEC data in a packet describes the previous one.
+	if (const auto next = find(m_playout + m_packetFrames)) {
+		frame.type   = Frame::Type::FEC;
+		frame.packet = BufViewConst(next->data.data(), next->size);
+
+		++m_stats.recovered;
+	} else {
+		frame.type = Frame::Type::Loss;
+
+		++m_stats.lost;
+	}
+
+	m_playout += m_packetFrames;
+	m_concealed = static_cast< uint8_t >(std::min< uint32_t >(m_concealed + m_packetFrames, concealFramesMax));
+
+	return frame;
+}
+
+void P::reset() {
+	for (auto &slot : m_slots) {
+		slot.used = false;
+	}
+
+	m_idle      = true;
+	m_playing   = false;
+	m_playout   = 0;
+	m_pcmOffset = 0;
+	m_pcmSize   = 0;
+}
+
+void P::restart(const uint64_t number) {
+	for (auto &slot : m_slots) {
+		slot.used = false;
+	}
+
+	m_idle         = false;
+	m_playing      = false;
+	m_playout      = number;
+	m_newest       = number;
+	m_newestFrames = 0;
+	m_end          = std::numeric_limits< uint64_t >::max();
+	m_waited       = 0;
+	m_concealed    = 0;
+	// The sender doesn't transmit during silence, the gap is not jitter.
+	m_hasTransit = false;
+}
+
+void P::finish() {
+	m_idle    = true;
+	m_playing = false;
+}
+
+void P::updateJitter(const uint64_t number, const TimePoint arrival) {
+	const auto sent    = static_cast< int64_t >(number) * duration_cast< microseconds >(frameDuration).count();
+	const auto transit = duration_cast< microseconds >(arrival.time_since_epoch()).count() - sent;
+
+	if (m_hasTransit) {
+		const auto difference = static_cast< float >(std::abs(transit - m_transit));
+		m_jitter += (difference - m_jitter) / 16;
+	}
+
+	m_transit    = transit;
+	m_hasTransit = true;
+}
+
+void P::updateTarget() {
+	// 3 times the mean deviation covers the vast majority of arrivals.
+	const auto jitterFrames = std::ceil(3 * m_jitter / duration_cast< microseconds >(frameDuration).count());
+	const auto target       = std::max(m_tickFrames, m_packetFrames) + static_cast< uint32_t >(jitterFrames);
+
+	m_target = static_cast< uint8_t >(std::min< uint32_t >(target, targetMax));
+}
+
+P::Slot *P::find(const uint64_t number) {
+	auto &slot = m_slots[number % capacity];
+	return slot.used && slot.number == number ? &slot : nullptr;
+}
+
+uint64_t P::span() const {
+	const auto end = m_newest + m_newestFrames;
+	return end > m_playout ? end - m_playout : 0;
+}
+
+uint8_t P::packetFrames(const BufViewConst packet) {
+	const auto frames = Opus::packetSamples(packet, 48000) / frameSamples;
+	return static_cast< uint8_t >(std::clamp< uint32_t >(frames, 1, packetFramesMax));
+}
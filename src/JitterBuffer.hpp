@@ -0,0 +1,106 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_JITTERBUFFER_HPP
+#define MUMBLE_SRC_JITTERBUFFER_HPP
+
+#include "mumble/JitterBuffer.hpp"
+
+#include "mumble/Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace mumble {
+class JitterBuffer::P {
+	friend JitterBuffer;
+
+public:
+	// Opus packets are 120 ms long at most.
+	static constexpr uint8_t packetFramesMax = 12;
+	// Consecutive frames concealed when nothing newer was received, before considering the speaker gone.
+	static constexpr uint8_t concealFramesMax = 6;
+	// The delay is capped so that a full spurt of reordered packets still fits in the ring.
+	static constexpr uint8_t targetMax = capacity / 2;
+
+	struct Slot {
+		uint64_t number    = 0;
+		uint16_t size      = 0;
+		uint8_t frames     = 0;
+		bool terminator    = false;
+		bool used          = false;
+		FixedBuf< packetSizeMax > data;
+	};
+
+	P(const uint8_t tickFrames);
+	~P() = default;
+
+	bool push(const uint64_t number, const BufViewConst packet, const bool terminator, const TimePoint arrival);
+	Frame pop();
+
+	void reset();
+
+private:
+	// Starts a new talk spurt, with "number" as its first packet.
+	void restart(const uint64_t number);
+	// Called when the speaker is done, the next packet starts a new talk spurt.
+	void finish();
+
+	void updateJitter(const uint64_t number, const TimePoint arrival);
+	void updateTarget();
+
+	Slot *find(const uint64_t number);
+
+	// Frames between the playback position and the end of the newest packet.
+	uint64_t span() const;
+
+	static uint8_t packetFrames(const BufViewConst packet);
+
+	// Held by push() and pop(), only for the bookkeeping: decoding happens outside of it.
+	mutable std::mutex m_mutex;
+	// Held by decode() and reset(), for the decoded audio and the packet being decoded. Taken before "m_mutex".
+	std::mutex m_decodeMutex;
+
+	uint8_t m_tickFrames;
+	std::array< Slot, capacity > m_slots;
+
+	// No packet since the last talk spurt ended.
+	bool m_idle;
+	bool m_playing;
+	// The next frame to play.
+	uint64_t m_playout;
+	uint64_t m_newest;
+	uint8_t m_newestFrames;
+	// Length of the last packet received, assumed for the missing ones.
+	uint8_t m_packetFrames;
+	// Where the current talk spurt ends, known once the terminator is received.
+	uint64_t m_end;
+	// Frames played since buffering started.
+	uint8_t m_waited;
+	// Frames concealed since the last packet that was received in time.
+	uint8_t m_concealed;
+
+	// In microseconds, per RFC 3550 (section 6.4.1).
+	float m_jitter;
+	int64_t m_transit;
+	bool m_hasTransit;
+	uint8_t m_target;
+
+	Stats m_stats;
+
+	// Copy of the packet being decoded, the slot can be reused as soon as the lock is released.
+	FixedBuf< packetSizeMax > m_packet;
+	// Decoded audio that didn't fit in the previous tick.
+	std::vector< float > m_pcm;
+	size_t m_pcmOffset;
+	size_t m_pcmSize;
+};
+} // namespace mumble
+
+#endif
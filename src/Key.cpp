@@ -13,9 +13,12 @@
 
 #include <openssl/bio.h>
 #include <openssl/buffer.h>
+#include <openssl/ec.h>
 #include <openssl/evp.h>
+#include <openssl/obj_mac.h>
 #include <openssl/opensslv.h>
 #include <openssl/pem.h>
+#include <openssl/rsa.h>
 
 #define CHECK      \
 	if (!*this) {  \
@@ -115,6 +118,10 @@ std::string Key::pem() const {
 	return pem;
 }
 
+Key Key::generate(const Type type) {
+	return P::generate(type);
+}
+
 P::P(EVP_PKEY *pkey) : m_pkey(pkey) {
 }
 
@@ -139,6 +146,54 @@ P::~P() {
 	}
 }
 
+EVP_PKEY *P::generate(const Type type) {
+	int id;
+	switch (type) {
+		case RSA2048:
+			id = EVP_PKEY_RSA;
+			break;
+		case P256:
+			id = EVP_PKEY_EC;
+			break;
+		case Ed25519:
+			id = EVP_PKEY_ED25519;
+			break;
+		default:
+			return nullptr;
+	}
+
+	auto ctx = EVP_PKEY_CTX_new_id(id, nullptr);
+	if (!ctx) {
+		return nullptr;
+	}
+
+	EVP_PKEY *pkey = nullptr;
+
+	if (EVP_PKEY_keygen_init(ctx) > 0) {
+		bool ok = true;
+
+		switch (type) {
+			case RSA2048:
+				ok = EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 2048) > 0;
+				break;
+			case P256:
+				ok = EVP_PKEY_CTX_set_ec_paramgen_curve_nid(ctx, NID_X9_62_prime256v1) > 0
+					 && EVP_PKEY_CTX_set_ec_param_enc(ctx, OPENSSL_EC_NAMED_CURVE) > 0;
+				break;
+			case Ed25519:
+				break;
+		}
+
+		if (ok && EVP_PKEY_keygen(ctx, &pkey) <= 0) {
+			pkey = nullptr;
+		}
+	}
+
+	EVP_PKEY_CTX_free(ctx);
+
+	return pkey;
+}
+
 int P::passwordCallback(char *buf, const int size, int, void *userdata) {
 	auto password = static_cast< const std::string_view * >(userdata);
 
@@ -22,6 +22,8 @@ public:
 	~P();
 
 private:
+	static EVP_PKEY *generate(const Type type);
+
 	static int passwordCallback(char *buf, const int size, int, void *userdata);
 
 	EVP_PKEY *m_pkey;
@@ -0,0 +1,521 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/Legacy.hpp"
+
+#include "mumble/Endian.hpp"
+#include "mumble/Message.hpp"
+#include "mumble/PacketDataStream.hpp"
+#include "mumble/Pack.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <gsl/span>
+
+using namespace mumble;
+
+using Audio = udp::Message::Audio;
+using Voice = legacy::udp::Voice;
+
+// Field numbers of "MumbleUDP::Audio", see MumbleUDP.proto.
+enum Field : uint8_t {
+	Target           = 1,
+	Context          = 2,
+	SenderSession    = 3,
+	FrameNumber      = 4,
+	OpusData         = 5,
+	PositionalData   = 6,
+	VolumeAdjustment = 7,
+	IsTerminator     = 16
+};
+
+enum WireType : uint8_t { Varint = 0, Fixed64 = 1, Bytes = 2, Fixed32 = 5 };
+
+static constexpr uint64_t tag(const Field field, const WireType type) {
+	return static_cast< uint64_t >(field) << 3 | type;
+}
+
+static constexpr size_t varintSize(uint64_t value) {
+	size_t size = 1;
+
+	while (value >= 0x80) {
+		value >>= 7;
+		++size;
+	}
+
+	return size;
+}
+
+static std::byte *putVarint(std::byte *dst, uint64_t value) {
+	while (value >= 0x80) {
+		*dst++ = static_cast< std::byte >(value | 0x80);
+		value >>= 7;
+	}
+
+	*dst++ = static_cast< std::byte >(value);
+
+	return dst;
+}
+
+static std::byte *putFloat(std::byte *dst, const float value) {
+	// Protobuf encodes fixed-size values in little-endian order.
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	if (Endian::isBig()) {
+		bits = Endian::swap(bits);
+	}
+
+	std::memcpy(dst, &bits, sizeof(bits));
+
+	return dst + sizeof(bits);
+}
+
+static bool getVarint(BufViewConst &in, uint64_t &value) {
+	value = 0;
+
+	for (uint8_t shift = 0; shift < 64 && !in.empty(); shift += 7) {
+		const auto byte = std::to_integer< uint8_t >(in.front());
+		in              = in.subspan(1);
+
+		value |= static_cast< uint64_t >(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool getFloat(BufViewConst &in, float &value) {
+	uint32_t bits;
+	if (in.size() < sizeof(bits)) {
+		return false;
+	}
+
+	std::memcpy(&bits, in.data(), sizeof(bits));
+	if (Endian::isBig()) {
+		bits = Endian::swap(bits);
+	}
+
+	std::memcpy(&value, &bits, sizeof(value));
+	in = in.subspan(sizeof(bits));
+
+	return true;
+}
+
+static bool skipField(BufViewConst &in, const uint8_t type) {
+	uint64_t value;
+
+	switch (type) {
+		case Varint:
+			return getVarint(in, value);
+		case Fixed64:
+			value = 8;
+			break;
+		case Bytes:
+			if (!getVarint(in, value)) {
+				return false;
+			}
+
+			break;
+		case Fixed32:
+			value = 4;
+			break;
+		default:
+			return false;
+	}
+
+	if (value > in.size()) {
+		return false;
+	}
+
+	in = in.subspan(static_cast< size_t >(value));
+
+	return true;
+}
+
+bool legacy::udp::decode(Voice &voice, const BufViewConst packet, const bool hasSession) {
+	if (packet.empty()) {
+		return false;
+	}
+
+	voice.type = type(packet);
+	if (voice.type != Type::VoiceOpus) {
+		return false;
+	}
+
+	voice.target = std::to_integer< uint8_t >(packet[0]) & Voice::targetMask;
+
+	// PacketDataStream only writes through the view when serializing.
+	PacketDataStream stream({ const_cast< std::byte * >(packet.data()), packet.size() });
+	stream.skip(1);
+
+	if (hasSession) {
+		uint32_t session = 0;
+		stream >> session;
+		voice.session = session;
+	} else {
+		voice.session.reset();
+	}
+
+	uint64_t size = 0;
+	stream >> voice.sequence >> size;
+	if (!stream) {
+		return false;
+	}
+
+	voice.isTerminator = size & Voice::terminatorFlag;
+	size &= Voice::sizeMask;
+
+	if (size > stream.seek().size()) {
+		return false;
+	}
+
+	voice.payload = stream.seek().first(static_cast< size_t >(size));
+	stream.skip(static_cast< uint32_t >(size));
+
+	if (stream.seek().size() >= sizeof(Voice::Position)) {
+		Voice::Position position;
+		stream >> position[0] >> position[1] >> position[2];
+		voice.position = position;
+	} else {
+		voice.position.reset();
+	}
+
+	return static_cast< bool >(stream);
+}
+
+size_t legacy::udp::encode(const BufView out, const Voice &voice) {
+	if (voice.type != Type::VoiceOpus || voice.target > Voice::targetMask || voice.payload.size() > Voice::sizeMask) {
+		return {};
+	}
+
+	PacketDataStream stream(out);
+
+	stream.append(static_cast< uint8_t >(voice.type) << 5 | voice.target);
+
+	if (voice.session) {
+		stream << voice.session.value();
+	}
+
+	stream << voice.sequence;
+	stream << static_cast< uint64_t >(voice.payload.size() | (voice.isTerminator ? Voice::terminatorFlag : 0));
+	stream.append(voice.payload);
+
+	if (voice.position) {
+		const auto &position = voice.position.value();
+		stream << position[0] << position[1] << position[2];
+	}
+
+	if (out.empty()) {
+		return stream.undersize();
+	}
+
+	return stream ? stream.data().size() : 0;
+}
+
+size_t legacy::udp::reheader(const BufView buf, const size_t size, const uint32_t session, const uint8_t context) {
+	if (!size || size > buf.size() || context > Voice::targetMask) {
+		return {};
+	}
+
+	if (type(buf) == Type::Ping) {
+		return {};
+	}
+
+	// A 32 bit value takes up to 5 bytes.
+	FixedBuf< 5 > varint;
+
+	PacketDataStream stream(varint);
+	stream << session;
+
+	const auto varintSize = stream.data().size();
+	if (size + varintSize > buf.size()) {
+		return {};
+	}
+
+	// The rest of the packet (sequence, payload, position) is the same in both directions.
+	std::memmove(buf.data() + 1 + varintSize, buf.data() + 1, size - 1);
+	std::copy_n(varint.cbegin(), varintSize, buf.begin() + 1);
+
+	buf[0] = static_cast< std::byte >((std::to_integer< uint8_t >(buf[0]) & ~Voice::targetMask) | context);
+
+	return size + varintSize;
+}
+
+bool legacy::udp::toAudio(Audio &audio, const Voice &voice) {
+	if (voice.type != Type::VoiceOpus) {
+		return false;
+	}
+
+	if (voice.session) {
+		audio.direction     = Audio::ServerToClient;
+		audio.context       = voice.target;
+		audio.senderSession = voice.session;
+	} else {
+		audio.direction = Audio::ClientToServer;
+		audio.target    = voice.target;
+		audio.senderSession.reset();
+	}
+
+	audio.frameNumber = voice.sequence;
+	audio.opusData.assign(voice.payload.begin(), voice.payload.end());
+
+	if (voice.position) {
+		audio.positionalData.assign(voice.position->cbegin(), voice.position->cend());
+	} else {
+		audio.positionalData.clear();
+	}
+
+	audio.volumeAdjustment = 0.f;
+	audio.isTerminator     = voice.isTerminator;
+
+	return true;
+}
+
+bool legacy::udp::fromAudio(Voice &voice, const Audio &audio) {
+	uint32_t target;
+
+	switch (audio.direction) {
+		case Audio::ClientToServer:
+			target = audio.target;
+			voice.session.reset();
+			break;
+		case Audio::ServerToClient:
+			target        = audio.context;
+			voice.session = audio.senderSession.value_or(0);
+			break;
+		default:
+			return false;
+	}
+
+	if (target > Voice::targetMask || audio.opusData.size() > Voice::sizeMask) {
+		return false;
+	}
+
+	voice.type         = Type::VoiceOpus;
+	voice.target       = static_cast< uint8_t >(target);
+	voice.sequence     = audio.frameNumber;
+	voice.payload      = audio.opusData;
+	voice.isTerminator = audio.isTerminator;
+
+	if (audio.positionalData.size() >= std::tuple_size< Voice::Position >()) {
+		Voice::Position position;
+		std::copy_n(audio.positionalData.cbegin(), position.size(), position.begin());
+		voice.position = position;
+	} else {
+		voice.position.reset();
+	}
+
+	return true;
+}
+
+size_t legacy::udp::toPack(const BufView out, const Voice &voice) {
+	if (voice.type != Type::VoiceOpus) {
+		return {};
+	}
+
+	// Same field order and default value elision as the protobuf serializer.
+	// The target/context is part of a "oneof" and thus always present.
+	const Field header = voice.session ? Context : Target;
+
+	size_t size = sizeof(mumble::udp::NetHeader);
+	size += varintSize(tag(header, Varint)) + varintSize(voice.target);
+
+	if (voice.session && voice.session.value()) {
+		size += varintSize(tag(SenderSession, Varint)) + varintSize(voice.session.value());
+	}
+
+	if (voice.sequence) {
+		size += varintSize(tag(FrameNumber, Varint)) + varintSize(voice.sequence);
+	}
+
+	if (!voice.payload.empty()) {
+		size += varintSize(tag(OpusData, Bytes)) + varintSize(voice.payload.size()) + voice.payload.size();
+	}
+
+	constexpr size_t positionSize = sizeof(Voice::Position);
+	if (voice.position) {
+		size += varintSize(tag(PositionalData, Bytes)) + varintSize(positionSize) + positionSize;
+	}
+
+	if (voice.isTerminator) {
+		size += varintSize(tag(IsTerminator, Varint)) + 1;
+	}
+
+	if (out.empty()) {
+		return size;
+	}
+
+	if (out.size() < size) {
+		return {};
+	}
+
+	auto dst = out.data();
+
+	*dst++ = static_cast< std::byte >(mumble::udp::Message::Type::Audio);
+
+	dst = putVarint(dst, tag(header, Varint));
+	dst = putVarint(dst, voice.target);
+
+	if (voice.session && voice.session.value()) {
+		dst = putVarint(dst, tag(SenderSession, Varint));
+		dst = putVarint(dst, voice.session.value());
+	}
+
+	if (voice.sequence) {
+		dst = putVarint(dst, tag(FrameNumber, Varint));
+		dst = putVarint(dst, voice.sequence);
+	}
+
+	if (!voice.payload.empty()) {
+		dst = putVarint(dst, tag(OpusData, Bytes));
+		dst = putVarint(dst, voice.payload.size());
+		dst = std::copy(voice.payload.begin(), voice.payload.end(), dst);
+	}
+
+	if (voice.position) {
+		dst = putVarint(dst, tag(PositionalData, Bytes));
+		dst = putVarint(dst, positionSize);
+
+		for (const auto coordinate : voice.position.value()) {
+			dst = putFloat(dst, coordinate);
+		}
+	}
+
+	if (voice.isTerminator) {
+		dst = putVarint(dst, tag(IsTerminator, Varint));
+		dst = putVarint(dst, 1);
+	}
+
+	return static_cast< size_t >(dst - out.data());
+}
+
+bool legacy::udp::fromPack(Voice &voice, BufViewConst pack) {
+	if (pack.empty() || pack[0] != static_cast< std::byte >(mumble::udp::Message::Type::Audio)) {
+		return false;
+	}
+
+	pack = pack.subspan(sizeof(mumble::udp::NetHeader));
+
+	bool hasContext          = false;
+	uint64_t target          = 0;
+	uint64_t session         = 0;
+	uint8_t coordinates      = 0;
+	Voice::Position position = {};
+
+	voice.sequence     = 0;
+	voice.payload      = {};
+	voice.isTerminator = false;
+
+	while (!pack.empty()) {
+		uint64_t key;
+		if (!getVarint(pack, key)) {
+			return false;
+		}
+
+		const auto type = static_cast< uint8_t >(key & 0x7);
+
+		uint64_t value;
+
+		switch (key >> 3) {
+			case Target:
+			case Context:
+				if (type != Varint || !getVarint(pack, target)) {
+					return false;
+				}
+
+				hasContext = (key >> 3) == Context;
+				break;
+			case SenderSession:
+				if (type != Varint || !getVarint(pack, session)) {
+					return false;
+				}
+
+				break;
+			case FrameNumber:
+				if (type != Varint || !getVarint(pack, voice.sequence)) {
+					return false;
+				}
+
+				break;
+			case OpusData:
+				if (type != Bytes || !getVarint(pack, value) || value > pack.size()) {
+					return false;
+				}
+
+				voice.payload = pack.first(static_cast< size_t >(value));
+				pack          = pack.subspan(static_cast< size_t >(value));
+				break;
+			case PositionalData:
+				if (type == Fixed32) {
+					float coordinate;
+					if (!getFloat(pack, coordinate)) {
+						return false;
+					}
+
+					if (coordinates < position.size()) {
+						position[coordinates++] = coordinate;
+					}
+
+					break;
+				}
+
+				// Packed repeated field.
+				if (type != Bytes || !getVarint(pack, value) || value > pack.size() || value % sizeof(float)) {
+					return false;
+				}
+
+				for (auto packed = pack.first(static_cast< size_t >(value)); !packed.empty();) {
+					float coordinate = 0.f;
+					getFloat(packed, coordinate);
+
+					if (coordinates < position.size()) {
+						position[coordinates++] = coordinate;
+					}
+				}
+
+				pack = pack.subspan(static_cast< size_t >(value));
+				break;
+			case IsTerminator:
+				if (type != Varint || !getVarint(pack, value)) {
+					return false;
+				}
+
+				voice.isTerminator = value;
+				break;
+			default:
+				// Includes the volume adjustment, which has no legacy equivalent.
+				if (!skipField(pack, type)) {
+					return false;
+				}
+		}
+	}
+
+	if (target > Voice::targetMask || voice.payload.size() > Voice::sizeMask) {
+		return false;
+	}
+
+	voice.type   = Type::VoiceOpus;
+	voice.target = static_cast< uint8_t >(target);
+
+	if (hasContext) {
+		voice.session = static_cast< uint32_t >(session);
+	} else {
+		voice.session.reset();
+	}
+
+	if (coordinates == position.size()) {
+		voice.position = position;
+	} else {
+		voice.position.reset();
+	}
+
+	return true;
+}
@@ -0,0 +1,287 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Mixer.hpp"
+
+#include "DSP.hpp"
+
+#include "mumble/JitterBuffer.hpp"
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+#ifndef MUMBLE_COMPILER_MSVC
+#	include <quickpool.hpp>
+#else
+#	pragma warning(push)
+#	pragma warning(disable : 4244)
+#	pragma warning(disable : 4324)
+#	include <quickpool.hpp>
+#	pragma warning(pop)
+#endif
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using P = Mixer::P;
+
+using FloatViewConst = Opus::FloatViewConst;
+using TimePoint      = JitterBuffer::TimePoint;
+
+Mixer::Mixer(const uint8_t channels, const uint32_t streamsMax, const uint32_t outputsMax, const uint32_t threads)
+	: m_p(new P(channels, streamsMax, outputsMax, threads)) {
+}
+
+Mixer::~Mixer() = default;
+
+Mixer::operator bool() const {
+	return m_p && m_p->m_decoders && m_p->m_encoders;
+}
+
+uint8_t Mixer::channels() const {
+	CHECK
+
+	return m_p->m_channels;
+}
+
+bool Mixer::addStream(const uint32_t id) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	if (m_p->m_streams.size() >= m_p->m_streamsMax || m_p->m_streams.count(id)) {
+		return false;
+	}
+
+	auto decoder = m_p->m_decoders.acquire();
+	if (!decoder) {
+		return false;
+	}
+
+	auto stream     = std::make_unique< P::Stream >();
+	stream->decoder = std::move(decoder);
+	stream->pcm.resize(tickSamples * m_p->m_channels);
+
+	m_p->m_streams.emplace(id, std::move(stream));
+	m_p->update();
+
+	return true;
+}
+
+bool Mixer::removeStream(const uint32_t id) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	if (!m_p->m_streams.erase(id)) {
+		return false;
+	}
+
+	m_p->update();
+
+	return true;
+}
+
+size_t Mixer::streams() const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	return m_p->m_streams.size();
+}
+
+bool Mixer::push(const uint32_t id, const udp::Message::Audio &audio, const TimePoint arrival) {
+	return push(id, audio.frameNumber, audio.opusData, audio.isTerminator, arrival);
+}
+
+bool Mixer::push(const uint32_t id, const uint64_t number, const BufViewConst packet, const bool terminator,
+				 const TimePoint arrival) {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend()) {
+		return false;
+	}
+
+	return iter->second->buffer.push(number, packet, terminator, arrival);
+}
+
+bool Mixer::addOutput(const uint32_t id, const std::optional< uint32_t > exclude, const uint32_t bitrate) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	if (m_p->m_outputs.size() >= m_p->m_outputsMax || m_p->m_outputs.count(id)) {
+		return false;
+	}
+
+	auto encoder = m_p->m_encoders.acquire();
+	if (!encoder || !encoder->setBitrate(bitrate)) {
+		return false;
+	}
+
+	auto output     = std::make_unique< P::Output >();
+	output->exclude = exclude;
+	output->encoder = std::move(encoder);
+	output->pcm.resize(tickSamples * m_p->m_channels);
+
+	m_p->m_outputs.emplace(id, std::move(output));
+	m_p->update();
+
+	return true;
+}
+
+bool Mixer::removeOutput(const uint32_t id) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	if (!m_p->m_outputs.erase(id)) {
+		return false;
+	}
+
+	m_p->update();
+
+	return true;
+}
+
+size_t Mixer::outputs() const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	return m_p->m_outputs.size();
+}
+
+size_t Mixer::tick() {
+	CHECK
+
+	// Shared with push(), which only touches the jitter buffers. The outputs are written without any other lock, the
+	// accessors of the results must not be called concurrently (see the header).
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	m_p->m_pool->parallel_for_each(m_p->m_streamList, [this](P::Stream *stream) { m_p->decode(*stream); });
+
+	std::fill(m_p->m_sum.begin(), m_p->m_sum.end(), 0.f);
+	m_p->m_active = 0;
+
+	for (const auto stream : m_p->m_streamList) {
+		if (stream->active) {
+			DSP::add(m_p->m_sum, stream->pcm);
+			++m_p->m_active;
+		}
+	}
+
+	m_p->m_pool->parallel_for_each(m_p->m_outputList, [this](P::Output *output) { m_p->encode(*output); });
+
+	return m_p->m_active;
+}
+
+BufViewConst Mixer::packet(const uint32_t id) const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_outputs.find(id);
+	if (iter == m_p->m_outputs.cend() || !iter->second->active) {
+		return {};
+	}
+
+	const auto &output = *iter->second;
+
+	return { output.packet.data(), output.packetSize };
+}
+
+FloatViewConst Mixer::pcm(const uint32_t id) const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_outputs.find(id);
+	if (iter == m_p->m_outputs.cend() || !iter->second->active) {
+		return {};
+	}
+
+	return iter->second->pcm;
+}
+
+P::P(const uint8_t channels, const uint32_t streamsMax, const uint32_t outputsMax, const uint32_t threads)
+	: m_channels(channels), m_streamsMax(streamsMax), m_outputsMax(outputsMax),
+	  m_decoders(channels, sampleRate, streamsMax), m_encoders(channels, sampleRate, outputsMax),
+	  m_pool(threads ? std::make_unique< quickpool::ThreadPool >(threads)
+					 : std::make_unique< quickpool::ThreadPool >()),
+	  m_sum(tickSamples * channels), m_active(0) {
+	m_streams.reserve(streamsMax);
+	m_outputs.reserve(outputsMax);
+	m_streamList.reserve(streamsMax);
+	m_outputList.reserve(outputsMax);
+}
+
+P::~P() = default;
+
+void P::decode(Stream &stream) {
+	stream.active = !stream.buffer.decode(stream.pcm, *stream.decoder).empty();
+}
+
+void P::encode(Output &output) {
+	const auto excluded = output.excluded && output.excluded->active;
+
+	output.active = m_active > (excluded ? 1 : 0);
+	if (!output.active) {
+		return;
+	}
+
+	// The sum minus one stream, instead of adding up all the others again.
+	FloatViewConst mix = m_sum;
+	if (excluded) {
+		DSP::subtract(output.pcm, m_sum, output.excluded->pcm);
+		mix = output.pcm;
+	}
+
+	// The gain drops within the tick the peak is in, which is then clamped, and comes back up progressively.
+	const auto peak   = DSP::peak(mix);
+	const auto target = peak > threshold ? threshold / peak : 1.f;
+	const auto gain   = target < output.gain ? target : output.gain + (target - output.gain) * release;
+
+	DSP::ramp(output.pcm, mix, output.gain, gain);
+	output.gain = gain;
+
+	const auto packet = (*output.encoder)(output.packet, output.pcm);
+
+	output.packetSize = packet.size();
+	output.active     = !packet.empty();
+}
+
+void P::update() {
+	m_streamList.clear();
+	for (const auto &iter : m_streams) {
+		m_streamList.push_back(iter.second.get());
+	}
+
+	m_outputList.clear();
+	for (const auto &iter : m_outputs) {
+		auto &output = *iter.second;
+
+		const auto stream = output.exclude ? m_streams.find(*output.exclude) : m_streams.cend();
+		output.excluded   = stream != m_streams.cend() ? stream->second.get() : nullptr;
+
+		m_outputList.push_back(&output);
+	}
+}
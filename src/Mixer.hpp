@@ -0,0 +1,88 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_MIXER_HPP
+#define MUMBLE_SRC_MIXER_HPP
+
+#include "mumble/Mixer.hpp"
+
+#include "mumble/JitterBuffer.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace quickpool {
+class ThreadPool;
+}
+
+namespace mumble {
+class Mixer::P {
+	friend Mixer;
+
+public:
+	// Amplitude the limiter keeps the outputs under.
+	static constexpr float threshold = 1.f;
+	// Fraction of the way back to unity gain covered each tick, once the output is quiet enough (~200 ms).
+	static constexpr float release = 0.1f;
+
+	struct Stream {
+		JitterBuffer buffer;
+		Opus::DecoderPool::Ptr decoder;
+		std::vector< float > pcm;
+		// Whether the stream was heard in the current tick.
+		bool active = false;
+	};
+
+	struct Output {
+		std::optional< uint32_t > exclude;
+		// Resolved from "exclude" when the streams change.
+		const Stream *excluded = nullptr;
+		Opus::EncoderPool::Ptr encoder;
+		std::vector< float > pcm;
+		FixedBuf< JitterBuffer::packetSizeMax > packet;
+		size_t packetSize = 0;
+		// Gain applied by the limiter at the end of the previous tick.
+		float gain  = 1.f;
+		bool active = false;
+	};
+
+	P(const uint8_t channels, const uint32_t streamsMax, const uint32_t outputsMax, const uint32_t threads);
+	~P();
+
+private:
+	void decode(Stream &stream);
+	void encode(Output &output);
+
+	// Rebuilds the lists iterated by tick(), called with the lock held exclusively.
+	void update();
+
+	uint8_t m_channels;
+	uint32_t m_streamsMax;
+	uint32_t m_outputsMax;
+
+	Opus::DecoderPool m_decoders;
+	Opus::EncoderPool m_encoders;
+	std::unique_ptr< quickpool::ThreadPool > m_pool;
+
+	mutable std::shared_mutex m_mutex;
+	std::unordered_map< uint32_t, std::unique_ptr< Stream > > m_streams;
+	std::unordered_map< uint32_t, std::unique_ptr< Output > > m_outputs;
+	std::vector< Stream * > m_streamList;
+	std::vector< Output * > m_outputList;
+
+	// Sum of all active streams.
+	std::vector< float > m_sum;
+	size_t m_active;
+};
+} // namespace mumble
+
+#endif
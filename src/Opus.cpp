@@ -7,7 +7,9 @@
 
 #include "mumble/Types.hpp"
 
+#include <cstddef>
 #include <limits>
+#include <mutex>
 #include <utility>
 
 #include <opus.h>
@@ -29,10 +31,13 @@
 
 using namespace mumble;
 
-using Decoder     = Opus::Decoder;
-using Encoder     = Opus::Encoder;
-using FloatView   = Opus::FloatView;
-using IntegerView = Opus::IntegerView;
+using Decoder      = Opus::Decoder;
+using Encoder      = Opus::Encoder;
+using DecoderPool  = Opus::DecoderPool;
+using EncoderPool  = Opus::EncoderPool;
+using Repacketizer = Opus::Repacketizer;
+using FloatView    = Opus::FloatView;
+using IntegerView  = Opus::IntegerView;
 
 using Preset = Encoder::Preset;
 
@@ -84,6 +89,9 @@ Decoder::Decoder(Decoder &&decoder) : m_p(std::exchange(decoder.m_p, nullptr)) {
 Decoder::Decoder(const uint8_t channels) : m_p(new P(channels)) {
 }
 
+Decoder::Decoder(P *p) : m_p(p) {
+}
+
 Decoder::~Decoder() = default;
 
 Decoder::operator bool() const {
@@ -156,12 +164,18 @@ uint32_t Decoder::packetSamples(const BufViewConst packet) {
 Decoder::P::P(const uint8_t channels) : OpusBase(channels) {
 }
 
+Decoder::P::P(const uint8_t channels, ::OpusDecoder *ctx) : OpusBase(channels, ctx) {
+}
+
 Encoder::Encoder(Encoder &&encoder) : m_p(std::exchange(encoder.m_p, nullptr)) {
 }
 
 Encoder::Encoder(const uint8_t channels) : m_p(new P(channels)) {
 }
 
+Encoder::Encoder(P *p) : m_p(p) {
+}
+
 Encoder::~Encoder() = default;
 
 Encoder::operator bool() const {
@@ -274,9 +288,30 @@ bool Encoder::toggleVBR(const bool enable) {
 	return m_p->set(OPUS_SET_VBR(enable));
 }
 
+bool Encoder::usesFEC() const {
+	opus_int32 ret = 0;
+	return m_p->get(OPUS_GET_INBAND_FEC(&ret)) ? ret : 0;
+}
+
+bool Encoder::toggleFEC(const bool enable) {
+	return m_p->set(OPUS_SET_INBAND_FEC(enable));
+}
+
+uint8_t Encoder::packetLoss() const {
+	opus_int32 ret = 0;
+	return m_p->get(OPUS_GET_PACKET_LOSS_PERC(&ret)) ? static_cast< uint8_t >(ret) : 0;
+}
+
+bool Encoder::setPacketLoss(const uint8_t percent) {
+	return m_p->set(OPUS_SET_PACKET_LOSS_PERC(static_cast< opus_int32 >(percent)));
+}
+
 Encoder::P::P(const uint8_t channels) : OpusBase(channels) {
 }
 
+Encoder::P::P(const uint8_t channels, ::OpusEncoder *ctx) : OpusBase(channels, ctx) {
+}
+
 int32_t Encoder::P::toApplication(const Preset preset) {
 	switch (preset) {
 		case Preset::Unknown:
@@ -305,22 +340,218 @@ Preset Encoder::P::toPreset(const int32_t application) {
 	return Preset::Unknown;
 }
 
+void DecoderPool::Releaser::operator()(Decoder *decoder) const {
+	decoder->reset();
+	pool->release(decoder);
+}
+
+DecoderPool::DecoderPool(const uint8_t channels, const uint32_t sampleRate, const size_t size)
+	: m_p(new P(channels, size)) {
+	// Only the pool can create decoders that don't own their state.
+	for (size_t i = 0; i < size; ++i) {
+		m_p->m_coders.push_back(Decoder(new Decoder::P(channels, m_p->state(i))));
+
+		if (m_p->m_coders.back().init(sampleRate) != Code::Success) {
+			return;
+		}
+	}
+
+	m_p->ready(sampleRate);
+}
+
+DecoderPool::~DecoderPool() = default;
+
+DecoderPool::operator bool() const {
+	return m_p && *m_p;
+}
+
+DecoderPool::Ptr DecoderPool::acquire() {
+	CHECK
+
+	return Ptr(m_p->acquire(), Releaser{ m_p.get() });
+}
+
+uint8_t DecoderPool::channels() const {
+	CHECK
+
+	return m_p->m_channels;
+}
+
+uint32_t DecoderPool::sampleRate() const {
+	CHECK
+
+	return m_p->m_sampleRate;
+}
+
+size_t DecoderPool::size() const {
+	CHECK
+
+	return m_p->m_coders.size();
+}
+
+size_t DecoderPool::available() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_free.size();
+}
+
+DecoderPool::P::P(const uint8_t channels, const size_t size) : OpusPool(channels, size) {
+}
+
+void EncoderPool::Releaser::operator()(Encoder *encoder) const {
+	encoder->reset();
+	pool->restore(*encoder);
+	pool->release(encoder);
+}
+
+EncoderPool::EncoderPool(const uint8_t channels, const uint32_t sampleRate, const size_t size, const Preset preset)
+	: m_p(new P(channels, size, preset)) {
+	// Only the pool can create encoders that don't own their state.
+	for (size_t i = 0; i < size; ++i) {
+		m_p->m_coders.push_back(Encoder(new Encoder::P(channels, m_p->state(i))));
+
+		if (m_p->m_coders.back().init(sampleRate, preset) != Code::Success) {
+			return;
+		}
+	}
+
+	m_p->ready(sampleRate);
+}
+
+EncoderPool::~EncoderPool() = default;
+
+EncoderPool::operator bool() const {
+	return m_p && *m_p;
+}
+
+EncoderPool::Ptr EncoderPool::acquire() {
+	CHECK
+
+	return Ptr(m_p->acquire(), Releaser{ m_p.get() });
+}
+
+uint8_t EncoderPool::channels() const {
+	CHECK
+
+	return m_p->m_channels;
+}
+
+uint32_t EncoderPool::sampleRate() const {
+	CHECK
+
+	return m_p->m_sampleRate;
+}
+
+Preset EncoderPool::preset() const {
+	if (!*this) {
+		return Preset::Unknown;
+	}
+
+	return m_p->m_preset;
+}
+
+size_t EncoderPool::size() const {
+	CHECK
+
+	return m_p->m_coders.size();
+}
+
+size_t EncoderPool::available() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_free.size();
+}
+
+EncoderPool::P::P(const uint8_t channels, const size_t size, const Preset preset)
+	: OpusPool(channels, size), m_preset(preset) {
+}
+
+bool EncoderPool::P::restore(Encoder &encoder) const {
+	// A bitrate of 0 stands for OPUS_AUTO, the default.
+	return encoder.setPreset(m_preset) && encoder.setBitrate(0) && encoder.toggleVBR(true) && encoder.toggleFEC(false)
+		   && encoder.setPacketLoss(0) && encoder.togglePhaseInversion(true);
+}
+
+Repacketizer::Repacketizer(Repacketizer &&repacketizer) : m_p(std::exchange(repacketizer.m_p, nullptr)) {
+}
+
+Repacketizer::Repacketizer() : m_p(new P) {
+}
+
+Repacketizer::~Repacketizer() = default;
+
+Repacketizer::operator bool() const {
+	return static_cast< bool >(m_p);
+}
+
+void Repacketizer::reset() {
+	if (*this) {
+		opus_repacketizer_init(m_p->ctx());
+	}
+}
+
+Code Repacketizer::add(const BufViewConst packet) {
+	if (!*this) {
+		return Code::Init;
+	}
+
+	return interpretLibCode(opus_repacketizer_cat(m_p->ctx(), CAST_BUF_CONST(packet.data()), CAST_SIZE(packet.size())));
+}
+
+uint32_t Repacketizer::frames() const {
+	CHECK
+
+	return static_cast< uint32_t >(opus_repacketizer_get_nb_frames(m_p->ctx()));
+}
+
+BufView Repacketizer::operator()(const BufView out, const uint32_t begin, const uint32_t end) {
+	CHECK
+
+	const auto written = opus_repacketizer_out_range(m_p->ctx(), static_cast< int >(begin), static_cast< int >(end),
+													 CAST_BUF(out.data()), CAST_SIZE(out.size()));
+
+	return written > 0 ? out.first(static_cast< size_t >(written)) : BufView();
+}
+
+BufView Repacketizer::operator()(const BufView out) {
+	return (*this)(out, 0, frames());
+}
+
+Repacketizer::P::P() : m_state(new std::byte[static_cast< size_t >(opus_repacketizer_get_size())]) {
+	opus_repacketizer_init(ctx());
+}
+
+OpusRepacketizer *Repacketizer::P::ctx() {
+	return reinterpret_cast< OpusRepacketizer * >(m_state.get());
+}
+
 template< typename T > OpusBase< T >::OpusBase(const uint8_t channels) : m_inited(false), m_channels(channels) {
+	m_ctx.reset(reinterpret_cast< T * >(new std::byte[stateSize(channels)]));
+}
+
+template< typename T >
+OpusBase< T >::OpusBase(const uint8_t channels, T *ctx)
+	: m_inited(false), m_channels(channels), m_ctx(ctx, Destructor{ false }) {
+}
+
+template< typename T > OpusBase< T >::operator bool() {
+	return m_inited;
+}
+
+template< typename T > size_t OpusBase< T >::stateSize(const uint8_t channels) {
 	if constexpr (std::is_same_v< T, ::OpusDecoder >) {
-		m_ctx.reset(
-			reinterpret_cast< T * >(new std::byte[static_cast< std::size_t >(opus_decoder_get_size(channels))]));
+		return static_cast< std::size_t >(opus_decoder_get_size(channels));
 	} else if constexpr (std::is_same_v< T, ::OpusEncoder >) {
-		m_ctx.reset(
-			reinterpret_cast< T * >(new std::byte[static_cast< std::size_t >(opus_encoder_get_size(channels))]));
+		return static_cast< std::size_t >(opus_encoder_get_size(channels));
 	} else {
 		static_assert(std::is_same_v< T, ::OpusEncoder > && "Invalid template type!");
 	}
 }
 
-template< typename T > OpusBase< T >::operator bool() {
-	return m_inited;
-}
-
 template< typename T > template< typename R > bool OpusBase< T >::get(const int32_t request, R *value) {
 	CHECK
 
@@ -344,3 +575,50 @@ template< typename T > template< typename R > bool OpusBase< T >::set(const int3
 		return opus_encoder_ctl(m_ctx.get(), request, value) == OPUS_OK;
 	}
 }
+
+template< typename T, typename C >
+OpusPool< T, C >::OpusPool(const uint8_t channels, const size_t size)
+	: m_channels(channels), m_sampleRate(0) {
+	constexpr auto alignment = alignof(std::max_align_t);
+
+	m_stride = (OpusBase< C >::stateSize(channels) + alignment - 1) / alignment * alignment;
+	m_slab.reset(new std::byte[m_stride * size]);
+
+	m_coders.reserve(size);
+	m_free.reserve(size);
+}
+
+template< typename T, typename C > OpusPool< T, C >::operator bool() {
+	return m_sampleRate;
+}
+
+template< typename T, typename C > C *OpusPool< T, C >::state(const size_t index) {
+	return reinterpret_cast< C * >(m_slab.get() + m_stride * index);
+}
+
+template< typename T, typename C > void OpusPool< T, C >::ready(const uint32_t sampleRate) {
+	m_sampleRate = sampleRate;
+
+	for (auto &coder : m_coders) {
+		m_free.push_back(&coder);
+	}
+}
+
+template< typename T, typename C > T *OpusPool< T, C >::acquire() {
+	const std::lock_guard< std::mutex > lock(m_mutex);
+
+	if (m_free.empty()) {
+		return nullptr;
+	}
+
+	const auto coder = m_free.back();
+	m_free.pop_back();
+
+	return coder;
+}
+
+template< typename T, typename C > void OpusPool< T, C >::release(T *coder) {
+	const std::lock_guard< std::mutex > lock(m_mutex);
+
+	m_free.push_back(coder);
+}
@@ -11,25 +11,36 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 struct OpusDecoder;
 struct OpusEncoder;
+struct OpusRepacketizer;
 
 namespace mumble {
 template< typename T > class OpusBase {
 public:
 	OpusBase(const uint8_t channels);
+	// The state is owned by a pool, it's neither allocated nor freed.
+	OpusBase(const uint8_t channels, T *ctx);
 
 	explicit operator bool();
 
+	static size_t stateSize(const uint8_t channels);
+
 	template< typename R > bool get(const int32_t request, R *value);
 	template< typename R > bool set(const int32_t request, const R value);
 
 protected:
 	struct Destructor {
+		bool owned = true;
+
 		void operator()(T *ctx) {
-			auto bytes = reinterpret_cast< std::byte * >(ctx);
-			delete[] bytes;
+			if (owned) {
+				auto bytes = reinterpret_cast< std::byte * >(ctx);
+				delete[] bytes;
+			}
 		}
 	};
 
@@ -43,6 +54,7 @@ class Opus::Decoder::P : public OpusBase<::OpusDecoder > {
 
 public:
 	P(const uint8_t channels);
+	P(const uint8_t channels, ::OpusDecoder *ctx);
 	~P() = default;
 };
 
@@ -51,11 +63,74 @@ class Opus::Encoder::P : public OpusBase<::OpusEncoder > {
 
 public:
 	P(const uint8_t channels);
+	P(const uint8_t channels, ::OpusEncoder *ctx);
 	~P() = default;
 
 	static int32_t toApplication(const Preset preset);
 	static Preset toPreset(const int32_t application);
 };
+
+class Opus::Repacketizer::P {
+	friend Opus::Repacketizer;
+
+public:
+	P();
+	~P() = default;
+
+	::OpusRepacketizer *ctx();
+
+private:
+	std::unique_ptr< std::byte[] > m_state;
+};
+
+// T is the coder handed out, C the library's state.
+template< typename T, typename C > class OpusPool {
+public:
+	OpusPool(const uint8_t channels, const size_t size);
+
+	explicit operator bool();
+
+	C *state(const size_t index);
+
+	// Called once all coders are initialized, makes them available.
+	void ready(const uint32_t sampleRate);
+
+	T *acquire();
+	void release(T *coder);
+
+protected:
+	size_t m_stride;
+	uint8_t m_channels;
+	// Set once all coders are initialized.
+	uint32_t m_sampleRate;
+	// The states of all coders, each one aligned like a regular allocation.
+	std::unique_ptr< std::byte[] > m_slab;
+	std::vector< T > m_coders;
+	std::vector< T * > m_free;
+	mutable std::mutex m_mutex;
+};
+
+class Opus::DecoderPool::P : public OpusPool< Opus::Decoder, ::OpusDecoder > {
+	friend Opus::DecoderPool;
+
+public:
+	P(const uint8_t channels, const size_t size);
+	~P() = default;
+};
+
+class Opus::EncoderPool::P : public OpusPool< Opus::Encoder, ::OpusEncoder > {
+	friend Opus::EncoderPool;
+
+public:
+	P(const uint8_t channels, const size_t size, const Encoder::Preset preset);
+	~P() = default;
+
+	// Brings back the settings the pool was created with.
+	bool restore(Encoder &encoder) const;
+
+private:
+	Encoder::Preset m_preset;
+};
 } // namespace mumble
 
 #endif
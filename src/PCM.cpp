@@ -0,0 +1,236 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "PCM.hpp"
+
+#include "DSP.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using P = PCM::Resampler::P;
+
+using FloatView        = PCM::FloatView;
+using FloatViewConst   = PCM::FloatViewConst;
+using IntegerView      = PCM::IntegerView;
+using IntegerViewConst = PCM::IntegerViewConst;
+
+static constexpr double pi = 3.14159265358979323846;
+
+// Blackman window, "x" goes from -1 to 1.
+static double window(const double x) {
+	return 0.42 + 0.5 * std::cos(pi * x) + 0.08 * std::cos(2 * pi * x);
+}
+
+static double sinc(const double x) {
+	return x != 0 ? std::sin(pi * x) / (pi * x) : 1;
+}
+
+size_t PCM::toFloat(const FloatView out, const IntegerViewConst in) {
+	DSP::toFloat(out, in);
+
+	return std::min(out.size(), in.size());
+}
+
+size_t PCM::toInteger(const IntegerView out, const FloatViewConst in) {
+	DSP::toInteger(out, in);
+
+	return std::min(out.size(), in.size());
+}
+
+size_t PCM::applyGain(const FloatView out, const FloatViewConst in, const float gain) {
+	DSP::ramp(out, in, gain, gain);
+
+	return std::min(out.size(), in.size());
+}
+
+size_t PCM::applyGain(const IntegerView out, const IntegerViewConst in, const float gain) {
+	DSP::scale(out, in, gain);
+
+	return std::min(out.size(), in.size());
+}
+
+size_t PCM::toMono(const FloatView out, const FloatViewConst in) {
+	DSP::downmix(out, in);
+
+	return std::min(out.size(), in.size() / 2);
+}
+
+size_t PCM::toStereo(const FloatView out, const FloatViewConst in) {
+	DSP::upmix(out, in);
+
+	return std::min(out.size() / 2, in.size());
+}
+
+PCM::Resampler::Resampler(Resampler &&resampler) : m_p(std::exchange(resampler.m_p, nullptr)) {
+}
+
+PCM::Resampler::Resampler(const uint8_t channels, const uint32_t inRate, const uint32_t outRate)
+	: m_p(new P(channels, inRate, outRate)) {
+}
+
+PCM::Resampler::~Resampler() = default;
+
+PCM::Resampler::operator bool() const {
+	return m_p && *m_p;
+}
+
+uint8_t PCM::Resampler::channels() const {
+	CHECK
+
+	return m_p->m_channels;
+}
+
+uint32_t PCM::Resampler::inRate() const {
+	CHECK
+
+	return m_p->m_inRate;
+}
+
+uint32_t PCM::Resampler::outRate() const {
+	CHECK
+
+	return m_p->m_outRate;
+}
+
+size_t PCM::Resampler::outputSize(const size_t samples) const {
+	CHECK
+
+	const auto frames = samples / m_p->m_channels;
+
+	return ((frames * m_p->m_up + m_p->m_down - 1) / m_p->m_down + 1) * m_p->m_channels;
+}
+
+FloatView PCM::Resampler::operator()(const FloatView out, const FloatViewConst in) {
+	CHECK
+
+	if (in.size() % m_p->m_channels || out.size() < outputSize(in.size())) {
+		return {};
+	}
+
+	return m_p->process(out, in);
+}
+
+void PCM::Resampler::reset() {
+	if (*this) {
+		m_p->reset();
+	}
+}
+
+P::P(const uint8_t channels, const uint32_t inRate, const uint32_t outRate)
+	: m_channels(channels), m_inRate(inRate), m_outRate(outRate), m_up(0), m_down(0), m_inputs(channels),
+	  m_index(0), m_phase(0) {
+	if (!channels || !inRate || !outRate) {
+		return;
+	}
+
+	const auto divisor = std::gcd(inRate, outRate);
+	if (outRate / divisor > phasesMax || inRate / divisor > phasesMax) {
+		return;
+	}
+
+	m_up   = outRate / divisor;
+	m_down = inRate / divisor;
+
+	// When downsampling, the cutoff has to be below the output's Nyquist frequency.
+	const double bandwidth = cutoff * std::min(1.0, static_cast< double >(m_up) / m_down);
+	const double center    = taps / 2 - 1;
+
+	m_filter.resize(static_cast< size_t >(m_up) * taps);
+
+	for (uint32_t phase = 0; phase < m_up; ++phase) {
+		const auto coefficients = FloatView(m_filter).subspan(static_cast< size_t >(phase) * taps, taps);
+
+		double sum = 0;
+
+		for (uint32_t tap = 0; tap < taps; ++tap) {
+			// Distance between the input frame and the output one, in input frames.
+			const double x     = tap - center - static_cast< double >(phase) / m_up;
+			const double value = bandwidth * sinc(bandwidth * x) * window(x / (taps / 2));
+
+			coefficients[tap] = static_cast< float >(value);
+			sum += value;
+		}
+
+		// Unity gain for every phase, otherwise a constant signal would come out with a ripple.
+		for (auto &coefficient : coefficients) {
+			coefficient = static_cast< float >(coefficient / sum);
+		}
+	}
+
+	reset();
+}
+
+P::~P() = default;
+
+P::operator bool() const {
+	return m_up && m_down;
+}
+
+FloatView P::process(const FloatView out, const FloatViewConst in) {
+	const auto frames = in.size() / m_channels;
+
+	// Deinterleaved, so that the filter is applied to contiguous samples.
+	for (uint8_t channel = 0; channel < m_channels; ++channel) {
+		auto &input = m_inputs[channel];
+
+		const auto offset = input.size();
+		input.resize(offset + frames);
+
+		for (size_t i = 0; i < frames; ++i) {
+			input[offset + i] = in[i * m_channels + channel];
+		}
+	}
+
+	const auto size = m_inputs[0].size();
+
+	size_t written = 0;
+
+	for (; m_index + taps <= size; ++written) {
+		const auto coefficients = FloatViewConst(m_filter).subspan(static_cast< size_t >(m_phase) * taps, taps);
+
+		for (uint8_t channel = 0; channel < m_channels; ++channel) {
+			const auto samples = FloatViewConst(m_inputs[channel]).subspan(m_index, taps);
+
+			out[written * m_channels + channel] = DSP::dot(coefficients, samples);
+		}
+
+		m_phase += m_down;
+		m_index += m_phase / m_up;
+		m_phase %= m_up;
+	}
+
+	// The frames that no output needs anymore are dropped, the index can point past the end of the input.
+	const auto consumed = std::min(m_index, size);
+
+	for (auto &input : m_inputs) {
+		input.erase(input.begin(), input.begin() + static_cast< std::ptrdiff_t >(consumed));
+	}
+
+	m_index -= consumed;
+
+	return out.first(written * m_channels);
+}
+
+void P::reset() {
+	// The first output frame is aligned with the first input frame.
+	for (auto &input : m_inputs) {
+		input.assign(taps / 2 - 1, 0.f);
+	}
+
+	m_index = 0;
+	m_phase = 0;
+}
@@ -0,0 +1,51 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_PCM_HPP
+#define MUMBLE_SRC_PCM_HPP
+
+#include "mumble/PCM.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mumble {
+class PCM::Resampler::P {
+	friend Resampler;
+
+public:
+	// Ends of the passband, relative to the lowest of the two Nyquist frequencies.
+	static constexpr double cutoff = 0.9;
+
+	P(const uint8_t channels, const uint32_t inRate, const uint32_t outRate);
+	~P();
+
+	explicit operator bool() const;
+
+	FloatView process(const FloatView out, const FloatViewConst in);
+	void reset();
+
+private:
+	uint8_t m_channels;
+	uint32_t m_inRate;
+	uint32_t m_outRate;
+
+	// The ratio, reduced: an output frame is computed every "down" steps of 1/"up" input frame.
+	uint32_t m_up;
+	uint32_t m_down;
+
+	// "up" phases of "taps" coefficients each, one per position of the output frames between two input frames.
+	std::vector< float > m_filter;
+
+	// One per channel, starting with the input that is held back.
+	std::vector< std::vector< float > > m_inputs;
+	// Position of the next output frame: first input frame of its window and phase.
+	size_t m_index;
+	uint32_t m_phase;
+};
+} // namespace mumble
+
+#endif
@@ -355,6 +355,13 @@ TCP::Pack(const Message &message, const uint32_t extraDataSize) {
 			proto.set_key(msg.key.data(), msg.key.size());
 			proto.set_client_nonce(msg.clientNonce.data(), msg.clientNonce.size());
 			proto.set_server_nonce(msg.serverNonce.data(), msg.serverNonce.size());
+			for (const auto mode : msg.modes) {
+				proto.add_modes(static_cast< decltype(proto)::Mode >(mode));
+			}
+			// Left out for OCB2, so that the message is the same one peers without mode support send.
+			if (msg.mode != Message::CryptSetup::OCB2AES128) {
+				proto.set_mode(static_cast< decltype(proto)::Mode >(msg.mode));
+			}
 
 			SET_BUF_AND_BREAK
 		}
@@ -552,68 +559,117 @@ TCP::Pack(const Message &message, const uint32_t extraDataSize) {
 	}
 }
 
+static void toProto(MumbleUDP::Audio &proto, const udp::Message::Audio &msg) {
+	using Audio = udp::Message::Audio;
+
+	switch (msg.direction) {
+		case Audio::ClientToServer:
+			proto.set_target(msg.target);
+			break;
+		case Audio::ServerToClient:
+			proto.set_context(msg.context);
+			break;
+		case Audio::Unknown:
+			break;
+	}
+
+	if (msg.senderSession) {
+		proto.set_sender_session(msg.senderSession.value());
+	}
+
+	proto.set_frame_number(msg.frameNumber);
+	proto.set_opus_data(msg.opusData.data(), msg.opusData.size());
+	for (const auto data : msg.positionalData) {
+		proto.add_positional_data(data);
+	}
+
+	proto.set_volume_adjustment(msg.volumeAdjustment);
+
+	proto.set_is_terminator(msg.isTerminator);
+}
+
+static void toProto(MumbleUDP::Ping &proto, const udp::Message::Ping &msg) {
+	std::int64_t timestamp =
+		std::chrono::duration_cast< std::chrono::nanoseconds >(msg.timestamp.time_since_epoch()).count();
+	assert(timestamp >= 0);
+	proto.set_timestamp(static_cast< std::uint64_t >(timestamp));
+
+	proto.set_request_extended_information(msg.requestExtendedInformation);
+
+	if (msg.version && msg.version.value().isValid()) {
+		proto.set_server_version_v2(msg.version.value().blob64());
+	}
+	if (msg.userCount) {
+		proto.set_user_count(msg.userCount.value());
+	}
+	if (msg.maxUserCount) {
+		proto.set_max_user_count(msg.maxUserCount.value());
+	}
+	if (msg.maxBandwidthPerUser) {
+		proto.set_max_bandwidth_per_user(msg.maxBandwidthPerUser.value());
+	}
+}
+
+static size_t serialize(const BufView out, const google::protobuf::Message &proto) {
+	const auto dataSize = proto.ByteSizeLong();
+	const auto size     = sizeof(udp::NetHeader) + dataSize;
+
+	if (out.empty()) {
+		return size;
+	}
+
+	if (out.size() < size) {
+		return {};
+	}
+
+	if (!proto.SerializeToArray(out.data() + sizeof(udp::NetHeader), static_cast< int >(dataSize))) {
+		return {};
+	}
+
+	auto &header = *reinterpret_cast< udp::NetHeader * >(out.data());
+	header.type  = static_cast< uint8_t >(proto.GetDescriptor()->index());
+
+	return size;
+}
+
 UDP::Pack(const Message &message, const uint32_t extraDataSize) {
 	using Type = Message::Type;
 
 	switch (message.type()) {
 		case Type::Audio: {
-			auto &msg = static_cast< const Message::Audio & >(message);
-
 			MumbleUDP::Audio proto;
-			switch (msg.direction) {
-				case Message::Audio::ClientToServer:
-					proto.set_target(msg.target);
-					break;
-				case Message::Audio::ServerToClient:
-					proto.set_context(msg.context);
-					break;
-				case Message::Audio::Unknown:
-					break;
-			}
+			toProto(proto, static_cast< const Message::Audio & >(message));
 
-			if (msg.senderSession) {
-				proto.set_sender_session(msg.senderSession.value());
-			}
+			SET_BUF_AND_BREAK
+		}
+		case Type::Ping: {
+			MumbleUDP::Ping proto;
+			toProto(proto, static_cast< const Message::Ping & >(message));
 
-			proto.set_frame_number(msg.frameNumber);
-			proto.set_opus_data(msg.opusData.data(), msg.opusData.size());
-			for (const auto data : msg.positionalData) {
-				proto.add_positional_data(data);
-			}
+			SET_BUF_AND_BREAK
+		}
+	}
+}
 
-			proto.set_volume_adjustment(msg.volumeAdjustment);
+size_t UDP::write(const BufView out, const Message &message) {
+	using Type = Message::Type;
 
-			proto.set_is_terminator(msg.isTerminator);
+	switch (message.type()) {
+		case Type::Audio: {
+			MumbleUDP::Audio proto;
+			toProto(proto, static_cast< const Message::Audio & >(message));
 
-			SET_BUF_AND_BREAK
+			return serialize(out, proto);
 		}
 		case Type::Ping: {
-			auto &msg = static_cast< const Message::Ping & >(message);
-
 			MumbleUDP::Ping proto;
-			std::int64_t timestamp =
-				std::chrono::duration_cast< std::chrono::nanoseconds >(msg.timestamp.time_since_epoch()).count();
-			assert(timestamp >= 0);
-			proto.set_timestamp(static_cast< std::uint64_t >(timestamp));
-
-			proto.set_request_extended_information(msg.requestExtendedInformation);
+			toProto(proto, static_cast< const Message::Ping & >(message));
 
-			if (msg.version && msg.version.value().isValid()) {
-				proto.set_server_version_v2(msg.version.value().blob64());
-			}
-			if (msg.userCount) {
-				proto.set_user_count(msg.userCount.value());
-			}
-			if (msg.maxUserCount) {
-				proto.set_max_user_count(msg.maxUserCount.value());
-			}
-			if (msg.maxBandwidthPerUser) {
-				proto.set_max_bandwidth_per_user(msg.maxBandwidthPerUser.value());
-			}
-
-			SET_BUF_AND_BREAK
+			return serialize(out, proto);
 		}
 	}
+
+	return {};
 }
 
 TCP::~Pack() = default;
@@ -932,6 +988,10 @@ bool TCP::operator()(Message &message, uint32_t dataSize) const {
 			toBuf(msg.key, proto.key());
 			toBuf(msg.clientNonce, proto.client_nonce());
 			toBuf(msg.serverNonce, proto.server_nonce());
+			for (const auto mode : proto.modes()) {
+				msg.modes.push_back(static_cast< Message::CryptSetup::Mode >(mode));
+			}
+			msg.mode = static_cast< Message::CryptSetup::Mode >(proto.mode());
 
 			return true;
 		}
@@ -1144,30 +1204,45 @@ bool TCP::operator()(Message &message, uint32_t dataSize) const {
 }
 
 bool UDP::operator()(Message &message, uint32_t dataSize) const {
+	if (dataSize > data().size()) {
+		dataSize = static_cast< decltype(dataSize) >(data().size());
+	}
+
+	return read(message, buf().first(sizeof(NetHeader) + dataSize));
+}
+
+bool UDP::read(Message &message, const BufViewConst buf) {
 	using Type = Message::Type;
 
-	if (message.type() != Message::type(*this)) {
+	if (buf.size() < sizeof(NetHeader)) {
 		return false;
 	}
 
-	if (dataSize > data().size()) {
-		dataSize = static_cast< decltype(dataSize) >(data().size());
+	const auto &header = *reinterpret_cast< const NetHeader * >(buf.data());
+	if (message.type() != static_cast< Type >(header.type)) {
+		return false;
 	}
 
+	const auto payload  = buf.subspan(sizeof(header));
+	const auto dataSize = payload.size();
+
 	switch (message.type()) {
 		case Type::Audio: {
 			MumbleUDP::Audio proto;
-			PARSE_PROTO_MESSAGE(proto, data().data(), dataSize)
+			PARSE_PROTO_MESSAGE(proto, payload.data(), dataSize)
 
 			auto &msg = static_cast< Message::Audio & >(message);
 			switch (proto.Header_case()) {
 				case MumbleUDP::Audio::kTarget:
-					msg.target = proto.target();
+					msg.direction = Message::Audio::ClientToServer;
+					msg.target    = proto.target();
 					break;
 				case MumbleUDP::Audio::kContext:
-					msg.context = proto.context();
+					msg.direction = Message::Audio::ServerToClient;
+					msg.context   = proto.context();
 					break;
 				case MumbleUDP::Audio::HEADER_NOT_SET:
+					msg.direction = Message::Audio::Unknown;
 					break;
 			}
 
@@ -1188,7 +1263,7 @@ bool UDP::operator()(Message &message, uint32_t dataSize) const {
 		}
 		case Type::Ping: {
 			MumbleUDP::Ping proto;
-			PARSE_PROTO_MESSAGE(proto, data().data(), dataSize)
+			PARSE_PROTO_MESSAGE(proto, payload.data(), dataSize)
 
 			auto &msg     = static_cast< Message::Ping & >(message);
 			msg.timestamp = Message::Timestamp(std::chrono::nanoseconds(proto.timestamp()));
@@ -40,6 +40,17 @@ using namespace mumble;
 
 using P = Peer::P;
 
+// Calls the EndpointV variant of a UDP callback when it's set, the Endpoint one otherwise.
+template< typename CallbackV, typename Callback, typename Arg >
+static void notify(const CallbackV &callbackV, const Callback &callback, EndpointV &endpoint, Arg &arg) {
+	if (callbackV) {
+		callbackV(endpoint, arg);
+	} else if (callback) {
+		Endpoint converted(endpoint);
+		callback(converted, arg);
+	}
+}
+
 Peer::Peer() : m_p(new P) {
 }
 
@@ -131,6 +142,10 @@ Code Peer::delTCP(const SharedConnection &connection) {
 }
 
 Code Peer::sendUDP(const Endpoint &endpoint, const BufViewConst data) {
+	return sendUDP(endpoint.value(), data);
+}
+
+Code Peer::sendUDP(const EndpointV &endpoint, const BufViewConst data) {
 	if (!m_p->m_udp.m_socket) {
 		return Code::Init;
 	}
@@ -342,7 +357,7 @@ void P::UDP::threadFunc(const uint32_t bufferSize) {
 		}
 
 		while (event.state & Event::InReady) {
-			Endpoint endpoint;
+			EndpointV endpoint;
 			BufView packet(pack.buf());
 
 			const auto code = m_socket->read(endpoint, packet);
@@ -351,25 +366,20 @@ void P::UDP::threadFunc(const uint32_t bufferSize) {
 					if (Message::type(pack) == Type::Ping) {
 						Message::Ping ping;
 						if (pack(ping, static_cast< uint32_t >(packet.size() - sizeof(NetHeader)))) {
-							if (m_feedback.ping) {
-								m_feedback.ping(endpoint, ping);
-							}
+							notify(m_feedback.pingV, m_feedback.ping, endpoint, ping);
 
 							continue;
 						}
 					}
 
 					if (isPlainPing(packet)) {
-						if (m_feedback.legacyPing) {
-							m_feedback.legacyPing(endpoint, *reinterpret_cast< Ping * >(packet.data()));
-						}
+						notify(m_feedback.legacyPingV, m_feedback.legacyPing, endpoint,
+							   *reinterpret_cast< Ping * >(packet.data()));
 
 						continue;
 					}
 
-					if (m_feedback.encrypted) {
-						m_feedback.encrypted(endpoint, packet);
-					}
+					notify(m_feedback.encryptedV, m_feedback.encrypted, endpoint, packet);
 
 					continue;
 				}
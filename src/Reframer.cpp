@@ -0,0 +1,252 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Reframer.hpp"
+
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using namespace std::chrono;
+
+using P = Reframer::P;
+
+using Audio    = udp::Message::Audio;
+using Messages = Reframer::Messages;
+
+static constexpr uint8_t toFrames(const milliseconds duration) {
+	if (duration <= 0ms || duration > Reframer::durationMax || duration % Reframer::frameDuration != 0ms) {
+		return 0;
+	}
+
+	return static_cast< uint8_t >(duration / Reframer::frameDuration);
+}
+
+static void copyHeader(Audio &out, const Audio &in) {
+	out.direction = in.direction;
+	// Same storage as "context".
+	out.target           = in.target;
+	out.senderSession    = in.senderSession;
+	out.positionalData   = in.positionalData;
+	out.volumeAdjustment = in.volumeAdjustment;
+}
+
+Reframer::Reframer(const milliseconds duration) : m_p(new P(toFrames(duration))) {
+}
+
+Reframer::~Reframer() = default;
+
+Reframer::operator bool() const {
+	return m_p && m_p->m_frames;
+}
+
+milliseconds Reframer::duration() const {
+	CHECK
+
+	return frameDuration * m_p->m_frames;
+}
+
+uint32_t Reframer::pending() const {
+	CHECK
+
+	return (m_p->m_repacketizer.frames() - m_p->m_sent) * m_p->m_units;
+}
+
+Messages Reframer::operator()(const Audio &audio) {
+	CHECK
+
+	return m_p->process(audio);
+}
+
+Messages Reframer::flush() {
+	CHECK
+
+	m_p->m_outCount = 0;
+	m_p->send(false);
+
+	return m_p->result();
+}
+
+void Reframer::reset() {
+	if (*this) {
+		m_p->clear();
+	}
+}
+
+P::P(const uint8_t frames)
+	: m_frames(frames), m_packetCount(0), m_packetBytes(0), m_sent(0), m_units(0), m_number(0), m_outCount(0) {
+}
+
+Messages P::process(const Audio &audio) {
+	m_outCount = 0;
+
+	copyHeader(m_header, audio);
+
+	const auto held = m_repacketizer.frames() - m_sent;
+
+	// A terminator without audio: the last packet being held carries the flag instead.
+	if (audio.opusData.empty() && held) {
+		send(audio.isTerminator);
+		return result();
+	}
+
+	const auto units = packetUnits(audio.opusData);
+
+	if (held && (units != m_units || audio.frameNumber != m_number + held * m_units)) {
+		send(false);
+	}
+
+	// Frames shorter than 10 ms can't be numbered, such packets are forwarded as is.
+	if (!units || !add(audio, units)) {
+		if (const auto out = next()) {
+			out->frameNumber  = audio.frameNumber;
+			out->opusData     = audio.opusData;
+			out->isTerminator = audio.isTerminator;
+		}
+
+		return result();
+	}
+
+	const uint32_t perPacket = std::max(m_frames / m_units, 1);
+
+	while (m_repacketizer.frames() - m_sent >= perPacket) {
+		if (!emit(perPacket, false)) {
+			break;
+		}
+	}
+
+	if (audio.isTerminator || m_sent == m_repacketizer.frames()) {
+		send(audio.isTerminator);
+	}
+
+	return result();
+}
+
+void P::send(const bool terminator) {
+	if (m_units) {
+		const uint32_t perPacket = std::max(m_frames / m_units, 1);
+
+		for (auto held = m_repacketizer.frames() - m_sent; held; held = m_repacketizer.frames() - m_sent) {
+			// The frames that don't fit in the messages are discarded along with the others.
+			if (!emit(std::min(held, perPacket), false)) {
+				break;
+			}
+		}
+	}
+
+	if (terminator && m_outCount) {
+		m_out[m_outCount - 1].isTerminator = true;
+	}
+
+	clear();
+}
+
+void P::clear() {
+	m_repacketizer.reset();
+
+	m_packetCount = 0;
+	m_packetBytes = 0;
+	m_sent        = 0;
+}
+
+uint8_t P::packetUnits(const BufViewConst packet) {
+	const auto info = Opus::inspect(packet);
+	if (!info || info.frameSamples % frameSamples) {
+		return 0;
+	}
+
+	return static_cast< uint8_t >(info.frameSamples / frameSamples);
+}
+
+bool P::add(const Audio &audio, const uint8_t units) {
+	// A new packet starts: the slots of the frames already sent are released before picking one.
+	const bool first = m_repacketizer.frames() == m_sent;
+	if (first) {
+		clear();
+	}
+
+	// The slots past the count are not referenced by the repacketizer anymore, they can be overwritten.
+	if (m_packetCount == m_packets.size()) {
+		m_packets.emplace_back();
+	}
+
+	auto &packet = m_packets[m_packetCount];
+	packet.assign(audio.opusData.cbegin(), audio.opusData.cend());
+
+	if (m_repacketizer.add(packet) != Code::Success) {
+		if (first) {
+			return false;
+		}
+
+		// Over 120 ms, the frames being held are sent as a shorter packet.
+		send(false);
+
+		return add(audio, units);
+	}
+
+	if (first) {
+		m_units  = units;
+		m_number = audio.frameNumber;
+	}
+
+	++m_packetCount;
+	m_packetBytes += packet.size();
+
+	return true;
+}
+
+bool P::emit(const uint32_t count, const bool terminator) {
+	const auto out = next();
+	if (!out) {
+		return false;
+	}
+
+	out->frameNumber  = m_number;
+	out->isTerminator = terminator;
+
+	// The frames themselves plus the header of a multi-frame packet, which can't be bigger than 2 bytes per frame.
+	out->opusData.resize(m_packetBytes + 2 * (count + 1));
+
+	const auto packet = m_repacketizer(out->opusData, m_sent, m_sent + count);
+	out->opusData.resize(packet.size());
+
+	m_sent += count;
+	m_number += count * m_units;
+
+	// Shouldn't happen, the frames are skipped.
+	if (packet.empty()) {
+		--m_outCount;
+	}
+
+	return true;
+}
+
+Audio *P::next() {
+	// Shouldn't happen either, see messagesMax.
+	if (m_outCount == m_out.size()) {
+		return nullptr;
+	}
+
+	auto &out = m_out[m_outCount++];
+	copyHeader(out, m_header);
+
+	return &out;
+}
+
+Messages P::result() const {
+	return { m_out.data(), m_outCount };
+}
@@ -0,0 +1,75 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_REFRAMER_HPP
+#define MUMBLE_SRC_REFRAMER_HPP
+
+#include "mumble/Reframer.hpp"
+
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mumble {
+class Reframer::P {
+	friend Reframer;
+
+public:
+	// Samples in a 10 ms frame, Opus packets are always parsed at 48 kHz.
+	static constexpr uint32_t frameSamples = 480;
+	// A call sends at most the frames held (one packet), a whole 120 ms packet split into 10 ms ones and a packet
+	// forwarded as is.
+	static constexpr size_t messagesMax = 16;
+
+	P(const uint8_t frames);
+	~P() = default;
+
+	Messages process(const udp::Message::Audio &audio);
+
+	// Sends all frames being held, the last packet is flagged as terminator if requested.
+	void send(const bool terminator);
+	void clear();
+
+	// Frames (of 10 ms) per Opus frame in the packet, 0 if it's not a whole number.
+	static uint8_t packetUnits(const BufViewConst packet);
+
+private:
+	bool add(const udp::Message::Audio &audio, const uint8_t units);
+	// Returns false when there's no message left to send the frames in, they are kept.
+	bool emit(const uint32_t count, const bool terminator);
+	// Returns nullptr when all messages are used.
+	udp::Message::Audio *next();
+	Messages result() const;
+
+	// Target packet length, in 10 ms frames.
+	uint8_t m_frames;
+
+	Opus::Repacketizer m_repacketizer;
+	// Copies of the packets being held, the repacketizer points into them.
+	std::vector< Buf > m_packets;
+	size_t m_packetCount;
+	size_t m_packetBytes;
+	// Opus frames already sent out of the ones in the repacketizer.
+	uint32_t m_sent;
+	// Length of each Opus frame, in 10 ms frames.
+	uint8_t m_units;
+	// Frame number of the first frame not sent yet.
+	uint64_t m_number;
+
+	// The fields that are carried over, from the latest message.
+	udp::Message::Audio m_header;
+
+	// Messages aren't copyable, the storage is reused instead.
+	std::array< udp::Message::Audio, messagesMax > m_out;
+	size_t m_outCount;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,182 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "SilenceGate.hpp"
+
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using namespace std::chrono;
+
+using P = SilenceGate::P;
+
+using Class   = SilenceGate::Class;
+using Config  = SilenceGate::Config;
+using Stats   = SilenceGate::Stats;
+using Verdict = SilenceGate::Verdict;
+
+static constexpr milliseconds frameDuration = 10ms;
+
+SilenceGate::SilenceGate() : SilenceGate(Config()) {
+}
+
+SilenceGate::SilenceGate(const Config &config) : m_p(new P(config)) {
+}
+
+SilenceGate::~SilenceGate() = default;
+
+SilenceGate::operator bool() const {
+	return static_cast< bool >(m_p);
+}
+
+Config SilenceGate::config() const {
+	CHECK
+
+	return m_p->m_config;
+}
+
+void SilenceGate::setConfig(const Config &config) {
+	if (*this) {
+		m_p->m_config = config;
+	}
+}
+
+bool SilenceGate::open() const {
+	CHECK
+
+	return m_p->m_open;
+}
+
+Stats SilenceGate::stats() const {
+	CHECK
+
+	return m_p->m_stats;
+}
+
+Verdict SilenceGate::operator()(const udp::Message::Audio &audio) {
+	return (*this)(audio.frameNumber, audio.opusData, audio.isTerminator);
+}
+
+Verdict SilenceGate::operator()(const uint64_t number, const BufViewConst packet, const bool terminator) {
+	if (!*this) {
+		return Verdict::Forward;
+	}
+
+	const auto verdict = m_p->process(number, packet, terminator);
+
+	if (verdict == Verdict::Drop) {
+		++m_p->m_stats.dropped;
+		m_p->m_stats.bytesSaved += packet.size();
+	} else {
+		++m_p->m_stats.forwarded;
+	}
+
+	return verdict;
+}
+
+void SilenceGate::reset() {
+	if (*this) {
+		m_p->m_open = false;
+		m_p->m_quietSince.reset();
+		m_p->m_keptAlive.reset();
+	}
+}
+
+Class SilenceGate::classify(const Opus::PacketInfo &info, const uint8_t quietBytes) {
+	if (!info) {
+		return Class::Speech;
+	}
+
+	// An encoder in DTX sends a frame of 1 or 2 bytes every now and then, a decoder treats 0 bytes like a loss.
+	if (info.largestFrame <= 2) {
+		return Class::DTX;
+	}
+
+	const uint32_t frames = std::max< uint32_t >(info.samples / P::frameSamples, 1);
+
+	return info.payload < quietBytes * frames ? Class::Quiet : Class::Speech;
+}
+
+P::P(const Config &config) : m_config(config), m_open(false) {
+}
+
+Verdict P::process(const uint64_t number, const BufViewConst packet, const bool terminator) {
+	if (!m_config.enabled) {
+		return Verdict::Forward;
+	}
+
+	// A terminator without audio only matters to the listeners if they are hearing the speaker.
+	if (packet.empty()) {
+		const auto verdict = m_open ? Verdict::Forward : Verdict::Drop;
+
+		if (terminator) {
+			m_open = false;
+			m_quietSince.reset();
+		}
+
+		return verdict;
+	}
+
+	const auto info = Opus::inspect(packet);
+
+	Verdict verdict;
+
+	if (classify(info, m_config.quietBytes) == Class::Speech) {
+		m_open = true;
+		m_quietSince.reset();
+		m_keptAlive.reset();
+
+		verdict = Verdict::Forward;
+	} else {
+		verdict = quiet(number, number + std::max< uint32_t >(info.samples / frameSamples, 1));
+	}
+
+	// The speaker ended the spurt themselves, the next one starts from a closed gate.
+	if (terminator) {
+		m_open = false;
+		m_quietSince.reset();
+	}
+
+	return verdict;
+}
+
+Verdict P::quiet(const uint64_t number, const uint64_t end) {
+	if (m_open) {
+		if (!m_quietSince || number < *m_quietSince) {
+			m_quietSince = number;
+		}
+
+		if (end - *m_quietSince < static_cast< uint64_t >(m_config.hangover / frameDuration)) {
+			return Verdict::Forward;
+		}
+
+		m_open = false;
+		m_quietSince.reset();
+		m_keptAlive = number;
+
+		return Verdict::Terminate;
+	}
+
+	const auto keepAlive = static_cast< uint64_t >(m_config.keepAlive / frameDuration);
+
+	if (keepAlive && (!m_keptAlive || number >= *m_keptAlive + keepAlive)) {
+		m_keptAlive = number;
+		return Verdict::Terminate;
+	}
+
+	return Verdict::Drop;
+}
@@ -0,0 +1,43 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_SILENCEGATE_HPP
+#define MUMBLE_SRC_SILENCEGATE_HPP
+
+#include "mumble/SilenceGate.hpp"
+
+#include "mumble/Types.hpp"
+
+#include <cstdint>
+#include <optional>
+
+namespace mumble {
+class SilenceGate::P {
+	friend SilenceGate;
+
+public:
+	// Samples in a 10 ms frame, Opus packets are always parsed at 48 kHz.
+	static constexpr uint32_t frameSamples = 480;
+
+	P(const Config &config);
+	~P() = default;
+
+	Verdict process(const uint64_t number, const BufViewConst packet, const bool terminator);
+
+private:
+	Verdict quiet(const uint64_t number, const uint64_t end);
+
+	Config m_config;
+	Stats m_stats;
+
+	bool m_open;
+	// Frame number the speaker went quiet at, while the gate is open.
+	std::optional< uint64_t > m_quietSince;
+	// Frame number of the last quiet packet let through, while the gate is closed.
+	std::optional< uint64_t > m_keptAlive;
+};
+} // namespace mumble
+
+#endif
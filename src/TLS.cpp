@@ -7,6 +7,7 @@
 
 #include "mumble/Cert.hpp"
 #include "mumble/Key.hpp"
+#include "mumble/TrustStore.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -19,6 +20,7 @@
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
 
 using namespace mumble;
 
@@ -26,7 +28,8 @@ using Code = SocketTLS::Code;
 
 SocketTLS::SocketTLS(SocketTLS &&socket)
 	: SocketTCP(std::move(socket)), m_ssl(std::exchange(socket.m_ssl, nullptr)),
-	  m_sslCtx(std::exchange(socket.m_sslCtx, nullptr)), m_closed(socket.m_closed.load()) {
+	  m_sslCtx(std::exchange(socket.m_sslCtx, nullptr)), m_trustStore(std::move(socket.m_trustStore)),
+	  m_closed(socket.m_closed.load()) {
 }
 
 SocketTLS::SocketTLS(const int32_t handle, const bool server)
@@ -94,6 +97,20 @@ bool SocketTLS::setCert(const Cert::Chain &cert, const Key &key) {
 	return true;
 }
 
+bool SocketTLS::setTrustStore(const std::shared_ptr< TrustStore > &store) {
+	if (store && !*store) {
+		return false;
+	}
+
+	m_trustStore = store;
+
+	// The store is passed instead of this object because the latter can be moved.
+	// Replaces OpenSSL's verification entirely, so that TrustStore can skip it for chains it already verified.
+	SSL_CTX_set_cert_verify_callback(m_sslCtx, store ? verifyChain : nullptr, store.get());
+
+	return true;
+}
+
 Cert::Chain SocketTLS::peerCert() const {
 	Cert::Chain cert;
 
@@ -204,3 +221,51 @@ uint32_t SocketTLS::pending() const {
 int SocketTLS::verifyCallback(int, X509_STORE_CTX *) {
 	return 1;
 }
+
+int SocketTLS::verifyChain(X509_STORE_CTX *ctx, void *store) {
+	Cert::Chain chain;
+
+	const auto leaf = X509_STORE_CTX_get0_cert(ctx);
+	if (!leaf || !X509_up_ref(leaf)) {
+		return 0;
+	}
+
+	chain.emplace_back(leaf);
+
+	// The leaf is usually part of the untrusted certificates too.
+	const auto untrusted = X509_STORE_CTX_get0_untrusted(ctx);
+	for (int i = 0; i < sk_X509_num(untrusted); ++i) {
+		const auto x509 = sk_X509_value(untrusted, i);
+		if (x509 != leaf && X509_up_ref(x509)) {
+			chain.emplace_back(x509);
+		}
+	}
+
+	// The connection's parameters (e.g. the host name to match) are already set on the context, by the TLS
+	// implementation. On the server side the peer is a client, its certificate has to be meant for that.
+	const auto ssl     = static_cast< SSL * >(X509_STORE_CTX_get_ex_data(ctx, SSL_get_ex_data_X509_STORE_CTX_idx()));
+	const auto purpose = ssl && SSL_is_server(ssl) ? TrustStore::Purpose::Client : TrustStore::Purpose::Server;
+
+	const auto verified = static_cast< TrustStore * >(store)->verify(chain, purpose, X509_STORE_CTX_get0_param(ctx));
+	if (verified.empty()) {
+		X509_STORE_CTX_set_error(ctx, X509_V_ERR_CERT_UNTRUSTED);
+		return 0;
+	}
+
+	// Retrieved by SSL_get0_verified_chain().
+	auto stack = sk_X509_new_null();
+	if (!stack) {
+		return 0;
+	}
+
+	for (const auto &cert : verified) {
+		const auto x509 = static_cast< X509 * >(cert.handle());
+		if (X509_up_ref(x509)) {
+			sk_X509_push(stack, x509);
+		}
+	}
+
+	X509_STORE_CTX_set0_verified_chain(ctx, stack);
+
+	return 1;
+}
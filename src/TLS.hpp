@@ -14,10 +14,13 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
 
 #include <openssl/ossl_typ.h>
 
 namespace mumble {
+class TrustStore;
+
 class SocketTLS : public SocketTCP {
 public:
 	enum Code : int8_t { Memory = -3, Failure, Unknown, Success, Retry, Shutdown, WaitIn, WaitOut };
@@ -31,6 +34,8 @@ public:
 	bool isServer() const;
 
 	bool setCert(const Cert::Chain &cert, const Key &key);
+	// Without a trust store, any certificate is accepted.
+	bool setTrustStore(const std::shared_ptr< TrustStore > &store);
 
 	Cert::Chain peerCert() const;
 
@@ -46,9 +51,11 @@ public:
 private:
 	Code interpretLibCode(const int code, const bool processed = true, const bool remaining = false);
 	static int verifyCallback(int, X509_STORE_CTX *);
+	static int verifyChain(X509_STORE_CTX *ctx, void *store);
 
 	SSL *m_ssl;
 	SSL_CTX *m_sslCtx;
+	std::shared_ptr< TrustStore > m_trustStore;
 	std::atomic_bool m_closed;
 };
 } // namespace mumble
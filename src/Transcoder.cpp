@@ -0,0 +1,379 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Transcoder.hpp"
+
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <utility>
+
+#ifndef MUMBLE_COMPILER_MSVC
+#	include <quickpool.hpp>
+#else
+#	pragma warning(push)
+#	pragma warning(disable : 4244)
+#	pragma warning(disable : 4324)
+#	include <quickpool.hpp>
+#	pragma warning(pop)
+#endif
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+using namespace mumble;
+
+using P = Transcoder::P;
+
+using FloatViewConst = Opus::FloatViewConst;
+using Packets        = Transcoder::Packets;
+using Stats          = Transcoder::Stats;
+using Variant        = Transcoder::Variant;
+
+static constexpr uint32_t sampleRate = 48000;
+
+Transcoder::Transcoder(const std::vector< Variant > &variants, const uint8_t channels, const uint32_t streamsMax,
+					   const uint32_t threads)
+	: m_p(new P(variants, channels, streamsMax, threads)) {
+}
+
+Transcoder::~Transcoder() = default;
+
+Transcoder::operator bool() const {
+	return m_p && !m_p->m_variants.empty() && m_p->m_decoders && m_p->m_encoders;
+}
+
+uint8_t Transcoder::channels() const {
+	CHECK
+
+	return m_p->m_channels;
+}
+
+size_t Transcoder::variants() const {
+	CHECK
+
+	return m_p->m_variants.size();
+}
+
+Variant Transcoder::variant(const size_t index) const {
+	CHECK
+
+	return index < m_p->m_variants.size() ? m_p->m_variants[index] : Variant();
+}
+
+std::optional< size_t > Transcoder::select(const uint32_t bandwidth, const uint32_t bitrate) const {
+	CHECK
+
+	if (bitrate && bitrate <= bandwidth) {
+		return {};
+	}
+
+	std::optional< size_t > best;
+	size_t lowest = 0;
+
+	for (size_t i = 0; i < m_p->m_variants.size(); ++i) {
+		const auto rate = m_p->m_variants[i].bitrate;
+
+		if (rate < m_p->m_variants[lowest].bitrate) {
+			lowest = i;
+		}
+
+		if (rate <= bandwidth && (!best || rate > m_p->m_variants[*best].bitrate)) {
+			best = i;
+		}
+	}
+
+	return best ? *best : lowest;
+}
+
+bool Transcoder::addStream(const uint32_t id) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	if (m_p->m_streams.size() >= m_p->m_streamsMax || m_p->m_streams.count(id)) {
+		return false;
+	}
+
+	auto decoder = m_p->m_decoders.acquire();
+	if (!decoder) {
+		return false;
+	}
+
+	auto stream     = std::make_unique< P::Stream >();
+	stream->decoder = std::move(decoder);
+	stream->pcm.resize(Opus::packetSamplesMax * m_p->m_channels);
+	stream->outputs.resize(m_p->m_variants.size());
+
+	m_p->m_streams.emplace(id, std::move(stream));
+	m_p->update();
+
+	return true;
+}
+
+bool Transcoder::removeStream(const uint32_t id) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	if (!m_p->m_streams.erase(id)) {
+		return false;
+	}
+
+	m_p->update();
+
+	return true;
+}
+
+size_t Transcoder::streams() const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	return m_p->m_streams.size();
+}
+
+bool Transcoder::subscribe(const uint32_t id, const size_t variant) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend() || variant >= m_p->m_variants.size()) {
+		return false;
+	}
+
+	auto &output = iter->second->outputs[variant];
+
+	if (!output.encoder) {
+		const auto &config = m_p->m_variants[variant];
+
+		auto encoder = m_p->m_encoders.acquire();
+		if (!encoder || !encoder->setPreset(config.preset) || !encoder->setBitrate(config.bitrate)
+			|| !encoder->toggleFEC(config.fec) || !encoder->setPacketLoss(config.packetLoss)) {
+			return false;
+		}
+
+		output.encoder = std::move(encoder);
+	}
+
+	++output.subscribers;
+
+	return true;
+}
+
+bool Transcoder::unsubscribe(const uint32_t id, const size_t variant) {
+	CHECK
+
+	const std::unique_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend() || variant >= m_p->m_variants.size()) {
+		return false;
+	}
+
+	auto &output = iter->second->outputs[variant];
+	if (!output.subscribers) {
+		return false;
+	}
+
+	if (!--output.subscribers) {
+		output.encoder.reset();
+		output.packets.clear();
+	}
+
+	return true;
+}
+
+uint32_t Transcoder::subscribers(const uint32_t id, const size_t variant) const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend() || variant >= m_p->m_variants.size()) {
+		return 0;
+	}
+
+	return iter->second->outputs[variant].subscribers;
+}
+
+bool Transcoder::push(const uint32_t id, const udp::Message::Audio &audio) {
+	return push(id, audio.frameNumber, audio.opusData, audio.isTerminator);
+}
+
+bool Transcoder::push(const uint32_t id, const uint64_t number, const BufViewConst packet, const bool terminator) {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend()) {
+		return false;
+	}
+
+	auto &stream = *iter->second;
+
+	const std::unique_lock< std::mutex > streamLock(stream.mutex);
+
+	if (stream.pendingCount == stream.pending.size()) {
+		stream.pending.emplace_back();
+	}
+
+	auto &input = stream.pending[stream.pendingCount++];
+
+	input.number     = number;
+	input.terminator = terminator;
+	input.data.assign(packet.begin(), packet.end());
+
+	return true;
+}
+
+size_t Transcoder::process() {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	std::atomic< size_t > decoded(0);
+
+	m_p->m_pool->parallel_for_each(m_p->m_streamList, [this, &decoded](P::Stream *stream) {
+		const auto start = std::chrono::steady_clock::now();
+
+		decoded += m_p->process(*stream);
+
+		stream->stats.time += std::chrono::steady_clock::now() - start;
+	});
+
+	return decoded;
+}
+
+Packets Transcoder::output(const uint32_t id, const size_t variant) const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend() || variant >= m_p->m_variants.size()) {
+		return {};
+	}
+
+	return iter->second->outputs[variant].packets;
+}
+
+Stats Transcoder::stats(const uint32_t id) const {
+	CHECK
+
+	const std::shared_lock< std::shared_mutex > lock(m_p->m_mutex);
+
+	const auto iter = m_p->m_streams.find(id);
+	if (iter == m_p->m_streams.cend()) {
+		return {};
+	}
+
+	return iter->second->stats;
+}
+
+P::P(const std::vector< Variant > &variants, const uint8_t channels, const uint32_t streamsMax,
+	 const uint32_t threads)
+	: m_variants(variants), m_channels(channels), m_streamsMax(streamsMax),
+	  m_decoders(channels, sampleRate, streamsMax), m_encoders(channels, sampleRate, streamsMax * variants.size()),
+	  m_pool(threads ? std::make_unique< quickpool::ThreadPool >(threads)
+					 : std::make_unique< quickpool::ThreadPool >()) {
+	m_streams.reserve(streamsMax);
+	m_streamList.reserve(streamsMax);
+}
+
+P::~P() = default;
+
+size_t P::process(Stream &stream) {
+	{
+		const std::unique_lock< std::mutex > lock(stream.mutex);
+
+		std::swap(stream.pending, stream.inputs);
+		stream.inputCount   = stream.pendingCount;
+		stream.pendingCount = 0;
+	}
+
+	// The packets point into the buffers, which must not move while they're filled.
+	for (auto &output : stream.outputs) {
+		output.packets.clear();
+
+		if (output.encoder && output.buffers.size() < stream.inputCount) {
+			output.buffers.resize(stream.inputCount);
+		}
+	}
+
+	size_t decoded = 0;
+
+	for (size_t i = 0; i < stream.inputCount; ++i) {
+		const auto &input = stream.inputs[i];
+
+		FloatViewConst pcm;
+
+		if (!input.data.empty()) {
+			pcm = (*stream.decoder)(stream.pcm, input.data);
+			if (pcm.empty()) {
+				++stream.stats.failed;
+			} else {
+				++stream.stats.decoded;
+				++decoded;
+
+				stream.stats.bytes += input.data.size();
+				stream.stats.duration +=
+					std::chrono::microseconds(pcm.size() / m_channels * uint64_t(1000000) / sampleRate);
+			}
+		}
+
+		for (auto &output : stream.outputs) {
+			if (output.encoder) {
+				encode(stream, output, input, pcm);
+			}
+		}
+	}
+
+	return decoded;
+}
+
+void P::encode(Stream &stream, Output &output, const Input &input, const FloatViewConst pcm) {
+	// A terminator still ends the talk spurt when it carries no audio (or audio that couldn't be decoded).
+	if (pcm.empty()) {
+		if (input.terminator) {
+			output.packets.push_back({ input.number, true, {} });
+		}
+
+		return;
+	}
+
+	auto &buffer = output.buffers[output.packets.size()];
+
+	const auto packet = (*output.encoder)(buffer, pcm);
+	if (packet.empty()) {
+		++stream.stats.failed;
+		return;
+	}
+
+	++stream.stats.encoded;
+
+	output.packets.push_back({ input.number, input.terminator, packet });
+}
+
+void P::update() {
+	m_streamList.clear();
+	for (const auto &iter : m_streams) {
+		m_streamList.push_back(iter.second.get());
+	}
+}
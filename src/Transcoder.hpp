@@ -0,0 +1,89 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_TRANSCODER_HPP
+#define MUMBLE_SRC_TRANSCODER_HPP
+
+#include "mumble/Transcoder.hpp"
+
+#include "mumble/JitterBuffer.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace quickpool {
+class ThreadPool;
+}
+
+namespace mumble {
+class Transcoder::P {
+	friend Transcoder;
+
+public:
+	static constexpr size_t packetSizeMax = JitterBuffer::packetSizeMax;
+
+	struct Input {
+		uint64_t number;
+		bool terminator;
+		Buf data;
+	};
+
+	struct Output {
+		Opus::EncoderPool::Ptr encoder;
+		uint32_t subscribers = 0;
+		// Only the first "count" buffers are used, the others are kept for the next calls.
+		std::vector< FixedBuf< packetSizeMax > > buffers;
+		std::vector< Packet > packets;
+	};
+
+	struct Stream {
+		Opus::DecoderPool::Ptr decoder;
+		std::vector< float > pcm;
+		std::vector< Output > outputs;
+		Stats stats;
+
+		// Filled by push(), swapped with "inputs" by process(). The buffers are reused, only the first "count" inputs
+		// are valid.
+		std::mutex mutex;
+		std::vector< Input > pending;
+		size_t pendingCount = 0;
+		std::vector< Input > inputs;
+		size_t inputCount = 0;
+	};
+
+	P(const std::vector< Variant > &variants, const uint8_t channels, const uint32_t streamsMax,
+	  const uint32_t threads);
+	~P();
+
+private:
+	// Returns the number of packets that were decoded.
+	size_t process(Stream &stream);
+	void encode(Stream &stream, Output &output, const Input &input, const Opus::FloatViewConst pcm);
+
+	// Rebuilds the list iterated by process(), called with the lock held exclusively.
+	void update();
+
+	std::vector< Variant > m_variants;
+	uint8_t m_channels;
+	uint32_t m_streamsMax;
+
+	Opus::DecoderPool m_decoders;
+	Opus::EncoderPool m_encoders;
+	std::unique_ptr< quickpool::ThreadPool > m_pool;
+
+	mutable std::shared_mutex m_mutex;
+	std::unordered_map< uint32_t, std::unique_ptr< Stream > > m_streams;
+	std::vector< Stream * > m_streamList;
+};
+} // namespace mumble
+
+#endif
@@ -0,0 +1,305 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "TrustStore.hpp"
+
+#include "mumble/Hash.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+#define CHECK      \
+	if (!*this) {  \
+		return {}; \
+	}
+
+#define CAST_SIZE(var) (static_cast< int >(var))
+
+using namespace mumble;
+
+using P = TrustStore::P;
+
+using Purpose = TrustStore::Purpose;
+
+// Everything that can make the verification of the same chain succeed or fail.
+static Buf serialize(const Purpose purpose, const X509_VERIFY_PARAM *params) {
+	Buf buf;
+
+	const auto append = [&buf](const void *data, const size_t size) {
+		const auto bytes = static_cast< const std::byte * >(data);
+		buf.insert(buf.end(), bytes, bytes + size);
+	};
+
+	// With the terminator, so that consecutive strings can't be mistaken for others.
+	const auto appendString = [&append](const char *str) { append(str ? str : "", str ? std::strlen(str) + 1 : 1); };
+
+	append(&purpose, sizeof(purpose));
+
+	if (!params) {
+		return buf;
+	}
+
+	const unsigned long flags    = X509_VERIFY_PARAM_get_flags(params);
+	const unsigned int hostFlags = X509_VERIFY_PARAM_get_hostflags(params);
+	const int depth              = X509_VERIFY_PARAM_get_depth(params);
+	const int level              = X509_VERIFY_PARAM_get_auth_level(params);
+
+	append(&flags, sizeof(flags));
+	append(&hostFlags, sizeof(hostFlags));
+	append(&depth, sizeof(depth));
+	append(&level, sizeof(level));
+
+	if (flags & X509_V_FLAG_USE_CHECK_TIME) {
+		const time_t time = X509_VERIFY_PARAM_get_time(params);
+		append(&time, sizeof(time));
+	}
+
+	// The getters only take a non-const pointer, they don't modify anything.
+	const auto param = const_cast< X509_VERIFY_PARAM * >(params);
+
+	const char *host;
+	for (int i = 0; (host = X509_VERIFY_PARAM_get0_host(param, i)); ++i) {
+		appendString(host);
+	}
+
+	// Host names are never empty, an empty string marks the end of the list.
+	appendString(nullptr);
+	appendString(X509_VERIFY_PARAM_get0_email(param));
+
+	const auto ip = X509_VERIFY_PARAM_get1_ip_asc(param);
+	appendString(ip);
+	OPENSSL_free(ip);
+
+	return buf;
+}
+
+static bool setParams(X509_STORE_CTX *ctx, const Purpose purpose, const X509_VERIFY_PARAM *params) {
+	// Named after the peer, the same defaults that the TLS implementation uses.
+	switch (purpose) {
+		case Purpose::Any:
+			break;
+		case Purpose::Client:
+			if (X509_STORE_CTX_set_default(ctx, "ssl_client") <= 0) {
+				return false;
+			}
+
+			break;
+		case Purpose::Server:
+			if (X509_STORE_CTX_set_default(ctx, "ssl_server") <= 0) {
+				return false;
+			}
+
+			break;
+	}
+
+	return !params || X509_VERIFY_PARAM_set1(X509_STORE_CTX_get0_param(ctx), params) > 0;
+}
+
+TrustStore::TrustStore() : m_p(new P) {
+}
+
+TrustStore::~TrustStore() = default;
+
+TrustStore::operator bool() const {
+	return m_p && m_p->m_store;
+}
+
+void *TrustStore::handle() const {
+	CHECK
+
+	return m_p->m_store;
+}
+
+bool TrustStore::add(const Cert &cert) {
+	CHECK
+
+	return cert ? X509_STORE_add_cert(m_p->m_store, static_cast< X509 * >(cert.handle())) > 0 : false;
+}
+
+bool TrustStore::addPEM(const std::string_view pem) {
+	CHECK
+
+	return m_p->addPEM(pem);
+}
+
+bool TrustStore::addDefaultPaths() {
+	CHECK
+
+	return X509_STORE_set_default_paths(m_p->m_store) > 0;
+}
+
+Cert::Chain TrustStore::verify(const Cert::Chain &chain, const Purpose purpose, const void *params) {
+	CHECK
+
+	if (chain.empty() || !chain[0]) {
+		return {};
+	}
+
+	const auto param = static_cast< const X509_VERIFY_PARAM * >(params);
+
+	auto key = P::key(chain, purpose, param);
+	if (key.first.empty() || key.second.empty()) {
+		return {};
+	}
+
+	{
+		const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+		const auto iter = m_p->m_cache.find(key);
+		if (iter != m_p->m_cache.cend()) {
+			if (std::chrono::system_clock::now() < iter->second.expiry) {
+				return iter->second.chain;
+			}
+
+			m_p->m_cache.erase(iter);
+		}
+	}
+
+	auto verified = m_p->verify(chain, purpose, param);
+	if (!verified.empty()) {
+		m_p->cache(std::move(key), verified);
+	}
+
+	return verified;
+}
+
+size_t TrustStore::cacheSize() const {
+	CHECK
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	return m_p->m_cache.size();
+}
+
+void TrustStore::clearCache() {
+	if (!*this) {
+		return;
+	}
+
+	const std::lock_guard< std::mutex > lock(m_p->m_mutex);
+
+	m_p->m_cache.clear();
+}
+
+P::P() : m_store(X509_STORE_new()) {
+}
+
+P::~P() {
+	if (m_store) {
+		X509_STORE_free(m_store);
+	}
+}
+
+P::Key P::key(const Cert::Chain &chain, const Purpose purpose, const X509_VERIFY_PARAM *params) {
+	auto &hash = Hash::local("SHA256");
+
+	for (auto iter = std::next(chain.cbegin()); iter != chain.cend(); ++iter) {
+		if (!hash.update(iter->fingerprint())) {
+			return {};
+		}
+	}
+
+	if (!hash.update(serialize(purpose, params))) {
+		return {};
+	}
+
+	Cert::Der chainHash(hash.final({}));
+	if (!hash.final(chainHash)) {
+		return {};
+	}
+
+	return { chain[0].fingerprint(), std::move(chainHash) };
+}
+
+bool P::addPEM(const std::string_view pem) {
+	auto bio = BIO_new_mem_buf(pem.data(), CAST_SIZE(pem.size()));
+	if (!bio) {
+		return false;
+	}
+
+	size_t added = 0;
+
+	while (auto x509 = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) {
+		if (X509_STORE_add_cert(m_store, x509) > 0) {
+			++added;
+		}
+
+		X509_free(x509);
+	}
+
+	BIO_free_all(bio);
+
+	return added;
+}
+
+Cert::Chain P::verify(const Cert::Chain &chain, const Purpose purpose, const X509_VERIFY_PARAM *params) {
+	auto ctx       = X509_STORE_CTX_new();
+	auto untrusted = sk_X509_new_null();
+
+	Cert::Chain verified;
+
+	if (ctx && untrusted) {
+		std::for_each(std::next(chain.cbegin()), chain.cend(),
+					  [untrusted](const Cert &cert) { sk_X509_push(untrusted, static_cast< X509 * >(cert.handle())); });
+
+		if (X509_STORE_CTX_init(ctx, m_store, static_cast< X509 * >(chain[0].handle()), untrusted) > 0
+			&& setParams(ctx, purpose, params) && X509_verify_cert(ctx) > 0) {
+			auto stack = X509_STORE_CTX_get1_chain(ctx);
+
+			// The references taken by X509_STORE_CTX_get1_chain() are passed to the Cert instances.
+			for (int i = 0; i < sk_X509_num(stack); ++i) {
+				verified.emplace_back(sk_X509_value(stack, i));
+			}
+
+			sk_X509_free(stack);
+		}
+	}
+
+	if (untrusted) {
+		sk_X509_free(untrusted);
+	}
+
+	if (ctx) {
+		X509_STORE_CTX_free(ctx);
+	}
+
+	return verified;
+}
+
+void P::cache(Key &&key, const Cert::Chain &chain) {
+	Verdict verdict{ chain, Cert::TimePoint::max() };
+	for (const auto &cert : chain) {
+		verdict.expiry = std::min(verdict.expiry, cert.until());
+	}
+
+	const auto now = std::chrono::system_clock::now();
+
+	const std::lock_guard< std::mutex > lock(m_mutex);
+
+	if (m_cache.size() >= cacheSizeMax) {
+		for (auto iter = m_cache.begin(); iter != m_cache.end();) {
+			iter = iter->second.expiry > now ? std::next(iter) : m_cache.erase(iter);
+		}
+	}
+
+	if (m_cache.size() >= cacheSizeMax) {
+		m_cache.erase(std::min_element(m_cache.cbegin(), m_cache.cend(), [](const auto &a, const auto &b) {
+			return a.second.expiry < b.second.expiry;
+		}));
+	}
+
+	m_cache.insert_or_assign(std::move(key), std::move(verdict));
+}
@@ -0,0 +1,52 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_SRC_TRUSTSTORE_HPP
+#define MUMBLE_SRC_TRUSTSTORE_HPP
+
+#include "mumble/TrustStore.hpp"
+
+#include "mumble/Cert.hpp"
+
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <utility>
+
+#include <openssl/ossl_typ.h>
+
+namespace mumble {
+class TrustStore::P {
+	friend TrustStore;
+
+public:
+	P();
+	~P();
+
+private:
+	// Fingerprint of the leaf and hash of the fingerprints of the other certificates and of the parameters.
+	using Key = std::pair< Cert::Der, Cert::Der >;
+
+	struct Verdict {
+		Cert::Chain chain;
+		// When the first certificate in the chain expires.
+		Cert::TimePoint expiry;
+	};
+
+	static Key key(const Cert::Chain &chain, const Purpose purpose, const X509_VERIFY_PARAM *params);
+
+	bool addPEM(const std::string_view pem);
+
+	Cert::Chain verify(const Cert::Chain &chain, const Purpose purpose, const X509_VERIFY_PARAM *params);
+
+	void cache(Key &&key, const Cert::Chain &chain);
+
+	X509_STORE *m_store;
+	std::map< Key, Verdict > m_cache;
+	mutable std::mutex m_mutex;
+};
+} // namespace mumble
+
+#endif
@@ -30,7 +30,7 @@ using namespace mumble;
 SocketUDP::SocketUDP() : Socket(Type::UDP) {
 }
 
-Code SocketUDP::read(Endpoint &endpoint, BufView &buf) {
+Code SocketUDP::read(EndpointV &endpoint, BufView &buf) {
 	sockaddr_in6 addr;
 #ifdef OS_WINDOWS
 	auto addrsize = static_cast< int >(sizeof(addr));
@@ -44,7 +44,7 @@ Code SocketUDP::read(Endpoint &endpoint, BufView &buf) {
 		return osErrorToCode(osError());
 	}
 
-	endpoint.ip   = IP(addr);
+	endpoint.ip   = IPValue::fromSockAddr(addr);
 	endpoint.port = Endian::toHost(addr.sin6_port);
 
 	assert(ret >= 0);
@@ -53,7 +53,7 @@ Code SocketUDP::read(Endpoint &endpoint, BufView &buf) {
 	return Code::Success;
 }
 
-Code SocketUDP::write(const Endpoint &endpoint, const BufViewConst buf) {
+Code SocketUDP::write(const EndpointV &endpoint, const BufViewConst buf) {
 	sockaddr_in6 addr = {};
 	endpoint.ip.toSockAddr(addr);
 	addr.sin6_port = Endian::toNetwork(endpoint.port);
@@ -15,8 +15,8 @@ class SocketUDP : public Socket {
 public:
 	SocketUDP();
 
-	Code read(Endpoint &endpoint, BufView &buf);
-	Code write(const Endpoint &endpoint, const BufViewConst buf);
+	Code read(EndpointV &endpoint, BufView &buf);
+	Code write(const EndpointV &endpoint, const BufViewConst buf);
 };
 } // namespace mumble
 
@@ -9,6 +9,7 @@
 #include "mumble/Base64.hpp"
 #include "mumble/Types.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
@@ -20,6 +21,10 @@
 #include <boost/thread/interruption.hpp>
 
 static constexpr size_t iterations = 1000000;
+// Big enough for the native implementations to process many blocks.
+static constexpr size_t bigSize = 100000;
+
+static constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 using namespace mumble;
 
@@ -59,6 +64,231 @@ static std::string encode(const Data::Entry &entry) {
 	return ret;
 }
 
+static BufViewConst toView(const std::string_view str) {
+	return { reinterpret_cast< const std::byte * >(str.data()), str.size() };
+}
+
+// Straightforward implementation, to check the optimized ones against.
+static std::string referenceEncode(const Buf &in) {
+	std::string ret;
+
+	for (size_t i = 0; i < in.size(); i += 3) {
+		const auto left = in.size() - i;
+
+		uint32_t group = std::to_integer< uint32_t >(in[i]) << 16;
+		if (left > 1) {
+			group |= std::to_integer< uint32_t >(in[i + 1]) << 8;
+		}
+		if (left > 2) {
+			group |= std::to_integer< uint32_t >(in[i + 2]);
+		}
+
+		ret += alphabet[group >> 18];
+		ret += alphabet[group >> 12 & 0x3F];
+		ret += left > 1 ? alphabet[group >> 6 & 0x3F] : '=';
+		ret += left > 2 ? alphabet[group & 0x3F] : '=';
+	}
+
+	return ret;
+}
+
+// The one-shot interface returns 0 both on failure and when there's nothing to decode, "first" tells them apart.
+static std::pair< bool, Buf > decode(Base64 &base64, const std::string_view in) {
+	Buf ret(base64.decode({}, toView(in)) + 3);
+
+	const auto written = base64.decode(ret, toView(in));
+	ret.resize(written);
+
+	// An empty output is only valid if there was nothing to decode.
+	if (!written) {
+		return { in.find_first_not_of(" \t\r\n") == std::string_view::npos || in.front() == '-', ret };
+	}
+
+	return { true, ret };
+}
+
+static std::pair< bool, Buf > decodeStream(Base64 &base64, const std::string_view in, std::mt19937 &algorithm) {
+	std::uniform_int_distribution< size_t > gen(0, 100);
+
+	Buf ret(in.size() / 4 * 3 + 3);
+	size_t written = 0;
+
+	for (size_t offset = 0; offset < in.size();) {
+		const auto chunk = std::min(gen(algorithm), in.size() - offset);
+
+		written += base64.decodeUpdate(BufView(ret).subspan(written), toView(in.substr(offset, chunk)));
+		offset += chunk;
+	}
+
+	ret.resize(written);
+
+	return { base64.decodeFinal(), ret };
+}
+
+static std::string encodeStream(Base64 &base64, const Buf &in, std::mt19937 &algorithm) {
+	std::uniform_int_distribution< size_t > gen(0, 100);
+
+	std::string ret(in.size() / 3 * 4 + 4, '\0');
+	const BufView out(reinterpret_cast< std::byte * >(ret.data()), ret.size());
+	size_t written = 0;
+
+	for (size_t offset = 0; offset < in.size();) {
+		const auto chunk = std::min(gen(algorithm), in.size() - offset);
+
+		written += base64.encodeUpdate(out.subspan(written), BufViewConst(in).subspan(offset, chunk));
+		offset += chunk;
+	}
+
+	written += base64.encodeFinal(out.subspan(written));
+	ret.resize(written);
+
+	return ret;
+}
+
+static std::string encodeBuf(const Buf &in) {
+	std::string ret(Base64::encode({}, in), '\0');
+
+	const auto written = Base64::encode({ reinterpret_cast< std::byte * >(ret.data()), ret.size() }, in);
+	if (!written || ret[written - 1] != '\0') {
+		return {};
+	}
+
+	ret.resize(written - 1);
+
+	return ret;
+}
+
+// Random data of all sizes up to a few blocks and a big one, through both interfaces.
+static uint8_t testRoundTrip() {
+	Base64 base64;
+
+	std::random_device device;
+	std::mt19937 algorithm(device());
+	std::uniform_int_distribution< uint32_t > gen(0, UINT8_MAX);
+
+	for (size_t size = 0; size <= 200 + 1; ++size) {
+		Buf data(size > 200 ? bigSize : size);
+		for (auto &byte : data) {
+			byte = static_cast< std::byte >(gen(algorithm));
+		}
+
+		const auto expected = referenceEncode(data);
+
+		if (encodeBuf(data) != expected) {
+			return 10;
+		}
+
+		if (encodeStream(base64, data, algorithm) != expected) {
+			return 11;
+		}
+
+		auto decoded = decode(base64, expected);
+		if (!decoded.first || decoded.second != data) {
+			return 12;
+		}
+
+		decoded = decodeStream(base64, expected, algorithm);
+		if (!decoded.first || decoded.second != data) {
+			return 13;
+		}
+
+		// Whitespace is skipped wherever it is, including between the padding characters.
+		std::string spaced;
+		for (size_t i = 0; i < expected.size(); ++i) {
+			spaced += expected[i];
+			if (i % 64 == 63) {
+				spaced += "\r\n";
+			} else if (gen(algorithm) < 8) {
+				spaced += " \t\n\r"[gen(algorithm) % 4];
+			}
+		}
+
+		decoded = decode(base64, spaced);
+		if (!decoded.first || decoded.second != data) {
+			return 14;
+		}
+
+		decoded = decodeStream(base64, spaced, algorithm);
+		if (!decoded.first || decoded.second != data) {
+			return 15;
+		}
+
+		// Everything after '-' is ignored.
+		decoded = decode(base64, expected + "-" + spaced.substr(0, 7) + "*");
+		if (!decoded.first || decoded.second != data) {
+			return 16;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testErrors() {
+	Base64 base64;
+
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	using Case = std::pair< std::string_view, bool >;
+
+	constexpr std::array< Case, 17 > cases = {
+		Case("QUJD", true),      Case(" Q U J D \n", true), Case("QQ==", true),   Case("QUI=", true),
+		Case("QUJD-QQ", true),   Case("-QUJD", true),       Case("QQ= =", true),  Case("QUJ", false),
+		Case("QUJDQ", false),    Case("QQ===", false),      Case("Q===", false),  Case("QQ==QUJD", false),
+		Case("QUI=D", false),    Case("QU*D", false),       Case("QUI-", false),  Case("QUJD\x80" "AAA", false),
+		Case("QUJD\vAAA", false)
+	};
+
+	for (const auto &entry : cases) {
+		if (decode(base64, entry.first).first != entry.second) {
+			return 20;
+		}
+
+		if (decodeStream(base64, entry.first, algorithm).first != entry.second) {
+			return 21;
+		}
+	}
+
+	// An invalid character anywhere in a big input, so that it's also found by the native implementations.
+	std::string big(bigSize, 'A');
+	for (size_t pos = 0; pos < 200; ++pos) {
+		auto invalid = big;
+		invalid[pos] = '.';
+
+		if (decode(base64, invalid).first) {
+			return 22;
+		}
+	}
+
+	// Every byte outside of the alphabet, other than whitespace and the special characters, is rejected.
+	for (uint32_t byte = 0; byte <= UINT8_MAX; ++byte) {
+		const auto chr = static_cast< char >(byte);
+		if (alphabet.find(chr) != std::string_view::npos
+			|| std::string_view(" \t\r\n=-").find(chr) != std::string_view::npos) {
+			continue;
+		}
+
+		auto invalid = big;
+		invalid[100] = chr;
+
+		if (decode(base64, invalid).first) {
+			return 23;
+		}
+	}
+
+	// Too small output.
+	Buf out(2);
+	if (base64.decode(out, toView("QUJD"))) {
+		return 24;
+	}
+
+	if (Base64::encode(out, toView("ABC"))) {
+		return 25;
+	}
+
+	return 0;
+}
+
 static uint8_t thread() {
 	Base64 base64;
 
@@ -100,7 +330,15 @@ static uint8_t thread() {
 }
 
 int32_t main() {
-	int32_t ret = 0;
+	int32_t ret = testRoundTrip();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testErrors();
+	if (ret != 0) {
+		return ret;
+	}
 
 	ThreadManager manager;
 
@@ -0,0 +1,216 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "ThreadManager.hpp"
+
+#include "mumble/BitrateLimiter.hpp"
+#include "mumble/Types.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/thread/interruption.hpp>
+
+static constexpr size_t iterations = 1000;
+static constexpr size_t packets    = 100;
+
+// 1000 bytes per second, the bucket holds one second of it.
+static constexpr uint32_t bitrate = 8000;
+
+using namespace mumble;
+
+using namespace std::chrono_literals;
+
+using Policy  = BitrateLimiter::Policy;
+using Verdict = BitrateLimiter::Verdict;
+
+static const BitrateLimiter::TimePoint epoch = BitrateLimiter::Clock::now();
+
+// One 20 ms CELT frame.
+static constexpr std::array< std::byte, 4 > opusPacket = { std::byte(0xF8), std::byte(0x01), std::byte(0x02),
+														   std::byte(0x03) };
+
+// A packet every 100 ms, "size" bytes long. Returns the number of packets that weren't let through.
+static size_t send(BitrateLimiter &limiter, const uint32_t session, const size_t size, const Verdict over,
+				   const std::chrono::milliseconds start = 0ms) {
+	size_t rejected = 0;
+
+	for (size_t i = 0; i < packets; ++i) {
+		const auto verdict = limiter(session, size, epoch + start + 100ms * i);
+		if (verdict != Verdict::Pass) {
+			if (verdict != over) {
+				return packets + 1;
+			}
+
+			++rejected;
+		}
+	}
+
+	return rejected;
+}
+
+static uint8_t testBudget() {
+	BitrateLimiter limiter(bitrate);
+	if (!limiter || limiter.bitrate() != bitrate || limiter.policy() != Policy::Drop) {
+		return 1;
+	}
+
+	// Exactly the allowed bitrate.
+	if (send(limiter, 1, 100, Verdict::Drop) != 0) {
+		return 2;
+	}
+
+	// Twice the allowed bitrate: the burst goes through, then half of the packets.
+	const auto dropped = send(limiter, 2, 200, Verdict::Drop);
+	if (dropped < 40 || dropped > 50) {
+		return 3;
+	}
+
+	const auto stats = limiter.stats(2);
+	if (stats.dropped != dropped || stats.passed != packets - dropped || stats.flagged
+		|| stats.bytes != stats.passed * 200) {
+		return 4;
+	}
+
+	// Other sessions are unaffected.
+	if (limiter(3, 1000, epoch) != Verdict::Pass || limiter(3, 1, epoch) != Verdict::Drop
+		|| limiter.sessions() != 3) {
+		return 5;
+	}
+
+	// Starts over with a full bucket.
+	if (!limiter.remove(3) || limiter.remove(3) || limiter(3, 1000, epoch) != Verdict::Pass) {
+		return 6;
+	}
+
+	// No limit.
+	if (!limiter.setBitrate(0) || send(limiter, 4, 10000, Verdict::Drop) != 0) {
+		return 7;
+	}
+
+	// The bucket is full again once a limit is set.
+	if (!limiter.setBitrate(bitrate) || limiter(4, 1000, epoch + 10s) != Verdict::Pass
+		|| limiter(4, 1, epoch + 10s) != Verdict::Drop) {
+		return 8;
+	}
+
+	if (BitrateLimiter(bitrate, Policy::Drop, 0ms)) {
+		return 9;
+	}
+
+	return 0;
+}
+
+static uint8_t testExpiry() {
+	BitrateLimiter limiter(bitrate, Policy::Drop, 1s, 10s);
+
+	if (limiter(1, 1000, epoch) != Verdict::Pass || limiter(2, 1000, epoch) != Verdict::Pass
+		|| limiter.sessions() != 2) {
+		return 10;
+	}
+
+	// Still there before the idle duration, even without sending.
+	if (limiter(2, 1, epoch + 9s) != Verdict::Pass || limiter.sessions() != 2) {
+		return 11;
+	}
+
+	// The first session left without being removed, its bucket goes away with the next sweep.
+	if (limiter(2, 1, epoch + 12s) != Verdict::Pass || limiter.sessions() != 1 || limiter.stats(1).passed
+		|| limiter.stats(2).passed != 3) {
+		return 12;
+	}
+
+	// Disabled, the bucket stays until removed.
+	BitrateLimiter forever(bitrate, Policy::Drop, 1s, 0ms);
+	if (forever(1, 1, epoch) != Verdict::Pass || forever(2, 1, epoch + 24h) != Verdict::Pass
+		|| forever.sessions() != 2) {
+		return 13;
+	}
+
+	return 0;
+}
+
+static uint8_t testPolicy() {
+	BitrateLimiter limiter(bitrate, Policy::Flag);
+
+	// Flagged packets don't take tokens, the same amount of packets go through.
+	const auto flagged = send(limiter, 1, 200, Verdict::Flag);
+	if (flagged < 40 || flagged > 50) {
+		return 20;
+	}
+
+	const auto stats = limiter.stats(1);
+	if (stats.flagged != flagged || stats.dropped || stats.bytes != packets * 200) {
+		return 21;
+	}
+
+	// Malformed Opus data is dropped whatever the policy, a terminator without audio is fine.
+	const BufViewConst empty;
+	const std::array< std::byte, 2 > code3 = { std::byte(0xFB), std::byte(0x00) };
+
+	if (limiter(2, opusPacket, 100, epoch) != Verdict::Pass || limiter(2, empty, 100, epoch) != Verdict::Pass
+		|| limiter(2, code3, 100, epoch) != Verdict::Drop || limiter.stats(2).dropped != 1) {
+		return 22;
+	}
+
+	return 0;
+}
+
+static uint8_t thread(const uint32_t session, BitrateLimiter &limiter) {
+	for (size_t i = 0; i < iterations; ++i) {
+		if (boost::this_thread::interruption_requested()) {
+			return 0;
+		}
+
+		// Within the budget, each session has its own.
+		if (limiter(session, opusPacket, 100, epoch + 100ms * i) != Verdict::Pass) {
+			return 30;
+		}
+	}
+
+	return limiter.stats(session).passed == iterations ? 0 : 31;
+}
+
+int32_t main() {
+	int32_t ret = testBudget();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testExpiry();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testPolicy();
+	if (ret != 0) {
+		return ret;
+	}
+
+	// The threads don't go through the packets in lockstep, a session must not expire while another is further ahead.
+	BitrateLimiter limiter(bitrate, Policy::Drop, 1s, 1h);
+	std::atomic_uint32_t sessions(0);
+
+	ThreadManager manager;
+
+	for (uint32_t i = 0; i < manager.physicalNum(); ++i) {
+		const ThreadManager::ThreadFunc func = [&]() {
+			const auto threadRet = thread(++sessions, limiter);
+			if (threadRet != 0) {
+				ret = threadRet;
+				manager.requestStop();
+			}
+		};
+
+		manager.add(func);
+	}
+
+	manager.wait();
+
+	return ret;
+}
@@ -0,0 +1,36 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_TESTCERT_DATA_HPP
+#define MUMBLE_TESTCERT_DATA_HPP
+
+#include <string_view>
+
+struct Data {
+	// Self-signed, generated with:
+	// openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -days 36500
+	//     -subj "/CN=Test User/O=libmumble/C=IT"
+	static constexpr std::string_view pem = "-----BEGIN CERTIFICATE-----\n"
+											"MIIBwjCCAWegAwIBAgIUGTYey3YJYXLI0sykJ7iYlncTDE8wCgYIKoZIzj0EAwIw\n"
+											"NTESMBAGA1UEAwwJVGVzdCBVc2VyMRIwEAYDVQQKDAlsaWJtdW1ibGUxCzAJBgNV\n"
+											"BAYTAklUMCAXDTI2MTAxOTAzNDYxOFoYDzIxMjYwOTI1MDM0NjE4WjA1MRIwEAYD\n"
+											"VQQDDAlUZXN0IFVzZXIxEjAQBgNVBAoMCWxpYm11bWJsZTELMAkGA1UEBhMCSVQw\n"
+											"WTATBgcqhkjOPQIBBggqhkjOPQMBBwNCAATKwEq+57662+qAJ3/EGUo6eXnEHg7+\n"
+											"Pb7InMeHByWC8tVTCmjrq3B7hCZFRF52mbIzMA17r6+P202usi2aEwqRo1MwUTAd\n"
+											"BgNVHQ4EFgQUBImaofxAeG1xxR4sIwunNvVAJ/swHwYDVR0jBBgwFoAUBImaofxA\n"
+											"eG1xxR4sIwunNvVAJ/swDwYDVR0TAQH/BAUwAwEB/zAKBggqhkjOPQQDAgNJADBG\n"
+											"AiEAuiop1sLZfrTs6GjRR6pV/GmsksRb30xK9hrCMUw61k4CIQCwHicUSpyW28fD\n"
+											"wNYUAnHMmOl0bkWhRHWfAK1i9DoWNg==\n"
+											"-----END CERTIFICATE-----\n";
+
+	static constexpr std::string_view sha1   = "7295698b8a52db5be060673839f5234721810097";
+	static constexpr std::string_view sha256 = "5a018d519dddca9205811b7baf9dfcea624cfb4623efbdeda082be01def1bf9e";
+
+	static constexpr std::string_view commonName   = "Test User";
+	static constexpr std::string_view organization = "libmumble";
+	static constexpr std::string_view country      = "IT";
+};
+
+#endif
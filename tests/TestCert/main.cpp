@@ -0,0 +1,191 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Data.hpp"
+#include "ThreadManager.hpp"
+
+#include "mumble/Cert.hpp"
+#include "mumble/Key.hpp"
+#include "mumble/Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include <boost/thread/interruption.hpp>
+
+static constexpr size_t iterations = 10000;
+
+using namespace mumble;
+
+static std::string toHex(const Cert::DerViewConst bytes) {
+	std::ostringstream stream;
+
+	stream << std::hex << std::setfill('0');
+
+	for (const auto byte : bytes) {
+		stream << std::setw(2) << static_cast< int >(byte);
+	}
+
+	return stream.str();
+}
+
+static bool checkAttributes(const Cert::Attributes &attributes) {
+	const auto find = [&attributes](const std::string_view name) {
+		const auto iter = attributes.find(name);
+		return iter != attributes.cend() ? iter->second : std::string();
+	};
+
+	return attributes.size() == 3 && find("CN") == Data::commonName && find("O") == Data::organization
+		   && find("C") == Data::country;
+}
+
+static uint8_t testCert() {
+	const Cert cert(Data::pem);
+	if (!cert) {
+		return 1;
+	}
+
+	if (toHex(cert.fingerprint("SHA1")) != Data::sha1 || toHex(cert.fingerprint()) != Data::sha256) {
+		return 2;
+	}
+
+	if (!cert.fingerprint("NotAHash").empty()) {
+		return 3;
+	}
+
+	if (!checkAttributes(cert.subjectAttributes()) || !checkAttributes(cert.issuerAttributes())) {
+		return 4;
+	}
+
+	const auto identity = cert.identity();
+	if (!identity) {
+		return 5;
+	}
+
+	if (toHex(identity->sha1) != Data::sha1 || toHex(identity->sha256) != Data::sha256) {
+		return 6;
+	}
+
+	if (!checkAttributes(identity->subjectAttributes) || !checkAttributes(identity->issuerAttributes)) {
+		return 7;
+	}
+
+	// Copies share the certificate.
+	const Cert copy(cert);
+	if (!(copy == cert) || copy.handle() != cert.handle()) {
+		return 8;
+	}
+
+	// A certificate parsed again gets the cached identity.
+	if (Cert(cert.der()).identity() != identity) {
+		return 9;
+	}
+
+	if (Cert(nullptr).identity()) {
+		return 10;
+	}
+
+	return 0;
+}
+
+static uint8_t testSelfSigned(const Key::Type type) {
+	using namespace std::chrono_literals;
+
+	const Key key = Key::generate(type);
+	if (!key || !key.isPrivate()) {
+		return 30;
+	}
+
+	if (!(Key(key.pem(), true) == key)) {
+		return 31;
+	}
+
+	const Cert::Attributes attributes = { { "CN", "Generated" }, { "O", "libmumble" } };
+
+	const auto before = std::chrono::system_clock::now();
+
+	const auto cert = Cert::selfSigned(key, attributes, 24h);
+	if (!cert) {
+		return 32;
+	}
+
+	if (cert.subjectAttributes() != attributes || cert.issuerAttributes() != attributes) {
+		return 33;
+	}
+
+	if (!cert.isSelfIssued() || !(cert.publicKey() == key)) {
+		return 34;
+	}
+
+	// The times are stored with a precision of one second.
+	if (cert.since() < before - 1s || cert.since() > before + 1min || cert.until() - cert.since() != 24h) {
+		return 35;
+	}
+
+	if (!(Cert(cert.pem()) == cert)) {
+		return 36;
+	}
+
+	// The private key is needed.
+	if (Cert::selfSigned(cert.publicKey(), attributes, 24h) || Cert::selfSigned(Key(nullptr), attributes, 24h)) {
+		return 37;
+	}
+
+	return 0;
+}
+
+static uint8_t thread(const Cert::IdentityPtr &identity) {
+	for (size_t i = 0; i < iterations; ++i) {
+		if (boost::this_thread::interruption_requested()) {
+			return 0;
+		}
+
+		const Cert cert(Data::pem);
+		if (cert.identity() != identity) {
+			return 20;
+		}
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	int32_t ret = testCert();
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (const auto type : { Key::RSA2048, Key::P256, Key::Ed25519 }) {
+		ret = testSelfSigned(type);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	const auto identity = Cert(Data::pem).identity();
+
+	ThreadManager manager;
+
+	for (uint32_t i = 0; i < manager.physicalNum(); ++i) {
+		const ThreadManager::ThreadFunc func = [&ret, &manager, &identity]() {
+			const auto threadRet = thread(identity);
+			if (threadRet != 0) {
+				ret = threadRet;
+				manager.requestStop();
+			}
+		};
+
+		manager.add(func);
+	}
+
+	manager.wait();
+
+	return ret;
+}
@@ -0,0 +1,63 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_TESTCRYPT_DATA_HPP
+#define MUMBLE_TESTCRYPT_DATA_HPP
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+struct Data {
+	// OCB2-AES128 with key 0x00..0x0F and nonce 0xF0..0xE1.
+	// The plaintext is either all zeros (to trigger the counter-cryptanalysis) or byte i = 7 * i + 3.
+	struct OCB2 {
+		size_t size;
+		bool zeros;
+		std::string_view cipher;
+		std::string_view tag;
+	};
+
+	static constexpr std::array< OCB2, 12 > ocb2 = { {
+		{ 1, false,
+		  "01",
+		  "836f8814c01f5f4741e062d5032c706b" },
+		{ 15, false,
+		  "064c79ef6aa17f734514553f96471c",
+		  "e2395e736bd14720b95011c1eef1696c" },
+		{ 16, false,
+		  "fba44f32047a23676e154e08cdcbf355",
+		  "71dc43fa73fec4dfd4b45ff1e0667f5d" },
+		{ 17, false,
+		  "959a86d496c01cc9fbdb4f9005a7e5bbd2",
+		  "ae4e45a1e02c788f86848d332b5e87a0" },
+		{ 20, true,
+		  "1a2d319070c67f675764925f5e630ede7fe23778",
+		  "60fe010cc6f60da499b5a9bfb5cf9793" },
+		{ 32, false,
+		  "959a86d496c01cc9fbdb4f9005a7e5bb2baa5960e30a83b6fb22b3f1da193d46",
+		  "ace4bdeabbe3dfab9c3b32d60fb072dd" },
+		{ 32, true,
+		  "1a2d319070c67f675764925f5e630ede58d0d8e86c9c1e1250900a311dd7e89a",
+		  "cb13c567357df0eccc9f56d6f8afc28e" },
+		{ 33, false,
+		  "959a86d496c01cc9fbdb4f9005a7e5bbbfd7d8f43a8f858506aba997c4225c8f96",
+		  "181240e409092c8046cd109226af5968" },
+		{ 64, false,
+		  "959a86d496c01cc9fbdb4f9005a7e5bbbfd7d8f43a8f858506aba997c4225c8fa509fbd56b0828aa0eb1bba01a2cd40dc86ed2f07273e2bfdf008e59f39581f9",
+		  "9ba48f1056669361525d683151b5a265" },
+		{ 128, true,
+		  "3eccbaef29f024105d804ae128c3e8f80e62edd230f8845b189c3adf492aef9cfff50e0f800b5ccb96469eb70b211ec4c9ad82f05bde223ddd46117eaecd838db035d7ebf53d09c107fe16988dc38e6d725b1bf0a09f7b48ccdf81e003ab27951060673951493e553e2727133ed46b88f389e581a7418d3aef7d20536eb3dc55",
+		  "4625d2e83e3c5a38b35a62a1e50fc9ae" },
+		{ 129, false,
+		  "959a86d496c01cc9fbdb4f9005a7e5bbbfd7d8f43a8f858506aba997c4225c8fa509fbd56b0828aa0eb1bba01a2cd40dd4e3fd3e33178095b634f52926196116c0ef3831653e058e2356a642b1915b2d470fe3b35cfa3a33b7a6434ac93d9ddea9ee3228489f015b7a92ccf32aaae687e5443f7f3d6af63a7d777c808a18371cae",
+		  "c3fe5f2f733299897b3c2295db043eb2" },
+		{ 200, false,
+		  "959a86d496c01cc9fbdb4f9005a7e5bbbfd7d8f43a8f858506aba997c4225c8fa509fbd56b0828aa0eb1bba01a2cd40dd4e3fd3e33178095b634f52926196116c0ef3831653e058e2356a642b1915b2d470fe3b35cfa3a33b7a6434ac93d9ddea9ee3228489f015b7a92ccf32aaae687e5443f7f3d6af63a7d777c808a18371c0bf22d0a97f3a1c8c4a83590c7b1e71ed49656df20fabb290951b3b25e7add92a6f3a319fe6906713899da1a5d4ed07b761544909c85a6c14cd9a3c5a5f6a2cc98229054389a3729",
+		  "0b1c28dd6df294dd718c8d013771aaf8" },
+	} };
+};
+
+#endif
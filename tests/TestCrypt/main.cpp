@@ -3,16 +3,21 @@
 // that can be found in the LICENSE file at the root of the
 // Mumble source tree or at <https://www.mumble.info/LICENSE>.
 
+#include "Data.hpp"
 #include "ThreadManager.hpp"
 
 #include "mumble/Crypt.hpp"
 #include "mumble/CryptOCB2.hpp"
+#include "mumble/CryptStateAEAD.hpp"
+#include "mumble/CryptStateOCB2.hpp"
 #include "mumble/Types.hpp"
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <random>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include <boost/thread/interruption.hpp>
@@ -60,6 +65,515 @@ template< typename T > static uint8_t test(T &crypt, const BufViewConst in) {
 	return 0;
 }
 
+static std::string toHex(const BufViewConst bytes) {
+	static constexpr std::string_view digits = "0123456789abcdef";
+
+	std::string hex;
+
+	for (const auto byte : bytes) {
+		hex += digits[std::to_integer< uint8_t >(byte) >> 4];
+		hex += digits[std::to_integer< uint8_t >(byte) & 0xF];
+	}
+
+	return hex;
+}
+
+// Makes sure that the output doesn't change, regardless of the implementation picked for the CPU.
+static uint8_t testOCB2() {
+	CryptOCB2 crypt;
+
+	Buf key(crypt.keySize()), nonce(crypt.nonceSize());
+	for (uint8_t i = 0; i < key.size(); ++i) {
+		key[i]   = static_cast< std::byte >(i);
+		nonce[i] = static_cast< std::byte >(0xF0 - i);
+	}
+
+	if (!crypt.setKey(key) || !crypt.setNonce(nonce)) {
+		return 20;
+	}
+
+	for (const auto &vector : Data::ocb2) {
+		Buf in(vector.size);
+		for (size_t i = 0; i < in.size(); ++i) {
+			in[i] = static_cast< std::byte >(vector.zeros ? 0 : i * 7 + 3);
+		}
+
+		Buf out(in.size());
+		Buf tag(crypt.blockSize());
+
+		if (crypt.encrypt(out, in, tag) != in.size()) {
+			return 21;
+		}
+
+		if (toHex(out) != vector.cipher || toHex(tag) != vector.tag) {
+			return 22;
+		}
+
+		if (crypt.decrypt(out, out, tag) != in.size()) {
+			return 23;
+		}
+
+		if (vector.zeros) {
+			// The counter-cryptanalysis flips a bit in the second to last block.
+			in[((in.size() - 1) / crypt.blockSize() - 1) * crypt.blockSize()] ^= std::byte(1);
+		}
+
+		if (out != in) {
+			return 24;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testOCB2Batch(std::mt19937 &algorithm) {
+	// Not a multiple of the number of lanes, to test partial batches as well.
+	constexpr size_t packets = 21;
+
+	std::uniform_int_distribution< size_t > genSize(minBufSize, 256);
+	std::uniform_int_distribution< uint16_t > genByte(0, UINT8_MAX);
+
+	std::vector< CryptOCB2 > crypts(packets);
+	std::vector< Buf > in(packets), out(packets), tags(packets), expectedOut(packets), expectedTags(packets);
+	std::vector< Buf > nonces(packets);
+
+	std::vector< CryptOCB2::EncryptJob > encryptJobs(packets);
+	std::vector< CryptOCB2::DecryptJob > decryptJobs(packets);
+
+	for (size_t i = 0; i < packets; ++i) {
+		auto &crypt = crypts[i];
+		if (!crypt.setKey(crypt.genKey()) || !crypt.setNonce(crypt.genNonce())) {
+			return 30;
+		}
+
+		in[i].resize(i % 3 ? genSize(algorithm) : 60);
+		std::generate(in[i].begin(), in[i].end(), [&]() { return static_cast< std::byte >(genByte(algorithm)); });
+
+		expectedOut[i].resize(in[i].size());
+		expectedTags[i].resize(crypt.blockSize());
+		if (!crypt.encrypt(expectedOut[i], in[i], expectedTags[i])) {
+			return 31;
+		}
+
+		out[i].resize(in[i].size());
+		tags[i].resize(crypt.blockSize());
+
+		// Every other job overrides the nonce, the expected output is computed with the same one.
+		auto &job = encryptJobs[i];
+		job.crypt = &crypt;
+		job.out   = out[i];
+		job.in    = in[i];
+		job.tag   = tags[i];
+
+		if (i % 2) {
+			nonces[i] = crypt.genNonce();
+			job.nonce = nonces[i];
+
+			const Buf nonce(crypt.nonce().begin(), crypt.nonce().end());
+			if (!crypt.setNonce(nonces[i]) || !crypt.encrypt(expectedOut[i], in[i], expectedTags[i])
+				|| !crypt.setNonce(nonce)) {
+				return 32;
+			}
+		}
+	}
+
+	if (CryptOCB2::encryptBatch(encryptJobs) != packets) {
+		return 33;
+	}
+
+	for (size_t i = 0; i < packets; ++i) {
+		if (encryptJobs[i].written != in[i].size() || out[i] != expectedOut[i] || tags[i] != expectedTags[i]) {
+			return 34;
+		}
+
+		auto &job = decryptJobs[i];
+		job.crypt = &crypts[i];
+		job.nonce = encryptJobs[i].nonce;
+		job.out   = out[i];
+		job.in    = out[i];
+		job.tag   = tags[i];
+	}
+
+	// A tampered packet must be rejected without affecting the others.
+	tags[packets / 2][0] ^= std::byte(1);
+
+	if (CryptOCB2::decryptBatch(decryptJobs) != packets - 1) {
+		return 35;
+	}
+
+	for (size_t i = 0; i < packets; ++i) {
+		if (i == packets / 2) {
+			if (decryptJobs[i].written) {
+				return 36;
+			}
+
+			continue;
+		}
+
+		if (decryptJobs[i].written != in[i].size() || out[i] != in[i]) {
+			return 37;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testCryptState() {
+	using Stats = CryptStateOCB2::Stats;
+
+	constexpr auto header = CryptStateOCB2::headerSize;
+
+	CryptStateOCB2 server, client;
+	if (!server.gen() || !client.setKey(server.key(), server.encryptNonce(), server.decryptNonce())) {
+		return 40;
+	}
+
+	// Not all zeros, which would trigger the countermeasure described in section 9 of the OCB2 paper.
+	FixedBuf< 60 > plain;
+	for (size_t i = 0; i < plain.size(); ++i) {
+		plain[i] = static_cast< std::byte >(i + 1);
+	}
+
+	FixedBuf< 60 + header > packets[300];
+	for (auto &packet : packets) {
+		if (client.encrypt(packet, plain) != packet.size()) {
+			return 41;
+		}
+	}
+
+	const auto deliver = [&server, &plain](const BufViewConst packet) {
+		FixedBuf< 60 > out;
+		return server.decrypt(out, packet) == out.size() && out == plain;
+	};
+
+	const auto expect = [&server](const uint32_t good, const uint32_t late, const uint32_t lost) {
+		const Stats stats = server.stats();
+		return stats.good == good && stats.late == late && stats.lost == lost;
+	};
+
+	// 0, 3 (1 and 2 lost), 1 (late), 1 (replay), 2 (late), 2 (replay), 3 (replay), 4.
+	if (!deliver(packets[0]) || !deliver(packets[3]) || !expect(2, 0, 2)) {
+		return 42;
+	}
+
+	if (!deliver(packets[1]) || deliver(packets[1]) || !deliver(packets[2]) || deliver(packets[2])
+		|| deliver(packets[3]) || !deliver(packets[4]) || !expect(5, 2, 0)) {
+		return 43;
+	}
+
+	// Too late.
+	if (!deliver(packets[40]) || deliver(packets[5]) || !expect(6, 2, 35)) {
+		return 44;
+	}
+
+	// Tampered.
+	auto tampered = packets[41];
+	tampered.back() ^= std::byte(1);
+	if (deliver(tampered) || !expect(6, 2, 35)) {
+		return 45;
+	}
+
+	// No room for the output: rejected before the nonce is touched, the tag isn't even checked.
+	const Buf nonce(server.decryptNonce().begin(), server.decryptNonce().end());
+
+	FixedBuf< 59 > shortOut;
+	if (server.decrypt({}, packets[41]) || server.decrypt(shortOut, packets[41]) || !expect(6, 2, 35)) {
+		return 51;
+	}
+
+	if (!std::equal(nonce.begin(), nonce.end(), server.decryptNonce().begin(), server.decryptNonce().end())) {
+		return 52;
+	}
+
+	// The lowest nonce byte wraps around.
+	for (size_t i = 41; i < 300; ++i) {
+		if (!deliver(packets[i])) {
+			return 46;
+		}
+	}
+
+	if (!expect(265, 2, 35)) {
+		return 47;
+	}
+
+	// More than 128 packets lost can't be recovered from without a resync.
+	for (size_t i = 0; i < 200; ++i) {
+		client.encrypt(packets[0], plain);
+	}
+
+	client.encrypt(packets[0], plain);
+	if (deliver(packets[0])) {
+		return 48;
+	}
+
+	if (!server.setDecryptNonce(client.encryptNonce()) || server.resync() != 1) {
+		return 49;
+	}
+
+	client.encrypt(packets[0], plain);
+	if (!deliver(packets[0])) {
+		return 50;
+	}
+
+	return 0;
+}
+
+static uint8_t testCryptStateAEAD(const CryptStateAEAD::Mode mode) {
+	using Job = CryptStateAEAD::Job;
+
+	constexpr auto header = CryptStateAEAD::headerSize;
+
+	if (CryptStateAEAD(CryptStateAEAD::Mode::OCB2AES128, true)) {
+		return 70;
+	}
+
+	CryptStateAEAD server(mode, true), client(mode, false);
+	if (!server.gen() || !client.setKey(server.key(), server.encryptNonce(), server.decryptNonce())) {
+		return 71;
+	}
+
+	FixedBuf< 60 > plain;
+	for (size_t i = 0; i < plain.size(); ++i) {
+		plain[i] = static_cast< std::byte >(i + 1);
+	}
+
+	FixedBuf< 60 + header > packets[300];
+	for (auto &packet : packets) {
+		if (client.encrypt(packet, plain) != packet.size()) {
+			return 72;
+		}
+	}
+
+	const auto deliver = [&server, &plain](const BufViewConst packet) {
+		FixedBuf< 60 > out;
+		return server.decrypt(out, packet) == out.size() && out == plain;
+	};
+
+	const auto expect = [&server](const uint32_t good, const uint32_t late, const uint32_t lost) {
+		const auto stats = server.stats();
+		return stats.good == good && stats.late == late && stats.lost == lost;
+	};
+
+	// Same sequence as for OCB2: 0, 3 (1 and 2 lost), 1 (late), 1 (replay), 2 (late), 2 (replay), 3 (replay), 4.
+	if (!deliver(packets[0]) || !deliver(packets[3]) || !deliver(packets[1]) || deliver(packets[1])
+		|| !deliver(packets[2]) || deliver(packets[2]) || deliver(packets[3]) || !deliver(packets[4])
+		|| !expect(5, 2, 0)) {
+		return 73;
+	}
+
+	// Too late.
+	if (!deliver(packets[40]) || deliver(packets[5]) || !expect(6, 2, 35)) {
+		return 74;
+	}
+
+	// Tampered, either the tag or the ciphertext.
+	for (const size_t offset : { size_t(1), packets[41].size() - 1 }) {
+		auto tampered = packets[41];
+		tampered[offset] ^= std::byte(1);
+		if (deliver(tampered) || !expect(6, 2, 35)) {
+			return 75;
+		}
+	}
+
+	// The lowest counter byte wraps around, delivered as a batch this time.
+	std::vector< FixedBuf< 60 > > outs(300 - 41);
+	std::vector< Job > jobs(outs.size());
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		jobs[i].out = outs[i];
+		jobs[i].in  = packets[41 + i];
+	}
+
+	if (server.decryptBatch(jobs) != jobs.size() || !expect(265, 2, 35)) {
+		return 76;
+	}
+
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		if (jobs[i].written != plain.size() || outs[i] != plain) {
+			return 77;
+		}
+	}
+
+	// A batch of packets with one that doesn't fit: it's skipped, the receiver counts it as lost.
+	FixedBuf< 60 + header > batch[4];
+	FixedBuf< 60 > small;
+	for (size_t i = 0; i < std::size(batch); ++i) {
+		jobs[i].out = i == 2 ? BufView(small) : BufView(batch[i]);
+		jobs[i].in  = plain;
+	}
+
+	if (client.encryptBatch({ jobs.data(), std::size(batch) }) != std::size(batch) - 1 || jobs[2].written) {
+		return 78;
+	}
+
+	if (!deliver(batch[0]) || !deliver(batch[1]) || !deliver(batch[3]) || !expect(268, 2, 36)) {
+		return 79;
+	}
+
+	// Header and body given separately.
+	const BufViewConst parts[] = { BufViewConst(plain).first(4), BufViewConst(plain).subspan(4) };
+	if (client.encrypt(batch[0], parts) != batch[0].size() || !deliver(batch[0])) {
+		return 83;
+	}
+
+	// More than 128 packets lost can't be recovered from without a resync.
+	for (size_t i = 0; i < 200; ++i) {
+		client.encrypt(packets[0], plain);
+	}
+
+	if (deliver(packets[0])) {
+		return 80;
+	}
+
+	if (!server.setDecryptNonce(client.encryptNonce()) || server.resync() != 1) {
+		return 81;
+	}
+
+	client.encrypt(packets[0], plain);
+	if (!deliver(packets[0])) {
+		return 82;
+	}
+
+	// Each direction has its own key: a packet sent by the server can only be decrypted by a client.
+	CryptStateAEAD reflected(mode, true), peer(mode, false);
+	if (!reflected.setKey(server.key(), server.encryptNonce(), server.decryptNonce())
+		|| !peer.setKey(server.key(), server.encryptNonce(), server.decryptNonce())) {
+		return 84;
+	}
+
+	FixedBuf< 60 > out;
+	if (server.encrypt(packets[0], plain) != packets[0].size() || reflected.decrypt(out, packets[0])
+		|| peer.decrypt(out, packets[0]) != out.size() || out != plain) {
+		return 85;
+	}
+
+	return 0;
+}
+
+// Header and body encrypted from separate buffers, in place and with AAD, must match the contiguous result.
+static uint8_t testScatter(const std::string_view cipher) {
+	Crypt crypt;
+	if (!crypt.setCipher(cipher) || !crypt.setKey(crypt.genKey()) || !crypt.setNonce(crypt.genNonce())) {
+		return 90;
+	}
+
+	Buf packet(300), aad(13);
+	for (size_t i = 0; i < packet.size(); ++i) {
+		packet[i] = static_cast< std::byte >(i * 7);
+	}
+
+	FixedBuf< 16 > tag, expectedTag;
+	Buf expected(packet.size());
+	if (crypt.encrypt(expected, packet, expectedTag, aad) != packet.size()) {
+		return 91;
+	}
+
+	const BufViewConst header(packet.data(), 6), body(packet.data() + 6, packet.size() - 6);
+	const BufViewConst parts[] = { header, {}, body };
+
+	Buf out(packet.size());
+	if (crypt.encrypt(out, parts, tag, aad) != packet.size() || out != expected || tag != expectedTag) {
+		return 92;
+	}
+
+	if (crypt.encrypt(BufView(out).first(out.size() - 1), parts, tag, aad)) {
+		return 93;
+	}
+
+	// In place, the body stays where it is and only the header comes from elsewhere.
+	Buf inPlace(packet);
+	const FixedBuf< 6 > separateHeader = { packet[0], packet[1], packet[2], packet[3], packet[4], packet[5] };
+	const BufViewConst inPlaceParts[] = { separateHeader, BufViewConst(inPlace).subspan(6) };
+	if (crypt.encrypt(inPlace, inPlaceParts, tag, aad) != packet.size() || inPlace != expected) {
+		return 94;
+	}
+
+	if (crypt.decrypt(inPlace, inPlace, tag, aad) != packet.size() || inPlace != packet) {
+		return 95;
+	}
+
+	// The AAD is authenticated.
+	aad[0] ^= std::byte(1);
+	if (crypt.decrypt(out, expected, expectedTag, aad)) {
+		return 96;
+	}
+
+	return 0;
+}
+
+// With padding, encryption needs room for an extra block but decryption only for the input.
+static uint8_t testPadding() {
+	Crypt crypt;
+	if (!crypt.setCipher("AES-256-CBC") || !crypt.setKey(crypt.genKey()) || !crypt.setNonce(crypt.genNonce())) {
+		return 97;
+	}
+
+	const Buf plain(100, std::byte(7));
+	Buf cipherText(plain.size() + crypt.blockSize());
+
+	const auto written = crypt.encrypt(cipherText, plain);
+	if (written != 112 || crypt.encrypt(BufView(cipherText).first(plain.size()), plain)) {
+		return 98;
+	}
+
+	Buf out(written);
+	if (crypt.decrypt(out, BufViewConst(cipherText).first(written)) != plain.size()
+		|| !std::equal(plain.begin(), plain.end(), out.begin())) {
+		return 99;
+	}
+
+	return 0;
+}
+
+// Alternates directions on the same instances, with a new nonce for every message.
+static uint8_t testDuplex(const std::string_view cipher) {
+	Crypt alice, bob;
+	if (!alice.setCipher(cipher) || !bob.setCipher(cipher) || !alice.keySize() || !alice.nonceSize()) {
+		return 60;
+	}
+
+	const auto key = alice.genKey();
+	if (!alice.setKey(key) || !bob.setKey(key)) {
+		return 61;
+	}
+
+	FixedBuf< 16 > tag;
+	Buf plain(200), cipherText(200), out(200);
+
+	for (uint8_t i = 0; i < 20; ++i) {
+		std::fill(plain.begin(), plain.end(), static_cast< std::byte >(i + 1));
+
+		auto &sender   = i % 2 ? bob : alice;
+		auto &receiver = i % 2 ? alice : bob;
+
+		const auto nonce = sender.genNonce();
+		if (!sender.setNonce(nonce) || !receiver.setNonce(nonce)) {
+			return 62;
+		}
+
+		if (sender.encrypt(cipherText, plain, tag) != plain.size()) {
+			return 63;
+		}
+
+		// The receiver's last operation was an encryption, except for the first message.
+		if (receiver.decrypt(out, cipherText, tag) != plain.size() || out != plain) {
+			return 64;
+		}
+
+		tag[0] ^= std::byte(1);
+		if (receiver.decrypt(out, cipherText, tag)) {
+			return 65;
+		}
+		tag[0] ^= std::byte(1);
+	}
+
+	// A different key must not be able to decrypt.
+	if (!bob.setKey(bob.genKey()) || bob.decrypt(out, cipherText, tag)) {
+		return 66;
+	}
+
+	return 0;
+}
+
 static uint8_t thread() {
 	Crypt cryptChaCha20;
 	if (!cryptChaCha20.setCipher("ChaCha20-Poly1305")) {
@@ -103,13 +617,52 @@ static uint8_t thread() {
 		if (ret != 0) {
 			return ret;
 		}
+
+		if (i % 100 == 0) {
+			ret = testOCB2Batch(algorithm);
+			if (ret != 0) {
+				return ret;
+			}
+		}
 	}
 
 	return 0;
 }
 
 int32_t main() {
-	int32_t ret = 0;
+	int32_t ret = testOCB2();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testCryptState();
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (const auto mode : { CryptStateAEAD::Mode::AES256GCM, CryptStateAEAD::Mode::ChaCha20Poly1305 }) {
+		ret = testCryptStateAEAD(mode);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	for (const auto cipher : { "AES-256-GCM", "ChaCha20-Poly1305" }) {
+		ret = testDuplex(cipher);
+		if (ret != 0) {
+			return ret;
+		}
+
+		ret = testScatter(cipher);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	ret = testPadding();
+	if (ret != 0) {
+		return ret;
+	}
 
 	ThreadManager manager;
 
@@ -0,0 +1,187 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/EndpointHash.hpp"
+#include "mumble/EndpointMap.hpp"
+#include "mumble/IP.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+static constexpr size_t iterations = 200000;
+
+using namespace mumble;
+
+static Endpoint natEndpoint(const uint16_t port) {
+	return { IP("203.0.113.7"), port };
+}
+
+static uint8_t testHash() {
+	const EndpointHash::Key key = { 0x0706050403020100, 0x0f0e0d0c0b0a0908 };
+
+	const EndpointHash hash(key), same(key), other({ key[1], key[0] });
+	const EndpointHash random;
+
+	const auto endpoint = natEndpoint(64738);
+
+	if (hash.hash(endpoint) != same.hash(endpoint) || hash.hash(endpoint) == other.hash(endpoint)) {
+		return 10;
+	}
+
+	if (EndpointHash().key() != random.key()) {
+		return 11;
+	}
+
+	// The IP alone must not hash like the IP with port 0.
+	if (hash.hash(endpoint.ip) == hash.hash(Endpoint(endpoint.ip, 0))) {
+		return 12;
+	}
+
+	// Clients behind the same NAT only differ in port, they must still spread evenly across buckets.
+	constexpr size_t buckets = 1 << 12;
+
+	std::vector< uint32_t > load(buckets);
+	for (uint32_t port = 0; port <= UINT16_MAX; ++port) {
+		++load[hash(natEndpoint(static_cast< uint16_t >(port))) % buckets];
+	}
+
+	// 16 on average.
+	const auto minmax = std::minmax_element(load.cbegin(), load.cend());
+	if (!*minmax.first || *minmax.second > 40) {
+		return 13;
+	}
+
+	return 0;
+}
+
+static uint8_t testValue() {
+	static_assert(std::is_trivially_copyable_v< EndpointV > && std::is_standard_layout_v< EndpointV >);
+	static_assert(sizeof(EndpointV) == IP::v6Size + sizeof(uint16_t));
+
+	constexpr EndpointV first  = { { { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff, 203, 0, 113, 7 } }, 64738 };
+	constexpr EndpointV second = { first.ip, 64739 };
+
+	static_assert(first == first && first != second && first.ip == second.ip && first.ip.isV4());
+
+	constexpr EndpointHash hash({ 1, 2 });
+	static_assert(hash.hash(first) != hash.hash(second));
+
+	const Endpoint endpoint(first);
+	if (endpoint.value() != first || !(endpoint.ip == IP("203.0.113.7")) || !(Endpoint(endpoint.value()) == endpoint)) {
+		return 30;
+	}
+
+	if (hash.hash(endpoint) != hash.hash(first) || hash.hash(endpoint.ip) != hash.hash(first.ip)) {
+		return 31;
+	}
+
+	// Packet metadata can be copied around as plain bytes.
+	EndpointV endpoints[2];
+	std::memcpy(endpoints, &first, sizeof(first));
+	std::memcpy(&endpoints[1], &second, sizeof(second));
+	if (endpoints[0] != first || endpoints[1] != second) {
+		return 32;
+	}
+
+	EndpointMap< uint8_t > map;
+	if (!map.insert(first, 1) || map.insert(endpoint, 2) || !map.find(first) || *map.find(first) != 2) {
+		return 33;
+	}
+
+	return 0;
+}
+
+static uint8_t testMap() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	// Few endpoints, so that the same ones are inserted and erased over and over, with long probe chains.
+	std::uniform_int_distribution< uint16_t > genPort(1, 2000);
+	std::uniform_int_distribution< uint8_t > genIP(0, 3);
+	std::uniform_int_distribution< uint8_t > genOp(0, 9);
+
+	const IP ips[] = { IP("203.0.113.7"), IP("198.51.100.1"), IP("2001:db8::1"), IP("2001:db8::2") };
+
+	EndpointMap< uint32_t > map;
+	std::unordered_map< Endpoint, uint32_t, EndpointHash > reference;
+
+	for (uint32_t i = 0; i < iterations; ++i) {
+		const Endpoint endpoint(ips[genIP(algorithm)], genPort(algorithm));
+
+		const auto op   = genOp(algorithm);
+		const auto iter = reference.find(endpoint);
+
+		if (op < 4) {
+			if (map.insert(endpoint, i) != (iter == reference.cend())) {
+				return 20;
+			}
+
+			reference.insert_or_assign(endpoint, i);
+		} else if (op < 7) {
+			if (map.erase(endpoint) != (iter != reference.cend())) {
+				return 21;
+			}
+
+			reference.erase(endpoint);
+		} else {
+			const auto value = map.find(endpoint);
+			if (!value != (iter == reference.cend()) || (value && *value != iter->second)) {
+				return 22;
+			}
+		}
+
+		if (map.size() != reference.size()) {
+			return 23;
+		}
+	}
+
+	// Every entry must still be reachable after all the deletions.
+	size_t entries = 0;
+	map.forEach([&](const Endpoint &endpoint, const uint32_t value) {
+		const auto iter = reference.find(endpoint);
+		if (iter != reference.cend() && iter->second == value) {
+			++entries;
+		}
+	});
+
+	if (entries != reference.size()) {
+		return 24;
+	}
+
+	for (const auto &iter : reference) {
+		const auto value = map.find(iter.first);
+		if (!value || *value != iter.second) {
+			return 25;
+		}
+	}
+
+	map.clear();
+	if (!map.empty() || map.find(natEndpoint(1))) {
+		return 26;
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	auto ret = testHash();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testValue();
+	if (ret != 0) {
+		return ret;
+	}
+
+	return testMap();
+}
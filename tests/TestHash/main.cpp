@@ -9,6 +9,7 @@
 #include "mumble/Hash.hpp"
 #include "mumble/Types.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstdint>
@@ -17,6 +18,7 @@
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <boost/thread/interruption.hpp>
 
@@ -55,6 +57,67 @@ static uint8_t test(Hash &hash, const Data::List &list, const size_t index) {
 	return 0;
 }
 
+// Every input hashed in pieces, from parts, as a batch and through the thread's own Hash must match the known digests.
+static uint8_t testIncremental(const std::string_view type, const Data::List &list) {
+	constexpr auto count = std::tuple_size< Data::List >();
+
+	auto &hash = Hash::local(type);
+	if (&hash != &Hash::local(type) || hash.type().empty() || !Hash::local("unknown").type().empty()) {
+		return 20;
+	}
+
+	std::vector< BufViewConst > in;
+	std::vector< Buf > digests(count, Buf(hash({}, BufViewConst())));
+
+	for (size_t i = 0; i < count; ++i) {
+		const auto &input = Data::input[i];
+		in.emplace_back(reinterpret_cast< const std::byte * >(input.data()), input.size());
+
+		const auto half = in[i].size() / 2;
+
+		// update() left pending is discarded by the one-shot call.
+		if (!hash.update(in[i].first(half)) || !hash(digests[i], in[i]) || toHex(digests[i]) != list[i]) {
+			return 21;
+		}
+
+		if (!hash.update(in[i].first(half)) || !hash.update({}) || !hash.update(in[i].subspan(half))
+			|| !hash.final(digests[i]) || toHex(digests[i]) != list[i]) {
+			return 22;
+		}
+
+		const BufViewConst parts[] = { in[i].first(half), in[i].subspan(half) };
+		if (!hash(digests[i], parts) || toHex(digests[i]) != list[i]) {
+			return 23;
+		}
+	}
+
+	std::vector< BufView > out(digests.begin(), digests.end());
+	for (auto &digest : digests) {
+		std::fill(digest.begin(), digest.end(), std::byte(0));
+	}
+
+	if (hash.hashMany(out, in) != count) {
+		return 24;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+		if (toHex(digests[i]) != list[i]) {
+			return 25;
+		}
+	}
+
+	// Not enough room for the digest: the pending data is discarded, it doesn't end up in the next digest.
+	if (!hash.update(in[0]) || hash.final(BufView(digests[0]).first(1))) {
+		return 26;
+	}
+
+	if (!hash.update(in[1]) || !hash.final(digests[1]) || toHex(digests[1]) != list[1]) {
+		return 27;
+	}
+
+	return 0;
+}
+
 static uint8_t thread() {
 	Hash sha2;
 	if (!sha2.setType("SHA512")) {
@@ -102,7 +165,15 @@ static uint8_t thread() {
 }
 
 int32_t main() {
-	int32_t ret = 0;
+	int32_t ret = testIncremental("SHA512", Data::sha2);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testIncremental("BLAKE2b512", Data::blake2b);
+	if (ret != 0) {
+		return ret;
+	}
 
 	ThreadManager manager;
 
@@ -0,0 +1,389 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "ThreadManager.hpp"
+
+#include "mumble/JitterBuffer.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <boost/thread/interruption.hpp>
+
+static constexpr size_t iterations = 100;
+static constexpr size_t packets    = 500;
+
+using namespace mumble;
+
+using namespace std::chrono_literals;
+
+using Frame = JitterBuffer::Frame;
+using Type  = Frame::Type;
+
+// TOC byte of a mono CELT packet with a single 20 ms frame, followed by some payload.
+static constexpr std::array< std::byte, 4 > packet = { std::byte(0xF8), std::byte(0x01), std::byte(0x02),
+													   std::byte(0x03) };
+static constexpr uint8_t packetFrames = 2;
+
+static const JitterBuffer::TimePoint epoch = JitterBuffer::Clock::now();
+
+// Packets sent exactly on time arrive with the same delay ("offset" is added to it).
+static bool push(JitterBuffer &buffer, const uint64_t number, const bool terminator = false,
+				 const std::chrono::milliseconds offset = 0ms) {
+	return buffer.push(number, packet, terminator, epoch + JitterBuffer::frameDuration * number + offset);
+}
+
+static bool check(const Frame &frame, const Type type, const uint64_t number) {
+	if (frame.type != type) {
+		return false;
+	}
+
+	return type == Type::None || frame.number == number;
+}
+
+static uint8_t testOrder() {
+	JitterBuffer buffer;
+	if (!buffer || buffer.tick() != 20ms) {
+		return 1;
+	}
+
+	if (JitterBuffer(15ms) || buffer.pop().type != Type::None) {
+		return 2;
+	}
+
+	// Out of order.
+	if (!push(buffer, 0) || !push(buffer, 4) || !push(buffer, 2) || push(buffer, 2)) {
+		return 3;
+	}
+
+	for (const uint64_t number : { 0, 2, 4 }) {
+		const auto frame = buffer.pop();
+		if (!check(frame, Type::Normal, number) || frame.frames != packetFrames
+			|| !std::equal(frame.packet.begin(), frame.packet.end(), packet.begin(), packet.end())) {
+			return 4;
+		}
+	}
+
+	if (!buffer.playing()) {
+		return 5;
+	}
+
+	// Too late.
+	if (push(buffer, 2) || buffer.stats().late != 1 || buffer.stats().good != 3) {
+		return 6;
+	}
+
+	return 0;
+}
+
+static uint8_t testLoss() {
+	JitterBuffer buffer;
+
+	// 2 is recovered from 4 and 8 from 10, nothing can be done for 6.
+	if (!push(buffer, 0) || !push(buffer, 4) || !push(buffer, 10)) {
+		return 10;
+	}
+
+	const std::pair< Type, uint64_t > expected[] = { { Type::Normal, 0 }, { Type::FEC, 2 }, { Type::Normal, 4 },
+													 { Type::Loss, 6 },   { Type::FEC, 8 }, { Type::Normal, 10 } };
+
+	for (const auto &entry : expected) {
+		const auto frame = buffer.pop();
+		if (!check(frame, entry.first, entry.second)) {
+			return 11;
+		}
+
+		// The successor is handed over for FEC.
+		if (frame.type == Type::FEC && frame.packet.size() != packet.size()) {
+			return 12;
+		}
+	}
+
+	const auto stats = buffer.stats();
+	if (stats.good != 3 || stats.recovered != 2 || stats.lost != 1) {
+		return 13;
+	}
+
+	// The speaker stopped without terminator: a few frames are concealed, then the buffer goes idle.
+	size_t concealed = 0;
+	for (auto frame = buffer.pop(); frame.type != Type::None; frame = buffer.pop()) {
+		if (frame.type != Type::Loss) {
+			return 14;
+		}
+
+		++concealed;
+	}
+
+	if (!concealed || concealed > 3 || buffer.playing()) {
+		return 15;
+	}
+
+	return 0;
+}
+
+static uint8_t testTerminator() {
+	JitterBuffer buffer;
+
+	// Shorter than the delay, played right away because it's complete.
+	if (!push(buffer, 100, true)) {
+		return 20;
+	}
+
+	auto frame = buffer.pop();
+	if (!check(frame, Type::Normal, 100) || !frame.terminator || buffer.playing()) {
+		return 21;
+	}
+
+	if (buffer.pop().type != Type::None) {
+		return 22;
+	}
+
+	// Leftover of the previous spurt.
+	if (push(buffer, 98)) {
+		return 23;
+	}
+
+	// New spurt, ended by an empty packet.
+	if (!push(buffer, 200) || !push(buffer, 202) || !buffer.push(204, {}, true, epoch)) {
+		return 24;
+	}
+
+	for (const uint64_t number : { 200, 202 }) {
+		if (!check(buffer.pop(), Type::Normal, number)) {
+			return 25;
+		}
+	}
+
+	if (buffer.pop().type != Type::None || buffer.playing()) {
+		return 26;
+	}
+
+	// The sender restarted its counter.
+	if (!push(buffer, 0) || !check(buffer.pop(), Type::Normal, 0)) {
+		return 27;
+	}
+
+	buffer.reset();
+
+	if (buffer.playing() || buffer.pop().type != Type::None) {
+		return 28;
+	}
+
+	return 0;
+}
+
+static uint8_t testAdaptation() {
+	JitterBuffer buffer;
+
+	const auto delay = buffer.delay();
+	if (delay != 20ms || buffer.jitter() != 0us) {
+		return 30;
+	}
+
+	// Packets arrive up to 40 ms late.
+	for (uint64_t number = 0; number < 100; number += packetFrames) {
+		push(buffer, number, false, number % 3 ? 0ms : 40ms);
+		buffer.pop();
+	}
+
+	if (buffer.jitter() < 10ms || buffer.delay() <= delay) {
+		return 31;
+	}
+
+	// The next spurt waits for the whole delay before starting.
+	buffer.reset();
+
+	push(buffer, 1000);
+
+	size_t waited = 0;
+	while (buffer.pop().type == Type::None) {
+		if (++waited > 100) {
+			return 32;
+		}
+	}
+
+	if (JitterBuffer::frameDuration * packetFrames * (waited + 1) < buffer.delay()) {
+		return 33;
+	}
+
+	// Jitter is gone, the excess audio gets dropped.
+	buffer.reset();
+
+	for (uint64_t number = 2000; number < 2040; number += packetFrames) {
+		push(buffer, number);
+	}
+
+	for (size_t i = 0; i < 20; ++i) {
+		buffer.pop();
+	}
+
+	if (!buffer.stats().dropped) {
+		return 34;
+	}
+
+	return 0;
+}
+
+static uint8_t testDecode(const std::chrono::milliseconds tick) {
+	Opus::Decoder decoder(1);
+	if (decoder.init() != Code::Success) {
+		return 40;
+	}
+
+	JitterBuffer buffer(tick);
+
+	std::vector< float > out(960 * 2);
+
+	if (!buffer.decode(out, decoder).empty()) {
+		return 41;
+	}
+
+	// Too small.
+	if (!push(buffer, 0) || !buffer.decode(Opus::FloatView(out).first(100), decoder).empty()) {
+		return 42;
+	}
+
+	push(buffer, 4);
+
+	// The packets are 20 ms long, a 10 ms tick needs two calls per packet.
+	const size_t calls = 3 * packetFrames * 10ms / tick;
+
+	for (size_t i = 0; i < calls; ++i) {
+		if (buffer.decode(out, decoder).size() != static_cast< size_t >(48 * tick.count())) {
+			return 43;
+		}
+	}
+
+	if (buffer.stats().recovered != 1) {
+		return 44;
+	}
+
+	return 0;
+}
+
+static uint8_t thread() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+	std::uniform_int_distribution< uint32_t > delay(0, 60);
+	std::uniform_int_distribution< uint32_t > percent(0, 99);
+
+	JitterBuffer buffer;
+
+	std::vector< std::pair< std::chrono::milliseconds, uint64_t > > network;
+
+	for (size_t i = 0; i < iterations; ++i) {
+		if (boost::this_thread::interruption_requested()) {
+			return 0;
+		}
+
+		buffer.reset();
+
+		const auto before = buffer.stats();
+
+		// Each packet is delayed by a random amount, some are lost.
+		network.clear();
+
+		for (uint64_t number = 0; number < packets * packetFrames; number += packetFrames) {
+			if (percent(algorithm) >= 5) {
+				network.emplace_back(JitterBuffer::frameDuration * number + std::chrono::milliseconds(delay(algorithm)),
+									 number);
+			}
+		}
+
+		std::sort(network.begin(), network.end());
+
+		auto next = network.cbegin();
+
+		uint64_t played  = 0;
+		uint32_t dropped = before.dropped;
+		bool started     = false;
+
+		for (auto now = 0ms; now < JitterBuffer::frameDuration * packetFrames * (packets + 50); now += buffer.tick()) {
+			for (; next != network.cend() && next->first <= now; ++next) {
+				buffer.push(next->second, packet, false, epoch + next->first);
+			}
+
+			const auto frame = buffer.pop();
+			if (frame.type == Type::None) {
+				started = false;
+				continue;
+			}
+
+			// Frames are contiguous, unless the buffer skipped one or started over.
+			const auto stats = buffer.stats();
+			if (started && frame.number != played && stats.dropped == dropped) {
+				return 50;
+			}
+
+			started = true;
+			played  = frame.number + frame.frames;
+			dropped = stats.dropped;
+		}
+
+		// Every packet is either played or discarded.
+		const auto stats = buffer.stats();
+		const auto good  = stats.good - before.good;
+		if (good + stats.late - before.late + stats.dropped - before.dropped != network.size() || !good) {
+			return 51;
+		}
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	int32_t ret = testOrder();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testLoss();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testTerminator();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testAdaptation();
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (const auto tick : { 10ms, 20ms }) {
+		ret = testDecode(tick);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	ThreadManager manager;
+
+	for (uint32_t i = 0; i < manager.physicalNum(); ++i) {
+		const ThreadManager::ThreadFunc func = [&ret, &manager]() {
+			const auto threadRet = thread();
+			if (threadRet != 0) {
+				ret = threadRet;
+				manager.requestStop();
+			}
+		};
+
+		manager.add(func);
+	}
+
+	manager.wait();
+
+	return ret;
+}
@@ -0,0 +1,196 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/Legacy.hpp"
+#include "mumble/Message.hpp"
+#include "mumble/Pack.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+static constexpr size_t iterations = 10000;
+
+using namespace mumble;
+
+using Type  = legacy::udp::Type;
+using Voice = legacy::udp::Voice;
+
+static bool equal(const BufViewConst a, const BufViewConst b) {
+	return std::equal(a.begin(), a.end(), b.begin(), b.end());
+}
+
+static bool equal(const Voice &a, const Voice &b) {
+	return a.type == b.type && a.target == b.target && a.session == b.session && a.sequence == b.sequence
+		   && equal(a.payload, b.payload) && a.isTerminator == b.isTerminator && a.position == b.position;
+}
+
+static Voice random(std::mt19937 &algorithm, Buf &payload, const bool hasSession) {
+	std::uniform_int_distribution< uint32_t > gen32;
+	std::uniform_int_distribution< uint16_t > genByte(0, UINT8_MAX);
+	std::uniform_int_distribution< uint16_t > genSize(0, 1000);
+	std::uniform_int_distribution< uint64_t > genSequence(0, UINT32_MAX);
+	std::uniform_real_distribution< float > genFloat(-100.f, 100.f);
+
+	payload.resize(genSize(algorithm));
+	for (auto &byte : payload) {
+		byte = static_cast< std::byte >(genByte(algorithm));
+	}
+
+	Voice voice;
+	voice.target       = static_cast< uint8_t >(gen32(algorithm) & Voice::targetMask);
+	voice.sequence     = genSequence(algorithm);
+	voice.payload      = payload;
+	voice.isTerminator = gen32(algorithm) % 2;
+
+	if (hasSession) {
+		voice.session = gen32(algorithm);
+	}
+
+	if (gen32(algorithm) % 2) {
+		voice.position = { genFloat(algorithm), genFloat(algorithm), genFloat(algorithm) };
+	}
+
+	return voice;
+}
+
+static uint8_t testVoice(const Voice &voice) {
+	const auto size = legacy::udp::encode({}, voice);
+	if (!size) {
+		return 1;
+	}
+
+	Buf packet(size);
+	if (legacy::udp::encode(packet, voice) != size) {
+		return 2;
+	}
+
+	Voice decoded;
+	if (!legacy::udp::decode(decoded, packet, voice.session.has_value())) {
+		return 3;
+	}
+
+	if (!equal(decoded, voice)) {
+		return 4;
+	}
+
+	if (voice.session) {
+		// Strip the session and check that reheader() restores the packet as the server would send it.
+		Voice client   = voice;
+		client.session = {};
+
+		Buf buf(size);
+		const auto clientSize = legacy::udp::encode(buf, client);
+		if (!clientSize) {
+			return 5;
+		}
+
+		if (legacy::udp::reheader(buf, clientSize, voice.session.value(), voice.target) != size) {
+			return 6;
+		}
+
+		if (buf != packet) {
+			return 7;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testPack(const Voice &voice) {
+	const auto size = legacy::udp::toPack({}, voice);
+	if (!size) {
+		return 10;
+	}
+
+	Buf buf(size);
+	if (legacy::udp::toPack(buf, voice) != size) {
+		return 11;
+	}
+
+	udp::Message::Audio audio;
+	if (!legacy::udp::toAudio(audio, voice)) {
+		return 12;
+	}
+
+	// The hand-rolled serializer has to produce exactly what protobuf does.
+	const udp::Pack pack(audio);
+	if (!equal(pack.buf(), buf)) {
+		return 13;
+	}
+
+	udp::Message::Audio parsed;
+	if (!pack(parsed)) {
+		return 14;
+	}
+
+	Voice converted;
+	if (!legacy::udp::fromAudio(converted, parsed)) {
+		return 15;
+	}
+
+	if (!equal(converted, voice)) {
+		return 16;
+	}
+
+	Voice unpacked;
+	if (!legacy::udp::fromPack(unpacked, buf)) {
+		return 17;
+	}
+
+	if (!equal(unpacked, voice)) {
+		return 18;
+	}
+
+	return 0;
+}
+
+static uint8_t testInvalid() {
+	const FixedBuf< 2 > truncated = { std::byte(static_cast< uint8_t >(Type::VoiceOpus) << 5), std::byte(0x80) };
+
+	Voice voice;
+	if (legacy::udp::decode(voice, truncated, false)) {
+		return 20;
+	}
+
+	const FixedBuf< 3 > speex = { std::byte(static_cast< uint8_t >(Type::VoiceSpeex) << 5), std::byte(0),
+								  std::byte(0) };
+	if (legacy::udp::decode(voice, speex, false)) {
+		return 21;
+	}
+
+	voice.target = Voice::targetMask + 1;
+	if (legacy::udp::encode({}, voice)) {
+		return 22;
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	Buf payload;
+
+	for (size_t i = 0; i < iterations; ++i) {
+		const auto voice = random(algorithm, payload, i % 2);
+
+		auto ret = testVoice(voice);
+		if (ret != 0) {
+			return ret;
+		}
+
+		ret = testPack(voice);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return testInvalid();
+}
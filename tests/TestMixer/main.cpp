@@ -0,0 +1,237 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "ThreadManager.hpp"
+
+#include "mumble/JitterBuffer.hpp"
+#include "mumble/Mixer.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <boost/thread/interruption.hpp>
+
+static constexpr size_t iterations = 100;
+static constexpr size_t ticks      = 10;
+// Loud enough for a few speakers to go over full scale when summed.
+static constexpr float level = 0.9f;
+
+using namespace mumble;
+
+// Frame numbers are in 10 ms units.
+static constexpr uint64_t tickFrames = Mixer::tickDuration / JitterBuffer::frameDuration;
+
+static const JitterBuffer::TimePoint epoch = JitterBuffer::Clock::now();
+
+// A single 20 ms packet of constant loud audio.
+static std::vector< std::byte > encode(const uint8_t channels) {
+	Opus::Encoder encoder(channels);
+	if (encoder.init(Mixer::sampleRate) != Code::Success) {
+		return {};
+	}
+
+	const std::vector< float > in(Mixer::tickSamples * channels, level);
+	std::vector< std::byte > out(JitterBuffer::packetSizeMax);
+
+	out.resize(encoder(out, in).size());
+
+	return out;
+}
+
+static bool push(Mixer &mixer, const uint32_t id, const BufViewConst packet, const uint64_t tick) {
+	return mixer.push(id, tick * tickFrames, packet, false, epoch + Mixer::tickDuration * tick);
+}
+
+static bool checkOutput(const Mixer &mixer, const uint32_t id) {
+	const auto packet = mixer.packet(id);
+	if (Opus::packetSamples(packet, Mixer::sampleRate) != Mixer::tickSamples) {
+		return false;
+	}
+
+	const auto pcm = mixer.pcm(id);
+	if (pcm.size() != Mixer::tickSamples * mixer.channels()) {
+		return false;
+	}
+
+	return std::all_of(pcm.begin(), pcm.end(), [](const float sample) { return std::abs(sample) <= 1.f; });
+}
+
+static uint8_t testLimits() {
+	if (Mixer(0) || Mixer(3)) {
+		return 1;
+	}
+
+	Mixer mixer(1, 2, 1, 1);
+	if (!mixer || mixer.channels() != 1) {
+		return 2;
+	}
+
+	if (!mixer.addStream(1) || !mixer.addStream(2) || mixer.addStream(2) || mixer.addStream(3)
+		|| mixer.streams() != 2) {
+		return 3;
+	}
+
+	if (mixer.push(3, 0, {}, false) || mixer.removeStream(3) || !mixer.removeStream(1) || !mixer.addStream(3)) {
+		return 4;
+	}
+
+	if (!mixer.addOutput(1) || mixer.addOutput(2, 1) || mixer.outputs() != 1 || mixer.removeOutput(2)) {
+		return 5;
+	}
+
+	// Nothing was pushed.
+	if (mixer.tick() != 0 || !mixer.packet(1).empty() || !mixer.pcm(1).empty() || !mixer.packet(2).empty()) {
+		return 6;
+	}
+
+	return 0;
+}
+
+static uint8_t testMix(const uint8_t channels) {
+	const auto packet = encode(channels);
+	if (packet.empty()) {
+		return 10;
+	}
+
+	Mixer mixer(channels, 8, 3, 2);
+	if (!mixer || mixer.channels() != channels) {
+		return 11;
+	}
+
+	for (uint32_t id = 1; id <= 4; ++id) {
+		if (!mixer.addStream(id)) {
+			return 12;
+		}
+	}
+
+	// Everyone, everyone but stream 1 and everyone but a stream that doesn't exist yet.
+	if (!mixer.addOutput(1) || !mixer.addOutput(2, 1) || !mixer.addOutput(3, 5, 24000)) {
+		return 13;
+	}
+
+	uint64_t tick = 0;
+
+	// Only stream 1 is talking: the output that leaves it out is silent.
+	for (size_t heard = 0; tick < ticks; ++tick) {
+		push(mixer, 1, packet, tick);
+
+		heard = std::max(heard, mixer.tick());
+		if (heard > 1) {
+			return 14;
+		}
+
+		if (heard && (!checkOutput(mixer, 1) || !mixer.packet(2).empty() || !checkOutput(mixer, 3))) {
+			return 15;
+		}
+	}
+
+	if (!mixer.addStream(5)) {
+		return 16;
+	}
+
+	// Everyone is talking, the sum goes well over full scale.
+	size_t heard = 0;
+
+	for (const auto end = tick + ticks; tick < end; ++tick) {
+		for (uint32_t id = 1; id <= 5; ++id) {
+			push(mixer, id, packet, tick);
+		}
+
+		heard = mixer.tick();
+		if (heard == 5 && (!checkOutput(mixer, 1) || !checkOutput(mixer, 2) || !checkOutput(mixer, 3))) {
+			return 17;
+		}
+	}
+
+	if (heard != 5) {
+		return 18;
+	}
+
+	if (!mixer.removeStream(1) || !mixer.removeOutput(2) || mixer.streams() != 4 || mixer.outputs() != 2) {
+		return 19;
+	}
+
+	return 0;
+}
+
+static uint8_t thread(Mixer &mixer, std::mutex &mutex, const uint32_t id, const BufViewConst packet) {
+	for (size_t i = 0; i < iterations; ++i) {
+		if (boost::this_thread::interruption_requested()) {
+			return 0;
+		}
+
+		if (!mixer.addStream(id)) {
+			return 30;
+		}
+
+		for (uint64_t tick = 0; tick < ticks; ++tick) {
+			if (!push(mixer, id, packet, tick)) {
+				return 31;
+			}
+
+			// Only one thread at a time drives the mixer, the others keep pushing.
+			const std::lock_guard< std::mutex > lock(mutex);
+
+			if (mixer.tick() && !checkOutput(mixer, 1)) {
+				return 32;
+			}
+		}
+
+		if (!mixer.removeStream(id)) {
+			return 33;
+		}
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	int32_t ret = testLimits();
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (const uint8_t channels : { 1, 2 }) {
+		ret = testMix(channels);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	const auto packet = encode(1);
+
+	ThreadManager manager;
+
+	Mixer mixer(1, manager.physicalNum(), 1);
+	if (!mixer.addOutput(1)) {
+		return 20;
+	}
+
+	std::mutex mutex;
+	std::atomic_uint32_t ids(0);
+
+	for (uint32_t i = 0; i < manager.physicalNum(); ++i) {
+		const ThreadManager::ThreadFunc func = [&]() {
+			const auto threadRet = thread(mixer, mutex, ++ids, packet);
+			if (threadRet != 0) {
+				ret = threadRet;
+				manager.requestStop();
+			}
+		};
+
+		manager.add(func);
+	}
+
+	manager.wait();
+
+	return ret;
+}
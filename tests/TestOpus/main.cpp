@@ -9,6 +9,7 @@
 #include "mumble/Types.hpp"
 
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
@@ -17,6 +18,7 @@
 #include <boost/thread/interruption.hpp>
 
 static constexpr size_t iterations = 1000;
+static constexpr size_t poolSize   = 8;
 
 static constexpr uint32_t sampleRate = 48000;
 
@@ -38,6 +40,220 @@ template< typename T > static constexpr T toView(const BufView buf, const uint32
 	return { reinterpret_cast< typename T::value_type * >(buf.data()), samples };
 }
 
+using Bandwidth = Opus::PacketInfo::Bandwidth;
+using Mode      = Opus::PacketInfo::Mode;
+
+template< size_t size > static constexpr Opus::PacketInfo inspect(const std::array< uint8_t, size > &bytes) {
+	std::array< std::byte, size > packet = {};
+	for (size_t i = 0; i < size; ++i) {
+		packet[i] = std::byte(bytes[i]);
+	}
+
+	return Opus::inspect(BufViewConst(packet));
+}
+
+// Stereo 20 ms CELT fullband, two frames of 1 and 2 bytes.
+static constexpr auto vbrInfo = inspect< 5 >({ 0xFE, 0x01, 0x0A, 0x0B, 0x0C });
+static_assert(vbrInfo && vbrInfo.mode == Mode::CELT && vbrInfo.bandwidth == Bandwidth::Full && vbrInfo.stereo
+				  && vbrInfo.code == 2 && vbrInfo.vbr && vbrInfo.frames == 2 && vbrInfo.samples == 1920
+				  && vbrInfo.payload == 3 && vbrInfo.smallestFrame == 1 && vbrInfo.largestFrame == 2,
+			  "Code 2 packet");
+
+// Mono 60 ms SILK wideband, two frames of 1 byte and 2 bytes of padding: 120 ms in total.
+static constexpr auto cbrInfo = inspect< 7 >({ 0x5B, 0x42, 0x02, 0x01, 0x02, 0x00, 0x00 });
+static_assert(cbrInfo && cbrInfo.mode == Mode::SILK && cbrInfo.bandwidth == Bandwidth::Wide && cbrInfo.frames == 2
+				  && cbrInfo.duration() == std::chrono::milliseconds(120) && cbrInfo.padding == 2
+				  && cbrInfo.payload == 2 && cbrInfo.largestFrame == 1,
+			  "Code 3 packet with padding");
+
+// Hybrid, 10 ms.
+static_assert(inspect< 2 >({ 0x60, 0x00 }).mode == Mode::Hybrid && inspect< 2 >({ 0x60, 0x00 }).frameSamples == 480,
+			  "Hybrid packet");
+
+// Odd size for two frames of the same size, no frames, over 120 ms, truncated lengths and padding.
+static_assert(!inspect< 4 >({ 0xF9, 0x00, 0x00, 0x00 }), "Code 1 packet with an odd size");
+static_assert(!inspect< 2 >({ 0xFB, 0x00 }), "Code 3 packet without frames");
+static_assert(!inspect< 2 >({ 0xFB, 0x07 }), "140 ms packet");
+static_assert(!inspect< 2 >({ 0xFA, 0xFC }), "Code 2 packet with a truncated length");
+static_assert(!inspect< 3 >({ 0xFB, 0x42, 0xFF }), "Code 3 packet with truncated padding");
+static_assert(!inspect< 4 >({ 0xFB, 0x83, 0x05, 0x00 }), "Code 3 packet with lengths past the end");
+
+static uint8_t testInspect(const uint8_t channels) {
+	Opus::Encoder encoder(channels);
+	if (!initOpus(encoder)) {
+		return 40;
+	}
+
+	std::vector< float > pcm(bufferSamples.back() * channels);
+	for (size_t i = 0; i < pcm.size(); ++i) {
+		pcm[i] = static_cast< float >(i % 100) / 100.f - 0.5f;
+	}
+
+	// Same results as the library.
+	for (const auto samples : bufferSamples) {
+		Buf packet(4000);
+		packet.resize(encoder(packet, Opus::FloatViewConst(pcm).first(samples * channels)).size());
+
+		const auto info = Opus::inspect(packet);
+		if (!info || info.channels() != Opus::packetChannels(packet) || info.frames != Opus::packetFrames(packet)
+			|| info.samples != Opus::packetSamples(packet, sampleRate)
+			|| info.frameSamples != Opus::packetSamplesPerFrame(packet, sampleRate)) {
+			return 41;
+		}
+
+		if (Opus::inspect(BufViewConst(packet).first(0))) {
+			return 42;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testPools(const uint8_t channels) {
+	Opus::DecoderPool decoders(channels, sampleRate, poolSize);
+	Opus::EncoderPool encoders(channels, sampleRate, poolSize);
+	if (!decoders || !encoders || decoders.available() != poolSize || encoders.available() != poolSize) {
+		return 10;
+	}
+
+	{
+		std::vector< Opus::DecoderPool::Ptr > acquired;
+
+		for (size_t i = 0; i < poolSize; ++i) {
+			acquired.push_back(decoders.acquire());
+
+			const auto &decoder = acquired.back();
+			if (!decoder || decoder->channels() != channels || decoder->sampleRate() != sampleRate) {
+				return 11;
+			}
+		}
+
+		if (decoders.acquire() || decoders.available()) {
+			return 12;
+		}
+	}
+
+	if (decoders.available() != poolSize) {
+		return 13;
+	}
+
+	// The settings are restored when an encoder is given back.
+	{
+		std::vector< Opus::EncoderPool::Ptr > acquired;
+
+		for (size_t i = 0; i < poolSize; ++i) {
+			acquired.push_back(encoders.acquire());
+
+			auto &encoder = *acquired.back();
+			if (!encoder.setBitrate(16000) || !encoder.toggleVBR(false) || !encoder.toggleFEC(true)
+				|| !encoder.setPacketLoss(10) || !encoder.usesFEC() || encoder.packetLoss() != 10) {
+				return 14;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < poolSize; ++i) {
+		const auto encoder = encoders.acquire();
+		if (!encoder || encoder->bitrate() == 16000 || !encoder->usesVBR() || encoder->usesFEC()
+			|| encoder->packetLoss() || encoder->preset() != Opus::Encoder::Preset::VoIP) {
+			return 15;
+		}
+	}
+
+	// Pooled coders work like regular ones.
+	const auto decoder = decoders.acquire();
+	const auto encoder = encoders.acquire();
+
+	std::vector< float > pcm(bufferSamples.back() * channels);
+	Buf packet(4000);
+
+	const auto encoded = (*encoder)(packet, Opus::FloatViewConst(pcm).first(960 * channels));
+	if (encoded.empty() || (*decoder)(pcm, encoded).size() != 960 * channels) {
+		return 16;
+	}
+
+	return 0;
+}
+
+static uint8_t testRepacketizer(const uint8_t channels) {
+	Opus::Encoder encoder(channels);
+	if (!initOpus(encoder)) {
+		return 20;
+	}
+
+	const std::vector< float > pcm(960 * channels);
+
+	// Three 20 ms packets and a 10 ms one.
+	std::array< Buf, 4 > packets;
+	for (size_t i = 0; i < packets.size(); ++i) {
+		auto &packet = packets[i];
+		packet.resize(4000);
+
+		const auto samples = i < 3 ? pcm.size() : pcm.size() / 2;
+		packet.resize(encoder(packet, Opus::FloatViewConst(pcm).first(samples)).size());
+		if (packet.empty()) {
+			return 21;
+		}
+	}
+
+	Opus::Repacketizer repacketizer;
+	if (!repacketizer || repacketizer.frames() != 0) {
+		return 22;
+	}
+
+	for (size_t i = 0; i < 3; ++i) {
+		if (repacketizer.add(packets[i]) != Code::Success) {
+			return 23;
+		}
+	}
+
+	// Different frame size.
+	if (repacketizer.add(packets[3]) == Code::Success || repacketizer.frames() != 3) {
+		return 24;
+	}
+
+	Buf merged(4000);
+	merged.resize(repacketizer(merged).size());
+	if (Opus::packetFrames(merged) != 3 || Opus::packetSamples(merged, sampleRate) != 2880
+		|| Opus::packetChannels(merged) != channels) {
+		return 25;
+	}
+
+	// Split back into single frames.
+	repacketizer.reset();
+	if (repacketizer.add(merged) != Code::Success || repacketizer.frames() != 3) {
+		return 26;
+	}
+
+	for (uint32_t i = 0; i < 3; ++i) {
+		Buf out(4000);
+		const auto packet = repacketizer(out, i, i + 1);
+		if (Opus::packetSamples(packet, sampleRate) != 960) {
+			return 27;
+		}
+	}
+
+	// Too small and out of range.
+	Buf small(2);
+	Buf out(4000);
+	if (!repacketizer(small).empty() || !repacketizer(out, 2, 4).empty() || !repacketizer(out, 1, 1).empty()) {
+		return 28;
+	}
+
+	// Up to 120 ms.
+	for (size_t i = 0; i < 3; ++i) {
+		if (repacketizer.add(packets[i]) != Code::Success) {
+			return 29;
+		}
+	}
+
+	if (repacketizer.add(packets[0]) == Code::Success) {
+		return 30;
+	}
+
+	return 0;
+}
+
 static uint8_t thread(const uint8_t channels) {
 	using FView = Opus::FloatView;
 	using IView = Opus::IntegerView;
@@ -89,6 +305,23 @@ static uint8_t thread(const uint8_t channels) {
 int32_t main() {
 	int32_t ret = 0;
 
+	for (uint8_t channels = 1; channels <= 2; ++channels) {
+		ret = testPools(channels);
+		if (ret != 0) {
+			return ret;
+		}
+
+		ret = testRepacketizer(channels);
+		if (ret != 0) {
+			return ret;
+		}
+
+		ret = testInspect(channels);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
 	ThreadManager manager;
 
 	for (uint8_t i = 0; i < 2; ++i) {
@@ -0,0 +1,315 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/PCM.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Not a multiple of any block size, so that the scalar tails are covered too.
+static constexpr size_t samples = 1000 + 7;
+
+static constexpr double pi = 3.14159265358979323846;
+
+using namespace mumble;
+
+static_assert(PCM::gain(0.f) == 1.f && PCM::gain(0.5f) == 0.5f && PCM::gain(2.f) == 2.f);
+
+// What the native implementations have to match exactly.
+static int16_t toSample(const float value) {
+	return static_cast< int16_t >(std::lrint(std::clamp(value, -32768.f, 32767.f)));
+}
+
+static std::vector< float > sine(const uint8_t channels, const uint32_t rate, const size_t frames,
+								 const double frequency) {
+	std::vector< float > ret(frames * channels);
+
+	for (size_t i = 0; i < frames; ++i) {
+		const auto value = static_cast< float >(0.5 * std::sin(2 * pi * frequency * i / rate));
+
+		// The second channel is inverted, to tell them apart.
+		for (uint8_t channel = 0; channel < channels; ++channel) {
+			ret[i * channels + channel] = channel ? -value : value;
+		}
+	}
+
+	return ret;
+}
+
+static uint8_t testConvert(std::mt19937 &algorithm) {
+	std::uniform_int_distribution< int32_t > integers(INT16_MIN, INT16_MAX);
+	std::uniform_real_distribution< float > floats(-1.5f, 1.5f);
+
+	std::vector< int16_t > integer(samples);
+	std::vector< float > floating(samples);
+
+	for (auto &sample : integer) {
+		sample = static_cast< int16_t >(integers(algorithm));
+	}
+
+	integer[0] = INT16_MIN;
+	integer[1] = INT16_MAX;
+
+	// Every 16 bit value is exact in float, the conversion back gives the same samples.
+	if (PCM::toFloat(floating, integer) != samples) {
+		return 1;
+	}
+
+	for (size_t i = 0; i < samples; ++i) {
+		if (floating[i] != static_cast< float >(integer[i]) / 32768.f || std::abs(floating[i]) > 1.f) {
+			return 2;
+		}
+	}
+
+	std::vector< int16_t > back(samples);
+	if (PCM::toInteger(back, floating) != samples || back != integer) {
+		return 3;
+	}
+
+	// Out of range values saturate.
+	for (auto &sample : floating) {
+		sample = floats(algorithm);
+	}
+
+	floating[0] = 1.f;
+	floating[1] = -1.f;
+	floating[2] = std::numeric_limits< float >::max();
+	floating[3] = std::numeric_limits< float >::lowest();
+
+	PCM::toInteger(back, floating);
+
+	if (back[0] != INT16_MAX || back[1] != INT16_MIN || back[2] != INT16_MAX || back[3] != INT16_MIN) {
+		return 4;
+	}
+
+	for (size_t i = 0; i < samples; ++i) {
+		if (back[i] != toSample(floating[i] * 32768.f)) {
+			return 5;
+		}
+	}
+
+	// Only what both views can take.
+	if (PCM::toInteger(Opus::IntegerView(back).first(10), floating) != 10 || PCM::toFloat({}, integer) != 0) {
+		return 6;
+	}
+
+	return 0;
+}
+
+static uint8_t testGain(std::mt19937 &algorithm) {
+	std::uniform_int_distribution< int32_t > integers(INT16_MIN, INT16_MAX);
+
+	std::vector< int16_t > integer(samples);
+	for (auto &sample : integer) {
+		sample = static_cast< int16_t >(integers(algorithm));
+	}
+
+	for (const float gain : { 0.f, 0.5f, 1.f, 1.7f }) {
+		std::vector< int16_t > out(integer);
+
+		// In place.
+		if (PCM::applyGain(out, out, gain) != samples) {
+			return 10;
+		}
+
+		for (size_t i = 0; i < samples; ++i) {
+			if (out[i] != toSample(static_cast< float >(integer[i]) * gain)) {
+				return 11;
+			}
+		}
+	}
+
+	std::vector< float > floating(samples);
+	PCM::toFloat(floating, integer);
+
+	std::vector< float > out(samples);
+	if (PCM::applyGain(out, floating, 2.f) != samples) {
+		return 12;
+	}
+
+	for (size_t i = 0; i < samples; ++i) {
+		if (out[i] != std::clamp(floating[i] * 2.f, -1.f, 1.f)) {
+			return 13;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testChannels() {
+	const auto mono = sine(1, 48000, samples, 1000);
+
+	std::vector< float > stereo(samples * 2);
+	if (PCM::toStereo(stereo, mono) != samples) {
+		return 20;
+	}
+
+	for (size_t i = 0; i < samples; ++i) {
+		if (stereo[i * 2] != mono[i] || stereo[i * 2 + 1] != mono[i]) {
+			return 21;
+		}
+	}
+
+	std::vector< float > back(samples);
+	if (PCM::toMono(back, stereo) != samples || back != mono) {
+		return 22;
+	}
+
+	// The inverted channel cancels the other one out.
+	const auto inverted = sine(2, 48000, samples, 1000);
+	if (PCM::toMono(back, inverted) != samples
+		|| !std::all_of(back.begin(), back.end(), [](const float sample) { return sample == 0.f; })) {
+		return 23;
+	}
+
+	// Only whole frames.
+	if (PCM::toMono(back, Opus::FloatViewConst(stereo).first(5)) != 2 || PCM::toStereo(stereo, {}) != 0
+		|| PCM::toStereo(Opus::FloatView(stereo).first(5), mono) != 2) {
+		return 24;
+	}
+
+	return 0;
+}
+
+static uint8_t testResamplerLimits() {
+	if (PCM::Resampler(0, 48000, 48000) || PCM::Resampler(1, 0, 48000) || PCM::Resampler(1, 48000, 0)
+		|| PCM::Resampler(1, 48000, 44099)) {
+		return 30;
+	}
+
+	PCM::Resampler resampler(2, 16000, 48000);
+	if (!resampler || resampler.channels() != 2 || resampler.inRate() != 16000 || resampler.outRate() != 48000) {
+		return 31;
+	}
+
+	// Not enough room, a partial frame: nothing is consumed.
+	std::vector< float > in(320 * 2, 0.5f);
+	std::vector< float > out(resampler.outputSize(in.size()));
+
+	if (out.size() < in.size() * 3 || !resampler(Opus::FloatView(out).first(in.size()), in).empty()
+		|| !resampler(out, Opus::FloatViewConst(in).first(3)).empty()) {
+		return 32;
+	}
+
+	// The first call fills the history.
+	const auto first = resampler(out, in).size();
+	if (first != (320 - PCM::Resampler::taps / 2) * 3 * 2) {
+		return 33;
+	}
+
+	if (resampler(out, in).size() != in.size() * 3) {
+		return 34;
+	}
+
+	// Back to the initial state.
+	resampler.reset();
+	if (resampler(out, in).size() != first) {
+		return 35;
+	}
+
+	return 0;
+}
+
+static uint8_t testResample(const uint32_t inRate, const uint32_t outRate, std::mt19937 &algorithm) {
+	constexpr uint8_t channels   = 2;
+	constexpr double frequency   = 1000;
+	constexpr double tolerance   = 0.01;
+	constexpr size_t inputFrames = 4800;
+
+	const auto in = sine(channels, inRate, inputFrames, frequency);
+
+	PCM::Resampler whole(channels, inRate, outRate);
+	PCM::Resampler chunked(channels, inRate, outRate);
+	if (!whole || !chunked) {
+		return 40;
+	}
+
+	std::vector< float > out(whole.outputSize(in.size()));
+	const auto written = whole(out, in);
+
+	// The input held back is all that's missing.
+	const size_t expected = (inputFrames - PCM::Resampler::taps / 2) * outRate / inRate;
+	if (written.size() / channels < expected - 1 || written.size() / channels > expected + 1) {
+		return 41;
+	}
+
+	// The first output frame is aligned with the first input frame. The edges are left out, the filter starts from
+	// silence.
+	const size_t margin = PCM::Resampler::taps * outRate / inRate;
+
+	for (size_t i = margin; i < written.size() / channels; ++i) {
+		const auto left  = written[i * channels];
+		const auto right = written[i * channels + 1];
+
+		if (std::abs(left - 0.5 * std::sin(2 * pi * frequency * i / outRate)) > tolerance || right != -left) {
+			return 42;
+		}
+	}
+
+	// Splitting the input gives the same output, to the bit.
+	std::uniform_int_distribution< size_t > sizes(0, 500);
+
+	std::vector< float > streamed;
+	std::vector< float > chunk;
+
+	for (size_t offset = 0; offset < inputFrames;) {
+		const auto frames = std::min(sizes(algorithm), inputFrames - offset);
+		const auto view   = Opus::FloatViewConst(in).subspan(offset * channels, frames * channels);
+
+		chunk.resize(chunked.outputSize(view.size()));
+
+		const auto ret = chunked(chunk, view);
+		streamed.insert(streamed.end(), ret.begin(), ret.end());
+
+		offset += frames;
+	}
+
+	if (streamed.size() != written.size() || !std::equal(streamed.begin(), streamed.end(), written.begin())) {
+		return 43;
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	int32_t ret = testConvert(algorithm);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testGain(algorithm);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testChannels();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testResamplerLimits();
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (const auto &rates : { std::pair(16000, 48000), std::pair(48000, 16000), std::pair(44100, 48000),
+							   std::pair(48000, 44100), std::pair(48000, 48000) }) {
+		ret = testResample(rates.first, rates.second, algorithm);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
@@ -7,8 +7,11 @@
 
 #include "mumble/PacketDataStream.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <string_view>
+#include <vector>
 
 using namespace mumble;
 
@@ -128,3 +131,54 @@ void TestPacketDataStream::undersize() {
 	assert(out);
 	assert(out.seek().empty());
 }
+
+void TestPacketDataStream::bulk() {
+	std::vector< uint64_t > valuesOut;
+	for (uint8_t i = 0; i < 64; ++i) {
+		valuesOut.push_back(1ULL << i);
+		valuesOut.push_back(~(1ULL << i));
+		valuesOut.push_back((1ULL << i) - 1);
+	}
+
+	std::vector< std::byte > buffer(valuesOut.size() * 10);
+
+	PacketDataStream out(buffer);
+	out.encode(valuesOut);
+	assert(out);
+
+	// The last values are decoded byte by byte, as there is not enough data left for the fast path.
+	std::vector< uint64_t > valuesIn(valuesOut.size() + 1);
+
+	PacketDataStream in({ buffer.data(), out.data().size() });
+	assert(in.decode(valuesIn) == valuesOut.size());
+	assert(std::equal(valuesOut.begin(), valuesOut.end(), valuesIn.begin()));
+	assert(in);
+	assert(in.seek().empty());
+
+	// Truncated value.
+	PacketDataStream truncated({ buffer.data(), out.data().size() - 1 });
+	assert(truncated.decode(valuesIn) == valuesOut.size() - 1);
+	assert(!truncated);
+}
+
+void TestPacketDataStream::view() {
+	std::array< std::byte, bufferSize > buffer{};
+
+	std::array< std::byte, 32 > data;
+	data.fill(std::byte('Z'));
+
+	PacketDataStream out(buffer);
+	out << data << std::string_view("String");
+
+	PacketDataStream in({ buffer.data(), out.data().size() });
+
+	BufViewConst dataIn;
+	std::string_view strIn;
+	in >> dataIn >> strIn;
+
+	assert(std::equal(data.begin(), data.end(), dataIn.begin(), dataIn.end()));
+	assert(dataIn.data() == buffer.data() + 1);
+	assert(strIn == "String");
+	assert(in);
+	assert(in.seek().empty());
+}
@@ -13,6 +13,8 @@ public:
 	static void string();
 	static void space();
 	static void undersize();
+	static void bulk();
+	static void view();
 };
 
 #endif
@@ -11,6 +11,8 @@ int main() {
 	TestPacketDataStream::string();
 	TestPacketDataStream::space();
 	TestPacketDataStream::undersize();
+	TestPacketDataStream::bulk();
+	TestPacketDataStream::view();
 
 	return 0;
 }
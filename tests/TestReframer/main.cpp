@@ -0,0 +1,209 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/Message.hpp"
+#include "mumble/Opus.hpp"
+#include "mumble/Reframer.hpp"
+#include "mumble/Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static constexpr uint32_t sampleRate = 48000;
+static constexpr uint32_t session    = 7;
+
+using namespace mumble;
+
+using namespace std::chrono_literals;
+
+using Audio    = udp::Message::Audio;
+using Messages = Reframer::Messages;
+
+// A packet with a single frame of the specified length.
+static Buf encode(const std::chrono::milliseconds duration) {
+	Opus::Encoder encoder(1);
+	if (encoder.init(sampleRate) != Code::Success) {
+		return {};
+	}
+
+	const std::vector< float > pcm(sampleRate / 1000 * duration.count());
+
+	Buf packet(4000);
+	packet.resize(encoder(packet, pcm).size());
+
+	return packet;
+}
+
+static Messages push(Reframer &reframer, const uint64_t number, const Buf &packet, const bool terminator = false) {
+	Audio audio;
+	audio.direction     = Audio::ServerToClient;
+	audio.context       = 1;
+	audio.senderSession = session;
+	audio.frameNumber   = number;
+	audio.opusData      = packet;
+	audio.isTerminator  = terminator;
+
+	return reframer(audio);
+}
+
+static bool check(const Messages messages, const size_t index, const uint64_t number,
+				  const std::chrono::milliseconds duration, const bool terminator = false) {
+	if (index >= messages.size()) {
+		return false;
+	}
+
+	const auto &audio = messages[index];
+	if (audio.frameNumber != number || audio.isTerminator != terminator || audio.senderSession != session
+		|| audio.context != 1) {
+		return false;
+	}
+
+	return Opus::packetSamples(audio.opusData, sampleRate) == sampleRate / 1000 * duration.count();
+}
+
+static uint8_t testMerge(const Buf &packet) {
+	if (Reframer(0ms) || Reframer(15ms) || Reframer(130ms)) {
+		return 1;
+	}
+
+	Reframer reframer(60ms);
+	if (!reframer || reframer.duration() != 60ms) {
+		return 2;
+	}
+
+	// Three 20 ms packets make one.
+	for (const uint64_t number : { 0, 6 }) {
+		if (!push(reframer, number, packet).empty() || !push(reframer, number + 2, packet).empty()
+			|| reframer.pending() != 4) {
+			return 3;
+		}
+
+		const auto messages = push(reframer, number + 4, packet);
+		if (messages.size() != 1 || !check(messages, 0, number, 60ms) || reframer.pending()) {
+			return 4;
+		}
+	}
+
+	// The terminator sends what's left.
+	push(reframer, 12, packet);
+
+	auto messages = push(reframer, 14, packet, true);
+	if (messages.size() != 1 || !check(messages, 0, 12, 40ms, true)) {
+		return 5;
+	}
+
+	// A lost packet: the frames held are sent as they are, the numbering carries on from the next one.
+	push(reframer, 20, packet);
+
+	messages = push(reframer, 24, packet);
+	if (messages.size() != 1 || !check(messages, 0, 20, 20ms) || reframer.pending() != 2) {
+		return 6;
+	}
+
+	push(reframer, 26, packet);
+
+	messages = push(reframer, 28, packet);
+	if (messages.size() != 1 || !check(messages, 0, 24, 60ms)) {
+		return 7;
+	}
+
+	// An empty terminator flags the last packet.
+	push(reframer, 30, packet);
+
+	messages = push(reframer, 32, {}, true);
+	if (messages.size() != 1 || !check(messages, 0, 30, 20ms, true)) {
+		return 8;
+	}
+
+	// Nothing held, it's forwarded.
+	messages = push(reframer, 34, {}, true);
+	if (messages.size() != 1 || messages[0].frameNumber != 34 || !messages[0].opusData.empty()
+		|| !messages[0].isTerminator) {
+		return 9;
+	}
+
+	push(reframer, 40, packet);
+
+	messages = reframer.flush();
+	if (messages.size() != 1 || !check(messages, 0, 40, 20ms) || !reframer.flush().empty()) {
+		return 10;
+	}
+
+	push(reframer, 50, packet);
+	reframer.reset();
+
+	if (reframer.pending() || !reframer.flush().empty()) {
+		return 11;
+	}
+
+	return 0;
+}
+
+static uint8_t testSplit(const Buf &packet, const Buf &shortPacket) {
+	// A 60 ms packet made of three frames.
+	Opus::Repacketizer repacketizer;
+	for (size_t i = 0; i < 3; ++i) {
+		repacketizer.add(packet);
+	}
+
+	Buf merged(4000);
+	merged.resize(repacketizer(merged).size());
+
+	Reframer reframer(20ms);
+
+	auto messages = push(reframer, 100, merged);
+	if (messages.size() != 3 || reframer.pending()) {
+		return 20;
+	}
+
+	for (size_t i = 0; i < messages.size(); ++i) {
+		if (!check(messages, i, 100 + 2 * i, 20ms)) {
+			return 21;
+		}
+	}
+
+	// Frames can't be cut.
+	Reframer reframer10(10ms);
+
+	messages = push(reframer10, 200, packet, true);
+	if (messages.size() != 1 || !check(messages, 0, 200, 20ms, true)) {
+		return 22;
+	}
+
+	// The frame size changes: the frames held are sent first.
+	push(reframer, 300, shortPacket);
+
+	messages = push(reframer, 301, shortPacket);
+	if (messages.size() != 1 || !check(messages, 0, 300, 20ms)) {
+		return 23;
+	}
+
+	push(reframer, 302, shortPacket);
+
+	messages = push(reframer, 303, packet);
+	if (messages.size() != 2 || !check(messages, 0, 302, 10ms) || !check(messages, 1, 303, 20ms)
+		|| reframer.pending()) {
+		return 24;
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	const auto packet      = encode(20ms);
+	const auto shortPacket = encode(10ms);
+	if (packet.empty() || shortPacket.empty()) {
+		return 100;
+	}
+
+	const int32_t ret = testMerge(packet);
+	if (ret != 0) {
+		return ret;
+	}
+
+	return testSplit(packet, shortPacket);
+}
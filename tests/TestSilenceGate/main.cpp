@@ -0,0 +1,159 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "mumble/Opus.hpp"
+#include "mumble/SilenceGate.hpp"
+#include "mumble/Types.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+using namespace mumble;
+
+using namespace std::chrono_literals;
+
+using Class   = SilenceGate::Class;
+using Verdict = SilenceGate::Verdict;
+
+// Mono 20 ms CELT packets (a single frame): 60 bytes of speech, 6 bytes of background and DTX.
+static Buf packet(const size_t size) {
+	Buf packet(size);
+	packet[0] = std::byte(0xF8);
+
+	return packet;
+}
+
+static const Buf speech = packet(61);
+static const Buf quiet  = packet(7);
+static const Buf dtx    = packet(1);
+
+// 20 ms packets, "number" counts them.
+static Verdict push(SilenceGate &gate, const uint64_t number, const Buf &packet, const bool terminator = false) {
+	return gate(number * 2, packet, terminator);
+}
+
+static uint8_t testClassify() {
+	if (SilenceGate::classify(Opus::inspect(speech)) != Class::Speech
+		|| SilenceGate::classify(Opus::inspect(quiet)) != Class::Quiet
+		|| SilenceGate::classify(Opus::inspect(dtx)) != Class::DTX) {
+		return 1;
+	}
+
+	// The threshold is per 10 ms.
+	if (SilenceGate::classify(Opus::inspect(quiet), 3) != Class::Speech
+		|| SilenceGate::classify(Opus::inspect(speech), 31) != Class::Quiet) {
+		return 2;
+	}
+
+	// Malformed.
+	if (SilenceGate::classify(Opus::inspect(BufViewConst())) != Class::Speech) {
+		return 3;
+	}
+
+	return 0;
+}
+
+static uint8_t testHangover() {
+	SilenceGate gate;
+	if (!gate || gate.open() || gate.config().hangover != 300ms) {
+		return 10;
+	}
+
+	// Nothing to forward until the speaker talks.
+	if (push(gate, 0, quiet) != Verdict::Drop || push(gate, 1, dtx) != Verdict::Drop || gate.open()) {
+		return 11;
+	}
+
+	if (push(gate, 2, speech) != Verdict::Forward || !gate.open()) {
+		return 12;
+	}
+
+	// 300 ms of silence go through, the packet that completes them closes the gate.
+	uint64_t number = 3;
+
+	for (; number < 3 + 14; ++number) {
+		if (push(gate, number, number % 2 ? quiet : dtx) != Verdict::Forward) {
+			return 13;
+		}
+	}
+
+	if (push(gate, number++, quiet) != Verdict::Terminate || gate.open()) {
+		return 14;
+	}
+
+	for (const auto end = number + 100; number < end; ++number) {
+		if (push(gate, number, quiet) != Verdict::Drop) {
+			return 15;
+		}
+	}
+
+	// Speech reopens it right away, a short pause doesn't close it.
+	if (push(gate, number++, speech) != Verdict::Forward || push(gate, number++, quiet) != Verdict::Forward
+		|| push(gate, number++, speech) != Verdict::Forward || !gate.open()) {
+		return 16;
+	}
+
+	// The speaker's own terminator is forwarded, the one that follows a closed gate isn't.
+	if (push(gate, number++, {}, true) != Verdict::Forward || gate.open()
+		|| push(gate, number++, {}, true) != Verdict::Drop) {
+		return 17;
+	}
+
+	const auto stats = gate.stats();
+	if (stats.dropped != 103 || stats.forwarded != number - 103 || stats.bytesSaved != 1 + 101 * 7) {
+		return 18;
+	}
+
+	return 0;
+}
+
+static uint8_t testConfig() {
+	SilenceGate::Config config;
+	config.hangover  = 0ms;
+	config.keepAlive = 1s;
+
+	SilenceGate gate(config);
+
+	if (push(gate, 0, speech) != Verdict::Forward || push(gate, 1, quiet) != Verdict::Terminate) {
+		return 20;
+	}
+
+	// One packet every second, each on its own.
+	for (uint64_t number = 2; number < 200; ++number) {
+		const auto expected = number % 50 == 1 ? Verdict::Terminate : Verdict::Drop;
+		if (push(gate, number, quiet) != expected) {
+			return 21;
+		}
+	}
+
+	config.enabled = false;
+	gate.setConfig(config);
+
+	if (push(gate, 200, dtx) != Verdict::Forward || gate.config().enabled) {
+		return 22;
+	}
+
+	gate.reset();
+	if (gate.open()) {
+		return 23;
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	int32_t ret = testClassify();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testHangover();
+	if (ret != 0) {
+		return ret;
+	}
+
+	return testConfig();
+}
@@ -0,0 +1,239 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "ThreadManager.hpp"
+
+#include "mumble/Opus.hpp"
+#include "mumble/Transcoder.hpp"
+#include "mumble/Types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <boost/thread/interruption.hpp>
+
+static constexpr size_t iterations = 100;
+static constexpr size_t packets    = 10;
+
+static constexpr uint32_t sampleRate = 48000;
+static constexpr uint32_t bitrate    = 64000;
+
+using namespace mumble;
+
+using Variant = Transcoder::Variant;
+
+// The variants are given in no particular order on purpose.
+static const std::vector< Variant > variants = { { 24000, Opus::Encoder::Preset::VoIP, true, 10 },
+												 { 12000, Opus::Encoder::Preset::VoIP, true, 20 } };
+
+// A single 20 ms packet at the original bitrate.
+static std::vector< std::byte > encode(const uint8_t channels) {
+	Opus::Encoder encoder(channels);
+	if (encoder.init(sampleRate) != Code::Success || !encoder.setBitrate(bitrate)) {
+		return {};
+	}
+
+	const std::vector< float > in(sampleRate / 50 * channels, 0.5f);
+	std::vector< std::byte > out(4000);
+
+	out.resize(encoder(out, in).size());
+
+	return out;
+}
+
+static bool checkOutput(const Transcoder &transcoder, const uint32_t id, const size_t variant, const size_t count,
+						const size_t original) {
+	const auto output = transcoder.output(id, variant);
+	if (output.size() != count) {
+		return false;
+	}
+
+	for (size_t i = 0; i < output.size(); ++i) {
+		const auto &packet = output[i];
+		const auto info    = Opus::inspect(packet.data);
+
+		if (packet.number != i * 2 || packet.terminator != (i + 1 == count) || !info || info.samples != 960
+			|| packet.data.size() >= original) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static uint8_t testSelect() {
+	if (Transcoder({}) || Transcoder(variants, 3)) {
+		return 1;
+	}
+
+	const Transcoder transcoder(variants, 1, 1, 1);
+	if (!transcoder || transcoder.variants() != 2 || transcoder.variant(1).bitrate != 12000
+		|| transcoder.variant(2).bitrate == 12000) {
+		return 2;
+	}
+
+	// The original fits.
+	if (transcoder.select(bitrate, bitrate)) {
+		return 3;
+	}
+
+	if (transcoder.select(30000, bitrate) != 0 || transcoder.select(20000, bitrate) != 1
+		|| transcoder.select(8000, bitrate) != 1 || transcoder.select(bitrate) != 0) {
+		return 4;
+	}
+
+	return 0;
+}
+
+static uint8_t testTranscode(const uint8_t channels) {
+	const auto packet = encode(channels);
+	if (packet.empty()) {
+		return 10;
+	}
+
+	Transcoder transcoder(variants, channels, 2, 2);
+	if (!transcoder || transcoder.channels() != channels) {
+		return 11;
+	}
+
+	if (!transcoder.addStream(1) || !transcoder.addStream(2) || transcoder.addStream(2) || transcoder.addStream(3)) {
+		return 12;
+	}
+
+	if (transcoder.subscribe(3, 0) || transcoder.subscribe(1, 2) || transcoder.unsubscribe(1, 0)) {
+		return 13;
+	}
+
+	// Nobody is subscribed yet: the packets are decoded, but not encoded again.
+	if (!transcoder.push(1, 0, packet, false) || transcoder.process() != 1 || !transcoder.output(1, 0).empty()) {
+		return 14;
+	}
+
+	if (!transcoder.subscribe(1, 0) || !transcoder.subscribe(1, 0) || !transcoder.subscribe(1, 1)
+		|| transcoder.subscribers(1, 0) != 2 || transcoder.subscribers(2, 0) != 0) {
+		return 15;
+	}
+
+	for (size_t i = 0; i < packets; ++i) {
+		if (!transcoder.push(1, i * 2, packet, i + 1 == packets)) {
+			return 16;
+		}
+	}
+
+	if (transcoder.process() != packets) {
+		return 17;
+	}
+
+	if (!checkOutput(transcoder, 1, 0, packets, packet.size()) || !checkOutput(transcoder, 1, 1, packets, packet.size())
+		|| !transcoder.output(2, 0).empty()) {
+		return 18;
+	}
+
+	// The lower variant is smaller.
+	if (transcoder.output(1, 1)[0].data.size() >= transcoder.output(1, 0)[0].data.size()) {
+		return 19;
+	}
+
+	const auto stats = transcoder.stats(1);
+	if (stats.decoded != packets + 1 || stats.encoded != packets * 2 || stats.failed
+		|| stats.bytes != packet.size() * (packets + 1) || stats.bitrate() != packet.size() * 8 * 50) {
+		return 20;
+	}
+
+	// Only the last call's packets are kept. A terminator without audio still goes through.
+	if (!transcoder.push(1, 100, {}, true) || transcoder.process() != 0 || transcoder.output(1, 0).size() != 1
+		|| !transcoder.output(1, 0)[0].terminator || !transcoder.output(1, 0)[0].data.empty()) {
+		return 21;
+	}
+
+	if (!transcoder.unsubscribe(1, 0) || transcoder.subscribers(1, 0) != 1 || !transcoder.unsubscribe(1, 0)
+		|| transcoder.unsubscribe(1, 0) || !transcoder.output(1, 0).empty()) {
+		return 22;
+	}
+
+	if (!transcoder.removeStream(1) || transcoder.push(1, 0, packet, false) || transcoder.streams() != 1) {
+		return 23;
+	}
+
+	return 0;
+}
+
+static uint8_t thread(Transcoder &transcoder, std::mutex &mutex, const uint32_t id, const BufViewConst packet) {
+	for (size_t i = 0; i < iterations; ++i) {
+		if (boost::this_thread::interruption_requested()) {
+			return 0;
+		}
+
+		if (!transcoder.addStream(id) || !transcoder.subscribe(id, 1)) {
+			return 30;
+		}
+
+		for (uint64_t number = 0; number < packets; ++number) {
+			if (!transcoder.push(id, number * 2, packet, false)) {
+				return 31;
+			}
+		}
+
+		// Only one thread at a time drives the transcoder, the others keep pushing.
+		{
+			const std::lock_guard< std::mutex > lock(mutex);
+
+			transcoder.process();
+
+			// All of our packets were pushed before, no matter which thread processed them.
+			if (transcoder.stats(id).encoded != packets) {
+				return 32;
+			}
+		}
+
+		if (!transcoder.removeStream(id)) {
+			return 33;
+		}
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	int32_t ret = testSelect();
+	if (ret != 0) {
+		return ret;
+	}
+
+	for (const uint8_t channels : { 1, 2 }) {
+		ret = testTranscode(channels);
+		if (ret != 0) {
+			return ret;
+		}
+	}
+
+	const auto packet = encode(1);
+
+	ThreadManager manager;
+
+	Transcoder transcoder(variants, 1, manager.physicalNum());
+
+	std::mutex mutex;
+	std::atomic_uint32_t ids(0);
+
+	for (uint32_t i = 0; i < manager.physicalNum(); ++i) {
+		const ThreadManager::ThreadFunc func = [&]() {
+			const auto threadRet = thread(transcoder, mutex, ++ids, packet);
+			if (threadRet != 0) {
+				ret = threadRet;
+				manager.requestStop();
+			}
+		};
+
+		manager.add(func);
+	}
+
+	manager.wait();
+
+	return ret;
+}
@@ -0,0 +1,79 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#ifndef MUMBLE_TESTTRUSTSTORE_DATA_HPP
+#define MUMBLE_TESTTRUSTSTORE_DATA_HPP
+
+#include <string_view>
+
+struct Data {
+	// Root authority: "/CN=Test Root".
+	static constexpr std::string_view root =
+		"-----BEGIN CERTIFICATE-----\n"
+		"MIIBfjCCASWgAwIBAgIUbw56COm3RgJml5tZvrwOh1OZzyYwCgYIKoZIzj0EAwIw\n"
+		"FDESMBAGA1UEAwwJVGVzdCBSb290MCAXDTI2MTAxOTAzNTUyNloYDzIxMjYwOTI1\n"
+		"MDM1NTI2WjAUMRIwEAYDVQQDDAlUZXN0IFJvb3QwWTATBgcqhkjOPQIBBggqhkjO\n"
+		"PQMBBwNCAASVO3/O6z8q0cxCDjHSHG0qa+rH4ubTJzo0Y1OvB+PblN0QdADpqv2H\n"
+		"VmC8Vhm9gDXpRhIituvNxfU+NAi201YYo1MwUTAdBgNVHQ4EFgQUAhsZ7CCM0wWL\n"
+		"nYb+7Xw+JOpDrJ0wHwYDVR0jBBgwFoAUAhsZ7CCM0wWLnYb+7Xw+JOpDrJ0wDwYD\n"
+		"VR0TAQH/BAUwAwEB/zAKBggqhkjOPQQDAgNHADBEAiBY1ZxHtQdpWoT/MeIOaZ6e\n"
+		"jSNNQCAeNgldTzvs2UtDswIgIeqQKcQAHcWrRKiC/gIbZhK5A74D/ZpikseaUHOS\n"
+		"vxU=\n"
+		"-----END CERTIFICATE-----\n";
+
+	// Issued by the root authority: "/CN=Test Intermediate".
+	static constexpr std::string_view intermediate =
+		"-----BEGIN CERTIFICATE-----\n"
+		"MIIBlzCCAT2gAwIBAgIUBBTHSdnmp09eM9BpGS3wl+OT1/0wCgYIKoZIzj0EAwIw\n"
+		"FDESMBAGA1UEAwwJVGVzdCBSb290MCAXDTI2MTAxOTAzNTUyNloYDzIxMjYwOTI1\n"
+		"MDM1NTI2WjAcMRowGAYDVQQDDBFUZXN0IEludGVybWVkaWF0ZTBZMBMGByqGSM49\n"
+		"AgEGCCqGSM49AwEHA0IABFr5El8tb7fmZDbG0Zk805H02AQBvaboNyudHGJJJPVk\n"
+		"5BeVw3+MWnMIafqpSOUwguHlanUBKqTuBcxo6vFAFIWjYzBhMA8GA1UdEwEB/wQF\n"
+		"MAMBAf8wDgYDVR0PAQH/BAQDAgIEMB0GA1UdDgQWBBTRNezym6JLAkkf9Z1zvOj4\n"
+		"pxdQgTAfBgNVHSMEGDAWgBQCGxnsIIzTBYudhv7tfD4k6kOsnTAKBggqhkjOPQQD\n"
+		"AgNIADBFAiBtSQhJrSByHdwSL14D+lau6m9ASBgpCAqlhgxSzbOHfwIhAPFW39Ji\n"
+		"jcqWNco0GKw/2NtH93kISxaWJeemFYFtoSKQ\n"
+		"-----END CERTIFICATE-----\n";
+
+	// Issued by the intermediate authority: "/CN=Test Leaf".
+	static constexpr std::string_view leaf =
+		"-----BEGIN CERTIFICATE-----\n"
+		"MIIBLTCB0wIUS5/DpXqKDy3hOmc7xuJZM4C896MwCgYIKoZIzj0EAwIwHDEaMBgG\n"
+		"A1UEAwwRVGVzdCBJbnRlcm1lZGlhdGUwIBcNMjYxMDE5MDM1NTI2WhgPMjEyNjA5\n"
+		"MjUwMzU1MjZaMBQxEjAQBgNVBAMMCVRlc3QgTGVhZjBZMBMGByqGSM49AgEGCCqG\n"
+		"SM49AwEHA0IABFhc2IVE9++MDWcDvHx5jukARY0INzVNdjJCbmZ5fwev1hhQyAwz\n"
+		"BlGGr04MH4WA/9hTTsqEZPwF2Ta4hW3Vu3owCgYIKoZIzj0EAwIDSQAwRgIhAMef\n"
+		"q110N/AXjRySeVuCD8feNTWy664U99RI659IQZPVAiEAsow10jht/0Pwd59YoEY0\n"
+		"or7RYq9rUaxwgDWC3zYu09g=\n"
+		"-----END CERTIFICATE-----\n";
+
+	// Same key and issuer as the leaf, expired right after being issued.
+	static constexpr std::string_view expired =
+		"-----BEGIN CERTIFICATE-----\n"
+		"MIIBKTCB0QIUS5/DpXqKDy3hOmc7xuJZM4C896QwCgYIKoZIzj0EAwIwHDEaMBgG\n"
+		"A1UEAwwRVGVzdCBJbnRlcm1lZGlhdGUwHhcNMjYxMDE5MDM1NTI5WhcNMjYxMDE5\n"
+		"MDM1NTI5WjAUMRIwEAYDVQQDDAlUZXN0IExlYWYwWTATBgcqhkjOPQIBBggqhkjO\n"
+		"PQMBBwNCAARYXNiFRPfvjA1nA7x8eY7pAEWNCDc1TXYyQm5meX8Hr9YYUMgMMwZR\n"
+		"hq9ODB+FgP/YU07KhGT8Bdk2uIVt1bt6MAoGCCqGSM49BAMCA0cAMEQCIFATd4mC\n"
+		"9zwacjpdl41QfWQbj4qy9SZub63VdTW3QH1LAiA+rSiHAb3ZzhE8Ski3yy08zqB6\n"
+		"WU7PvznNCeBqJ6EXPg==\n"
+		"-----END CERTIFICATE-----\n";
+
+	// Self-signed, only meant for servers (extended key usage): "/CN=Test Server".
+	static constexpr std::string_view server =
+		"-----BEGIN CERTIFICATE-----\n"
+		"MIIBlTCCATugAwIBAgIUYZ2lyDYk4XMIhVnzKPsfkXFO/KwwCgYIKoZIzj0EAwIw\n"
+		"FjEUMBIGA1UEAwwLVGVzdCBTZXJ2ZXIwIBcNMjYxMDE5MDUzMDU2WhgPMjEyNjA5\n"
+		"MjUwNTMwNTZaMBYxFDASBgNVBAMMC1Rlc3QgU2VydmVyMFkwEwYHKoZIzj0CAQYI\n"
+		"KoZIzj0DAQcDQgAEQ1OhNbcy58P4EYQtE+IVoLbkLgfL8wPoS6fpdeS+25+uY9i8\n"
+		"5gZJ1am38DvhH81ljxobiWdzoqXUc6W45vExI6NlMGMwHQYDVR0OBBYEFDEEEaJd\n"
+		"YIsxMQ/hS5nTmtKAeXLsMB8GA1UdIwQYMBaAFDEEEaJdYIsxMQ/hS5nTmtKAeXLs\n"
+		"MBMGA1UdJQQMMAoGCCsGAQUFBwMBMAwGA1UdEwEB/wQCMAAwCgYIKoZIzj0EAwID\n"
+		"SAAwRQIhAOo6YytnCw5yzbdocwxDkTeUvTOO/FWgRBtcpQwjjE2wAiACQvshGOdY\n"
+		"Tzx8Bls6qzJw/7nb1RxQCr5PQhE+kc0+WQ==\n"
+		"-----END CERTIFICATE-----\n";
+};
+
+#endif
@@ -0,0 +1,188 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+#include "Data.hpp"
+#include "ThreadManager.hpp"
+
+#include "mumble/Cert.hpp"
+#include "mumble/TrustStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <boost/thread/interruption.hpp>
+
+static constexpr size_t iterations = 10000;
+
+using namespace mumble;
+
+static bool sameChain(const Cert::Chain &a, const Cert::Chain &b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (!(a[i] == b[i])) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static uint8_t testVerify() {
+	const Cert root(Data::root);
+	const Cert intermediate(Data::intermediate);
+	const Cert leaf(Data::leaf);
+	const Cert expired(Data::expired);
+
+	if (!root || !intermediate || !leaf || !expired) {
+		return 1;
+	}
+
+	TrustStore store;
+	if (!store) {
+		return 2;
+	}
+
+	if (!store.verify({ leaf, intermediate }).empty() || !store.verify({}).empty()) {
+		return 3;
+	}
+
+	if (!store.add(root)) {
+		return 4;
+	}
+
+	// The intermediate authority is missing.
+	if (!store.verify({ leaf }).empty()) {
+		return 5;
+	}
+
+	const auto verified = store.verify({ leaf, intermediate });
+	if (!sameChain(verified, { leaf, intermediate, root })) {
+		return 6;
+	}
+
+	if (store.cacheSize() != 1) {
+		return 7;
+	}
+
+	// Cached: the certificates of the first verification are returned.
+	const auto cached = store.verify({ Cert(leaf.der()), Cert(intermediate.der()) });
+	if (!sameChain(cached, verified) || cached[0].handle() != verified[0].handle()) {
+		return 8;
+	}
+
+	// Failures are not cached.
+	if (!store.verify({ expired, intermediate }).empty() || store.cacheSize() != 1) {
+		return 9;
+	}
+
+	if (!sameChain(store.verify({ root }), { root })) {
+		return 10;
+	}
+
+	store.clearCache();
+	if (store.cacheSize() != 0) {
+		return 11;
+	}
+
+	TrustStore bundle;
+	if (bundle.addPEM("Not a certificate") || !bundle.addPEM(std::string(Data::intermediate).append(Data::root))) {
+		return 12;
+	}
+
+	if (!sameChain(bundle.verify({ leaf }), { leaf, intermediate, root })) {
+		return 13;
+	}
+
+	return 0;
+}
+
+static uint8_t testPurpose() {
+	const Cert server(Data::server);
+	if (!server) {
+		return 14;
+	}
+
+	TrustStore store;
+	if (!store.add(server)) {
+		return 15;
+	}
+
+	if (!sameChain(store.verify({ server }, TrustStore::Purpose::Server), { server })
+		|| !sameChain(store.verify({ server }), { server })) {
+		return 16;
+	}
+
+	// Not meant for clients, even though it's trusted and the verifications above are cached.
+	if (!store.verify({ server }, TrustStore::Purpose::Client).empty() || store.cacheSize() != 2) {
+		return 17;
+	}
+
+	// No extended key usage, good for both.
+	TrustStore chain;
+	chain.add(Cert(Data::root));
+
+	const Cert::Chain leaf = { Cert(Data::leaf), Cert(Data::intermediate) };
+	if (chain.verify(leaf, TrustStore::Purpose::Client).empty()
+		|| chain.verify(leaf, TrustStore::Purpose::Server).empty()) {
+		return 18;
+	}
+
+	return 0;
+}
+
+static uint8_t thread(TrustStore &store, const Cert::Chain &expected) {
+	const Cert::Chain chain = { Cert(Data::leaf), Cert(Data::intermediate) };
+
+	for (size_t i = 0; i < iterations; ++i) {
+		if (boost::this_thread::interruption_requested()) {
+			return 0;
+		}
+
+		if (!sameChain(store.verify(chain), expected)) {
+			return 20;
+		}
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	int32_t ret = testVerify();
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testPurpose();
+	if (ret != 0) {
+		return ret;
+	}
+
+	TrustStore store;
+	store.add(Cert(Data::root));
+
+	const Cert::Chain expected = { Cert(Data::leaf), Cert(Data::intermediate), Cert(Data::root) };
+
+	ThreadManager manager;
+
+	for (uint32_t i = 0; i < manager.physicalNum(); ++i) {
+		const ThreadManager::ThreadFunc func = [&ret, &manager, &store, &expected]() {
+			const auto threadRet = thread(store, expected);
+			if (threadRet != 0) {
+				ret = threadRet;
+				manager.requestStop();
+			}
+		};
+
+		manager.add(func);
+	}
+
+	manager.wait();
+
+	return ret;
+}
@@ -0,0 +1,313 @@
+// This file is part of libmumble.
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file at the root of the
+// Mumble source tree or at <https://www.mumble.info/LICENSE>.
+
+// Forwards voice packets the way a server does (decrypt, rewrite the header, encrypt for every listener)
+// and checks that no heap allocation takes place on the way.
+//
+// Only the library calls are covered, the steps are written out here: the example server's Node and User are not run.
+// What they have to reserve for a forwarded packet is checked against the library, see testMaxSize().
+
+#include "mumble/CryptStateOCB2.hpp"
+#include "mumble/Legacy.hpp"
+#include "mumble/Message.hpp"
+#include "mumble/Pack.hpp"
+#include "mumble/Types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+static constexpr size_t iterations = 1000;
+static constexpr size_t listeners  = 10;
+
+static constexpr size_t maxPacketSize = 1024;
+// The sender's session is added when forwarding, with its field tag in the protobuf format. Same as
+// User::maxForwardedSize in the example server.
+static constexpr size_t maxForwardedSize = maxPacketSize + 6;
+
+static size_t allocations = 0;
+
+void *operator new(const std::size_t size) {
+	++allocations;
+
+	if (const auto ptr = std::malloc(size ? size : 1)) {
+		return ptr;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+using namespace mumble;
+
+using Voice = legacy::udp::Voice;
+
+using Packet    = FixedBuf< maxPacketSize >;
+using Forwarded = FixedBuf< maxForwardedSize >;
+using Datagram  = FixedBuf< maxForwardedSize + CryptStateOCB2::headerSize >;
+
+// Both ends of a connection.
+struct Client {
+	CryptStateOCB2 server;
+	CryptStateOCB2 client;
+
+	Client() {
+		server.gen();
+		client.setKey(server.key(), server.encryptNonce(), server.decryptNonce());
+	}
+};
+
+// What the server does for every voice packet, using stack buffers only.
+static size_t forward(Client &sender, std::array< Client, listeners > &clients,
+					  std::array< Datagram, listeners > &datagrams, const BufViewConst in, const uint32_t session,
+					  const bool legacy) {
+	Forwarded decrypted;
+
+	auto size = sender.server.decrypt(decrypted, in);
+	if (!size) {
+		return {};
+	}
+
+	Forwarded forwarded;
+	BufViewConst packet;
+
+	if (legacy) {
+		size   = legacy::udp::reheader(decrypted, size, session, 0);
+		packet = { decrypted.data(), size };
+	} else {
+		Voice voice;
+		if (!legacy::udp::fromPack(voice, { decrypted.data(), size })) {
+			return {};
+		}
+
+		voice.session = session;
+
+		size   = legacy::udp::toPack(forwarded, voice);
+		packet = { forwarded.data(), size };
+	}
+
+	if (!size) {
+		return {};
+	}
+
+	for (size_t i = 0; i < listeners; ++i) {
+		if (!clients[i].server.encrypt(datagrams[i], packet)) {
+			return {};
+		}
+	}
+
+	return packet.size() + CryptStateOCB2::headerSize;
+}
+
+static uint8_t testForward(std::mt19937 &algorithm) {
+	std::uniform_int_distribution< uint32_t > genByte(0, UINT8_MAX);
+	std::uniform_int_distribution< uint32_t > genSize(20, 500);
+
+	Client sender;
+	std::array< Client, listeners > clients;
+	std::array< Datagram, listeners > datagrams;
+
+	FixedBuf< 500 > payload;
+	for (auto &byte : payload) {
+		byte = static_cast< std::byte >(genByte(algorithm));
+	}
+
+	for (size_t i = 0; i < iterations; ++i) {
+		const bool legacy = i % 2;
+
+		Voice voice;
+		voice.sequence     = i;
+		voice.payload      = BufViewConst(payload).first(genSize(algorithm));
+		voice.isTerminator = i == iterations - 1;
+
+		Packet plain;
+		const auto plainSize = legacy ? legacy::udp::encode(plain, voice) : legacy::udp::toPack(plain, voice);
+		if (!plainSize) {
+			return 1;
+		}
+
+		Packet datagram;
+		const auto datagramSize = sender.client.encrypt(datagram, { plain.data(), plainSize });
+		if (!datagramSize) {
+			return 2;
+		}
+
+		// The first round sets up whatever is lazily initialized (e.g. by OpenSSL and protobuf).
+		const auto before = allocations;
+
+		const auto size = forward(sender, clients, datagrams, { datagram.data(), datagramSize }, 123, legacy);
+		if (!size) {
+			return 3;
+		}
+
+		if (i && allocations != before) {
+			return 4;
+		}
+
+		for (size_t j = 0; j < listeners; ++j) {
+			Forwarded received;
+			const auto receivedSize = clients[j].client.decrypt(received, { datagrams[j].data(), size });
+			if (!receivedSize) {
+				return 5;
+			}
+
+			Voice decoded;
+			const BufViewConst packet = { received.data(), receivedSize };
+			if (legacy ? !legacy::udp::decode(decoded, packet, true) : !legacy::udp::fromPack(decoded, packet)) {
+				return 6;
+			}
+
+			if (decoded.session != 123u || decoded.sequence != voice.sequence
+				|| !std::equal(decoded.payload.begin(), decoded.payload.end(), voice.payload.begin(),
+							   voice.payload.end())) {
+				return 7;
+			}
+		}
+	}
+
+	return 0;
+}
+
+// The largest packets a client can send still fit once the session is added, and the room reserved for it is needed.
+static uint8_t testMaxSize() {
+	Client sender;
+	std::array< Client, listeners > clients;
+	std::array< Datagram, listeners > datagrams;
+
+	const Packet payload{};
+
+	for (const bool legacy : { true, false }) {
+		const auto encode = legacy ? legacy::udp::encode : legacy::udp::toPack;
+
+		Voice voice;
+		voice.sequence = 1;
+		voice.payload  = BufViewConst(payload).first(maxPacketSize - CryptStateOCB2::headerSize);
+
+		// The size of the header depends on the one of the payload.
+		while (encode({}, voice) > maxPacketSize - CryptStateOCB2::headerSize) {
+			voice.payload = voice.payload.first(voice.payload.size() - 1);
+		}
+
+		Packet plain;
+		const auto plainSize = encode(plain, voice);
+		if (!plainSize) {
+			return 20;
+		}
+
+		Packet datagram;
+		const auto datagramSize = sender.client.encrypt(datagram, { plain.data(), plainSize });
+		if (datagramSize + 1 < maxPacketSize) {
+			return 21;
+		}
+
+		// The largest session takes all of the room, in the legacy format it can't go anywhere else.
+		Voice forwardedVoice   = voice;
+		forwardedVoice.session = UINT32_MAX;
+
+		const auto growth = encode({}, forwardedVoice) - plainSize;
+		if (growth > maxForwardedSize - maxPacketSize || (legacy && growth != 5)) {
+			return 25;
+		}
+
+		if (legacy) {
+			Forwarded copy;
+			std::copy_n(plain.cbegin(), plainSize, copy.begin());
+
+			const auto room = plainSize + growth;
+			if (legacy::udp::reheader(BufView(copy).first(room - 1), plainSize, UINT32_MAX, 0)
+				|| legacy::udp::reheader(BufView(copy).first(room), plainSize, UINT32_MAX, 0) != room) {
+				return 26;
+			}
+		}
+
+		const auto size = forward(sender, clients, datagrams, { datagram.data(), datagramSize }, UINT32_MAX, legacy);
+		if (size <= datagramSize) {
+			return 22;
+		}
+
+		Forwarded received;
+		const auto receivedSize = clients[0].client.decrypt(received, { datagrams[0].data(), size });
+
+		Voice decoded;
+		const BufViewConst packet = { received.data(), receivedSize };
+		if (legacy ? !legacy::udp::decode(decoded, packet, true) : !legacy::udp::fromPack(decoded, packet)) {
+			return 23;
+		}
+
+		if (decoded.session != UINT32_MAX || decoded.payload.size() != voice.payload.size()) {
+			return 24;
+		}
+	}
+
+	return 0;
+}
+
+static uint8_t testPing() {
+	using Ping = udp::Message::Ping;
+
+	Packet buf;
+
+	for (size_t i = 0; i < iterations; ++i) {
+		const auto before = allocations;
+
+		Ping ping;
+		ping.requestExtendedInformation = true;
+		ping.userCount                  = static_cast< uint32_t >(i);
+
+		const auto size = udp::Pack::write(buf, ping);
+		if (!size || size != udp::Pack::write({}, ping)) {
+			return 10;
+		}
+
+		Ping parsed;
+		if (!udp::Pack::read(parsed, { buf.data(), size })) {
+			return 11;
+		}
+
+		if (i && allocations != before) {
+			return 12;
+		}
+
+		if (parsed.userCount != ping.userCount || parsed.timestamp != ping.timestamp) {
+			return 13;
+		}
+
+		// Has to match what the allocating counterpart produces.
+		const udp::Pack pack(ping);
+		if (!std::equal(pack.buf().begin(), pack.buf().end(), buf.cbegin(), buf.cbegin() + size)) {
+			return 14;
+		}
+	}
+
+	return 0;
+}
+
+int32_t main() {
+	std::random_device device;
+	std::mt19937 algorithm(device());
+
+	auto ret = testForward(algorithm);
+	if (ret != 0) {
+		return ret;
+	}
+
+	ret = testMaxSize();
+	if (ret != 0) {
+		return ret;
+	}
+
+	return testPing();
+}